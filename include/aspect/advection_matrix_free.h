@@ -0,0 +1,378 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _aspect_advection_matrix_free_h
+#define _aspect_advection_matrix_free_h
+
+#include <aspect/global.h>
+
+#include <aspect/simulator.h>
+
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/operators.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/solver_control.h>
+
+namespace aspect
+{
+  using namespace dealii;
+
+  /**
+   * This namespace contains the matrix-free operators used in the solver
+   * for the temperature and compositional field equations.
+   */
+  namespace MatrixFreeAdvectionOperators
+  {
+    /**
+     * Operator for the advection-diffusion equation of a single temperature
+     * or compositional field. This operator applies the same terms that
+     * Assemblers::AdvectionSystem assembles into the system matrix, i.e.,
+     * the time derivative discretized by the BDF2 scheme, the advection
+     * term, the physical and artificial (entropy viscosity) diffusion,
+     * and, if SUPG is used, the streamline-upwind Petrov-Galerkin
+     * stabilization terms.
+     */
+    template <int dim, int degree, int n_q_points_1d, typename number>
+    class AdvectionDiffusionOperator
+      : public MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >
+    {
+      public:
+
+        /**
+         * Constructor.
+         */
+        AdvectionDiffusionOperator ();
+
+        /**
+         * Reset the object.
+         */
+        void clear () override;
+
+        /**
+         * Set the coefficient tables and the time stepping constants. The
+         * tables contain, for every cell batch and quadrature point, the
+         * coefficient in front of the time derivative and the advection
+         * term (i.e., $\rho C_p$ plus the latent heat term for the
+         * temperature, and one for compositional fields), the advection
+         * velocity, and the diffusion constant. If @p use_supg is set,
+         * the tables for the SUPG stabilization parameter $\tau$ and the
+         * physical conductivity that enters the SUPG residual have to be
+         * filled as well.
+         */
+        void fill_cell_data (const Table<2, VectorizedArray<number>> &mass_coefficient_table,
+                             const Table<2, Tensor<1,dim,VectorizedArray<number>>> &velocity_table,
+                             const Table<2, VectorizedArray<number>> &diffusion_table,
+                             const Table<2, VectorizedArray<number>> &supg_tau_table,
+                             const Table<2, VectorizedArray<number>> &supg_conductivity_table,
+                             const double time_step,
+                             const double bdf2_factor,
+                             const bool use_supg);
+
+        /**
+         * Computes the diagonal of the matrix. Since matrix-free operators have not access
+         * to matrix elements, we must apply the matrix-free operator to the unit vectors to
+         * recover the diagonal.
+         */
+        void compute_diagonal () override;
+
+      private:
+
+        /**
+         * Performs the application of the matrix-free operator. This function is called by
+         * vmult() functions MatrixFreeOperators::Base.
+         */
+        void apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                        const dealii::LinearAlgebra::distributed::Vector<number> &src) const override;
+
+        /**
+         * Defines the application of the cell matrix.
+         */
+        void local_apply (const dealii::MatrixFree<dim, number>                 &data,
+                          dealii::LinearAlgebra::distributed::Vector<number>       &dst,
+                          const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                          const std::pair<unsigned int, unsigned int>           &cell_range) const;
+
+        /**
+         * Computes the diagonal contribution from a cell matrix.
+         */
+        void local_compute_diagonal (const MatrixFree<dim,number>                     &data,
+                                     dealii::LinearAlgebra::distributed::Vector<number>  &dst,
+                                     const unsigned int                               &dummy,
+                                     const std::pair<unsigned int,unsigned int>       &cell_range) const;
+
+        /**
+         * Apply the operator to the degrees of freedom currently stored in
+         * @p field, which has been reinitialized on the cell batch @p cell.
+         * This evaluates the field, applies the coefficients at all
+         * quadrature points, and integrates the result, which is left in
+         * the degrees of freedom of @p field.
+         */
+        void apply_cell (FEEvaluation<dim,degree,n_q_points_1d,1,number> &field,
+                         const unsigned int cell) const;
+
+        /**
+         * Tables which store the coefficients for each cell batch and
+         * quadrature point. See fill_cell_data().
+         */
+        const Table<2, VectorizedArray<number>> *mass_coefficient;
+        const Table<2, Tensor<1,dim,VectorizedArray<number>>> *velocity;
+        const Table<2, VectorizedArray<number>> *diffusion;
+        const Table<2, VectorizedArray<number>> *supg_tau;
+        const Table<2, VectorizedArray<number>> *supg_conductivity;
+
+        /**
+         * The time step size and the factor of the BDF2 scheme in front
+         * of the field value at the new time.
+         */
+        number time_step;
+        number bdf2_factor;
+
+        /**
+         * Whether the SUPG stabilization terms are applied.
+         */
+        bool use_supg;
+    };
+  }
+
+  /**
+   * Base class for the matrix-free solver for the advection-diffusion
+   * systems of the temperature or of the compositional fields. The actual
+   * implementation is found inside AdvectionMatrixFreeHandlerImplementation
+   * below. One object of this class handles either the temperature or all
+   * compositional fields, since all of these share the same finite element.
+   */
+  template<int dim>
+  class AdvectionMatrixFreeHandler
+  {
+    public:
+      /**
+       * virtual Destructor.
+       */
+      virtual ~AdvectionMatrixFreeHandler() = default;
+
+      /**
+       * Allocates and sets up the members of the AdvectionMatrixFreeHandler. This
+       * is called by Simulator<dim>::setup_dofs()
+       */
+      virtual void setup_dofs()=0;
+
+      /**
+       * Prepare the matrix-free operator for the given @p advection_field.
+       * This sets up the constraints of the field, reinitializes the
+       * matrix-free storage if necessary, and resizes the coefficient
+       * tables that are later filled by fill_cell_coefficients(). This is
+       * called by Simulator<dim>::assemble_advection_system() before the
+       * loop over all cells.
+       */
+      virtual void setup_operator(const typename Simulator<dim>::AdvectionField &advection_field)=0;
+
+      /**
+       * Store the coefficients of the advection-diffusion operator on the
+       * given @p cell, using the material model outputs, heating model
+       * outputs, velocities, and artificial viscosity that were computed
+       * in @p scratch while assembling the right-hand side of the
+       * system. Different cells can be filled concurrently.
+       */
+      virtual void fill_cell_coefficients(const typename Simulator<dim>::AdvectionField &advection_field,
+                                          const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                          const internal::Assembly::Scratch::AdvectionSystem<dim> &scratch)=0;
+
+      /**
+       * Solve the linear system of the given @p advection_field
+       * matrix-free, using the right-hand side stored in the system
+       * right-hand side of the simulator. @p solution contains the
+       * initial guess with zero constrained entries on input, and
+       * the solution on output. Return the residual of the initial
+       * guess. This is called by Simulator<dim>::solve_advection().
+       *
+       * The operator set up by the last call to setup_operator() is used,
+       * so this function can be called for several fields that share the
+       * same operator, in which case its diagonal is only computed once.
+       */
+      virtual double solve(const typename Simulator<dim>::AdvectionField &advection_field,
+                           SolverControl &solver_control,
+                           LinearAlgebra::Vector &solution)=0;
+
+      /**
+       * Create an object of this class that handles the fields of the
+       * same kind (temperature or compositional fields) as
+       * @p advection_field, with the template arguments that correspond
+       * to the polynomial degree of these fields and the quadrature used
+       * to assemble their right-hand side.
+       */
+      static
+      std::unique_ptr<AdvectionMatrixFreeHandler<dim> >
+      create (Simulator<dim> &simulator,
+              const typename Simulator<dim>::AdvectionField &advection_field);
+  };
+
+  /**
+   * Main class of the matrix-free advection solver. Here are all the
+   * functions for the setup and for solving the advection-diffusion
+   * systems.
+   *
+   * We need to derive from AdvectionMatrixFreeHandler to be able to
+   * introduce the degree of the finite element and the number of
+   * quadrature points as template arguments. This way, the main simulator
+   * does not need to know about them by using a pointer to the base class.
+   */
+  template<int dim, int degree, int n_q_points_1d>
+  class AdvectionMatrixFreeHandlerImplementation: public AdvectionMatrixFreeHandler<dim>
+  {
+    public:
+      /**
+       * Initialize this class, giving it a reference to the Simulator that
+       * owns it, and the kind of fields it handles (temperature or
+       * compositional fields), described by @p advection_field.
+       */
+      AdvectionMatrixFreeHandlerImplementation(Simulator<dim> &simulator,
+                                               const typename Simulator<dim>::AdvectionField &advection_field);
+
+      /**
+       * Destructor.
+       */
+      ~AdvectionMatrixFreeHandlerImplementation() override = default;
+
+      /**
+       * Allocates and sets up the members of the AdvectionMatrixFreeHandler. This
+       * is called by Simulator<dim>::setup_dofs()
+       */
+      void setup_dofs() override;
+
+      /**
+       * Prepare the matrix-free operator for the given @p advection_field.
+       * See the documentation in the base class.
+       */
+      void setup_operator(const typename Simulator<dim>::AdvectionField &advection_field) override;
+
+      /**
+       * Store the coefficients of the advection-diffusion operator on the
+       * given @p cell. See the documentation in the base class.
+       */
+      void fill_cell_coefficients(const typename Simulator<dim>::AdvectionField &advection_field,
+                                  const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                  const internal::Assembly::Scratch::AdvectionSystem<dim> &scratch) override;
+
+      /**
+       * Solve the linear system of the given @p advection_field
+       * matrix-free. See the documentation in the base class.
+       */
+      double solve(const typename Simulator<dim>::AdvectionField &advection_field,
+                   SolverControl &solver_control,
+                   LinearAlgebra::Vector &solution) override;
+
+    private:
+      /**
+       * Return the index of the DoFHandler and constraints object inside
+       * the matrix-free storage that belongs to @p advection_field.
+       */
+      unsigned int
+      dof_index (const typename Simulator<dim>::AdvectionField &advection_field) const;
+
+      /**
+       * Fill @p field_constraints with the homogeneous version of the constraints
+       * of the simulator for the block of @p advection_field, translated
+       * to the numbering of the degrees of freedom of dof_handler. This
+       * includes hanging node constraints, periodicity constraints, and
+       * the Dirichlet boundary conditions of the field. The inhomogeneities
+       * are taken into account when assembling the right-hand side. The
+       * locally relevant constrained degrees of freedom are also stored in
+       * @p field_constrained_dofs.
+       */
+      void
+      extract_constraints (const typename Simulator<dim>::AdvectionField &advection_field,
+                           ConstraintMatrix &field_constraints,
+                           IndexSet &field_constrained_dofs) const;
+
+      /**
+       * Reinitialize the matrix-free storage for all fields handled by this
+       * object, and recompute the map from active cells to cell batches.
+       */
+      void
+      reinit_matrix_free ();
+
+      Simulator<dim> &sim;
+
+      /**
+       * The kind of fields (temperature or compositional fields) this
+       * object handles, and the number of them.
+       */
+      const typename Simulator<dim>::AdvectionField::FieldType field_type;
+      const unsigned int n_fields;
+
+      /**
+       * The scalar finite element shared by all fields handled by this
+       * object, i.e., the corresponding base element of the finite
+       * element of the simulator.
+       */
+      const FiniteElement<dim> &fe;
+
+      DoFHandler<dim> dof_handler;
+
+      /**
+       * The constraints of each field, in the numbering of dof_handler,
+       * and the set of constrained degrees of freedom these were built
+       * from. Since the latter can change over time (e.g., with time
+       * dependent boundary indicators), the matrix-free storage has to be
+       * reinitialized whenever the set changes.
+       */
+      std::vector<ConstraintMatrix> constraints;
+      std::vector<IndexSet> constrained_dofs;
+
+      std::shared_ptr<MatrixFree<dim,double> > matrix_free;
+
+      /**
+       * The time step number for which the matrix-free storage was set
+       * up. With a deforming mesh, the mapping stored inside the
+       * matrix-free storage changes in every time step.
+       */
+      unsigned int matrix_free_timestep_number;
+
+      /**
+       * For each active cell of the triangulation, the cell batch and
+       * the vectorization lane it is stored in inside the matrix-free
+       * storage. This allows to fill the coefficient tables from the
+       * cell loop of the right-hand side assembly.
+       */
+      std::vector<std::pair<unsigned int, unsigned int> > cell_batch_of_active_cell;
+
+      Table<2, VectorizedArray<double>> mass_coefficient_table;
+      Table<2, Tensor<1,dim,VectorizedArray<double>>> velocity_table;
+      Table<2, VectorizedArray<double>> diffusion_table;
+      Table<2, VectorizedArray<double>> supg_tau_table;
+      Table<2, VectorizedArray<double>> supg_conductivity_table;
+
+      typedef MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,double> AdvectionMatrixType;
+
+      AdvectionMatrixType advection_matrix;
+
+      /**
+       * Whether the diagonal of advection_matrix has been computed since
+       * the last call to setup_operator().
+       */
+      bool diagonal_is_computed;
+  };
+}
+
+
+#endif
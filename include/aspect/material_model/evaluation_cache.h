@@ -0,0 +1,165 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _aspect_material_model_evaluation_cache_h
+#define _aspect_material_model_evaluation_cache_h
+
+#include <aspect/material_model/interface.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace aspect
+{
+  namespace MaterialModel
+  {
+    using namespace dealii;
+
+    /**
+     * A class that stores the outputs of material model evaluations on
+     * the active cells of the mesh, and returns them again if the material
+     * model is evaluated a second time with the same inputs on the same
+     * cell. Within one nonlinear iteration, the material model is often
+     * evaluated several times with identical inputs, e.g., when assembling
+     * the Stokes system and the Stokes preconditioner, or when computing
+     * the artificial viscosity and assembling an advection system. For
+     * expensive material models, this class avoids the repeated
+     * evaluations.
+     *
+     * For every cell and every number of evaluation points (i.e., for every
+     * quadrature formula used on the cell), the class keeps the inputs and
+     * outputs of the most recently used evaluations. Keeping more than one
+     * evaluation allows to serve, e.g., the computation of the artificial
+     * viscosity of every advected field, which uses the same inputs for all
+     * fields, even though the assembly of each field evaluates the material
+     * model with different inputs in between. A cached result is only used if
+     * all inputs are identical to the current ones, which also means that
+     * cached results automatically become invalid if the solution changes.
+     * Evaluations with additional material model inputs or outputs, or
+     * without a current cell, are not cached, because these objects can not
+     * be compared or copied.
+     *
+     * Material model outputs that depend on anything else than the inputs
+     * (e.g., on the time step size) can only be cached if the cache is
+     * cleared whenever this other information changes, see clear().
+     *
+     * The functions of this class can be called concurrently from several
+     * threads.
+     */
+    template <int dim>
+    class EvaluationCache
+    {
+      public:
+        /**
+         * Constructor.
+         */
+        EvaluationCache ();
+
+        /**
+         * Evaluate @p material_model for the inputs @p in and store the
+         * results in @p out, unless @p material_model has already been
+         * evaluated for the same inputs on the same cell, in which case the
+         * stored results are copied into @p out.
+         */
+        void
+        evaluate (const Interface<dim> &material_model,
+                  const MaterialModelInputs<dim> &in,
+                  MaterialModelOutputs<dim> &out);
+
+        /**
+         * Delete all stored results. This has to be called whenever the
+         * active cells change, and whenever the material model outputs may
+         * change for the same inputs, e.g., at the beginning of every time
+         * step.
+         */
+        void
+        clear ();
+
+        /**
+         * Return the number of calls of evaluate() since the last call of
+         * clear() that used stored results.
+         */
+        unsigned int
+        n_hits () const;
+
+        /**
+         * Return the number of calls of evaluate() since the last call of
+         * clear() that evaluated the material model, including the
+         * evaluations that can not be cached.
+         */
+        unsigned int
+        n_misses () const;
+
+      private:
+        /**
+         * The inputs and outputs of one material model evaluation on one
+         * cell.
+         */
+        struct Entry
+        {
+          Entry (const MaterialModelInputs<dim> &in,
+                 const MaterialModelOutputs<dim> &out);
+
+          MaterialModelInputs<dim> inputs;
+          MaterialModelOutputs<dim> outputs;
+        };
+
+        /**
+         * Return whether the inputs @p cached_inputs of an earlier
+         * evaluation can be used in place of @p in, i.e., whether all
+         * inputs are identical, and whether the earlier evaluation computed
+         * all requested properties.
+         */
+        static
+        bool
+        inputs_match (const MaterialModelInputs<dim> &cached_inputs,
+                      const MaterialModelInputs<dim> &in);
+
+        /**
+         * The number of evaluations that are stored for every cell and
+         * number of evaluation points.
+         */
+        static const unsigned int n_entries_per_key = 2;
+
+        /**
+         * The stored evaluations, indexed by the active cell index of the
+         * cell and the number of evaluation points. The evaluations for one
+         * index are sorted from the most to the least recently used one.
+         */
+        std::map<std::pair<unsigned int, unsigned int>, std::list<Entry> > entries;
+
+        /**
+         * The number of evaluations that used stored results, and that
+         * evaluated the material model, since the last call of clear().
+         */
+        unsigned int hits;
+        unsigned int misses;
+
+        /**
+         * A mutex that protects the map and the counters above from being
+         * accessed concurrently.
+         */
+        mutable std::mutex entries_mutex;
+    };
+  }
+}
+
+#endif
@@ -45,6 +45,8 @@ namespace aspect
 
         std::vector<double> get_nth_output(const unsigned int idx) const override;
 
+        bool reset () override;
+
         /**
          * Dislocation viscosities at the evaluation points passed to
          * the instance of MaterialModel::Interface::evaluate() that fills
@@ -409,6 +411,16 @@ namespace aspect
          * field provided.
          */
         std::vector<std::unique_ptr<MaterialModel::MaterialUtilities::Lookup::MaterialLookup> > material_lookup;
+
+        /**
+         * Mix the values @p lookup_values of one property, one for each
+         * object in material_lookup, with the weights given by
+         * @p compositional_fields. This is the same average that the
+         * functions density(), seismic_Vp(), etc. compute.
+         */
+        double
+        average_lookup_values (const std::vector<double> &lookup_values,
+                               const std::vector<double> &compositional_fields) const;
     };
 
   }
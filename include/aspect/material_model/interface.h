@@ -25,6 +25,7 @@
 #include <aspect/plugins.h>
 #include <aspect/material_model/utilities.h>
 
+#include <deal.II/base/array_view.h>
 #include <deal.II/base/point.h>
 #include <deal.II/base/quadrature.h>
 #include <deal.II/base/symmetric_tensor.h>
@@ -225,6 +226,176 @@ namespace aspect
       }
     }
 
+    /**
+     * A container for the values of all compositional fields at a number of
+     * evaluation points. The values are stored in one contiguous array,
+     * field by field, i.e., the values of one compositional field at all
+     * points are stored next to each other. Compared to a vector of vectors
+     * indexed by point and field, this requires only a single memory
+     * allocation, and loops over the points for one field (see
+     * field_values()) access contiguous memory.
+     *
+     * For compatibility with code written for the earlier storage as
+     * <code>std::vector<std::vector<double> ></code>, operator[] returns an
+     * object that represents the values of all fields at one point. It
+     * again provides operator[] and size(), and can be converted to a
+     * <code>std::vector<double></code>, so that expressions like
+     * <code>composition[q][c]</code> and <code>composition[q].size()</code>
+     * keep working, and <code>composition[q]</code> can still be passed to
+     * functions that take a <code>const std::vector<double> &</code>. The
+     * latter creates a copy of the values, so code that needs the values
+     * at every point should rather fill a vector that is reused for all
+     * points with get_point_values().
+     */
+    class CompositionalFieldValues
+    {
+      public:
+        /**
+         * An object that represents the values of all compositional fields
+         * at one point. @p Number is either <code>double</code> or
+         * <code>const double</code>, depending on whether the values can be
+         * modified through this object.
+         */
+        template <typename Number>
+        class PointValues
+        {
+          public:
+            /**
+             * Constructor. The value of field @p c is stored at
+             * <code>values[c*stride+point]</code>.
+             */
+            PointValues (Number *values,
+                         const unsigned int point,
+                         const unsigned int stride,
+                         const unsigned int n_fields);
+
+            /**
+             * Return a reference to the value of the compositional field
+             * with index @p field at this point.
+             */
+            Number &operator[] (const unsigned int field) const;
+
+            /**
+             * Return the number of compositional fields.
+             */
+            unsigned int size () const;
+
+            /**
+             * Return a copy of the values of all compositional fields at
+             * this point.
+             */
+            operator std::vector<double> () const;
+
+          private:
+            Number *values;
+            const unsigned int point;
+            const unsigned int stride;
+            const unsigned int n_fields;
+        };
+
+        /**
+         * Constructor. Create a container for @p n_points points and
+         * @p n_fields compositional fields, and set all values to @p value.
+         */
+        explicit CompositionalFieldValues (const unsigned int n_points = 0,
+                                           const unsigned int n_fields = 0,
+                                           const double value = 0.);
+
+        /**
+         * Resize the container to @p n_points points and @p n_fields
+         * compositional fields, and set all values to @p value.
+         */
+        void
+        reinit (const unsigned int n_points,
+                const unsigned int n_fields,
+                const double value = 0.);
+
+        /**
+         * Return the number of points. This is the same as n_points(), and
+         * exists for compatibility with the earlier storage as a vector
+         * of vectors.
+         */
+        unsigned int size () const;
+
+        /**
+         * Return the number of points.
+         */
+        unsigned int n_points () const;
+
+        /**
+         * Return the number of compositional fields.
+         */
+        unsigned int n_fields () const;
+
+        /**
+         * Return an object that represents the values of all compositional
+         * fields at the point with index @p point.
+         */
+        PointValues<double> operator[] (const unsigned int point);
+
+        /**
+         * Return an object that represents the values of all compositional
+         * fields at the point with index @p point.
+         */
+        PointValues<const double> operator[] (const unsigned int point) const;
+
+        /**
+         * Return a reference to the value of the compositional field with
+         * index @p field at the point with index @p point.
+         */
+        double &operator() (const unsigned int point,
+                            const unsigned int field);
+
+        /**
+         * Return the value of the compositional field with index @p field
+         * at the point with index @p point.
+         */
+        double operator() (const unsigned int point,
+                           const unsigned int field) const;
+
+        /**
+         * Return the values of the compositional field with index
+         * @p field at all points, which are stored contiguously.
+         */
+        ArrayView<double> field_values (const unsigned int field);
+
+        /**
+         * Return the values of the compositional field with index
+         * @p field at all points, which are stored contiguously.
+         */
+        ArrayView<const double> field_values (const unsigned int field) const;
+
+        /**
+         * Copy the values of all compositional fields at the point with
+         * index @p point into @p values, which is resized to the number of
+         * fields. If @p values already has the correct size, no memory is
+         * allocated.
+         */
+        void
+        get_point_values (const unsigned int point,
+                          std::vector<double> &values) const;
+
+        /**
+         * Return whether all values of this object and @p other are equal.
+         */
+        bool operator== (const CompositionalFieldValues &other) const;
+
+        /**
+         * Return whether any value of this object and @p other differs.
+         */
+        bool operator!= (const CompositionalFieldValues &other) const;
+
+      private:
+        unsigned int n_evaluation_points;
+        unsigned int n_compositional_fields;
+
+        /**
+         * The values of all fields at all points. The value of field c at
+         * point q is stored at index c*n_evaluation_points+q.
+         */
+        std::vector<double> values;
+    };
+
     template <int dim> class AdditionalMaterialInputs;
 
     /**
@@ -321,6 +492,17 @@ namespace aspect
                   const LinearAlgebra::BlockVector &solution_vector,
                   const bool use_strain_rates = true);
 
+      /**
+       * Function to re-initialize and populate the arrays of this structure
+       * with the values in @p input_data, as done by the constructor that
+       * takes the same arguments. The arrays are only resized if the number
+       * of points changes, so reusing an object for many cells does not
+       * allocate memory.
+       */
+      void reinit(const DataPostprocessorInputs::Vector<dim> &input_data,
+                  const Introspection<dim> &introspection,
+                  const bool use_strain_rate = true);
+
       /**
        * Function that returns the number of points at which
        * the material model is to be evaluated.
@@ -369,9 +551,10 @@ namespace aspect
       /**
        * Values of the compositional fields at the points given in the
        * #position vector: composition[i][c] is the compositional field c at
-       * point i.
+       * point i. See CompositionalFieldValues for how the values are stored
+       * and for efficient ways to access them.
        */
-      std::vector<std::vector<double> > composition;
+      CompositionalFieldValues composition;
 
       /**
        * Strain rate at the points given in the #position vector. Only the
@@ -813,6 +996,19 @@ namespace aspect
                               const FullMatrix<double>  &/*projection_matrix*/,
                               const FullMatrix<double>  &/*expansion_matrix*/)
         {}
+
+        /**
+         * Reset all values stored in this object to the values the
+         * constructor sets, so that the object can be reused for another
+         * evaluation of the material model, and return true. Classes that
+         * can not be reset return false instead, which is what the default
+         * implementation does, and need to be replaced by a newly created
+         * object.
+         */
+        virtual bool reset ()
+        {
+          return false;
+        }
     };
 
 
@@ -891,6 +1087,8 @@ namespace aspect
 
         std::vector<double> get_nth_output(const unsigned int idx) const override;
 
+        bool reset () override;
+
         /**
          * Seismic s-wave velocities at the evaluation points passed to
          * the instance of MaterialModel::Interface::evaluate() that fills
@@ -936,6 +1134,8 @@ namespace aspect
 
         std::vector<double> get_nth_output(const unsigned int idx) const override;
 
+        bool reset () override;
+
         /**
          * Reaction rates for all compositional fields at the evaluation points
          * that are passed to the instance of MaterialModel::Interface::evaluate()
@@ -974,6 +1174,8 @@ namespace aspect
 
         std::vector<double> get_nth_output(const unsigned int idx) const override;
 
+        bool reset () override;
+
         /**
          * Prescribed field outputs for all compositional fields at the evaluation points
          * that are passed to the instance of MaterialModel::Interface::evaluate()
@@ -1005,6 +1207,8 @@ namespace aspect
 
         std::vector<double> get_nth_output(const unsigned int idx) const override;
 
+        bool reset () override;
+
         /**
          * Prescribed field outputs for the temperature field at the evaluation points
          * that are passed to the instance of MaterialModel::Interface::evaluate()
@@ -1090,6 +1294,8 @@ namespace aspect
          */
         virtual std::vector<double> get_nth_output(const unsigned int idx) const;
 
+        bool reset () override;
+
         /**
          * A scalar value per evaluation point that specifies the prescribed dilation
          * in that point.
@@ -1414,6 +1620,167 @@ namespace aspect
 
 // --------------------- template function definitions ----------------------------------
 
+    template <typename Number>
+    inline
+    CompositionalFieldValues::PointValues<Number>::PointValues (Number *values,
+                                                                const unsigned int point,
+                                                                const unsigned int stride,
+                                                                const unsigned int n_fields)
+      :
+      values (values),
+      point (point),
+      stride (stride),
+      n_fields (n_fields)
+    {}
+
+
+
+    template <typename Number>
+    inline
+    Number &
+    CompositionalFieldValues::PointValues<Number>::operator[] (const unsigned int field) const
+    {
+      AssertIndexRange (field, n_fields);
+      return values[field*stride + point];
+    }
+
+
+
+    template <typename Number>
+    inline
+    unsigned int
+    CompositionalFieldValues::PointValues<Number>::size () const
+    {
+      return n_fields;
+    }
+
+
+
+    template <typename Number>
+    inline
+    CompositionalFieldValues::PointValues<Number>::operator std::vector<double> () const
+    {
+      std::vector<double> point_values (n_fields);
+      for (unsigned int c=0; c<n_fields; ++c)
+        point_values[c] = values[c*stride + point];
+      return point_values;
+    }
+
+
+
+    inline
+    unsigned int
+    CompositionalFieldValues::size () const
+    {
+      return n_evaluation_points;
+    }
+
+
+
+    inline
+    unsigned int
+    CompositionalFieldValues::n_points () const
+    {
+      return n_evaluation_points;
+    }
+
+
+
+    inline
+    unsigned int
+    CompositionalFieldValues::n_fields () const
+    {
+      return n_compositional_fields;
+    }
+
+
+
+    inline
+    CompositionalFieldValues::PointValues<double>
+    CompositionalFieldValues::operator[] (const unsigned int point)
+    {
+      AssertIndexRange (point, n_evaluation_points);
+      return PointValues<double>(values.data(), point, n_evaluation_points, n_compositional_fields);
+    }
+
+
+
+    inline
+    CompositionalFieldValues::PointValues<const double>
+    CompositionalFieldValues::operator[] (const unsigned int point) const
+    {
+      AssertIndexRange (point, n_evaluation_points);
+      return PointValues<const double>(values.data(), point, n_evaluation_points, n_compositional_fields);
+    }
+
+
+
+    inline
+    double &
+    CompositionalFieldValues::operator() (const unsigned int point,
+                                          const unsigned int field)
+    {
+      AssertIndexRange (point, n_evaluation_points);
+      AssertIndexRange (field, n_compositional_fields);
+      return values[field*n_evaluation_points + point];
+    }
+
+
+
+    inline
+    double
+    CompositionalFieldValues::operator() (const unsigned int point,
+                                          const unsigned int field) const
+    {
+      AssertIndexRange (point, n_evaluation_points);
+      AssertIndexRange (field, n_compositional_fields);
+      return values[field*n_evaluation_points + point];
+    }
+
+
+
+    inline
+    ArrayView<double>
+    CompositionalFieldValues::field_values (const unsigned int field)
+    {
+      AssertIndexRange (field, n_compositional_fields);
+      return ArrayView<double>(values.data() + field*n_evaluation_points, n_evaluation_points);
+    }
+
+
+
+    inline
+    ArrayView<const double>
+    CompositionalFieldValues::field_values (const unsigned int field) const
+    {
+      AssertIndexRange (field, n_compositional_fields);
+      return ArrayView<const double>(values.data() + field*n_evaluation_points, n_evaluation_points);
+    }
+
+
+
+    inline
+    void
+    CompositionalFieldValues::get_point_values (const unsigned int point,
+                                                std::vector<double> &point_values) const
+    {
+      AssertIndexRange (point, n_evaluation_points);
+      point_values.resize(n_compositional_fields);
+      for (unsigned int c=0; c<n_compositional_fields; ++c)
+        point_values[c] = values[c*n_evaluation_points + point];
+    }
+
+
+
+    inline
+    bool
+    CompositionalFieldValues::operator!= (const CompositionalFieldValues &other) const
+    {
+      return !(*this == other);
+    }
+
+
+
     template <int dim>
     template <class AdditionalInputType>
     AdditionalInputType *MaterialModelInputs<dim>::get_additional_input()
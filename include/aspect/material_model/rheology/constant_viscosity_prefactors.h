@@ -61,10 +61,12 @@ namespace aspect
           parse_parameters (ParameterHandler &prm);
 
           /**
-           * Compute the viscosity.
+           * Compute the viscosity. Instantiated for double and
+           * VectorizedArray<double>.
            */
-          double
-          compute_viscosity (const double viscosity,
+          template <typename Number>
+          Number
+          compute_viscosity (const Number &viscosity,
                              const unsigned int composition_index) const;
 
         private:
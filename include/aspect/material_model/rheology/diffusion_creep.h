@@ -57,10 +57,16 @@ namespace aspect
 
           /**
            * Compute the viscosity based on the diffusion creep law.
+           *
+           * The function is instantiated for Number=double and for
+           * Number=VectorizedArray<double>. The latter evaluates the creep
+           * law for as many points at once as there are lanes in the
+           * vectorized array.
            */
-          double
-          compute_viscosity (const double pressure,
-                             const double temperature,
+          template <typename Number>
+          Number
+          compute_viscosity (const Number &pressure,
+                             const Number &temperature,
                              const unsigned int composition) const;
 
         private:
@@ -56,11 +56,16 @@ namespace aspect
 
           /**
            * Compute the viscosity based on the dislocation creep law.
+           *
+           * Like DiffusionCreep::compute_viscosity(), this function is
+           * instantiated for double and for VectorizedArray<double>
+           * arguments, where the latter evaluates several points at once.
            */
-          double
-          compute_viscosity (const double strain_rate,
-                             const double pressure,
-                             const double temperature,
+          template <typename Number>
+          Number
+          compute_viscosity (const Number &strain_rate,
+                             const Number &pressure,
+                             const Number &temperature,
                              const unsigned int composition) const;
 
         private:
@@ -81,22 +81,30 @@ namespace aspect
 
           /**
            * Compute the plastic yield stress based on the Drucker Prager yield criterion.
+           *
+           * This function and compute_viscosity() are instantiated for
+           * double and VectorizedArray<double> arguments. In the latter case
+           * each lane holds the values of a different point, and all
+           * arguments (including @p max_yield_stress) have to be given
+           * for every lane.
            */
-          double
-          compute_yield_stress (const double cohesion,
-                                const double angle_internal_friction,
-                                const double pressure,
-                                const double max_yield_stress) const;
+          template <typename Number>
+          Number
+          compute_yield_stress (const Number &cohesion,
+                                const Number &angle_internal_friction,
+                                const Number &pressure,
+                                const Number &max_yield_stress) const;
 
           /**
            * Compute the plastic viscosity with the yield stress and effective strain rate.
            */
-          double
-          compute_viscosity (const double cohesion,
-                             const double angle_internal_friction,
-                             const double pressure,
-                             const double effective_strain_rate,
-                             const double max_yield_stress) const;
+          template <typename Number>
+          Number
+          compute_viscosity (const Number &cohesion,
+                             const Number &angle_internal_friction,
+                             const Number &pressure,
+                             const Number &effective_strain_rate,
+                             const Number &max_yield_stress) const;
 
           /**
            * Compute the derivative of the plastic viscosity with respect to pressure.
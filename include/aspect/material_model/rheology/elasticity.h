@@ -44,6 +44,8 @@ namespace aspect
 
         std::vector<double> get_nth_output(const unsigned int idx) const override;
 
+        bool reset () override;
+
         /**
          * Elastic shear moduli at the evaluation points passed to
          * the instance of MaterialModel::Interface::evaluate() that fills
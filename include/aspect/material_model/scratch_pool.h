@@ -0,0 +1,121 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _aspect_material_model_scratch_pool_h
+#define _aspect_material_model_scratch_pool_h
+
+#include <aspect/material_model/interface.h>
+
+#include <deal.II/base/thread_local_storage.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace aspect
+{
+  namespace MaterialModel
+  {
+    using namespace dealii;
+
+    /**
+     * A class that provides MaterialModelInputs and MaterialModelOutputs
+     * objects that are reused for many material model evaluations. This is
+     * useful for code that evaluates the material model once for every cell,
+     * but can not keep these objects alive between cells itself, e.g., the
+     * functions of postprocessors that are called once per cell. Creating
+     * the objects, and in particular their additional inputs and outputs,
+     * for every cell allocates dozens of vectors, whereas the objects of
+     * this class are only created once per thread and number of evaluation
+     * points, and are then reused for all later calls.
+     *
+     * Since the objects are reused, all inputs need to be set before every
+     * evaluation, e.g., with the reinit() functions of MaterialModelInputs.
+     * The outputs are reset to signaling NaNs by every call of get(), just
+     * like the outputs of a newly created MaterialModelOutputs object, and
+     * the additional outputs are reset by AdditionalMaterialOutputs::reset().
+     * Only if one of the additional outputs can not be reset in place, all
+     * additional inputs and outputs are deleted and attached again.
+     *
+     * Every thread gets its own objects, so the functions of this class can
+     * be called concurrently from several threads.
+     */
+    template <int dim>
+    class ScratchPool
+    {
+      public:
+        /**
+         * The material model inputs and outputs for one number of evaluation
+         * points.
+         */
+        struct Scratch
+        {
+          Scratch (const unsigned int n_points,
+                   const unsigned int n_comp);
+
+          MaterialModelInputs<dim> inputs;
+          MaterialModelOutputs<dim> outputs;
+        };
+
+        /**
+         * Constructor. @p initialize is called for every newly created
+         * Scratch object, and whenever its additional inputs and outputs
+         * were deleted because they could not be reset. It is the place to
+         * attach additional material model inputs and outputs, e.g., by
+         * calling MaterialModel::Interface::create_additional_named_outputs().
+         */
+        explicit ScratchPool (const std::function<void (Scratch &)> &initialize = std::function<void (Scratch &)>());
+
+        /**
+         * Return the objects of the current thread for @p n_points
+         * evaluation points and @p n_comp compositional fields, and create
+         * them the first time this function is called with these arguments
+         * on the current thread. All outputs of the returned object, including
+         * the additional outputs, are reset to the values of a newly created
+         * object.
+         */
+        Scratch &
+        get (const unsigned int n_points,
+             const unsigned int n_comp);
+
+        /**
+         * Delete all objects. This has to be called if the additional inputs
+         * and outputs need to be recreated, e.g., after the material model
+         * changed the additional outputs it provides.
+         */
+        void
+        clear ();
+
+      private:
+        /**
+         * The function that initializes newly created objects.
+         */
+        std::function<void (Scratch &)> initialize;
+
+        /**
+         * The objects of every thread, indexed by the number of evaluation
+         * points and the number of compositional fields.
+         */
+        Threads::ThreadLocalStorage<std::map<std::pair<unsigned int, unsigned int>, std::shared_ptr<Scratch> > > scratch;
+    };
+  }
+}
+
+#endif
@@ -305,6 +305,16 @@ namespace aspect
          */
         std::vector<std::unique_ptr<MaterialModel::MaterialUtilities::Lookup::PerplexReader> > material_lookup;
 
+        /**
+         * Average the values @p lookup_values of one property, which were
+         * looked up in each of the material files in material_lookup,
+         * according to @p compositional_fields, in the same way as the
+         * functions density(), specific_heat(), etc.
+         */
+        double
+        average_lookup_values (const std::vector<double> &lookup_values,
+                               const std::vector<double> &compositional_fields) const;
+
         /**
          * Pointer to an object that reads and processes data for the lateral
          * temperature dependency of viscosity.
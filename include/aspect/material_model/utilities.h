@@ -27,6 +27,9 @@
 #include <deal.II/fe/component_mask.h>
 #include <deal.II/base/signaling_nan.h>
 #include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/table.h>
+
+#include <array>
 
 namespace aspect
 {
@@ -50,10 +53,29 @@ namespace aspect
          * data source (e.g. a table in a file). The class consists of data members
          * and functions to access this data, but it does not contain the functions
          * to read this data, which has to be implemented in a derived class.
+         *
+         * All properties of one temperature-pressure point of the table are
+         * stored next to each other, so that looking up several properties
+         * at the same temperature and pressure, e.g. using evaluate_all(),
+         * only touches a few cache lines.
          */
         class MaterialLookup
         {
           public:
+            /**
+             * The indices of the properties stored in the table for every
+             * temperature-pressure point.
+             */
+            enum PropertyIndex
+            {
+              density_index,
+              thermal_expansivity_index,
+              specific_heat_index,
+              vp_index,
+              vs_index,
+              enthalpy_index,
+              n_properties
+            };
 
             double
             specific_heat(const double temperature,
@@ -118,6 +140,21 @@ namespace aspect
             dRhodp (const double temperature,
                     const double pressure) const;
 
+            /**
+             * Look up all properties of the table at the given
+             * @p temperatures and @p pressures, and store them in
+             * @p properties, indexed by point and PropertyIndex. The results
+             * are identical to calling the individual functions
+             * density(), thermal_expansivity(), specific_heat(), seismic_Vp(),
+             * seismic_Vs(), and enthalpy() for every point, but the position
+             * in the table and the interpolation weights are computed only once
+             * per point.
+             */
+            void
+            evaluate_all (const std::vector<double> &temperatures,
+                          const std::vector<double> &pressures,
+                          std::vector<std::array<double,n_properties> > &properties) const;
+
             /**
              * Returns the size of the data tables in pressure (first entry)
              * and temperature (second entry) dimensions.
@@ -127,18 +164,26 @@ namespace aspect
 
           protected:
             /**
-             * Access that data value of the property that is stored in table
-             * @p values at pressure @p pressure and temperature @p temperature.
-             * @p interpol controls whether to perform linear interpolation
-             * between the closest data points, or simply use the closest point
-             * value.
+             * Access that data value of the property with index
+             * @p property_index at pressure @p pressure and temperature
+             * @p temperature. @p interpol controls whether to perform linear
+             * interpolation between the closest data points, or simply use the
+             * closest point value.
              */
             double
             value (const double temperature,
                    const double pressure,
-                   const Table<2, double> &values,
+                   const unsigned int property_index,
                    const bool interpol) const;
 
+            /**
+             * Return whether the property with index @p property_index is
+             * interpolated between the data points, or taken from the closest
+             * data point.
+             */
+            bool
+            is_interpolated (const unsigned int property_index) const;
+
             /**
              * Find the position in a data table given a temperature.
              */
@@ -149,12 +194,39 @@ namespace aspect
              */
             double get_np(const double pressure) const;
 
-            dealii::Table<2,double> density_values;
-            dealii::Table<2,double> thermal_expansivity_values;
-            dealii::Table<2,double> specific_heat_values;
-            dealii::Table<2,double> vp_values;
-            dealii::Table<2,double> vs_values;
-            dealii::Table<2,double> enthalpy_values;
+            /**
+             * Return a reference to the value of one property at the
+             * temperature index @p i and the pressure index @p j of
+             * property_values. These functions take the place of the separate
+             * tables density_values, thermal_expansivity_values, etc. that
+             * derived classes used before all properties were stored in
+             * property_values, so that reading or writing single values, e.g.
+             * <code>density_values(i,j) = rho</code>, still works.
+             * property_values has to be initialized before they are called.
+             *
+             * @{
+             */
+            double &density_values (const unsigned int i, const unsigned int j);
+            double density_values (const unsigned int i, const unsigned int j) const;
+            double &thermal_expansivity_values (const unsigned int i, const unsigned int j);
+            double thermal_expansivity_values (const unsigned int i, const unsigned int j) const;
+            double &specific_heat_values (const unsigned int i, const unsigned int j);
+            double specific_heat_values (const unsigned int i, const unsigned int j) const;
+            double &vp_values (const unsigned int i, const unsigned int j);
+            double vp_values (const unsigned int i, const unsigned int j) const;
+            double &vs_values (const unsigned int i, const unsigned int j);
+            double vs_values (const unsigned int i, const unsigned int j) const;
+            double &enthalpy_values (const unsigned int i, const unsigned int j);
+            double enthalpy_values (const unsigned int i, const unsigned int j) const;
+            /**
+             * @}
+             */
+
+            /**
+             * The values of all properties, indexed by temperature, pressure,
+             * and PropertyIndex.
+             */
+            dealii::Table<3,double> property_values;
 
             double delta_press;
             double min_press;
@@ -52,6 +52,8 @@ namespace aspect
 
         std::vector<double> get_nth_output(const unsigned int idx) const override;
 
+        bool reset () override;
+
         /**
          * Cohesions at the evaluation points passed to
          * the instance of MaterialModel::Interface::evaluate() that fills
@@ -272,6 +274,17 @@ namespace aspect
         bool
         is_yielding (const MaterialModelInputs<dim> &in) const;
 
+        /**
+         * A function that computes for every evaluation point in @p in whether
+         * the material is plastically yielding, in the same way as the function
+         * above does for a single point, and stores the results in
+         * @p plastic_yielding. Without elasticity, the viscosities of all
+         * points are computed at once by the vectorized rheology kernels.
+         */
+        void
+        is_yielding (const MaterialModelInputs<dim> &in,
+                     std::vector<bool> &plastic_yielding) const;
+
       private:
 
         double min_strain_rate;
@@ -330,6 +343,24 @@ namespace aspect
                                           const ViscosityScheme &viscous_type,
                                           const YieldScheme &yield_type) const;
 
+        /**
+         * Compute the same viscosities and yielding flags as
+         * calculate_isostrain_viscosities(), but for all points in @p in
+         * at once. The rheology kernels are evaluated for batches of
+         * VectorizedArray<double>::size() points, with one point per lane.
+         * Upon return, @p composition_viscosities and @p composition_yielding
+         * hold the results for every point, indexed by point and composition.
+         *
+         * This function does not support elasticity, which requires the
+         * stresses of the previous time step of each point.
+         */
+        void
+        calculate_isostrain_viscosities_vectorized (const MaterialModel::MaterialModelInputs<dim> &in,
+                                                    const ViscosityScheme &viscous_type,
+                                                    const YieldScheme &yield_type,
+                                                    std::vector<std::vector<double> > &composition_viscosities,
+                                                    std::vector<std::vector<bool> > &composition_yielding) const;
+
 
         /**
          * A function that fills the plastic additional output in the
@@ -108,6 +108,14 @@ namespace aspect
          */
         void parse_parameters (ParameterHandler &prm) override;
 
+        /**
+         * Return the stabilization parameter for the free surface. This is
+         * used by the matrix-free Stokes solver, which applies the
+         * stabilization term inside its operators instead of through an
+         * assembler.
+         */
+        double get_stabilization_theta () const;
+
       private:
         /**
          * Project the Stokes velocity solution onto the
@@ -37,6 +37,10 @@
 #endif
 
 #include <deal.II/base/index_set.h>
+#include <deal.II/fe/mapping.h>
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/multigrid/mg_level_object.h>
+#include <deal.II/multigrid/mg_transfer_matrix_free.h>
 
 
 namespace aspect
@@ -244,6 +248,28 @@ namespace aspect
         const LinearAlgebra::Vector &
         get_mesh_displacements () const;
 
+        /**
+         * Return the mapping that describes the deformed mesh on the
+         * given multigrid @p level. The level mappings are only available
+         * if the matrix-free GMG Stokes solver is used, because this is
+         * the only place where ASPECT needs geometry information on
+         * multigrid levels.
+         */
+        const Mapping<dim> &
+        get_level_mapping (const unsigned int level) const;
+
+        /**
+         * Interpolate the current mesh displacements to all multigrid
+         * levels, so that the mappings returned by get_level_mapping()
+         * describe the current shape of the mesh. This needs to be called
+         * whenever the mesh displacements change, e.g., after the mesh
+         * deformation was executed, after mesh refinement, or after
+         * resuming from a checkpoint. This function does nothing if the
+         * matrix-free GMG Stokes solver is not used.
+         */
+        void
+        update_multilevel_deformation ();
+
         /**
          * Go through the list of all mesh deformation objects that have been selected
          * in the input file (and are consequently currently active) and return
@@ -351,6 +377,29 @@ namespace aspect
          */
         LinearAlgebra::Vector mesh_displacements;
 
+        /**
+         * The mesh displacements interpolated to each of the multigrid
+         * levels. These vectors are only filled if the matrix-free GMG
+         * Stokes solver is used, and are used to describe the deformed
+         * mesh in the level mappings.
+         */
+        MGLevelObject<dealii::LinearAlgebra::distributed::Vector<double> > level_displacements;
+
+        /**
+         * The transfer operator that interpolates the mesh displacements to
+         * the multigrid levels, and a copy of the mesh displacements in the
+         * vector type it works on. Both are set up in setup_dofs() whenever
+         * the mesh changes and are reused by update_multilevel_deformation().
+         */
+        MGTransferMatrixFree<dim,double> level_displacement_transfer;
+        dealii::LinearAlgebra::distributed::Vector<double> distributed_mesh_displacements;
+
+        /**
+         * One mapping per multigrid level that describes the deformed
+         * mesh on that level. See get_level_mapping().
+         */
+        MGLevelObject<std::unique_ptr<Mapping<dim> > > level_mappings;
+
         /**
          * Vector for storing the mesh velocity in the mesh deformation finite
          * element space, which is, in general, not the same finite element
@@ -423,10 +472,8 @@ namespace aspect
     bool
     MeshDeformationHandler<dim>::has_matching_postprocessor () const
     {
-      for (typename std::map<types::boundary_id, std::vector<std::unique_ptr<Interface<dim> > > >::iterator boundary_id
-           = mesh_deformation_objects_map.begin();
-           boundary_id != mesh_deformation_objects_map.end(); ++boundary_id)
-        for (const auto &p : boundary_id->second)
+      for (const auto &boundary_id_and_objects : mesh_deformation_objects_map)
+        for (const auto &p : boundary_id_and_objects.second)
           if (Plugins::plugin_type_matches<MeshDeformationType>(*p))
             return true;
 
@@ -447,20 +494,13 @@ namespace aspect
                              "that could not be found in the current model. Activate this "
                              "mesh deformation in the input file."));
 
-      for (typename std::map<types::boundary_id, std::vector<std::unique_ptr<Interface<dim> > > >::iterator boundary_id
-           = mesh_deformation_objects_map.begin();
-           boundary_id != mesh_deformation_objects_map.end(); ++boundary_id)
-        {
-          typename std::vector<std::unique_ptr<Interface<dim> > >::const_iterator mesh_def;
-          for (const auto &p : boundary_id->second)
-            {
-              if (Plugins::plugin_type_matches<MeshDeformationType>(*p))
-                return Plugins::get_plugin_as_type<MeshDeformationType>(*p);
-              else
-                // We will never get here, because we had the Assert above. Just to avoid warnings.
-                return Plugins::get_plugin_as_type<MeshDeformationType>(*(*mesh_def));
-            }
-        }
+      for (const auto &boundary_id_and_objects : mesh_deformation_objects_map)
+        for (const auto &p : boundary_id_and_objects.second)
+          if (Plugins::plugin_type_matches<MeshDeformationType>(*p))
+            return Plugins::get_plugin_as_type<MeshDeformationType>(*p);
+
+      // We will never get here, because we had the Assert above. Just to avoid warnings.
+      return Plugins::get_plugin_as_type<MeshDeformationType>(*(mesh_deformation_objects_map.begin()->second.front()));
     }
 
 
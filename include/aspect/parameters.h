@@ -455,6 +455,8 @@ namespace aspect
 
     // subsection: Advection solver parameters
     unsigned int                   advection_gmres_restart_length;
+    bool                           use_matrix_free_advection_solver;
+    bool                           reuse_matrix_for_identical_compositional_fields;
 
     // subsection: Stokes solver parameters
     bool                           use_direct_stokes_solver;
@@ -621,6 +623,7 @@ namespace aspect
     unsigned int                   composition_degree;
     std::string                    pressure_normalization;
     MaterialModel::MaterialAveraging::AveragingOperation material_averaging;
+    bool                           cache_material_model_outputs;
 
     /**
      * @}
@@ -0,0 +1,171 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _aspect_particle_cell_property_arrays_h
+#define _aspect_particle_cell_property_arrays_h
+
+#include <aspect/global.h>
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/array_view.h>
+#include <deal.II/fe/component_mask.h>
+#include <deal.II/particles/particle_handler.h>
+
+namespace aspect
+{
+  namespace Particle
+  {
+    using namespace dealii;
+    using namespace dealii::Particles;
+
+    /**
+     * A structure-of-arrays copy of the properties of all particles in one
+     * cell. deal.II stores the properties of every particle contiguously,
+     * i.e., all properties of one particle follow each other in memory.
+     * Algorithms that work on one property of all particles in a cell, like
+     * the averaging of a property in a cell, therefore access memory with a
+     * stride and through one iterator per particle. This class instead
+     * copies each selected property of all particles in a cell into one
+     * contiguous array, which allows to stream over the values of a
+     * property with unit stride and to vectorize such loops. Modified
+     * values can be copied back into the particles by
+     * write_properties().
+     *
+     * @ingroup Particle
+     */
+    template <int dim>
+    class CellPropertyArrays
+    {
+      public:
+        /**
+         * Constructor. Creates an empty object.
+         */
+        CellPropertyArrays ();
+
+        /**
+         * Copy the properties selected by @p selected_properties of all
+         * particles in @p particles into the arrays of this object. The
+         * particles are numbered in the order of the range. The memory of
+         * this object is reused if the object is reinitialized for another
+         * cell.
+         */
+        void
+        reinit (const typename ParticleHandler<dim>::particle_iterator_range &particles,
+                const ComponentMask &selected_properties);
+
+        /**
+         * Return the number of particles this object was initialized with.
+         */
+        unsigned int
+        n_particles () const;
+
+        /**
+         * Return a view to the contiguous array of the values of the
+         * property with index @p property_index for all particles. The
+         * property needs to have been selected in the last call to
+         * reinit().
+         */
+        ArrayView<const double>
+        get_property_values (const unsigned int property_index) const;
+
+        /**
+         * Return a writable view to the contiguous array of the values of
+         * the property with index @p property_index for all particles. The
+         * property needs to have been selected in the last call to
+         * reinit(). Changes only become visible in the particles after a
+         * call to write_properties().
+         */
+        ArrayView<double>
+        get_property_values (const unsigned int property_index);
+
+        /**
+         * Copy the values of all selected properties back into the
+         * particles in @p particles, which need to be the same particles in
+         * the same order as in the last call to reinit().
+         */
+        void
+        write_properties (const typename ParticleHandler<dim>::particle_iterator_range &particles) const;
+
+      private:
+        /**
+         * The number of particles in the cell.
+         */
+        unsigned int n_particles_in_cell;
+
+        /**
+         * The indices of the selected properties within the properties of
+         * a particle, and for every property the index of its array within
+         * property_values, or numbers::invalid_unsigned_int if the property
+         * was not selected.
+         */
+        std::vector<unsigned int> selected_property_indices;
+        std::vector<unsigned int> array_index;
+
+        /**
+         * The values of the selected properties. The values of the property
+         * with array index $a$ are stored for all particles in the entries
+         * starting at $a \cdot$ n_particles_in_cell.
+         */
+        AlignedVector<double> property_values;
+    };
+
+
+
+    template <int dim>
+    inline
+    unsigned int
+    CellPropertyArrays<dim>::n_particles () const
+    {
+      return n_particles_in_cell;
+    }
+
+
+
+    template <int dim>
+    inline
+    ArrayView<const double>
+    CellPropertyArrays<dim>::get_property_values (const unsigned int property_index) const
+    {
+      AssertIndexRange (property_index, array_index.size());
+      Assert (array_index[property_index] != numbers::invalid_unsigned_int,
+              ExcMessage ("The requested particle property was not selected "
+                          "when this object was initialized."));
+      return ArrayView<const double>(property_values.begin() + array_index[property_index] * n_particles_in_cell,
+                                     n_particles_in_cell);
+    }
+
+
+
+    template <int dim>
+    inline
+    ArrayView<double>
+    CellPropertyArrays<dim>::get_property_values (const unsigned int property_index)
+    {
+      AssertIndexRange (property_index, array_index.size());
+      Assert (array_index[property_index] != numbers::invalid_unsigned_int,
+              ExcMessage ("The requested particle property was not selected "
+                          "when this object was initialized."));
+      return ArrayView<double>(property_values.begin() + array_index[property_index] * n_particles_in_cell,
+                               n_particles_in_cell);
+    }
+  }
+}
+
+#endif
@@ -25,8 +25,12 @@
 #include <aspect/simulator_access.h>
 
 #include <deal.II/particles/particle.h>
+#include <deal.II/base/bounding_box.h>
 #include <deal.II/base/parameter_handler.h>
 #include <deal.II/base/exceptions.h>
+#include <deal.II/grid/grid_tools_cache.h>
+
+#include <boost/signals2/connection.hpp>
 
 DEAL_II_DISABLE_EXTRA_DIAGNOSTICS
 #include <boost/random.hpp>
@@ -156,6 +160,46 @@ namespace aspect
            * initialized in the constructor with a constant.
            */
           boost::mt19937            random_number_generator;
+
+        private:
+          /**
+           * Compute local_bounding_boxes for the current mesh.
+           */
+          void
+          compute_local_bounding_boxes () const;
+
+          /**
+           * A cache of the geometric information of the mesh, in particular
+           * a spatial index of its vertices, that generate_particle() uses to
+           * find the cell around a position without searching all cells.
+           * The cache is updated automatically when the mesh changes.
+           */
+          std::unique_ptr<GridTools::Cache<dim> > grid_cache;
+
+          /**
+           * A small number of boxes that cover all locally owned cells,
+           * enlarged by the diameter of the largest locally owned cell to
+           * also cover curved cells. Positions outside of these boxes are
+           * rejected by generate_particle() without searching the mesh,
+           * which is the case for most positions if the generator creates
+           * the same positions on all processes. The boxes are computed the
+           * first time they are needed after the mesh changed.
+           */
+          mutable std::vector<BoundingBox<dim> > local_bounding_boxes;
+          mutable bool local_bounding_boxes_are_valid;
+
+          /**
+           * The cell the last particle was generated in. Many generators
+           * create neighboring positions one after the other, so the search
+           * for the cell around the next position starts here.
+           */
+          mutable typename Triangulation<dim>::active_cell_iterator last_cell;
+
+          /**
+           * The connection to the signal of the triangulation that
+           * invalidates the data above when the mesh changes.
+           */
+          boost::signals2::connection mesh_changed_connection;
       };
 
       /**
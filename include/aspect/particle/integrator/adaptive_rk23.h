@@ -0,0 +1,247 @@
+/*
+ Copyright (C) 2020 by the authors of the ASPECT code.
+
+ This file is part of ASPECT.
+
+ ASPECT is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ ASPECT is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with ASPECT; see the file LICENSE.  If not see
+ <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _aspect_particle_integrator_adaptive_rk23_h
+#define _aspect_particle_integrator_adaptive_rk23_h
+
+#include <aspect/particle/integrator/interface.h>
+
+#include <aspect/simulator_access.h>
+
+#include <array>
+#include <mutex>
+
+namespace aspect
+{
+  namespace Particle
+  {
+    namespace Integrator
+    {
+      /**
+       * Adaptive Runge Kutta integrator based on the embedded third order
+       * scheme of Bogacki and Shampine. Every particle moves through the
+       * time step in its own sequence of substeps. After each substep, the
+       * difference between the third order and the embedded second order
+       * solution estimates the error of the trajectory, which grows with
+       * the variation of the velocity along the path of the particle. If
+       * this error is larger than the allowed fraction of the distance the
+       * particle moved in the substep, the substep is repeated with a
+       * smaller length; otherwise the next substep is enlarged. The length
+       * of the last substep of each particle is kept as the initial
+       * substep length in the next time step.
+       *
+       * Each stage of a substep requires the velocity at a new particle
+       * position, and therefore one integration step, i.e. one sweep over
+       * all particles. Particles that have finished the time step remain in
+       * place while other particles still take substeps, and the
+       * integration continues until all particles on all processes have
+       * reached the end of the time step. Every time step takes at least
+       * four integration steps: the three stages of the first substep and
+       * one more, because the error estimate requires the velocity at the
+       * new position. This velocity is reused as the first stage of the
+       * next substep, so every further or repeated substep adds three
+       * integration steps. Particles in smooth flow can finish the time
+       * step after the first substep.
+       *
+       * This scheme requires storing the start location of the current
+       * substep, the intermediate velocities, and the progress of every
+       * particle, so the read/write_data functions reflect this.
+       *
+       * @ingroup ParticleIntegrators
+       */
+      template <int dim>
+      class AdaptiveRK23 : public Interface<dim>, public SimulatorAccess<dim>
+      {
+        public:
+          AdaptiveRK23();
+
+          /**
+           * Perform one stage of the current substep of all particles of
+           * one cell, or, for particles that have finished the current
+           * time step, do nothing.
+           *
+           * @param [in] begin_particle An iterator to the first particle to be moved.
+           * @param [in] end_particle An iterator to the last particle to be moved.
+           * @param [in] old_velocities The velocities at t_n, i.e. before the
+           * particle movement, for all particles between @p begin_particle
+           * and @p end_particle at their current position.
+           * @param [in] velocities The velocities at the particle positions
+           * at t_{n+1}, i.e. after the particle movement. Note that this is
+           * the velocity at the old positions, but at the new time. Velocities
+           * at times in between are interpolated linearly.
+           * @param [in] dt The length of the integration timestep.
+           */
+          void
+          local_integrate_step(const typename ParticleHandler<dim>::particle_iterator &begin_particle,
+                               const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                               const std::vector<Tensor<1,dim> > &old_velocities,
+                               const std::vector<Tensor<1,dim> > &velocities,
+                               const double dt) override;
+
+          /**
+           * This function is called at the end of every integration step.
+           * It returns true as long as any particle on any process has not
+           * yet reached the end of the time step.
+           *
+           * @return This function returns true if the integrator requires
+           * another integration step. The particle integration will continue
+           * to start new integration steps until this function returns false.
+           */
+          bool new_integration_step() override;
+
+          /**
+           * Return data length of the integration related data required for
+           * communication in terms of number of bytes. When data about
+           * particles is transported from one processor to another, or stored
+           * on disk for snapshots, integrators get the chance to store
+           * whatever information they need with each particle. This function
+           * returns how many pieces of additional information a concrete
+           * integrator class needs to store for each particle.
+           *
+           * @return The number of bytes required to store the relevant
+           * integrator data for one particle.
+           */
+          std::size_t get_data_size() const override;
+
+          /**
+           * @copydoc Interface::read_data()
+           */
+          const void *
+          read_data(const typename ParticleHandler<dim>::particle_iterator &particle,
+                    const void *data) override;
+
+          /**
+           * @copydoc Interface::write_data()
+           */
+          void *
+          write_data(const typename ParticleHandler<dim>::particle_iterator &particle,
+                     void *data) const override;
+
+          /**
+           * Declare the parameters this class takes through input files.
+           */
+          static
+          void
+          declare_parameters (ParameterHandler &prm);
+
+          /**
+           * Read the parameters this class declares from the parameter file.
+           */
+          void
+          parse_parameters (ParameterHandler &prm) override;
+
+        private:
+          /**
+           * The integration state of one particle.
+           */
+          struct ParticleState
+          {
+            /**
+             * The location of the particle at the start of the current
+             * substep.
+             */
+            Point<dim> start_location;
+
+            /**
+             * The velocities at the first three stages of the current
+             * substep.
+             */
+            std::array<Tensor<1,dim>,3> stage_velocities;
+
+            /**
+             * The fraction of the time step the particle has already
+             * advanced, and the length of the current substep as a fraction
+             * of the time step.
+             */
+            double time_fraction;
+            double substep_fraction;
+
+            /**
+             * The stage of the current substep whose velocity is evaluated
+             * next, or finished_stage if the particle has reached the end of
+             * the time step.
+             */
+            unsigned int stage;
+          };
+
+          /**
+           * The value of ParticleState::stage for particles that have
+           * finished the current time step.
+           */
+          static const unsigned int finished_stage = 4;
+
+          /**
+           * Perform one stage of the current substep of @p particle, whose
+           * state is @p state, given the velocities at the current location
+           * of the particle at the old and new time.
+           */
+          void
+          integrate_particle (const typename ParticleHandler<dim>::particle_iterator &particle,
+                              ParticleState &state,
+                              const Tensor<1,dim> &old_velocity,
+                              const Tensor<1,dim> &velocity,
+                              const double dt) const;
+
+          /**
+           * The number of integration steps in the current time step.
+           */
+          unsigned int integrator_substep;
+
+          /**
+           * The integration state of all particles in the current time
+           * step. The states of the previous time step are kept in
+           * previous_particle_states to initialize the substep length of
+           * each particle in the first integration step.
+           */
+          std::map<types::particle_index, ParticleState> particle_states;
+          std::map<types::particle_index, ParticleState> previous_particle_states;
+
+          /**
+           * The number of locally owned particles that have not finished
+           * the current time step after the last integration step.
+           */
+          unsigned int n_unfinished_particles;
+
+          /**
+           * A mutex that protects the maps and the counter above from being
+           * modified concurrently, since local_integrate_step() is called
+           * for different cells at the same time.
+           */
+          std::mutex data_mutex;
+
+          /**
+           * The allowed error of the trajectory in one substep, relative to
+           * the distance the particle moved in this substep.
+           */
+          double relative_tolerance;
+
+          /**
+           * The smallest allowed substep length as a fraction of the time
+           * step. Substeps of this length are accepted regardless of their
+           * error, which bounds the number of integration steps.
+           */
+          double minimum_substep_fraction;
+      };
+
+    }
+  }
+}
+
+#endif
@@ -71,6 +71,11 @@ namespace aspect
            * responsibility of this function to compute the new location of
            * the particles.
            * @param [in] dt The length of the integration timestep.
+           *
+           * This function is called concurrently for the particles of
+           * different cells and therefore needs to be thread-safe. In
+           * particular, data that is stored for all particles of the
+           * process needs to be protected against concurrent modification.
            */
           virtual
           void
@@ -25,6 +25,8 @@
 
 #include <aspect/simulator_access.h>
 
+#include <mutex>
+
 
 namespace aspect
 {
@@ -122,6 +124,13 @@ namespace aspect
            */
           std::map<types::particle_index, Point<dim> >   loc0;
 
+          /**
+           * A mutex that protects the maps above from being modified
+           * concurrently, since local_integrate_step() is called for
+           * different cells at the same time.
+           */
+          std::mutex data_mutex;
+
       };
 
     }
@@ -23,6 +23,8 @@
 
 #include <aspect/particle/integrator/interface.h>
 
+#include <mutex>
+
 namespace aspect
 {
   namespace Particle
@@ -128,6 +130,13 @@ namespace aspect
            */
           std::map<types::particle_index, Tensor<1,dim> > k1, k2, k3;
 
+          /**
+           * A mutex that protects the maps above from being modified
+           * concurrently, since local_integrate_step() is called for
+           * different cells at the same time.
+           */
+          std::mutex data_mutex;
+
       };
     }
   }
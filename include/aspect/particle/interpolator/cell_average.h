@@ -22,8 +22,11 @@
 #define _aspect_particle_interpolator_cell_average_h
 
 #include <aspect/particle/interpolator/interface.h>
+#include <aspect/particle/cell_property_arrays.h>
 #include <aspect/simulator_access.h>
 
+#include <deal.II/base/thread_local_storage.h>
+
 namespace aspect
 {
   namespace Particle
@@ -72,6 +75,14 @@ namespace aspect
            * in which case the interpolator will return 0 for the cell's properties.
            */
           bool allow_cells_without_particles;
+
+          /**
+           * The contiguous copies of the particle properties of the current
+           * cell. Every thread reuses its own object for all cells, so that
+           * the arrays are only allocated when a cell contains more particles
+           * than all previous ones.
+           */
+          mutable Threads::ThreadLocalStorage<CellPropertyArrays<dim> > property_arrays;
       };
     }
   }
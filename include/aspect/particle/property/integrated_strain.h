@@ -59,14 +59,13 @@ namespace aspect
                                             std::vector<double> &particle_properties) const override;
 
           /**
-          * @copydoc aspect::Particle::Property::Interface::update_particle_property()
+          * @copydoc aspect::Particle::Property::Interface::update_particle_properties()
           **/
-          virtual
           void
-          update_particle_property (const unsigned int data_position,
-                                    const Vector<double> &solution,
-                                    const std::vector<Tensor<1,dim> > &gradients,
-                                    typename ParticleHandler<dim>::particle_iterator &particle) const;
+          update_particle_properties (const unsigned int data_position,
+                                      const ArrayView<const double> &solution,
+                                      const ArrayView<const Tensor<1,dim> > &gradients,
+                                      typename ParticleHandler<dim>::particle_iterator_range &particles) const override;
 
           /**
            * This implementation tells the particle manager that
@@ -354,6 +354,9 @@ namespace aspect
            * the call of this function. The particle location can be accessed
            * using particle->get_location() and its properties using
            * particle->get_properties().
+           *
+           * This function is called concurrently for the particles of
+           * different cells and therefore needs to be thread-safe.
            */
           virtual
           void
@@ -362,6 +365,50 @@ namespace aspect
                                     const std::vector<Tensor<1,dim> > &gradients,
                                     typename ParticleHandler<dim>::particle_iterator &particle) const;
 
+          /**
+           * Update function. This function is called every time an update is
+           * request by need_update() once for all particles of a cell for
+           * every property. The interface provides a default implementation
+           * that calls update_particle_property() for every particle of the
+           * cell. Plugins whose update is expensive should instead implement
+           * this function, which allows them to set up temporary objects and
+           * to compute quantities that are the same for all particles only
+           * once per cell, and avoids one virtual function call per particle.
+           *
+           * @param [in] data_position An unsigned integer that denotes which
+           * component of the particle property vector is associated with the
+           * current property. For properties that own several components it
+           * denotes the first component of this property, all other components
+           * fill consecutive entries in the properties of each particle.
+           *
+           * @param [in] solution The values of the solution variables at the
+           * positions of the particles in @p particles, stored contiguously
+           * particle by particle: the value of solution component @p c at
+           * the @p i-th particle of @p particles is
+           * <code>solution[i*n_components+c]</code>, where
+           * <code>n_components</code> is the number of components of the
+           * finite element, i.e., <code>solution.size()</code> divided by
+           * the number of particles.
+           *
+           * @param [in] gradients The gradients of the solution variables at
+           * the positions of the particles in @p particles, stored in the
+           * same order as @p solution.
+           *
+           * @param [in,out] particles The particles of one cell that are
+           * updated within the call of this function. The particle locations
+           * can be accessed using particle->get_location() and their properties
+           * using particle->get_properties().
+           *
+           * This function is called concurrently for different cells and
+           * therefore needs to be thread-safe.
+           */
+          virtual
+          void
+          update_particle_properties (const unsigned int data_position,
+                                      const ArrayView<const double> &solution,
+                                      const ArrayView<const Tensor<1,dim> > &gradients,
+                                      typename ParticleHandler<dim>::particle_iterator_range &particles) const;
+
           /**
            * Update function. This function is called every time an update is
            * request by need_update() for every particle for every property.
@@ -549,6 +596,20 @@ namespace aspect
                                const Vector<double> &solution,
                                const std::vector<Tensor<1,dim> > &gradients) const;
 
+          /**
+           * Update function for particle properties. This function is
+           * called once every time step for all particles of a cell, and
+           * calls update_particle_properties() of every property plugin
+           * once. @p solution and @p gradients contain the values and
+           * gradients of all solution components at the positions of the
+           * particles in @p particles, stored particle by particle as
+           * described in Interface::update_particle_properties().
+           */
+          void
+          update_particles (typename ParticleHandler<dim>::particle_iterator_range &particles,
+                            const ArrayView<const double> &solution,
+                            const ArrayView<const Tensor<1,dim> > &gradients) const;
+
           /**
            * Returns an enum, which denotes at what time this class needs to
            * update particle properties. The result of this class is a
@@ -0,0 +1,308 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _aspect_particle_solution_evaluator_h
+#define _aspect_particle_solution_evaluator_h
+
+#include <aspect/global.h>
+
+#include <deal.II/base/array_view.h>
+#include <deal.II/base/polynomial.h>
+#include <deal.II/base/table.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/component_mask.h>
+#include <deal.II/fe/fe.h>
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/fe/mapping.h>
+#include <deal.II/particles/particle_handler.h>
+
+namespace aspect
+{
+  namespace Particle
+  {
+    using namespace dealii;
+
+    namespace internal
+    {
+      /**
+       * A class that evaluates the solution and its gradients at the
+       * positions of the particles in one cell, given in the coordinates of
+       * the reference cell.
+       *
+       * Using an FEValues object for this purpose requires to create a new
+       * object with a new quadrature formula for every cell, which
+       * recomputes all shape functions of the whole finite element at all
+       * particle positions and all mapping data. This class instead is
+       * created once (per thread) and reused for all cells. For base elements
+       * whose shape functions are tensor products of one-dimensional
+       * Lagrange polynomials (FE_Q and FE_DGQ), only the one-dimensional
+       * polynomials are evaluated at the coordinates of each particle, and
+       * the solution is evaluated by sum factorization. The shape function
+       * data is computed once per cell for every base element, and is shared
+       * by all components of the base element and by all solution vectors
+       * that are evaluated on this cell. For other base elements (e.g.,
+       * FE_DGP), the shape functions are evaluated directly.
+       *
+       * If gradients are requested, the Jacobian of the mapping at every
+       * particle position is computed from the mapped support points of the
+       * mapping in the same way. This is supported for the mappings used in
+       * ASPECT, i.e., MappingCartesian, MappingQ, and MappingQGeneric and the
+       * classes derived from them.
+       */
+      template <int dim>
+      class SolutionEvaluator
+      {
+        public:
+          /**
+           * Constructor. The evaluator computes the components of the
+           * finite element @p fe that are selected by @p evaluated_components,
+           * and their values and/or gradients depending on whether
+           * @p update_flags contains update_values and/or update_gradients.
+           */
+          SolutionEvaluator (const Mapping<dim> &mapping,
+                             const FiniteElement<dim> &fe,
+                             const ComponentMask &evaluated_components,
+                             const UpdateFlags update_flags);
+
+          /**
+           * Copy constructor. Creates a new object with the same settings
+           * as @p evaluator, which does not share any data with it. This
+           * allows to use an object of this class as the exemplar of a
+           * Threads::ThreadLocalStorage object.
+           */
+          SolutionEvaluator (const SolutionEvaluator<dim> &evaluator);
+
+          /**
+           * Prepare the evaluation of the solution at the points
+           * @p reference_positions, given in the coordinates of the
+           * reference cell, in @p cell.
+           */
+          void
+          reinit (const typename DoFHandler<dim>::active_cell_iterator &cell,
+                  const std::vector<Point<dim> > &reference_positions);
+
+          /**
+           * Prepare the evaluation of the solution at the reference
+           * locations of the particles in @p particles, which all need to be
+           * located in @p cell.
+           */
+          void
+          reinit (const typename DoFHandler<dim>::active_cell_iterator &cell,
+                  const typename Particles::ParticleHandler<dim>::particle_iterator_range &particles);
+
+          /**
+           * Evaluate the selected components of @p solution at all points
+           * given to the last call of reinit(). The results can be queried
+           * by get_value() and get_gradient(). This function can be called
+           * several times for different solution vectors between two calls
+           * to reinit().
+           */
+          void
+          evaluate (const LinearAlgebra::BlockVector &solution);
+
+          /**
+           * Return the value of the component @p component of the solution
+           * at the point with index @p point, as computed by the last call to
+           * evaluate().
+           */
+          double
+          get_value (const unsigned int point,
+                     const unsigned int component) const;
+
+          /**
+           * Return the gradient of the component @p component of the
+           * solution at the point with index @p point, as computed by the
+           * last call to evaluate().
+           */
+          const Tensor<1,dim> &
+          get_gradient (const unsigned int point,
+                        const unsigned int component) const;
+
+          /**
+           * Return the values of all components at all points, as computed
+           * by the last call to evaluate(), stored point by point: the value
+           * of component @p c at point @p q is the entry
+           * <code>q*fe.n_components()+c</code>. Entries of components that
+           * are not evaluated, or of all components if values were not
+           * requested in the constructor, are zero.
+           */
+          ArrayView<const double>
+          get_values () const;
+
+          /**
+           * Return the gradients of all components at all points, in the
+           * same order as get_values().
+           */
+          ArrayView<const Tensor<1,dim> >
+          get_gradients () const;
+
+        private:
+          /**
+           * Compute the shape function and mapping data for the points
+           * stored in #points in @p cell. Called by the reinit() functions.
+           */
+          void
+          reinit_points (const typename DoFHandler<dim>::active_cell_iterator &cell);
+
+          /**
+           * The data that describes the shape functions of one base element
+           * of the finite element at the current points.
+           */
+          struct BaseElementData
+          {
+            /**
+             * Whether the shape functions of the base element are tensor
+             * products of the polynomials in polynomials_1d, with the
+             * shape function with index i in the base element corresponding
+             * to the tensor product with the lexicographic index
+             * lexicographic_numbering[i].
+             */
+            bool is_tensor_product;
+            std::vector<Polynomials::Polynomial<double> > polynomials_1d;
+            std::vector<unsigned int> lexicographic_numbering;
+
+            /**
+             * Whether any component of this base element is evaluated.
+             */
+            bool is_evaluated;
+
+            /**
+             * For tensor product elements: The values and derivatives of
+             * the one-dimensional polynomials at the coordinates of each
+             * point, indexed by point, coordinate direction, and polynomial.
+             */
+            Table<3,double> values_1d;
+            Table<3,double> derivatives_1d;
+
+            /**
+             * For all other elements: The values and gradients on the
+             * reference cell of all shape functions at each point, indexed
+             * by point and shape function.
+             */
+            Table<2,double> shape_values;
+            Table<2,Tensor<1,dim> > shape_gradients;
+          };
+
+          /**
+           * Compute the values and derivatives of the one-dimensional
+           * @p polynomials at the coordinates of the current points, and
+           * store them in @p values_1d and @p derivatives_1d.
+           */
+          void
+          evaluate_polynomials_1d (const std::vector<Polynomials::Polynomial<double> > &polynomials,
+                                   Table<3,double> &values_1d,
+                                   Table<3,double> &derivatives_1d) const;
+
+          const Mapping<dim> &mapping;
+          const FiniteElement<dim> &fe;
+          const ComponentMask evaluated_components;
+          const UpdateFlags update_flags;
+
+          std::vector<BaseElementData> base_element_data;
+
+          /**
+           * If gradients are computed: The one-dimensional Lagrange
+           * polynomials that describe the mapping, an FEValues object that
+           * computes the mapped support points of the mapping on every cell,
+           * and the values and derivatives of the polynomials at the current
+           * points.
+           */
+          std::vector<Polynomials::Polynomial<double> > mapping_polynomials_1d;
+          std::unique_ptr<FEValues<dim> > mapping_support_points;
+          Table<3,double> mapping_values_1d;
+          Table<3,double> mapping_derivatives_1d;
+
+          /**
+           * Data of the current cell and points.
+           */
+          std::vector<types::global_dof_index> local_dof_indices;
+          std::vector<Point<dim> > points;
+          std::vector<Tensor<2,dim> > jacobians;
+          std::vector<Tensor<2,dim> > inverse_jacobians;
+
+          /**
+           * Scratch array for the coefficients of one component, in the
+           * numbering of the tensor product polynomials.
+           */
+          std::vector<double> coefficients;
+
+          /**
+           * The results of the last call to evaluate(), indexed by point
+           * and component.
+           */
+          Table<2,double> values;
+          Table<2,Tensor<1,dim> > gradients;
+      };
+
+
+
+      template <int dim>
+      inline
+      double
+      SolutionEvaluator<dim>::get_value (const unsigned int point,
+                                         const unsigned int component) const
+      {
+        AssertIndexRange (point, values.size(0));
+        Assert (evaluated_components[component] == true,
+                ExcMessage ("This component is not evaluated by this object."));
+        return values(point, component);
+      }
+
+
+
+      template <int dim>
+      inline
+      const Tensor<1,dim> &
+      SolutionEvaluator<dim>::get_gradient (const unsigned int point,
+                                            const unsigned int component) const
+      {
+        AssertIndexRange (point, gradients.size(0));
+        Assert (evaluated_components[component] == true,
+                ExcMessage ("This component is not evaluated by this object."));
+        return gradients(point, component);
+      }
+
+
+
+      template <int dim>
+      inline
+      ArrayView<const double>
+      SolutionEvaluator<dim>::get_values () const
+      {
+        return ArrayView<const double>(values.n_elements() > 0 ? &values(0,0) : nullptr,
+                                       values.n_elements());
+      }
+
+
+
+      template <int dim>
+      inline
+      ArrayView<const Tensor<1,dim> >
+      SolutionEvaluator<dim>::get_gradients () const
+      {
+        return ArrayView<const Tensor<1,dim> >(gradients.n_elements() > 0 ? &gradients(0,0) : nullptr,
+                                               gradients.n_elements());
+      }
+    }
+  }
+}
+
+#endif
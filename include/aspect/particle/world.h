@@ -33,6 +33,7 @@
 #include <aspect/particle/integrator/interface.h>
 #include <aspect/particle/interpolator/interface.h>
 #include <aspect/particle/property/interface.h>
+#include <aspect/particle/solution_evaluator.h>
 
 #include <aspect/simulator_access.h>
 #include <aspect/simulator_signals.h>
@@ -40,6 +41,8 @@
 #include <deal.II/base/timer.h>
 #include <deal.II/base/array_view.h>
 
+#include <functional>
+
 #include <boost/serialization/unique_ptr.hpp>
 
 namespace aspect
@@ -163,7 +166,11 @@ namespace aspect
          * the register_store_callback_function() and
          * register_load_callback_function() to the
          * pre_refinement_store_user_data signal and the
-         * post_refinement_load_user_data signal respectively.
+         * post_refinement_load_user_data signal respectively. For
+         * checkpoints, either the same functions, or save_particles() and
+         * load_particles() are connected to the
+         * pre_checkpoint_store_user_data and post_resume_load_user_data
+         * signals.
          */
         void
         connect_to_signals(aspect::SimulatorSignals<dim> &signals);
@@ -171,16 +178,23 @@ namespace aspect
         /**
          * Called by listener functions from Triangulation for every cell
          * before a refinement step. A weight is attached to every cell
-         * depending on the number of contained particles.
+         * depending on the number of contained particles, or, if the
+         * measured cell cost is used, depending on the time spent on the
+         * particles and the material model evaluation in this cell.
          */
         unsigned int
         cell_weight(const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
                     const typename parallel::distributed::Triangulation<dim>::CellStatus status);
 
         /**
-         * Update the particle properties if necessary.
+         * Update the particle properties if necessary. If
+         * @p exchange_ghost_particles is set, the ghost particles are
+         * exchanged with the neighboring processes afterwards. The exchange
+         * allocates and frees properties in the property pool, which is not
+         * thread-safe, so it only starts once the threaded update of all
+         * cells is finished.
          */
-        void update_particles();
+        void update_particles(const bool exchange_ghost_particles = false);
 
         /**
          * Serialize the contents of this class.
@@ -202,6 +216,59 @@ namespace aspect
         void
         load (std::istringstream &is);
 
+        /**
+         * Whether the weights of the cells for load balancing are computed
+         * from the measured cost of the cells, which includes the time spent
+         * in the material model evaluation of each cell. See the parameter
+         * 'Use measured cell cost'.
+         */
+        bool
+        uses_measured_cell_cost () const;
+
+        /**
+         * Whether the particles are written to a separate file by
+         * save_particles() when a checkpoint is created, instead of being
+         * attached to the cells of the triangulation.
+         */
+        bool
+        use_separate_checkpoint_file () const;
+
+        /**
+         * Write the ids, locations, properties, and integrator data of all
+         * particles into the file @p filename. All processes write their
+         * particles at the same time using MPI-IO. The file contains a header
+         * with the dimension, the number of properties, the number of
+         * particles, and the size of the integrator data of one particle,
+         * followed by the ids of all particles, their locations, one
+         * contiguous array for every property, and the integrator data, in
+         * which the particles are ordered by the rank of the process that
+         * owns them. The integrator data contains, e.g., the length of the
+         * last substep of the adaptive RK23 integrator, so that a resumed
+         * computation continues with the same substeps.
+         *
+         * This function is collective, i.e., it needs to be called on all
+         * processes at the same time.
+         */
+        void
+        save_particles (const std::string &filename) const;
+
+        /**
+         * Read the particles from the file @p filename written by
+         * save_particles(), and insert them into the particle handler. The
+         * file does not depend on the mesh or on the number of processes
+         * that wrote it: Every process reads an equally sized part of the
+         * particles, and sends them to the processes that own the cells the
+         * particles are located in, together with their integrator data.
+         * The cells are found using bounding boxes of the locally owned
+         * cells, which are enlarged by the largest cell diameter, because
+         * curved or deformed cells can extend beyond their vertices.
+         *
+         * This function is collective, i.e., it needs to be called on all
+         * processes at the same time.
+         */
+        void
+        load_particles (const std::string &filename);
+
         /**
          * Declare the parameters this class takes through input files.
          */
@@ -299,6 +366,52 @@ namespace aspect
          */
         unsigned int particle_weight;
 
+        /**
+         * Whether the weights of the cells for the 'repartition' load
+         * balancing strategy are computed from the measured time spent on
+         * the particles and the material model evaluation in each cell,
+         * instead of from the number of particles and particle_weight.
+         */
+        bool use_measured_cell_cost;
+
+        /**
+         * The time (in seconds) spent on updating and advecting the
+         * particles of every active cell since the mesh last changed,
+         * indexed by the active cell index.
+         */
+        std::vector<double> particle_cell_time;
+
+        /**
+         * A timer that measures the wall time since the mesh last changed.
+         * The part of this time that was not measured per cell gives an
+         * estimate of the time of the work done for all cells alike, which
+         * corresponds to the weight of 1000 that every cell carries. See
+         * compute_cell_cost_to_weight_factor().
+         */
+        Timer cell_cost_timer;
+
+        /**
+         * The factor that converts the measured time of a cell into its
+         * weight. It is computed before every refinement step by
+         * compute_cell_cost_to_weight_factor(), and is zero if no cost has
+         * been measured yet.
+         */
+        double cell_cost_to_weight;
+
+        /**
+         * Compute cell_cost_to_weight from the measured times of all
+         * processes.
+         */
+        void
+        compute_cell_cost_to_weight_factor();
+
+        /**
+         * Reset the measured times of all cells, e.g. because the mesh
+         * changed.
+         */
+        void
+        reset_cell_cost();
+
         /**
          * Some particle interpolation algorithms require knowledge
          * about particles in neighboring cells. To allow this,
@@ -308,6 +421,12 @@ namespace aspect
          */
         bool update_ghost_particles;
 
+        /**
+         * Whether the particles are written to a separate file when a
+         * checkpoint is created. See use_separate_checkpoint_file().
+         */
+        bool separate_checkpoint_file;
+
         /**
          * Get a map between subdomain id and the neighbor index. In other words
          * the returned map answers the question: Given a subdomain id, which
@@ -341,6 +460,21 @@ namespace aspect
          */
         void advect_particles();
 
+        /**
+         * Call @p cell_worker for every locally owned cell that contains
+         * particles, with the range of particles in this cell. The cells
+         * are distributed to all available threads using the WorkStream
+         * interface, so @p cell_worker is called concurrently for
+         * different cells and must only modify the particles of the cell
+         * it is called for. If @p measure_cell_cost is set and the measured
+         * cell cost is used for load balancing, the time spent in
+         * @p cell_worker is added to the cost of each cell.
+         */
+        void
+        loop_over_cells_with_particles(const std::function<void (const typename DoFHandler<dim>::active_cell_iterator &,
+                                                                 const typename ParticleHandler<dim>::particle_iterator_range &)> &cell_worker,
+                                       const bool measure_cell_cost = false);
+
         /**
          * Initialize the particle properties of one cell.
          */
@@ -349,12 +483,15 @@ namespace aspect
                                    const typename ParticleHandler<dim>::particle_iterator &end_particle);
 
         /**
-         * Update the particle properties of one cell.
+         * Update the particle properties of one cell. The solution is
+         * evaluated at the particle positions by @p evaluator, which is
+         * reused for all cells handled by the current thread.
          */
         void
         local_update_particles(const typename DoFHandler<dim>::active_cell_iterator &cell,
                                const typename ParticleHandler<dim>::particle_iterator &begin_particle,
-                               const typename ParticleHandler<dim>::particle_iterator &end_particle);
+                               const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                               internal::SolutionEvaluator<dim> &evaluator);
 
         /**
          * Advect the particles of one cell. Performs only one step for
@@ -362,12 +499,15 @@ namespace aspect
          * evaluates to false. Particles that moved out of their old cell
          * during this advection step are removed from the local multimap and
          * stored in @p particles_out_of_cell for further treatment (sorting
-         * them into the new cell).
+         * them into the new cell). The velocity is evaluated at the particle
+         * positions by @p evaluator, which is reused for all cells handled
+         * by the current thread.
          */
         void
         local_advect_particles(const typename DoFHandler<dim>::active_cell_iterator &cell,
                                const typename ParticleHandler<dim>::particle_iterator &begin_particle,
-                               const typename ParticleHandler<dim>::particle_iterator &end_particle);
+                               const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                               internal::SolutionEvaluator<dim> &evaluator);
     };
 
     /* -------------------------- inline and template functions ---------------------- */
@@ -51,12 +51,14 @@ namespace aspect
            * This function prepares the data for writing. It reads the data from @p particle_hander and their
            * property information from @p property_information, and builds a list of patches that is stored
            * internally until the destructor is called. This function needs to be called before one of the
-           * write function of the base class can be called to write the output data.
+           * write function of the base class can be called to write the output data. Only particles
+           * whose id is a multiple of @p output_stride are written.
            */
           void build_patches(const Particles::ParticleHandler<dim> &particle_handler,
                              const aspect::Particle::Property::ParticlePropertyInformation &property_information,
                              const std::vector<std::string> &exclude_output_properties,
-                             const bool only_group_3d_vectors);
+                             const bool only_group_3d_vectors,
+                             const unsigned int output_stride = 1);
 
         private:
           /**
@@ -288,6 +290,18 @@ namespace aspect
          */
         std::vector<std::string> exclude_output_properties;
 
+        /**
+         * Only particles whose id is a multiple of this number are written
+         * to the output files. Since the ids of the particles do not change,
+         * the same subset of particles is written in every output step.
+         */
+        unsigned int output_stride;
+
+        /**
+         * The level of zlib compression of the data in VTU files.
+         */
+        DataOutBase::VtkFlags::ZlibCompressionLevel compression_level;
+
         /**
          * A function that writes the text in the second argument to a file
          * with the name given in the first argument. The function is run on a
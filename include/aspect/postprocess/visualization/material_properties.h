@@ -24,6 +24,7 @@
 
 #include <aspect/postprocess/visualization.h>
 #include <aspect/simulator_access.h>
+#include <aspect/material_model/scratch_pool.h>
 
 #include <deal.II/numerics/data_postprocessor.h>
 
@@ -84,6 +85,11 @@ namespace aspect
 
         private:
           std::vector<std::string> property_names;
+
+          /**
+           * Material model inputs and outputs that are reused for all cells.
+           */
+          mutable MaterialModel::ScratchPool<dim> scratch_pool;
       };
     }
   }
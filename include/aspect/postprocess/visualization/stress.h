@@ -24,6 +24,7 @@
 
 #include <aspect/postprocess/visualization.h>
 #include <aspect/simulator_access.h>
+#include <aspect/material_model/scratch_pool.h>
 
 #include <deal.II/numerics/data_postprocessor.h>
 
@@ -83,6 +84,12 @@ namespace aspect
            * constructor of this class.
            */
           UpdateFlags get_needed_update_flags () const override;
+
+        private:
+          /**
+           * Material model inputs and outputs that are reused for all cells.
+           */
+          mutable MaterialModel::ScratchPool<dim> scratch_pool;
       };
     }
   }
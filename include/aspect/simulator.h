@@ -51,6 +51,7 @@ DEAL_II_ENABLE_EXTRA_DIAGNOSTICS
 #include <aspect/lateral_averaging.h>
 #include <aspect/simulator_signals.h>
 #include <aspect/material_model/interface.h>
+#include <aspect/material_model/evaluation_cache.h>
 #include <aspect/heating_model/interface.h>
 #include <aspect/geometry_model/initial_topography_model/interface.h>
 #include <aspect/geometry_model/interface.h>
@@ -99,9 +100,15 @@ namespace aspect
   template <int dim>
   class StokesMatrixFreeHandler;
 
-  template <int dim, int velocity_degree>
+  template <int dim, int velocity_degree, typename GMGNumberType>
   class StokesMatrixFreeHandlerImplementation;
 
+  template <int dim>
+  class AdvectionMatrixFreeHandler;
+
+  template <int dim, int degree, int n_q_points_1d>
+  class AdvectionMatrixFreeHandlerImplementation;
+
   namespace MeshDeformation
   {
     template <int dim>
@@ -677,6 +684,60 @@ namespace aspect
                                            aspect::LinearAlgebra::PreconditionILU &preconditioner,
                                            const double diagonal_strengthening);
 
+      /**
+       * Return whether the linear system of the given advection field only
+       * consists of the terms that are assembled by
+       * Assemblers::AdvectionSystem, i.e., whether the field is a
+       * continuous field that is solved with the finite element method,
+       * and no other assemblers or face terms contribute to its system.
+       *
+       * This function is implemented in
+       * <code>source/simulator/helper_functions.cc</code>.
+       */
+      bool advection_system_uses_default_assemblers_only (const AdvectionField &advection_field) const;
+
+      /**
+       * Return whether the linear system of the given advection field is
+       * solved with the matrix-free advection solver instead of assembling
+       * a matrix for it. This is the case if the matrix-free advection
+       * solver was selected in the input file, and if the system of the
+       * field only consists of the terms that the matrix-free operator
+       * implements, i.e., those of a continuous field that are assembled
+       * by Assemblers::AdvectionSystem.
+       *
+       * This function is implemented in
+       * <code>source/simulator/helper_functions.cc</code>.
+       */
+      bool use_matrix_free_advection_solver (const AdvectionField &advection_field) const;
+
+      /**
+       * Return a reference to the matrix-free advection solver that handles
+       * the given advection field. Only valid if
+       * use_matrix_free_advection_solver() returns true for this field.
+       *
+       * This function is implemented in
+       * <code>source/simulator/helper_functions.cc</code>.
+       */
+      AdvectionMatrixFreeHandler<dim> &
+      get_advection_matrix_free_handler (const AdvectionField &advection_field) const;
+
+      /**
+       * Partition the compositional fields into groups of fields whose
+       * linear systems share the same matrix. This is the case for fields
+       * whose systems only consist of the terms of
+       * Assemblers::AdvectionSystem (see
+       * advection_system_uses_default_assemblers_only()), if they have the
+       * same constraints and the same artificial viscosity on every cell.
+       * All other fields form groups of their own. The fields within each
+       * group, and the groups themselves, are ordered by the index of the
+       * fields.
+       *
+       * This function is implemented in
+       * <code>source/simulator/helper_functions.cc</code>.
+       */
+      std::vector<std::vector<AdvectionField> >
+      group_compositional_fields_with_identical_matrices () const;
+
       /**
        * Initiate the assembly of the Stokes matrix and right hand side.
        *
@@ -755,6 +816,20 @@ namespace aspect
        */
       void assemble_advection_system (const AdvectionField &advection_field);
 
+      /**
+       * Initiate the assembly of the right hand sides of several advection
+       * fields that share the same matrix, as determined by
+       * group_compositional_fields_with_identical_matrices(). The matrix
+       * (or the matrix-free operator) is only assembled for the first
+       * field and stored in the matrix block of this field, while the
+       * right hand sides of all fields are assembled in the same loop over
+       * all cells, using the same evaluation of the material model.
+       *
+       * This function is implemented in
+       * <code>source/simulator/assembly.cc</code>.
+       */
+      void assemble_advection_system (const std::vector<AdvectionField> &advection_fields);
+
       /**
        * Solve one block of the temperature/composition linear system.
        * Return the initial nonlinear residual, i.e., if the linear system to
@@ -767,11 +842,33 @@ namespace aspect
        */
       double solve_advection (const AdvectionField &advection_field);
 
+      /**
+       * Solve the linear systems of several advection fields that share the
+       * same matrix, as assembled by the assemble_advection_system() function
+       * that takes a vector of fields. The matrix is stored in the matrix
+       * block of the first field, and the preconditioner built from it is
+       * reused for all fields. Return the initial nonlinear residual of
+       * each field, see the function above.
+       *
+       * This function is implemented in
+       * <code>source/simulator/solver.cc</code>.
+       */
+      std::vector<double> solve_advection (const std::vector<AdvectionField> &advection_fields);
+
       /**
        * Interpolate a particular particle property to the solution field.
        */
       void interpolate_particle_properties (const AdvectionField &advection_field);
 
+      /**
+       * Interpolate the particle properties that belong to all of the given
+       * @p advection_fields to their solution fields. In contrast to calling
+       * the function above for every field, the particles of each cell are
+       * only visited once and the interpolator computes the properties of
+       * all fields together.
+       */
+      void interpolate_particle_properties (const std::vector<AdvectionField> &advection_fields);
+
       /**
        * Solve the Stokes linear system.
        *
@@ -1091,6 +1188,23 @@ namespace aspect
                                        internal::Assembly::Scratch::AdvectionSystem<dim>  &scratch,
                                        internal::Assembly::CopyData::AdvectionSystem<dim> &data);
 
+      /**
+       * Compute the right hand side of another advection field on the cell
+       * that local_assemble_advection_system() was just called for with the
+       * same @p scratch object, reusing the material model and heating model
+       * outputs stored in it. This is only valid for fields that share the
+       * matrix of the field assembled in that call, see
+       * group_compositional_fields_with_identical_matrices(). The local
+       * matrix stored in @p data is overwritten, but not used.
+       *
+       * This function is implemented in
+       * <code>source/simulator/assembly.cc</code>.
+       */
+      void
+      local_assemble_advection_system_rhs (const AdvectionField &advection_field,
+                                           internal::Assembly::Scratch::AdvectionSystem<dim>  &scratch,
+                                           internal::Assembly::CopyData::AdvectionSystem<dim> &data);
+
       /**
        * Copy the contribution to the advection system from a single cell into
        * the global matrix that stores these elements.
@@ -1610,6 +1724,21 @@ namespace aspect
                                            const bool                                                   compute_strainrate,
                                            MaterialModel::MaterialModelInputs<dim> &material_model_inputs) const;
 
+      /**
+       * Evaluate the material model for the inputs @p material_model_inputs
+       * and store the results in @p material_model_outputs. If the
+       * material model outputs are cached (see the parameter
+       * `Material model/Cache material model outputs'), the results of
+       * an earlier evaluation with the same inputs on the same cell are
+       * reused.
+       *
+       * This function is implemented in
+       * <code>source/simulator/assembly.cc</code>.
+       */
+      void
+      evaluate_material_model (const MaterialModel::MaterialModelInputs<dim> &material_model_inputs,
+                               MaterialModel::MaterialModelOutputs<dim> &material_model_outputs) const;
+
 
       /**
        * Return whether the Stokes matrix depends on the values of the
@@ -1988,6 +2117,27 @@ namespace aspect
       bool                                                      assemble_newton_stokes_system;
       bool                                                      rebuild_stokes_preconditioner;
 
+      /**
+       * The wall time (in seconds) spent in evaluate_material_model() on
+       * every active cell since the mesh last changed, indexed by the
+       * active cell index. This includes the evaluations in the assembly of
+       * the Stokes and advection systems and in the matrix-free Stokes
+       * solver. It is used to balance the cost of expensive material models
+       * (e.g., with internal iterations) across processes when the mesh is
+       * repartitioned. The vector is empty if the particles do not use the
+       * measured cell cost, in which case no time is measured. It is
+       * mutable because it is updated by evaluate_material_model().
+       */
+      mutable std::vector<double>                               material_model_evaluation_time;
+
+      /**
+       * The cached material model outputs used by evaluate_material_model().
+       * The cache is cleared whenever the mesh changes and at the beginning
+       * of every time step, when the material model is updated. It is
+       * mutable because it does not change the results of any function.
+       */
+      mutable MaterialModel::EvaluationCache<dim>               material_model_cache;
+
       /**
        * @}
        */
@@ -2006,13 +2156,24 @@ namespace aspect
        */
       std::unique_ptr<StokesMatrixFreeHandler<dim> > stokes_matrix_free;
 
+      /**
+       * Unique pointers for the matrix-free solvers of the temperature
+       * and of the compositional field equations. They are only allocated
+       * if at least one field of the respective kind is solved matrix-free.
+       */
+      std::unique_ptr<AdvectionMatrixFreeHandler<dim> > temperature_matrix_free;
+      std::unique_ptr<AdvectionMatrixFreeHandler<dim> > composition_matrix_free;
+
       friend class boost::serialization::access;
       friend class SimulatorAccess<dim>;
       friend class MeshDeformation::MeshDeformationHandler<dim>;   // MeshDeformationHandler needs access to the internals of the Simulator
       friend class VolumeOfFluidHandler<dim>; // VolumeOfFluidHandler needs access to the internals of the Simulator
       friend class StokesMatrixFreeHandler<dim>;
-      template <int dimension, int velocity_degree>
+      template <int dimension, int velocity_degree, typename GMGNumberType>
       friend class StokesMatrixFreeHandlerImplementation;
+      friend class AdvectionMatrixFreeHandler<dim>;
+      template <int dimension, int degree, int n_q_points_1d>
+      friend class AdvectionMatrixFreeHandlerImplementation;
       friend struct Parameters<dim>;
   };
 }
@@ -67,6 +67,7 @@ namespace aspect
   namespace MaterialModel
   {
     template <int dim> class Interface;
+    template <int dim> class EvaluationCache;
   }
 
   namespace InitialTemperature
@@ -530,6 +531,14 @@ namespace aspect
       const MaterialModel::Interface<dim> &
       get_material_model () const;
 
+      /**
+       * Return a reference to the cache of material model outputs that is
+       * used if the parameter 'Material model/Cache material model outputs'
+       * is set.
+       */
+      const MaterialModel::EvaluationCache<dim> &
+      get_material_model_cache () const;
+
       /**
        * This function simply calls Simulator<dim>::compute_material_model_input_values()
        * with the given arguments.
@@ -913,6 +922,18 @@ namespace aspect
       const StokesMatrixFreeHandler<dim> &
       get_stokes_matrix_free () const;
 
+      /**
+       * Return the wall time (in seconds) spent in evaluating the material
+       * model while assembling the Stokes and advection systems, and while
+       * setting up the matrix-free Stokes solver, accumulated for every
+       * active cell since the mesh last changed. The vector is indexed by
+       * the active cell index, and the entries of cells that are not
+       * locally owned are zero. The vector is empty unless the particles
+       * use the measured cell cost for load balancing.
+       */
+      const std::vector<double> &
+      get_material_model_evaluation_time () const;
+
       /** @} */
 
     private:
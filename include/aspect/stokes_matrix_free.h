@@ -79,6 +79,45 @@ namespace aspect
                              const double pressure_scaling,
                              const bool is_compressible);
 
+        /**
+         * Enable the additional terms of the Newton linearization of the
+         * viscous term. The @p viscosity_derivative_table stores the
+         * derivative of the viscosity with respect to the strain rate
+         * (already multiplied by the Newton derivative scaling factor and the
+         * SPD stabilization factor), the @p strain_rate_table stores the
+         * strain rate of the current linearization point, and the
+         * @p pressure_derivative_table stores two times the derivative of
+         * the viscosity with respect to the pressure (multiplied by the
+         * derivative scaling factor), each for every cell batch and
+         * quadrature point. If @p symmetrize is true, only the symmetric
+         * part of the strain rate derivative term is applied.
+         */
+        void set_newton_derivatives (const Table<2, SymmetricTensor<2,dim,VectorizedArray<number>>> &viscosity_derivative_table,
+                                     const Table<2, SymmetricTensor<2,dim,VectorizedArray<number>>> &strain_rate_table,
+                                     const Table<2, VectorizedArray<number>> &pressure_derivative_table,
+                                     const bool symmetrize);
+
+        /**
+         * Enable the additional term of the mass conservation equation of
+         * the implicit reference density profile formulation, i.e.,
+         * $-\frac{1}{\rho_{\text{ref}}}\nabla\rho_{\text{ref}}\cdot\mathbf u$.
+         * The @p reference_density_gradient_table stores the vector
+         * $\frac{1}{\rho_{\text{ref}}}\frac{\partial\rho_{\text{ref}}}{\partial z}
+         * \frac{\mathbf g}{\|\mathbf g\|}$ for each cell batch and
+         * quadrature point.
+         */
+        void set_implicit_reference_density_gradient (const Table<2, Tensor<1,dim,VectorizedArray<number>>> &reference_density_gradient_table);
+
+        /**
+         * Enable the free surface stabilization term on all boundary faces
+         * with one of the given @p free_surface_boundary_indicators. The
+         * @p stabilization_table stores the vector
+         * $\theta \Delta t \rho \mathbf g$ for each boundary face batch
+         * and face quadrature point, see Kaus et al. (2010).
+         */
+        void set_free_surface_stabilization (const Table<2, Tensor<1,dim,VectorizedArray<number>>> &stabilization_table,
+                                             const std::set<types::boundary_id> &free_surface_boundary_indicators);
+
         /**
          * Computes the diagonal of the matrix. Since matrix-free operators have not access
          * to matrix elements, we must apply the matrix-free operator to the unit vectors to
@@ -103,11 +142,66 @@ namespace aspect
                           const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
                           const std::pair<unsigned int, unsigned int> &cell_range) const;
 
+        /**
+         * Defines the application of the operator on interior faces. There
+         * are no face terms in the Stokes operator, so this function does
+         * nothing, but MatrixFree::loop() requires it.
+         */
+        void local_apply_face (const dealii::MatrixFree<dim, number> &data,
+                               dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                               const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                               const std::pair<unsigned int, unsigned int> &face_range) const;
+
+        /**
+         * Defines the application of the free surface stabilization term on
+         * boundary faces.
+         */
+        void local_apply_boundary_face (const dealii::MatrixFree<dim, number> &data,
+                                        dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                                        const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                                        const std::pair<unsigned int, unsigned int> &face_range) const;
+
         /**
          * Table which stores viscosity values for each cell.
          */
         const Table<2, VectorizedArray<number>> *viscosity;
 
+        /**
+         * Tables which store the scaled viscosity derivatives and the strain
+         * rate of the linearization point for each cell and quadrature point
+         * if the Newton linearization terms are applied, or nullptr
+         * otherwise. See set_newton_derivatives().
+         */
+        const Table<2, SymmetricTensor<2,dim,VectorizedArray<number>>> *newton_viscosity_derivative;
+        const Table<2, SymmetricTensor<2,dim,VectorizedArray<number>>> *newton_strain_rate;
+        const Table<2, VectorizedArray<number>> *newton_pressure_derivative;
+
+        /**
+         * Whether to apply only the symmetric part of the Newton
+         * linearization term.
+         */
+        bool symmetrize_newton_terms;
+
+        /**
+         * Table which stores the scaled gradient of the reference density
+         * for each cell and quadrature point if the implicit reference
+         * density profile formulation is used, or nullptr otherwise. See
+         * set_implicit_reference_density_gradient().
+         */
+        const Table<2, Tensor<1,dim,VectorizedArray<number>>> *reference_density_gradient;
+
+        /**
+         * Table which stores the free surface stabilization vector for each
+         * boundary face and face quadrature point, or nullptr if no
+         * stabilization is applied.
+         */
+        const Table<2, Tensor<1,dim,VectorizedArray<number>>> *free_surface_stabilization;
+
+        /**
+         * Boundary indicators of the free surface boundaries.
+         */
+        std::set<types::boundary_id> free_surface_boundary_indicators;
+
         /**
          * Pressure scaling constant.
          */
@@ -191,6 +285,202 @@ namespace aspect
         double pressure_scaling;
     };
 
+    /**
+     * Operator for the entire Stokes system with melt transport, i.e., the
+     * solid velocity and the fluid and compaction pressure (stored as the two
+     * components of the second block) as assembled by
+     * Assemblers::MeltStokesSystem.
+     */
+    template <int dim, int degree_v, typename number>
+    class MeltStokesOperator
+      : public MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >
+    {
+      public:
+
+        /**
+         * Constructor.
+         */
+        MeltStokesOperator ();
+
+        /**
+         * Reset object.
+         */
+        void clear () override;
+
+        /**
+         * Fills in the viscosity table and the tables of the melt coefficients,
+         * and sets the value for the pressure scaling constant. The
+         * @p darcy_coefficient_table stores the limited Darcy coefficient
+         * $K_D$, the @p one_over_compaction_viscosity_table stores
+         * $1/\xi$, and the @p p_c_scale_table stores the scaling factor
+         * of the compaction pressure, each for every cell batch and quadrature
+         * point. If the model is compressible, @p fluid_density_gradient_table
+         * stores $K_D \frac{\nabla \rho_f}{\rho_f}$, otherwise it has to be
+         * empty.
+         */
+        void fill_cell_data (const Table<2, VectorizedArray<number>> &viscosity_table,
+                             const Table<2, VectorizedArray<number>> &darcy_coefficient_table,
+                             const Table<2, VectorizedArray<number>> &one_over_compaction_viscosity_table,
+                             const Table<2, VectorizedArray<number>> &p_c_scale_table,
+                             const Table<2, Tensor<1,dim,VectorizedArray<number>>> &fluid_density_gradient_table,
+                             const double pressure_scaling);
+
+        /**
+         * Apply the operator to @p src and add the result to @p dst without
+         * taking the constraints into account, i.e., constrained entries of
+         * @p src are used as they are. This is used to compute the right-hand
+         * side correction for inhomogeneous constraints.
+         */
+        void apply_add_without_constraints (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                                            const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const;
+
+        /**
+         * Computing the diagonal of the entire system is not needed and not
+         * implemented.
+         */
+        void compute_diagonal () override;
+
+      private:
+
+        /**
+         * Performs the application of the matrix-free operator. This function is called by
+         * vmult() functions MatrixFreeOperators::Base.
+         */
+        void apply_add (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                        const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const override;
+
+        /**
+         * Defines the application of the cell matrix.
+         */
+        void local_apply (const dealii::MatrixFree<dim, number> &data,
+                          dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                          const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                          const std::pair<unsigned int, unsigned int> &cell_range) const;
+
+        /**
+         * Same as local_apply(), but reads the values of constrained
+         * degrees of freedom from @p src instead of resolving constraints.
+         */
+        void local_apply_without_constraints (const dealii::MatrixFree<dim, number> &data,
+                                              dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                                              const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                                              const std::pair<unsigned int, unsigned int> &cell_range) const;
+
+        /**
+         * Evaluate the operator on the current cell batch for the dof values
+         * already read into @p velocity and @p pressure, and integrate the
+         * result.
+         */
+        void do_cell_integral (FEEvaluation<dim,degree_v,degree_v+1,dim,number> &velocity,
+                               FEEvaluation<dim,degree_v-1,degree_v+1,2,number> &pressure,
+                               const unsigned int cell) const;
+
+        /**
+         * Table which stores viscosity values for each cell.
+         */
+        const Table<2, VectorizedArray<number>> *viscosity;
+
+        /**
+         * Tables which store the melt coefficients for each cell and
+         * quadrature point. See fill_cell_data().
+         */
+        const Table<2, VectorizedArray<number>> *darcy_coefficient;
+        const Table<2, VectorizedArray<number>> *one_over_compaction_viscosity;
+        const Table<2, VectorizedArray<number>> *p_c_scale;
+        const Table<2, Tensor<1,dim,VectorizedArray<number>>> *fluid_density_gradient;
+
+        /**
+         * Pressure scaling constant.
+         */
+        double pressure_scaling;
+    };
+
+    /**
+     * Operator for the approximation of the Schur complement of the Stokes
+     * system with melt transport used in the block preconditioner, see
+     * Assemblers::MeltStokesPreconditioner.
+     */
+    template <int dim, int degree_p, typename number>
+    class MeltSchurComplementOperator
+      : public MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number>>
+    {
+      public:
+
+        /**
+         * Constructor
+         */
+        MeltSchurComplementOperator ();
+
+        /**
+         * Reset the object.
+         */
+        void clear () override;
+
+        /**
+         * Fills in the viscosity and melt coefficient tables (see
+         * MeltStokesOperator::fill_cell_data()) and sets the value for the
+         * pressure scaling constant.
+         */
+        void fill_cell_data (const Table<2, VectorizedArray<number>> &viscosity_table,
+                             const Table<2, VectorizedArray<number>> &darcy_coefficient_table,
+                             const Table<2, VectorizedArray<number>> &one_over_compaction_viscosity_table,
+                             const Table<2, VectorizedArray<number>> &p_c_scale_table,
+                             const double pressure_scaling);
+
+        /**
+         * Computes the diagonal of the matrix. Since matrix-free operators have not access
+         * to matrix elements, we must apply the matrix-free operator to the unit vectors to
+         * recover the diagonal.
+         */
+        void compute_diagonal () override;
+
+      private:
+
+        /**
+         * Performs the application of the matrix-free operator. This function is called by
+         * vmult() functions MatrixFreeOperators::Base.
+         */
+        void apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                        const dealii::LinearAlgebra::distributed::Vector<number> &src) const override;
+
+        /**
+         * Defines the application of the cell matrix.
+         */
+        void local_apply (const dealii::MatrixFree<dim, number> &data,
+                          dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                          const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                          const std::pair<unsigned int, unsigned int> &cell_range) const;
+
+        /**
+         * Computes the diagonal contribution from a cell matrix.
+         */
+        void local_compute_diagonal (const MatrixFree<dim,number>                     &data,
+                                     dealii::LinearAlgebra::distributed::Vector<number>  &dst,
+                                     const unsigned int                               &dummy,
+                                     const std::pair<unsigned int,unsigned int>       &cell_range) const;
+
+        /**
+         * Evaluate the operator at all quadrature points of the given cell
+         * batch, for values and gradients already evaluated in @p pressure.
+         */
+        void do_quadrature_point_operations (FEEvaluation<dim,degree_p,degree_p+2,2,number> &pressure,
+                                             const unsigned int cell) const;
+
+        /**
+         * Tables which store the viscosity and melt coefficients for each
+         * cell. See MeltStokesOperator::fill_cell_data().
+         */
+        const Table<2, VectorizedArray<number>> *viscosity;
+        const Table<2, VectorizedArray<number>> *darcy_coefficient;
+        const Table<2, VectorizedArray<number>> *one_over_compaction_viscosity;
+        const Table<2, VectorizedArray<number>> *p_c_scale;
+
+        /**
+         * Pressure scaling constant.
+         */
+        double pressure_scaling;
+    };
+
     /**
      * Operator for the A block of the Stokes matrix. The same class is used for both
      * active and level mesh operators.
@@ -219,6 +509,20 @@ namespace aspect
         void fill_cell_data (const Table<2, VectorizedArray<number>> &viscosity_table,
                              const bool is_compressible);
 
+        /**
+         * Enable the free surface stabilization term on all boundary faces
+         * with one of the given @p free_surface_boundary_indicators. Since
+         * this operator is used inside a preconditioner that requires a
+         * symmetric operator, we only apply the symmetric part of the
+         * stabilization term. For a free surface that is approximately
+         * perpendicular to gravity, this is almost identical to the full
+         * term. The StokesOperator applies the full, nonsymmetric term like
+         * the matrix-based assembly, so the difference only affects the
+         * convergence of the solver, not its solution.
+         */
+        void set_free_surface_stabilization (const Table<2, Tensor<1,dim,VectorizedArray<number>>> &stabilization_table,
+                                             const std::set<types::boundary_id> &free_surface_boundary_indicators);
+
         /**
          * Computes the diagonal of the matrix. Since matrix-free operators have not access
          * to matrix elements, we must apply the matrix-free operator to the unit vectors to
@@ -250,6 +554,25 @@ namespace aspect
                           const dealii::LinearAlgebra::distributed::Vector<number> &src,
                           const std::pair<unsigned int, unsigned int> &cell_range) const;
 
+        /**
+         * Defines the application of the operator on interior faces. There
+         * are no face terms in this operator, so this function does
+         * nothing, but MatrixFree::loop() requires it.
+         */
+        void local_apply_face (const dealii::MatrixFree<dim, number> &data,
+                               dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                               const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                               const std::pair<unsigned int, unsigned int> &face_range) const;
+
+        /**
+         * Defines the application of the free surface stabilization term on
+         * boundary faces.
+         */
+        void local_apply_boundary_face (const dealii::MatrixFree<dim, number> &data,
+                                        dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                                        const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                                        const std::pair<unsigned int, unsigned int> &face_range) const;
+
         /**
          * Computes the diagonal contribution from a cell matrix.
          */
@@ -258,6 +581,23 @@ namespace aspect
                                      const unsigned int                               &dummy,
                                      const std::pair<unsigned int,unsigned int>       &cell_range) const;
 
+        /**
+         * Computes the diagonal contribution from interior faces, which is zero.
+         */
+        void local_compute_diagonal_face (const MatrixFree<dim,number>                     &data,
+                                          dealii::LinearAlgebra::distributed::Vector<number>  &dst,
+                                          const unsigned int                               &dummy,
+                                          const std::pair<unsigned int,unsigned int>       &face_range) const;
+
+        /**
+         * Computes the diagonal contribution of the free surface stabilization
+         * term on boundary faces.
+         */
+        void local_compute_diagonal_boundary_face (const MatrixFree<dim,number>                     &data,
+                                                   dealii::LinearAlgebra::distributed::Vector<number>  &dst,
+                                                   const unsigned int                               &dummy,
+                                                   const std::pair<unsigned int,unsigned int>       &face_range) const;
+
         /**
          * Table which stores viscosity values for each cell.
          */
@@ -268,6 +608,17 @@ namespace aspect
           */
         bool is_compressible;
 
+        /**
+         * Table which stores the free surface stabilization vector for each
+         * boundary face and face quadrature point, or nullptr if no
+         * stabilization is applied.
+         */
+        const Table<2, Tensor<1,dim,VectorizedArray<number>>> *free_surface_stabilization;
+
+        /**
+         * Boundary indicators of the free surface boundaries.
+         */
+        std::set<types::boundary_id> free_surface_boundary_indicators;
     };
   }
 
@@ -296,6 +647,21 @@ namespace aspect
        */
       virtual void setup_dofs()=0;
 
+      /**
+       * Set up the matrix-free operators on the active mesh and on all
+       * multigrid levels. This function is called by setup_dofs().
+       */
+      virtual void setup_operators()=0;
+
+      /**
+       * Recompute the mapping information that the matrix-free objects
+       * store for all cells on the active mesh and on all multigrid levels.
+       * This function needs to be called whenever the geometry of the mesh
+       * changes without a change in the degrees of freedom, e.g., when the
+       * mesh is deformed. The constraints of the operators are kept.
+       */
+      virtual void update_mapping()=0;
+
       /**
        * Evalute the MaterialModel to query for the viscosity on the active cells,
        * project this viscosity to the multigrid hierarchy, and cache the information
@@ -357,18 +723,12 @@ namespace aspect
       get_constraints_p () const = 0;
 
       /**
-       * Return a pointer to the MGTransfer object used for the A block
-       * of the block GMG Stokes solver.
-       */
-      virtual const MGTransferMatrixFree<dim,double> &
-      get_mg_transfer_A () const = 0;
-
-      /**
-       * Return a pointer to the MGTransfer object used for the Schur
-       * complement block of the block GMG Stokes solver.
+       * Return the memory consumption of the MGTransfer objects used for
+       * the A block and the Schur complement block of the block GMG Stokes
+       * solver.
        */
-      virtual const MGTransferMatrixFree<dim,double> &
-      get_mg_transfer_S () const = 0;
+      virtual std::size_t
+      get_mg_transfer_memory_consumption () const = 0;
 
       /**
        * Return a pointer to the Table containing the viscosities on
@@ -378,11 +738,12 @@ namespace aspect
                                                    get_active_viscosity_table() const = 0;
 
       /**
-       * Return a pointer to the Tables containing the viscosities on
-       * the multigrid levels used in the block GMG Stokes solver.
+       * Return the memory consumption of the Tables containing the
+       * viscosities on the multigrid levels used in the block GMG Stokes
+       * solver.
        */
-      virtual const MGLevelObject<Table<2, VectorizedArray<double>>> &
-      get_level_viscosity_tables() const = 0;
+      virtual std::size_t
+      get_level_viscosity_tables_memory_consumption () const = 0;
   };
 
   /**
@@ -393,9 +754,13 @@ namespace aspect
    * second template argument for the degree of the Stokes finite
    * element. This way, the main simulator does not need to know about the
    * degree by using a pointer to the base class and we can pick the desired
-   * velocity degree at runtime.
+   * velocity degree at runtime. The same applies to the third template
+   * argument, the number type used for the multigrid hierarchy (level
+   * operators, smoothers, and transfer), which can be float to run the
+   * multigrid V-cycles in single precision inside the double precision
+   * outer Krylov solver.
    */
-  template<int dim, int velocity_degree>
+  template<int dim, int velocity_degree, typename GMGNumberType>
   class StokesMatrixFreeHandlerImplementation: public StokesMatrixFreeHandler<dim>
   {
     public:
@@ -424,6 +789,18 @@ namespace aspect
        */
       void setup_dofs() override;
 
+      /**
+       * Set up the matrix-free operators on the active mesh and on all
+       * multigrid levels. See the documentation in the base class.
+       */
+      void setup_operators() override;
+
+      /**
+       * Recompute the mapping information of the matrix-free objects.
+       * See the documentation in the base class.
+       */
+      void update_mapping() override;
+
       /**
        * Evalute the MaterialModel to query for the viscosity on the active cells,
        * project this viscosity to the multigrid hierarchy, and cache the information
@@ -450,7 +827,7 @@ namespace aspect
       double get_workload_imbalance();
 
       /**
-       * Declare parameters. (No actual parameters at the moment).
+       * Declare parameters.
        */
       static
       void declare_parameters (ParameterHandler &prm);
@@ -491,18 +868,12 @@ namespace aspect
       get_constraints_p () const override;
 
       /**
-       * Return a pointer to the MGTransfer object used for the A block
-       * of the block GMG Stokes solver.
+       * Return the memory consumption of the MGTransfer objects used for
+       * the A block and the Schur complement block of the block GMG Stokes
+       * solver.
        */
-      const MGTransferMatrixFree<dim,double> &
-      get_mg_transfer_A () const override;
-
-      /**
-       * Return a pointer to the MGTransfer object used for the Schur
-       * complement block of the block GMG Stokes solver.
-       */
-      const MGTransferMatrixFree<dim,double> &
-      get_mg_transfer_S () const override;
+      std::size_t
+      get_mg_transfer_memory_consumption () const override;
 
       /**
        * Return a pointer to the Table containing the viscosities on
@@ -512,21 +883,130 @@ namespace aspect
                                            get_active_viscosity_table() const override;
 
       /**
-       * Return a pointer to the Tables containing the viscosities on
-       * the multigrid levels used in the block GMG Stokes solver.
+       * Return the memory consumption of the Tables containing the
+       * viscosities on the multigrid levels used in the block GMG Stokes
+       * solver.
        */
-      const MGLevelObject<Table<2, VectorizedArray<double>>> &
-      get_level_viscosity_tables() const override;
+      std::size_t
+      get_level_viscosity_tables_memory_consumption () const override;
 
     private:
       /**
-       * Parse parameters. (No actual parameters at the moment).
+       * Parse parameters.
        */
       void parse_parameters (ParameterHandler &prm);
 
+      /**
+       * Add the constraints for all periodic boundary pairs of the geometry
+       * model to @p constraints for the active degrees of freedom of
+       * @p dof_handler. This has to happen before hanging node constraints
+       * are added.
+       */
+      void
+      make_periodicity_constraints (const DoFHandler<dim> &dof_handler,
+                                    ConstraintMatrix &constraints) const;
+
+      /**
+       * Evaluate the material model with derivatives at the quadrature
+       * points of all active cells and fill the tables needed to apply the
+       * Newton linearization terms in the matrix-free Stokes operator.
+       */
+      void
+      fill_newton_derivative_tables ();
+
+      /**
+       * Evaluate the reference density profile of the adiabatic conditions
+       * at the quadrature points of all active cells and fill the table
+       * needed for the implicit reference density profile formulation.
+       */
+      void
+      fill_reference_density_gradient_table ();
+
+      /**
+       * Evaluate the material model at the quadrature points of all active
+       * cells and fill the tables of the melt coefficients needed by the
+       * matrix-free operators of the Stokes system with melt transport.
+       */
+      void
+      fill_melt_tables ();
+
+      /**
+       * Recompute the pressure constraints for melt transport, in which
+       * the compaction pressure is constrained to zero in all cells that
+       * are not melt cells (see MeltHandler::add_current_constraints()).
+       * Since the melt cells change over time, this has to be done
+       * whenever the material model is evaluated. Return whether the set of
+       * constrained compaction pressure degrees of freedom changed.
+       */
+      bool
+      update_melt_constraints ();
+
+      /**
+       * Solve the Stokes system given by @p stokes_operator with the block
+       * Schur preconditioner built from the A block GMG preconditioner
+       * @p A_block_preconditioner and the preconditioner
+       * @p Schur_complement_preconditioner for the Schur complement
+       * approximation @p Schur_complement_operator. This implements solve()
+       * for both the Stokes system with and without melt transport.
+       */
+      template <class StokesOperatorType, class SchurComplementOperatorType,
+                class ABlockPreconditionerType, class SchurComplementPreconditionerType>
+      std::pair<double,double>
+      solve_system (const StokesOperatorType                &stokes_operator,
+                    const SchurComplementOperatorType       &Schur_complement_operator,
+                    const ABlockPreconditionerType          &A_block_preconditioner,
+                    const SchurComplementPreconditionerType &Schur_complement_preconditioner);
+
+      /**
+       * Return the mapping to use for the given multigrid @p level. This
+       * is the mapping of the simulator, unless the mesh is deformed, in
+       * which case each level has its own mapping that describes the
+       * deformed mesh.
+       */
+      const Mapping<dim> &
+      get_level_mapping (const unsigned int level) const;
+
+      /**
+       * Return whether the free surface stabilization term needs to be
+       * applied in the matrix-free operators.
+       */
+      bool
+      apply_free_surface_stabilization () const;
+
+      /**
+       * Return whether the Schur complement approximation is preconditioned
+       * by a geometric multigrid V-cycle. If not, no multigrid hierarchy is
+       * set up for the pressure and a preconditioner based on the diagonal
+       * of the operator on the active level is used instead.
+       */
+      bool
+      use_Schur_complement_GMG () const;
+
+      /**
+       * Fill the table of free surface stabilization vectors for all
+       * boundary faces of the given @p matrix_free object. If @p level is
+       * equal to numbers::invalid_unsigned_int, the object describes the
+       * active mesh, and the density is evaluated at the quadrature points
+       * of the faces from the current solution, like in the matrix-based
+       * Stokes assembly. Otherwise, the density is taken as the cellwise
+       * average stored in @p density_vector on the given multigrid level.
+       */
+      template <typename number>
+      void
+      fill_free_surface_stabilization_table (const MatrixFree<dim,number> &matrix_free,
+                                             const dealii::LinearAlgebra::distributed::Vector<double> &density_vector,
+                                             const unsigned int level,
+                                             Table<2, Tensor<1,dim,VectorizedArray<number>>> &stabilization_table) const;
+
 
       Simulator<dim> &sim;
 
+      /**
+       * Whether the solver may be used for models with melt transport, see
+       * the parameter "Allow melt transport".
+       */
+      bool allow_melt_transport;
+
       DoFHandler<dim> dof_handler_v;
       DoFHandler<dim> dof_handler_p;
       DoFHandler<dim> dof_handler_projection;
@@ -536,7 +1016,28 @@ namespace aspect
       FESystem<dim> fe_projection;
 
       Table<2, VectorizedArray<double>> active_viscosity_table;
-      MGLevelObject<Table<2, VectorizedArray<double>>> level_viscosity_tables;
+      MGLevelObject<Table<2, VectorizedArray<GMGNumberType>>> level_viscosity_tables;
+
+      Table<2, SymmetricTensor<2,dim,VectorizedArray<double>>> active_newton_viscosity_derivative_table;
+      Table<2, SymmetricTensor<2,dim,VectorizedArray<double>>> active_newton_strain_rate_table;
+      Table<2, VectorizedArray<double>> active_newton_pressure_derivative_table;
+
+      Table<2, Tensor<1,dim,VectorizedArray<double>>> active_reference_density_gradient_table;
+
+      Table<2, VectorizedArray<double>> active_melt_darcy_coefficient_table;
+      Table<2, VectorizedArray<double>> active_melt_one_over_compaction_viscosity_table;
+      Table<2, VectorizedArray<double>> active_melt_p_c_scale_table;
+      Table<2, Tensor<1,dim,VectorizedArray<double>>> active_melt_fluid_density_gradient_table;
+
+      /**
+       * The compaction pressure degrees of freedom that are constrained
+       * to zero because they are not part of any melt cell. See
+       * update_melt_constraints().
+       */
+      IndexSet constrained_p_c_dofs;
+
+      Table<2, Tensor<1,dim,VectorizedArray<double>>> active_free_surface_stabilization_table;
+      MGLevelObject<Table<2, Tensor<1,dim,VectorizedArray<GMGNumberType>>>> level_free_surface_stabilization_tables;
 
       // This variable is needed only in the setup in both evaluate_material_model()
       // and build_preconditioner(). It will be deleted after the last use.
@@ -546,22 +1047,43 @@ namespace aspect
       typedef MatrixFreeStokesOperators::MassMatrixOperator<dim,velocity_degree-1,double> SchurComplementMatrixType;
       typedef MatrixFreeStokesOperators::ABlockOperator<dim,velocity_degree,double> ABlockMatrixType;
 
+      typedef MatrixFreeStokesOperators::MeltStokesOperator<dim,velocity_degree,double> MeltStokesMatrixType;
+      typedef MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,velocity_degree-1,double> MeltSchurComplementMatrixType;
+
+      typedef MatrixFreeStokesOperators::MassMatrixOperator<dim,velocity_degree-1,GMGNumberType> GMGSchurComplementMatrixType;
+      typedef MatrixFreeStokesOperators::ABlockOperator<dim,velocity_degree,GMGNumberType> GMGABlockMatrixType;
+
       StokesMatrixType stokes_matrix;
       ABlockMatrixType A_block_matrix;
       SchurComplementMatrixType Schur_complement_block_matrix;
 
+      MeltStokesMatrixType melt_stokes_matrix;
+      MeltSchurComplementMatrixType melt_Schur_complement_matrix;
+
       ConstraintMatrix constraints_v;
       ConstraintMatrix constraints_p;
 
-      MGLevelObject<ABlockMatrixType> mg_matrices_A_block;
-      MGLevelObject<SchurComplementMatrixType> mg_matrices_Schur_complement;
+      MGLevelObject<GMGABlockMatrixType> mg_matrices_A_block;
+      MGLevelObject<GMGSchurComplementMatrixType> mg_matrices_Schur_complement;
+
+      /**
+       * The matrix-free objects the operators above are initialized with.
+       * The operators only have read access to them, so they are also
+       * stored here to update their mapping information in
+       * update_mapping().
+       */
+      std::shared_ptr<MatrixFree<dim,double> > stokes_mf_storage;
+      std::shared_ptr<MatrixFree<dim,double> > ablock_mf_storage;
+      std::shared_ptr<MatrixFree<dim,double> > Schur_mf_storage;
+      MGLevelObject<std::shared_ptr<MatrixFree<dim,GMGNumberType> > > mg_mf_storage_A_block;
+      MGLevelObject<std::shared_ptr<MatrixFree<dim,GMGNumberType> > > mg_mf_storage_Schur_complement;
 
       MGConstrainedDoFs mg_constrained_dofs_A_block;
       MGConstrainedDoFs mg_constrained_dofs_Schur_complement;
       MGConstrainedDoFs mg_constrained_dofs_projection;
 
-      MGTransferMatrixFree<dim,double> mg_transfer_A_block;
-      MGTransferMatrixFree<dim,double> mg_transfer_Schur_complement;
+      MGTransferMatrixFree<dim,GMGNumberType> mg_transfer_A_block;
+      MGTransferMatrixFree<dim,GMGNumberType> mg_transfer_Schur_complement;
   };
 }
 
@@ -42,10 +42,11 @@ namespace aspect
       const unsigned int n_compositions_for_eos = std::min(this->n_compositional_fields()+1, 3u);
       EquationOfStateOutputs<dim> eos_outputs (n_compositions_for_eos);
 
+      std::vector<double> composition;
       for (unsigned int i=0; i < in.n_evaluation_points(); ++i)
         {
           const double temperature = in.temperature[i];
-          const std::vector<double> &composition = in.composition[i];
+          in.composition.get_point_values(i, composition);
           const double delta_temp = temperature-reference_T;
           double temperature_dependence = std::max(std::min(std::exp(-thermal_viscosity_exponent*delta_temp/reference_T),1e2),1e-2);
 
@@ -176,12 +176,14 @@ namespace aspect
     evaluate(const MaterialModel::MaterialModelInputs<dim> &in,
              MaterialModel::MaterialModelOutputs<dim> &out) const
     {
+      // The compositional field values at one point, reused for all points
+      std::vector<double> composition;
       for (unsigned int i=0; i < in.n_evaluation_points(); ++i)
         {
           // const Point<dim> position = in.position[i];
           const double temperature = in.temperature[i];
           const double pressure= in.pressure[i];
-          const std::vector<double> composition = in.composition[i];
+          in.composition.get_point_values(i, composition);
           const std::vector<double> volume_fractions = MaterialUtilities::compute_volume_fractions(composition);
 
           // Averaging composition-field dependent properties
@@ -0,0 +1,189 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <aspect/material_model/evaluation_cache.h>
+
+
+namespace aspect
+{
+  namespace MaterialModel
+  {
+    namespace
+    {
+      /**
+       * Copy the outputs stored in @p source into @p destination. Unlike
+       * the copy constructor of MaterialModelOutputs, this reuses the
+       * memory of @p destination.
+       */
+      template <int dim>
+      void
+      copy_outputs (const MaterialModelOutputs<dim> &source,
+                    MaterialModelOutputs<dim> &destination)
+      {
+        destination.viscosities = source.viscosities;
+        destination.densities = source.densities;
+        destination.thermal_expansion_coefficients = source.thermal_expansion_coefficients;
+        destination.specific_heat = source.specific_heat;
+        destination.thermal_conductivities = source.thermal_conductivities;
+        destination.compressibilities = source.compressibilities;
+        destination.entropy_derivative_pressure = source.entropy_derivative_pressure;
+        destination.entropy_derivative_temperature = source.entropy_derivative_temperature;
+        destination.reaction_terms = source.reaction_terms;
+      }
+    }
+
+
+
+    template <int dim>
+    EvaluationCache<dim>::EvaluationCache ()
+      :
+      hits (0),
+      misses (0)
+    {}
+
+
+
+    template <int dim>
+    EvaluationCache<dim>::Entry::Entry (const MaterialModelInputs<dim> &in,
+                                        const MaterialModelOutputs<dim> &out)
+      :
+      inputs (in),
+      outputs (out)
+    {}
+
+
+
+    template <int dim>
+    void
+    EvaluationCache<dim>::evaluate (const Interface<dim> &material_model,
+                                    const MaterialModelInputs<dim> &in,
+                                    MaterialModelOutputs<dim> &out)
+    {
+      if (in.current_cell.state() != IteratorState::valid
+          || in.additional_inputs.size() > 0
+          || out.additional_outputs.size() > 0)
+        {
+          material_model.evaluate(in, out);
+
+          std::lock_guard<std::mutex> lock(entries_mutex);
+          ++misses;
+          return;
+        }
+
+      const std::pair<unsigned int, unsigned int> key (in.current_cell->active_cell_index(),
+                                                       in.n_evaluation_points());
+
+      {
+        std::lock_guard<std::mutex> lock(entries_mutex);
+        std::list<Entry> &cell_entries = entries[key];
+        for (auto entry = cell_entries.begin(); entry != cell_entries.end(); ++entry)
+          if (inputs_match(entry->inputs, in))
+            {
+              copy_outputs(entry->outputs, out);
+              cell_entries.splice(cell_entries.begin(), cell_entries, entry);
+              ++hits;
+              return;
+            }
+      }
+
+      // Do not hold the lock while evaluating the material model, so that
+      // other threads can use the cache in the meantime.
+      material_model.evaluate(in, out);
+
+      std::lock_guard<std::mutex> lock(entries_mutex);
+      ++misses;
+      std::list<Entry> &cell_entries = entries[key];
+      cell_entries.emplace_front(in, out);
+      if (cell_entries.size() > n_entries_per_key)
+        cell_entries.pop_back();
+    }
+
+
+
+    template <int dim>
+    void
+    EvaluationCache<dim>::clear ()
+    {
+      std::lock_guard<std::mutex> lock(entries_mutex);
+      entries.clear();
+      hits = 0;
+      misses = 0;
+    }
+
+
+
+    template <int dim>
+    unsigned int
+    EvaluationCache<dim>::n_hits () const
+    {
+      std::lock_guard<std::mutex> lock(entries_mutex);
+      return hits;
+    }
+
+
+
+    template <int dim>
+    unsigned int
+    EvaluationCache<dim>::n_misses () const
+    {
+      std::lock_guard<std::mutex> lock(entries_mutex);
+      return misses;
+    }
+
+
+
+    template <int dim>
+    bool
+    EvaluationCache<dim>::inputs_match (const MaterialModelInputs<dim> &cached_inputs,
+                                        const MaterialModelInputs<dim> &in)
+    {
+      // The earlier evaluation needs to have computed at least the
+      // properties that are requested now.
+      const int requested_properties = static_cast<int>(in.requested_properties);
+      if ((static_cast<int>(cached_inputs.requested_properties) & requested_properties) != requested_properties)
+        return false;
+
+      return (cached_inputs.current_cell == in.current_cell
+              && cached_inputs.position == in.position
+              && cached_inputs.temperature == in.temperature
+              && cached_inputs.pressure == in.pressure
+              && cached_inputs.pressure_gradient == in.pressure_gradient
+              && cached_inputs.velocity == in.velocity
+              && cached_inputs.composition == in.composition
+              && cached_inputs.strain_rate == in.strain_rate);
+    }
+  }
+}
+
+
+// explicit instantiations
+namespace aspect
+{
+  namespace MaterialModel
+  {
+#define INSTANTIATE(dim) \
+  template class EvaluationCache<dim>;
+
+    ASPECT_INSTANTIATE(INSTANTIATE)
+
+#undef INSTANTIATE
+  }
+}
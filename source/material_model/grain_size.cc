@@ -81,6 +81,18 @@ namespace aspect
 
 
 
+    template <int dim>
+    bool
+    DislocationViscosityOutputs<dim>::reset ()
+    {
+      std::fill (dislocation_viscosities.begin(), dislocation_viscosities.end(), numbers::signaling_nan<double>());
+      std::fill (boundary_area_change_work_fractions.begin(), boundary_area_change_work_fractions.end(),
+                 numbers::signaling_nan<double>());
+      return true;
+    }
+
+
+
     template <int dim>
     void
     GrainSize<dim>::initialize()
@@ -744,22 +756,80 @@ namespace aspect
 
 
 
+    template <int dim>
+    double
+    GrainSize<dim>::
+    average_lookup_values (const std::vector<double> &lookup_values,
+                           const std::vector<double> &compositional_fields) const
+    {
+      if (n_material_data == 1)
+        return lookup_values[0];
+
+      double average = 0.0;
+      for (unsigned i = 0; i < n_material_data; i++)
+        average += compositional_fields[i] * lookup_values[i];
+      return average;
+    }
+
+
+
     template <int dim>
     void
     GrainSize<dim>::
     evaluate(const typename Interface<dim>::MaterialModelInputs &in, typename Interface<dim>::MaterialModelOutputs &out) const
     {
+      typedef MaterialUtilities::Lookup::MaterialLookup MaterialLookup;
+
+      // The compositional field values at one point as given in the inputs,
+      // and with the grain size converted, reused for all points
+      std::vector<double> input_composition;
+      std::vector<double> composition;
+
+      // Use the adiabatic pressure instead of the real one, because of oscillations
+      std::vector<double> pressures (in.n_evaluation_points());
+      for (unsigned int i=0; i<in.n_evaluation_points(); ++i)
+        pressures[i] = (this->get_adiabatic_conditions().is_initialized())
+                       ?
+                       this->get_adiabatic_conditions().pressure(in.position[i])
+                       :
+                       in.pressure[i];
+
+      // Look up all properties of all material files at once, which computes
+      // the position of every point in each table only once. The seismic
+      // velocities are looked up at the real pressure instead.
+      SeismicAdditionalOutputs<dim> *seismic_out = (use_table_properties
+                                                    ?
+                                                    out.template get_additional_output<SeismicAdditionalOutputs<dim> >()
+                                                    :
+                                                    nullptr);
+      std::vector<std::vector<std::array<double,MaterialLookup::n_properties> > > lookup_properties (material_lookup.size());
+      std::vector<std::vector<std::array<double,MaterialLookup::n_properties> > > seismic_lookup_properties (material_lookup.size());
+      if (use_table_properties)
+        for (unsigned int j=0; j<material_lookup.size(); ++j)
+          {
+            material_lookup[j]->evaluate_all(in.temperature, pressures, lookup_properties[j]);
+            if (seismic_out != nullptr)
+              material_lookup[j]->evaluate_all(in.temperature, in.pressure, seismic_lookup_properties[j]);
+          }
+
+      std::vector<double> lookup_values (material_lookup.size());
+      const auto average_property = [&](const std::vector<std::vector<std::array<double,MaterialLookup::n_properties> > > &properties,
+                                        const unsigned int i,
+                                        const unsigned int property_index,
+                                        const std::vector<double> &compositional_fields) -> double
+      {
+        for (unsigned int j=0; j<material_lookup.size(); ++j)
+          lookup_values[j] = properties[j][i][property_index];
+        return average_lookup_values(lookup_values, compositional_fields);
+      };
+
       for (unsigned int i=0; i<in.n_evaluation_points(); ++i)
         {
-          // Use the adiabatic pressure instead of the real one, because of oscillations
-          const double pressure = (this->get_adiabatic_conditions().is_initialized())
-                                  ?
-                                  this->get_adiabatic_conditions().pressure(in.position[i])
-                                  :
-                                  in.pressure[i];
+          const double pressure = pressures[i];
 
           // convert the grain size from log to normal
-          std::vector<double> composition (in.composition[i]);
+          in.composition.get_point_values(i, input_composition);
+          composition = input_composition;
           if (advect_log_grainsize)
             convert_log_grain_size(composition);
           else
@@ -840,9 +910,23 @@ namespace aspect
                 disl_viscosities_out->dislocation_viscosities[i] = std::min(std::max(min_eta,disl_viscosity),1e300);
             }
 
-          out.densities[i] = density(in.temperature[i], pressure, in.composition[i], in.position[i]);
+          if (use_table_properties)
+            {
+              out.densities[i] = average_property(lookup_properties, i, MaterialLookup::density_index, input_composition);
+
+              // The compressibility mixes the files with the converted grain
+              // size, like the compressibility() function
+              for (unsigned int j=0; j<material_lookup.size(); ++j)
+                lookup_values[j] = material_lookup[j]->dRhodp(in.temperature[i], pressure);
+              const double dRhodp = average_lookup_values(lookup_values, composition);
+              out.compressibilities[i] = dRhodp / average_property(lookup_properties, i, MaterialLookup::density_index, composition);
+            }
+          else
+            {
+              out.densities[i] = density(in.temperature[i], pressure, input_composition, in.position[i]);
+              out.compressibilities[i] = compressibility(in.temperature[i], pressure, composition, in.position[i]);
+            }
           out.thermal_conductivities[i] = k_value;
-          out.compressibilities[i] = compressibility(in.temperature[i], pressure, composition, in.position[i]);
 
           if (DislocationViscosityOutputs<dim> *disl_viscosities_out = out.template get_additional_output<DislocationViscosityOutputs<dim> >())
             disl_viscosities_out->boundary_area_change_work_fractions[i] =
@@ -863,12 +947,11 @@ namespace aspect
               }
 
           // fill seismic velocities outputs if they exist
-          if (use_table_properties)
-            if (SeismicAdditionalOutputs<dim> *seismic_out = out.template get_additional_output<SeismicAdditionalOutputs<dim> >())
-              {
-                seismic_out->vp[i] = seismic_Vp(in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
-                seismic_out->vs[i] = seismic_Vs(in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
-              }
+          if (seismic_out != nullptr)
+            {
+              seismic_out->vp[i] = average_property(seismic_lookup_properties, i, MaterialLookup::vp_index, input_composition);
+              seismic_out->vs[i] = average_property(seismic_lookup_properties, i, MaterialLookup::vs_index, input_composition);
+            }
         }
 
       /* We separate the calculation of specific heat and thermal expansivity,
@@ -892,12 +975,7 @@ namespace aspect
 
       for (unsigned int i = 0; i < in.n_evaluation_points(); ++i)
         {
-          //Use the adiabatic pressure instead of the real one, because of oscillations
-          const double pressure = (this->get_adiabatic_conditions().is_initialized())
-                                  ?
-                                  this->get_adiabatic_conditions().pressure(in.position[i])
-                                  :
-                                  in.pressure[i];
+          const double pressure = pressures[i];
 
           if (!use_table_properties)
             {
@@ -929,8 +1007,9 @@ namespace aspect
             }
           else
             {
-              out.thermal_expansion_coefficients[i] = thermal_expansion_coefficient(in.temperature[i], pressure, in.composition[i], in.position[i]);
-              out.specific_heat[i] = specific_heat(in.temperature[i], pressure, in.composition[i], in.position[i]);
+              in.composition.get_point_values(i, input_composition);
+              out.thermal_expansion_coefficients[i] = average_property(lookup_properties, i, MaterialLookup::thermal_expansivity_index, input_composition);
+              out.specific_heat[i] = average_property(lookup_properties, i, MaterialLookup::specific_heat_index, input_composition);
             }
 
           out.thermal_expansion_coefficients[i] = std::max(std::min(out.thermal_expansion_coefficients[i],max_thermal_expansivity),min_thermal_expansivity);
@@ -256,6 +256,39 @@ namespace aspect
     }
 
 
+    CompositionalFieldValues::CompositionalFieldValues (const unsigned int n_points,
+                                                        const unsigned int n_fields,
+                                                        const double value)
+      :
+      n_evaluation_points (n_points),
+      n_compositional_fields (n_fields),
+      values (n_points * n_fields, value)
+    {}
+
+
+
+    void
+    CompositionalFieldValues::reinit (const unsigned int n_points,
+                                      const unsigned int n_fields,
+                                      const double value)
+    {
+      n_evaluation_points = n_points;
+      n_compositional_fields = n_fields;
+      values.assign (n_points * n_fields, value);
+    }
+
+
+
+    bool
+    CompositionalFieldValues::operator== (const CompositionalFieldValues &other) const
+    {
+      return (n_evaluation_points == other.n_evaluation_points
+              && n_compositional_fields == other.n_compositional_fields
+              && values == other.values);
+    }
+
+
+
     // We still use the cell reference in the different constructors, although it is deprecated.
     // Make sure we don't get any compiler warnings.
     DEAL_II_DISABLE_EXTRA_DIAGNOSTICS
@@ -268,7 +301,7 @@ namespace aspect
       pressure(n_points, numbers::signaling_nan<double>()),
       pressure_gradient(n_points, numbers::signaling_nan<Tensor<1,dim> >()),
       velocity(n_points, numbers::signaling_nan<Tensor<1,dim> >()),
-      composition(n_points, std::vector<double>(n_comp, numbers::signaling_nan<double>())),
+      composition(n_points, n_comp, numbers::signaling_nan<double>()),
       strain_rate(n_points, numbers::signaling_nan<SymmetricTensor<2,dim> >()),
       cell (nullptr),
       current_cell(),
@@ -285,33 +318,14 @@ namespace aspect
       pressure(input_data.solution_values.size(), numbers::signaling_nan<double>()),
       pressure_gradient(input_data.solution_values.size(), numbers::signaling_nan<Tensor<1,dim> >()),
       velocity(input_data.solution_values.size(), numbers::signaling_nan<Tensor<1,dim> >()),
-      composition(input_data.solution_values.size(), std::vector<double>(introspection.n_compositional_fields, numbers::signaling_nan<double>())),
+      composition(input_data.solution_values.size(), introspection.n_compositional_fields, numbers::signaling_nan<double>()),
       strain_rate(input_data.solution_values.size(), numbers::signaling_nan<SymmetricTensor<2,dim> >()),
       cell(&current_cell),
       current_cell(input_data.template get_cell<DoFHandler<dim> >()),
       requested_properties(MaterialProperties::all_properties)
     {
-      for (unsigned int q=0; q<input_data.solution_values.size(); ++q)
-        {
-          Tensor<2,dim> grad_u;
-          for (unsigned int d=0; d<dim; ++d)
-            {
-              grad_u[d] = input_data.solution_gradients[q][d];
-              this->velocity[q][d] = input_data.solution_values[q][introspection.component_indices.velocities[d]];
-              this->pressure_gradient[q][d] = input_data.solution_gradients[q][introspection.component_indices.pressure][d];
-            }
-
-          if (use_strain_rate)
-            this->strain_rate[q] = symmetrize (grad_u);
-          else
-            this->strain_rate.resize(0);
-
-          this->pressure[q] = input_data.solution_values[q][introspection.component_indices.pressure];
-          this->temperature[q] = input_data.solution_values[q][introspection.component_indices.temperature];
-
-          for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-            this->composition[q][c] = input_data.solution_values[q][introspection.component_indices.compositional_fields[c]];
-        }
+      // Call the function reinit to populate the new arrays.
+      this->reinit(input_data, introspection, use_strain_rate);
     }
 
     template <int dim>
@@ -326,7 +340,7 @@ namespace aspect
       pressure(fe_values.n_quadrature_points, numbers::signaling_nan<double>()),
       pressure_gradient(fe_values.n_quadrature_points, numbers::signaling_nan<Tensor<1,dim> >()),
       velocity(fe_values.n_quadrature_points, numbers::signaling_nan<Tensor<1,dim> >()),
-      composition(fe_values.n_quadrature_points, std::vector<double>(introspection.n_compositional_fields, numbers::signaling_nan<double>())),
+      composition(fe_values.n_quadrature_points, introspection.n_compositional_fields, numbers::signaling_nan<double>()),
       strain_rate(fe_values.n_quadrature_points, numbers::signaling_nan<SymmetricTensor<2,dim> >()),
       cell(cell_x.state() == IteratorState::valid ? &current_cell : nullptr),
       current_cell (cell_x),
@@ -379,25 +393,79 @@ namespace aspect
       else
         this->strain_rate.resize(0);
 
-      // Vectors for evaluating the compositional field parts of the finite element solution
-      std::vector<std::vector<double> > composition_values (introspection.n_compositional_fields, std::vector<double> (fe_values.n_quadrature_points));
+      for (unsigned int i=0; i<fe_values.n_quadrature_points; ++i)
+        this->position[i] = fe_values.quadrature_point(i);
+
+      // The values of each compositional field at all points are stored
+      // contiguously, so they can be copied as a whole from a vector that is
+      // reused for all fields.
+      std::vector<double> composition_values (fe_values.n_quadrature_points);
       for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
         {
-          fe_values[introspection.extractors.compositional_fields[c]].get_function_values(solution_vector,composition_values[c]);
+          fe_values[introspection.extractors.compositional_fields[c]].get_function_values(solution_vector,composition_values);
+          const ArrayView<double> field_values = this->composition.field_values(c);
+          AssertDimension (field_values.size(), composition_values.size());
+          std::copy (composition_values.begin(), composition_values.end(), field_values.begin());
         }
 
-      for (unsigned int i=0; i<fe_values.n_quadrature_points; ++i)
+      DEAL_II_DISABLE_EXTRA_DIAGNOSTICS
+      this->cell = cell_x.state() == IteratorState::valid ? &cell_x : nullptr;
+      DEAL_II_ENABLE_EXTRA_DIAGNOSTICS
+
+      this->current_cell = cell_x;
+    }
+
+
+
+    template <int dim>
+    void
+    MaterialModelInputs<dim>::reinit(const DataPostprocessorInputs::Vector<dim> &input_data,
+                                     const Introspection<dim> &introspection,
+                                     const bool use_strain_rate)
+    {
+      const unsigned int n_points = input_data.solution_values.size();
+
+      // Only resize the arrays if the number of points changed, because
+      // resizing the compositional field values resets them
+      if (this->position.size() != n_points
+          || this->composition.n_points() != n_points
+          || this->composition.n_fields() != introspection.n_compositional_fields)
         {
-          this->position[i] = fe_values.quadrature_point(i);
+          this->temperature.resize(n_points);
+          this->pressure.resize(n_points);
+          this->pressure_gradient.resize(n_points);
+          this->velocity.resize(n_points);
+          this->composition.reinit(n_points, introspection.n_compositional_fields, numbers::signaling_nan<double>());
+        }
+      this->strain_rate.resize(use_strain_rate ? n_points : 0);
+
+      this->position = input_data.evaluation_points;
+
+      for (unsigned int q=0; q<n_points; ++q)
+        {
+          Tensor<2,dim> grad_u;
+          for (unsigned int d=0; d<dim; ++d)
+            {
+              grad_u[d] = input_data.solution_gradients[q][d];
+              this->velocity[q][d] = input_data.solution_values[q][introspection.component_indices.velocities[d]];
+              this->pressure_gradient[q][d] = input_data.solution_gradients[q][introspection.component_indices.pressure][d];
+            }
+
+          if (use_strain_rate)
+            this->strain_rate[q] = symmetrize (grad_u);
+
+          this->pressure[q] = input_data.solution_values[q][introspection.component_indices.pressure];
+          this->temperature[q] = input_data.solution_values[q][introspection.component_indices.temperature];
+
           for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-            this->composition[i][c] = composition_values[c][i];
+            this->composition(q,c) = input_data.solution_values[q][introspection.component_indices.compositional_fields[c]];
         }
 
+      this->current_cell = input_data.template get_cell<DoFHandler<dim> >();
+
       DEAL_II_DISABLE_EXTRA_DIAGNOSTICS
-      this->cell = cell_x.state() == IteratorState::valid ? &cell_x : nullptr;
+      this->cell = &this->current_cell;
       DEAL_II_ENABLE_EXTRA_DIAGNOSTICS
-
-      this->current_cell = cell_x;
     }
 
 
@@ -883,6 +951,15 @@ namespace aspect
 
 
 
+    template <int dim>
+    bool PrescribedPlasticDilation<dim>::reset ()
+    {
+      std::fill (dilation.begin(), dilation.end(), numbers::signaling_nan<double>());
+      return true;
+    }
+
+
+
     namespace
     {
       std::vector<std::string> make_seismic_additional_outputs_names()
@@ -928,6 +1005,17 @@ namespace aspect
 
 
 
+    template <int dim>
+    bool
+    SeismicAdditionalOutputs<dim>::reset ()
+    {
+      std::fill (vs.begin(), vs.end(), numbers::signaling_nan<double>());
+      std::fill (vp.begin(), vp.end(), numbers::signaling_nan<double>());
+      return true;
+    }
+
+
+
     namespace
     {
       std::vector<std::string> make_reaction_rate_outputs_names(const unsigned int n_comp)
@@ -979,6 +1067,17 @@ namespace aspect
 
 
 
+    template<int dim>
+    bool
+    ReactionRateOutputs<dim>::reset ()
+    {
+      for (std::vector<double> &rates : reaction_rates)
+        std::fill (rates.begin(), rates.end(), std::numeric_limits<double>::quiet_NaN());
+      return true;
+    }
+
+
+
     template<int dim>
     PrescribedFieldOutputs<dim>::PrescribedFieldOutputs (const unsigned int n_points,
                                                          const unsigned int n_comp)
@@ -1005,6 +1104,17 @@ namespace aspect
 
 
 
+    template<int dim>
+    bool
+    PrescribedFieldOutputs<dim>::reset ()
+    {
+      for (std::vector<double> &outputs : prescribed_field_outputs)
+        std::fill (outputs.begin(), outputs.end(), std::numeric_limits<double>::quiet_NaN());
+      return true;
+    }
+
+
+
     template<int dim>
     PrescribedTemperatureOutputs<dim>::PrescribedTemperatureOutputs (const unsigned int n_points)
       :
@@ -1022,6 +1132,17 @@ namespace aspect
       AssertIndexRange (idx, 1);
       return prescribed_temperature_outputs;
     }
+
+
+
+    template<int dim>
+    bool
+    PrescribedTemperatureOutputs<dim>::reset ()
+    {
+      std::fill (prescribed_temperature_outputs.begin(), prescribed_temperature_outputs.end(),
+                 std::numeric_limits<double>::quiet_NaN());
+      return true;
+    }
   }
 }
 
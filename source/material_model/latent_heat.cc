@@ -34,11 +34,13 @@ namespace aspect
     evaluate(const MaterialModelInputs<dim> &in,
              MaterialModelOutputs<dim> &out) const
     {
+      // The compositional field values at one point, reused for all points
+      std::vector<double> composition;
       for (unsigned int i=0; i < in.n_evaluation_points(); ++i)
         {
           const double temperature = in.temperature[i];
           const double pressure = in.pressure[i];
-          const std::vector<double> composition = in.composition[i];
+          in.composition.get_point_values(i, composition);
           const Point<dim> position = in.position[i];
 
           // Assign constant material properties
@@ -34,6 +34,8 @@ namespace aspect
     evaluate(const MaterialModel::MaterialModelInputs<dim> &in,
              MaterialModel::MaterialModelOutputs<dim> &out) const
     {
+      // The compositional field values at one point, reused for all points
+      std::vector<double> composition;
       for (unsigned int i=0; i < in.n_evaluation_points(); ++i)
         {
 
@@ -45,7 +47,7 @@ namespace aspect
               out.reaction_terms[i][c]            = 0;
             }
 
-          std::vector<double> composition = in.composition[i];
+          in.composition.get_point_values(i, composition);
           const double delta_temp = in.temperature[i] - reference_T;
           const double T_dependence = ( thermal_viscosity_exponent == 0.0
                                         ?
@@ -101,7 +103,7 @@ namespace aspect
 
           // fourth, melt fraction dependence
           double melt_dependence = (1.0 - relative_melt_density)
-                                   * melt_fraction(in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
+                                   * melt_fraction(in.temperature[i], in.pressure[i], composition, in.position[i]);
 
           // in the end, all the influences are added up
           out.densities[i] = (reference_rho + composition_dependence + pressure_dependence) * temperature_dependence
@@ -24,6 +24,7 @@
 
 #include <deal.II/base/signaling_nan.h>
 #include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/vectorization.h>
 
 
 namespace aspect
@@ -39,8 +40,9 @@ namespace aspect
 
 
       template <int dim>
-      double
-      ConstantViscosityPrefactors<dim>::compute_viscosity (const double viscosity,
+      template <typename Number>
+      Number
+      ConstantViscosityPrefactors<dim>::compute_viscosity (const Number &viscosity,
                                                            const unsigned int composition_index) const
       {
         return viscosity * constant_viscosity_prefactors[composition_index];
@@ -85,6 +87,10 @@ namespace aspect
   namespace Rheology \
   { \
     template class ConstantViscosityPrefactors<dim>; \
+    template double ConstantViscosityPrefactors<dim>::compute_viscosity (const double &, \
+                                                                         const unsigned int) const; \
+    template VectorizedArray<double> ConstantViscosityPrefactors<dim>::compute_viscosity (const VectorizedArray<double> &, \
+                                                                                          const unsigned int) const; \
   }
 
     ASPECT_INSTANTIATE(INSTANTIATE)
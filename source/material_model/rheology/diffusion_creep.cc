@@ -24,6 +24,7 @@
 
 #include <deal.II/base/signaling_nan.h>
 #include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/vectorization.h>
 
 
 namespace aspect
@@ -39,9 +40,10 @@ namespace aspect
 
 
       template <int dim>
-      double
-      DiffusionCreep<dim>::compute_viscosity (const double pressure,
-                                              const double temperature,
+      template <typename Number>
+      Number
+      DiffusionCreep<dim>::compute_viscosity (const Number &pressure,
+                                              const Number &temperature,
                                               const unsigned int composition) const
       {
         // Power law creep equation
@@ -49,7 +51,7 @@ namespace aspect
         // A: prefactor,
         // d: grain size, m: grain size exponent, E: activation energy, P: pressure,
         // V; activation volume, R: gas constant, T: temperature.
-        const double viscosity_diffusion = 0.5 / prefactors_diffusion[composition] *
+        const Number viscosity_diffusion = 0.5 / prefactors_diffusion[composition] *
                                            std::exp((activation_energies_diffusion[composition] +
                                                      pressure*activation_volumes_diffusion[composition])/
                                                     (constants::gas_constant*temperature)) *
@@ -124,6 +126,12 @@ namespace aspect
   namespace Rheology \
   { \
     template class DiffusionCreep<dim>; \
+    template double DiffusionCreep<dim>::compute_viscosity (const double &, \
+                                                            const double &, \
+                                                            const unsigned int) const; \
+    template VectorizedArray<double> DiffusionCreep<dim>::compute_viscosity (const VectorizedArray<double> &, \
+                                                                             const VectorizedArray<double> &, \
+                                                                             const unsigned int) const; \
   }
 
     ASPECT_INSTANTIATE(INSTANTIATE)
@@ -24,6 +24,7 @@
 
 #include <deal.II/base/signaling_nan.h>
 #include <deal.II/base/parameter_handler.h>
+#include <deal.II/base/vectorization.h>
 
 
 namespace aspect
@@ -39,10 +40,11 @@ namespace aspect
 
 
       template <int dim>
-      double
-      DislocationCreep<dim>::compute_viscosity (const double strain_rate,
-                                                const double pressure,
-                                                const double temperature,
+      template <typename Number>
+      Number
+      DislocationCreep<dim>::compute_viscosity (const Number &strain_rate,
+                                                const Number &pressure,
+                                                const Number &temperature,
                                                 const unsigned int composition) const
       {
         // Power law creep equation:
@@ -50,7 +52,7 @@ namespace aspect
         // A: prefactor, edot_ii: square root of second invariant of deviatoric strain rate tensor,
         // E: activation energy, P: pressure,
         // V; activation volume, n: stress exponent, R: gas constant, T: temperature.
-        const double viscosity_dislocation = 0.5 * std::pow(prefactors_dislocation[composition],-1/stress_exponents_dislocation[composition]) *
+        const Number viscosity_dislocation = 0.5 * std::pow(prefactors_dislocation[composition],-1/stress_exponents_dislocation[composition]) *
                                              std::exp((activation_energies_dislocation[composition] + pressure*activation_volumes_dislocation[composition])/
                                                       (constants::gas_constant*temperature*stress_exponents_dislocation[composition])) *
                                              std::pow(strain_rate,((1. - stress_exponents_dislocation[composition])/stress_exponents_dislocation[composition]));
@@ -121,6 +123,14 @@ namespace aspect
   namespace Rheology \
   { \
     template class DislocationCreep<dim>; \
+    template double DislocationCreep<dim>::compute_viscosity (const double &, \
+                                                              const double &, \
+                                                              const double &, \
+                                                              const unsigned int) const; \
+    template VectorizedArray<double> DislocationCreep<dim>::compute_viscosity (const VectorizedArray<double> &, \
+                                                                               const VectorizedArray<double> &, \
+                                                                               const VectorizedArray<double> &, \
+                                                                               const unsigned int) const; \
   }
 
     ASPECT_INSTANTIATE(INSTANTIATE)
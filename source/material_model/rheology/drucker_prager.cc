@@ -22,6 +22,8 @@
 #include <aspect/material_model/rheology/drucker_prager.h>
 #include <aspect/utilities.h>
 
+#include <deal.II/base/vectorization.h>
+
 
 namespace aspect
 {
@@ -30,17 +32,18 @@ namespace aspect
     namespace Rheology
     {
       template <int dim>
-      double
-      DruckerPrager<dim>::compute_yield_stress (const double cohesion,
-                                                const double angle_internal_friction,
-                                                const double pressure,
-                                                const double max_yield_stress) const
+      template <typename Number>
+      Number
+      DruckerPrager<dim>::compute_yield_stress (const Number &cohesion,
+                                                const Number &angle_internal_friction,
+                                                const Number &pressure,
+                                                const Number &max_yield_stress) const
       {
-        const double sin_phi = std::sin(angle_internal_friction);
-        const double cos_phi = std::cos(angle_internal_friction);
-        const double stress_inv_part = 1. / (std::sqrt(3.0) * (3.0 + sin_phi));
+        const Number sin_phi = std::sin(angle_internal_friction);
+        const Number cos_phi = std::cos(angle_internal_friction);
+        const Number stress_inv_part = 1. / (std::sqrt(3.0) * (3.0 + sin_phi));
 
-        double yield_stress = ( (dim==3)
+        const Number yield_stress = ( (dim==3)
                                 ?
                                 ( 6.0 * cohesion * cos_phi + 6.0 * pressure * sin_phi) * stress_inv_part
                                 :
@@ -52,16 +55,17 @@ namespace aspect
 
 
       template <int dim>
-      double
-      DruckerPrager<dim>::compute_viscosity (const double cohesion,
-                                             const double angle_internal_friction,
-                                             const double pressure,
-                                             const double effective_strain_rate,
-                                             const double max_yield_stress) const
+      template <typename Number>
+      Number
+      DruckerPrager<dim>::compute_viscosity (const Number &cohesion,
+                                             const Number &angle_internal_friction,
+                                             const Number &pressure,
+                                             const Number &effective_strain_rate,
+                                             const Number &max_yield_stress) const
       {
-        const double yield_stress = compute_yield_stress(cohesion, angle_internal_friction, pressure, max_yield_stress);
+        const Number yield_stress = compute_yield_stress(cohesion, angle_internal_friction, pressure, max_yield_stress);
 
-        const double strain_rate_effective_inv = 1./(2.*effective_strain_rate);
+        const Number strain_rate_effective_inv = 1./(2.*effective_strain_rate);
 
         return yield_stress * strain_rate_effective_inv;
       }
@@ -153,6 +157,24 @@ namespace aspect
   namespace Rheology \
   { \
     template class DruckerPrager<dim>; \
+    template double DruckerPrager<dim>::compute_yield_stress (const double &, \
+                                                              const double &, \
+                                                              const double &, \
+                                                              const double &) const; \
+    template double DruckerPrager<dim>::compute_viscosity (const double &, \
+                                                           const double &, \
+                                                           const double &, \
+                                                           const double &, \
+                                                           const double &) const; \
+    template VectorizedArray<double> DruckerPrager<dim>::compute_yield_stress (const VectorizedArray<double> &, \
+                                                                               const VectorizedArray<double> &, \
+                                                                               const VectorizedArray<double> &, \
+                                                                               const VectorizedArray<double> &) const; \
+    template VectorizedArray<double> DruckerPrager<dim>::compute_viscosity (const VectorizedArray<double> &, \
+                                                                            const VectorizedArray<double> &, \
+                                                                            const VectorizedArray<double> &, \
+                                                                            const VectorizedArray<double> &, \
+                                                                            const VectorizedArray<double> &) const; \
   }
 
     ASPECT_INSTANTIATE(INSTANTIATE)
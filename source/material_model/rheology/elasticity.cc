@@ -63,6 +63,16 @@ namespace aspect
 
 
 
+    template <int dim>
+    bool
+    ElasticAdditionalOutputs<dim>::reset ()
+    {
+      std::fill (elastic_shear_moduli.begin(), elastic_shear_moduli.end(), numbers::signaling_nan<double>());
+      return true;
+    }
+
+
+
     namespace Rheology
     {
       template <int dim>
@@ -0,0 +1,128 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <aspect/material_model/scratch_pool.h>
+
+#include <algorithm>
+
+
+namespace aspect
+{
+  namespace MaterialModel
+  {
+    template <int dim>
+    ScratchPool<dim>::Scratch::Scratch (const unsigned int n_points,
+                                        const unsigned int n_comp)
+      :
+      inputs (n_points, n_comp),
+      outputs (n_points, n_comp)
+    {}
+
+
+
+    template <int dim>
+    ScratchPool<dim>::ScratchPool (const std::function<void (Scratch &)> &initialize)
+      :
+      initialize (initialize)
+    {}
+
+
+
+    template <int dim>
+    typename ScratchPool<dim>::Scratch &
+    ScratchPool<dim>::get (const unsigned int n_points,
+                           const unsigned int n_comp)
+    {
+      std::shared_ptr<Scratch> &thread_scratch = scratch.get()[std::make_pair(n_points, n_comp)];
+
+      if (!thread_scratch)
+        {
+          thread_scratch = std::make_shared<Scratch>(n_points, n_comp);
+          if (initialize)
+            initialize(*thread_scratch);
+        }
+      else
+        {
+          // Reset the outputs to the values the constructor of
+          // MaterialModelOutputs sets, so that outputs the material model
+          // does not compute are not silently taken from the previous
+          // evaluation:
+          MaterialModelOutputs<dim> &out = thread_scratch->outputs;
+          for (std::vector<double> *values : {&out.viscosities,
+                                              &out.densities,
+                                              &out.thermal_expansion_coefficients,
+                                              &out.specific_heat,
+                                              &out.thermal_conductivities,
+                                              &out.compressibilities,
+                                              &out.entropy_derivative_pressure,
+                                              &out.entropy_derivative_temperature
+                                             })
+            std::fill (values->begin(), values->end(), numbers::signaling_nan<double>());
+
+          for (std::vector<double> &reaction_terms : out.reaction_terms)
+            std::fill (reaction_terms.begin(), reaction_terms.end(), numbers::signaling_nan<double>());
+
+          // The additional outputs are reset in place as well. Only if one of
+          // them does not know how to do that, all additional inputs and
+          // outputs are created again. The additional inputs do not need to
+          // be reset, since they are filled together with the other inputs.
+          bool additional_outputs_reset = true;
+          for (const auto &additional_output : out.additional_outputs)
+            additional_outputs_reset = additional_output->reset() && additional_outputs_reset;
+
+          if (!additional_outputs_reset)
+            {
+              thread_scratch->inputs.additional_inputs.clear();
+              out.additional_outputs.clear();
+
+              if (initialize)
+                initialize(*thread_scratch);
+            }
+        }
+
+      return *thread_scratch;
+    }
+
+
+
+    template <int dim>
+    void
+    ScratchPool<dim>::clear ()
+    {
+      scratch.clear();
+    }
+  }
+}
+
+
+// explicit instantiations
+namespace aspect
+{
+  namespace MaterialModel
+  {
+#define INSTANTIATE(dim) \
+  template class ScratchPool<dim>;
+
+    ASPECT_INSTANTIATE(INSTANTIATE)
+
+#undef INSTANTIATE
+  }
+}
@@ -465,25 +465,79 @@ namespace aspect
 
 
 
+    template <int dim>
+    double
+    Steinberger<dim>::
+    average_lookup_values (const std::vector<double> &lookup_values,
+                           const std::vector<double> &compositional_fields) const
+    {
+      double average = 0.0;
+      if (material_lookup.size() == 1)
+        {
+          average = lookup_values[0];
+        }
+      else if (material_lookup.size() == compositional_fields.size() + 1)
+        {
+          average = lookup_values[0];
+          for (unsigned int i = 0; i < compositional_fields.size(); ++i)
+            average += compositional_fields[i] *
+                       (lookup_values[i+1] - lookup_values[0]);
+        }
+      else
+        {
+          for (unsigned i = 0; i < material_lookup.size(); ++i)
+            average += compositional_fields[i] * lookup_values[i];
+        }
+      return average;
+    }
+
+
+
     template <int dim>
     void
     Steinberger<dim>::evaluate(const MaterialModel::MaterialModelInputs<dim> &in,
                                MaterialModel::MaterialModelOutputs<dim> &out) const
     {
+      typedef MaterialUtilities::Lookup::MaterialLookup MaterialLookup;
+
+      // Look up all properties of all material files at once, which computes
+      // the position of every point in each table only once
+      std::vector<std::vector<std::array<double,MaterialLookup::n_properties> > > lookup_properties (material_lookup.size());
+      for (unsigned int j=0; j<material_lookup.size(); ++j)
+        material_lookup[j]->evaluate_all(in.temperature, in.pressure, lookup_properties[j]);
+
+      // The compositional field values at the current point
+      std::vector<double> composition;
+
+      std::vector<double> lookup_values (material_lookup.size());
+      const auto average_property = [&](const unsigned int i,
+                                        const unsigned int property_index) -> double
+      {
+        for (unsigned int j=0; j<material_lookup.size(); ++j)
+          lookup_values[j] = lookup_properties[j][i][property_index];
+        return average_lookup_values(lookup_values, composition);
+      };
+
       for (unsigned int i=0; i < in.n_evaluation_points(); ++i)
         {
+          in.composition.get_point_values(i, composition);
+
           // We are only asked to give viscosities if strain_rate.size() > 0.
           if (in.requests_property(MaterialProperties::viscosity))
-            out.viscosities[i]                  = viscosity                     (in.temperature[i], in.pressure[i], in.composition[i], in.strain_rate[i], in.position[i]);
+            out.viscosities[i]                  = viscosity                     (in.temperature[i], in.pressure[i], composition, in.strain_rate[i], in.position[i]);
 
-          out.densities[i]                      = density                       (in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
+          out.densities[i]                      = average_property(i, MaterialLookup::density_index);
           if (!latent_heat)
             {
-              out.thermal_expansion_coefficients[i] = thermal_expansion_coefficient (in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
-              out.specific_heat[i]                  = specific_heat                 (in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
+              out.thermal_expansion_coefficients[i] = average_property(i, MaterialLookup::thermal_expansivity_index);
+              out.specific_heat[i]                  = average_property(i, MaterialLookup::specific_heat_index);
             }
-          out.thermal_conductivities[i]         = thermal_conductivity          (in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
-          out.compressibilities[i]              = compressibility               (in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
+          out.thermal_conductivities[i]         = thermal_conductivity          (in.temperature[i], in.pressure[i], composition, in.position[i]);
+
+          for (unsigned int j=0; j<material_lookup.size(); ++j)
+            lookup_values[j] = material_lookup[j]->dRhodp(in.temperature[i], in.pressure[i]);
+          out.compressibilities[i]              = average_lookup_values(lookup_values, composition) / out.densities[i];
+
           out.entropy_derivative_pressure[i]    = 0;
           out.entropy_derivative_temperature[i] = 0;
           for (unsigned int c=0; c<in.composition[i].size(); ++c)
@@ -492,8 +546,8 @@ namespace aspect
           // fill seismic velocities outputs if they exist
           if (SeismicAdditionalOutputs<dim> *seismic_out = out.template get_additional_output<SeismicAdditionalOutputs<dim> >())
             {
-              seismic_out->vp[i] = seismic_Vp(in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
-              seismic_out->vs[i] = seismic_Vs(in.temperature[i], in.pressure[i], in.composition[i], in.position[i]);
+              seismic_out->vp[i] = average_property(i, MaterialLookup::vp_index);
+              seismic_out->vs[i] = average_property(i, MaterialLookup::vs_index);
             }
         }
 
@@ -46,50 +46,50 @@ namespace aspect
         MaterialLookup::specific_heat(const double temperature,
                                       const double pressure) const
         {
-          return value(temperature,pressure,specific_heat_values,interpolation);
+          return value(temperature,pressure,specific_heat_index,interpolation);
         }
 
         double
         MaterialLookup::density(const double temperature,
                                 const double pressure) const
         {
-          return value(temperature,pressure,density_values,interpolation);
+          return value(temperature,pressure,density_index,interpolation);
         }
 
         double
         MaterialLookup::thermal_expansivity(const double temperature,
                                             const double pressure) const
         {
-          return value(temperature,pressure,thermal_expansivity_values,interpolation);
+          return value(temperature,pressure,thermal_expansivity_index,interpolation);
         }
 
         double
         MaterialLookup::seismic_Vp(const double temperature,
                                    const double pressure) const
         {
-          return value(temperature,pressure,vp_values,false);
+          return value(temperature,pressure,vp_index,false);
         }
 
         double
         MaterialLookup::seismic_Vs(const double temperature,
                                    const double pressure) const
         {
-          return value(temperature,pressure,vs_values,false);
+          return value(temperature,pressure,vs_index,false);
         }
 
         double
         MaterialLookup::enthalpy(const double temperature,
                                  const double pressure) const
         {
-          return value(temperature,pressure,enthalpy_values,true);
+          return value(temperature,pressure,enthalpy_index,true);
         }
 
         double
         MaterialLookup::dHdT (const double temperature,
                               const double pressure) const
         {
-          const double h = value(temperature,pressure,enthalpy_values,interpolation);
-          const double dh = value(temperature+delta_temp,pressure,enthalpy_values,interpolation);
+          const double h = value(temperature,pressure,enthalpy_index,interpolation);
+          const double dh = value(temperature+delta_temp,pressure,enthalpy_index,interpolation);
           return (dh - h) / delta_temp;
         }
 
@@ -97,8 +97,8 @@ namespace aspect
         MaterialLookup::dHdp (const double temperature,
                               const double pressure) const
         {
-          const double h = value(temperature,pressure,enthalpy_values,interpolation);
-          const double dh = value(temperature,pressure+delta_press,enthalpy_values,interpolation);
+          const double h = value(temperature,pressure,enthalpy_index,interpolation);
+          const double dh = value(temperature,pressure+delta_press,enthalpy_index,interpolation);
           return (dh - h) / delta_press;
         }
 
@@ -179,15 +179,82 @@ namespace aspect
         MaterialLookup::dRhodp (const double temperature,
                                 const double pressure) const
         {
-          const double rho = value(temperature,pressure,density_values,interpolation);
-          const double drho = value(temperature,pressure+delta_press,density_values,interpolation);
+          const double rho = value(temperature,pressure,density_index,interpolation);
+          const double drho = value(temperature,pressure+delta_press,density_index,interpolation);
           return (drho - rho) / delta_press;
         }
 
+        void
+        MaterialLookup::evaluate_all (const std::vector<double> &temperatures,
+                                      const std::vector<double> &pressures,
+                                      std::vector<std::array<double,n_properties> > &properties) const
+        {
+          Assert(temperatures.size() == pressures.size(), ExcInternalError());
+          properties.resize(temperatures.size());
+
+          std::array<bool,n_properties> interpolate_property;
+          for (unsigned int k=0; k<n_properties; ++k)
+            interpolate_property[k] = is_interpolated(k);
+
+          for (unsigned int i=0; i<temperatures.size(); ++i)
+            {
+              const double nT = get_nT(temperatures[i]);
+              const unsigned int inT = static_cast<unsigned int>(nT);
+
+              const double np = get_np(pressures[i]);
+              const unsigned int inp = static_cast<unsigned int>(np);
+
+              Assert(inT<property_values.size(0), ExcMessage("Attempting to look up a temperature value with index greater than the number of rows."));
+              Assert(inp<property_values.size(1), ExcMessage("Attempting to look up a pressure value with index greater than the number of columns."));
+
+              // compute the coordinates of this point in the
+              // reference cell between the data points, and the
+              // weights of the bilinear interpolation
+              const double xi = nT-inT;
+              const double eta = np-inp;
+
+              Assert ((0 <= xi) && (xi <= 1), ExcInternalError());
+              Assert ((0 <= eta) && (eta <= 1), ExcInternalError());
+
+              const double w00 = (1-xi)*(1-eta);
+              const double w10 = xi    *(1-eta);
+              const double w01 = (1-xi)*eta;
+              const double w11 = xi    *eta;
+
+              // All properties of one data point are stored contiguously
+              const double *values_00 = &property_values[inT][inp][0];
+              const double *values_10 = &property_values[inT+1][inp][0];
+              const double *values_01 = &property_values[inT][inp+1][0];
+              const double *values_11 = &property_values[inT+1][inp+1][0];
+
+              for (unsigned int k=0; k<n_properties; ++k)
+                properties[i][k] = (interpolate_property[k]
+                                    ?
+                                    w00*values_00[k] + w10*values_10[k] + w01*values_01[k] + w11*values_11[k]
+                                    :
+                                    values_00[k]);
+            }
+        }
+
+        bool
+        MaterialLookup::is_interpolated (const unsigned int property_index) const
+        {
+          switch (property_index)
+            {
+              case vp_index:
+              case vs_index:
+                return false;
+              case enthalpy_index:
+                return true;
+              default:
+                return interpolation;
+            }
+        }
+
         double
         MaterialLookup::value (const double temperature,
                                const double pressure,
-                               const Table<2, double> &values,
+                               const unsigned int property_index,
                                const bool interpol) const
         {
           const double nT = get_nT(temperature);
@@ -196,11 +263,12 @@ namespace aspect
           const double np = get_np(pressure);
           const unsigned int inp = static_cast<unsigned int>(np);
 
-          Assert(inT<values.n_rows(), ExcMessage("Attempting to look up a temperature value with index greater than the number of rows."));
-          Assert(inp<values.n_cols(), ExcMessage("Attempting to look up a pressure value with index greater than the number of columns."));
+          Assert(inT<property_values.size(0), ExcMessage("Attempting to look up a temperature value with index greater than the number of rows."));
+          Assert(inp<property_values.size(1), ExcMessage("Attempting to look up a pressure value with index greater than the number of columns."));
+          AssertIndexRange(property_index, n_properties);
 
           if (!interpol)
-            return values[inT][inp];
+            return property_values[inT][inp][property_index];
           else
             {
               // compute the coordinates of this point in the
@@ -212,10 +280,10 @@ namespace aspect
               Assert ((0 <= eta) && (eta <= 1), ExcInternalError());
 
               // use these coordinates for a bilinear interpolation
-              return ((1-xi)*(1-eta)*values[inT][inp] +
-                      xi    *(1-eta)*values[inT+1][inp] +
-                      (1-xi)*eta    *values[inT][inp+1] +
-                      xi    *eta    *values[inT+1][inp+1]);
+              return ((1-xi)*(1-eta)*property_values[inT][inp][property_index] +
+                      xi    *(1-eta)*property_values[inT+1][inp][property_index] +
+                      (1-xi)*eta    *property_values[inT][inp+1][property_index] +
+                      xi    *eta    *property_values[inT+1][inp+1][property_index]);
             }
         }
 
@@ -246,6 +314,78 @@ namespace aspect
           return (bounded_pressure-min_press)/delta_press;
         }
 
+        double &
+        MaterialLookup::density_values (const unsigned int i, const unsigned int j)
+        {
+          return property_values[i][j][density_index];
+        }
+
+        double
+        MaterialLookup::density_values (const unsigned int i, const unsigned int j) const
+        {
+          return property_values[i][j][density_index];
+        }
+
+        double &
+        MaterialLookup::thermal_expansivity_values (const unsigned int i, const unsigned int j)
+        {
+          return property_values[i][j][thermal_expansivity_index];
+        }
+
+        double
+        MaterialLookup::thermal_expansivity_values (const unsigned int i, const unsigned int j) const
+        {
+          return property_values[i][j][thermal_expansivity_index];
+        }
+
+        double &
+        MaterialLookup::specific_heat_values (const unsigned int i, const unsigned int j)
+        {
+          return property_values[i][j][specific_heat_index];
+        }
+
+        double
+        MaterialLookup::specific_heat_values (const unsigned int i, const unsigned int j) const
+        {
+          return property_values[i][j][specific_heat_index];
+        }
+
+        double &
+        MaterialLookup::vp_values (const unsigned int i, const unsigned int j)
+        {
+          return property_values[i][j][vp_index];
+        }
+
+        double
+        MaterialLookup::vp_values (const unsigned int i, const unsigned int j) const
+        {
+          return property_values[i][j][vp_index];
+        }
+
+        double &
+        MaterialLookup::vs_values (const unsigned int i, const unsigned int j)
+        {
+          return property_values[i][j][vs_index];
+        }
+
+        double
+        MaterialLookup::vs_values (const unsigned int i, const unsigned int j) const
+        {
+          return property_values[i][j][vs_index];
+        }
+
+        double &
+        MaterialLookup::enthalpy_values (const unsigned int i, const unsigned int j)
+        {
+          return property_values[i][j][enthalpy_index];
+        }
+
+        double
+        MaterialLookup::enthalpy_values (const unsigned int i, const unsigned int j) const
+        {
+          return property_values[i][j][enthalpy_index];
+        }
+
         HeFESToReader::HeFESToReader(const std::string &material_filename,
                                      const std::string &derivatives_filename,
                                      const bool interpol,
@@ -306,12 +446,7 @@ namespace aspect
             Assert(i == n_temperature * n_pressure,
                    ExcMessage("Material table size not consistent."));
 
-            density_values.reinit(n_temperature,n_pressure);
-            thermal_expansivity_values.reinit(n_temperature,n_pressure);
-            specific_heat_values.reinit(n_temperature,n_pressure);
-            vp_values.reinit(n_temperature,n_pressure);
-            vs_values.reinit(n_temperature,n_pressure);
-            enthalpy_values.reinit(n_temperature,n_pressure);
+            property_values.reinit(n_temperature,n_pressure,n_properties);
 
             i = 0;
             while (!in.eof())
@@ -338,7 +473,7 @@ namespace aspect
                 if (in.fail())
                   {
                     in.clear();
-                    rho = density_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                    rho = density_values((i-1)%n_temperature,(i-1)/n_temperature);
                   }
                 else
                   rho *= 1e3; // conversion from [g/cm^3] to [kg/m^3]
@@ -351,13 +486,13 @@ namespace aspect
                 if (in.fail())
                   {
                     in.clear();
-                    vs = vs_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                    vs = vs_values((i-1)%n_temperature,(i-1)/n_temperature);
                   }
                 in >> vp;
                 if (in.fail())
                   {
                     in.clear();
-                    vp = vp_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                    vp = vp_values((i-1)%n_temperature,(i-1)/n_temperature);
                   }
                 in >> vsq >> vpq;
 
@@ -365,7 +500,7 @@ namespace aspect
                 if (in.fail())
                   {
                     in.clear();
-                    h = enthalpy_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                    h = enthalpy_values((i-1)%n_temperature,(i-1)/n_temperature);
                   }
                 else
                   h *= 1e6; // conversion from [kJ/g] to [J/kg]
@@ -374,12 +509,12 @@ namespace aspect
                 if (in.eof())
                   break;
 
-                density_values[i/n_pressure][i%n_pressure]=rho;
-                thermal_expansivity_values[i/n_pressure][i%n_pressure]=alpha;
-                specific_heat_values[i/n_pressure][i%n_pressure]=cp;
-                vp_values[i/n_pressure][i%n_pressure]=vp;
-                vs_values[i/n_pressure][i%n_pressure]=vs;
-                enthalpy_values[i/n_pressure][i%n_pressure]=h;
+                density_values(i/n_pressure,i%n_pressure)=rho;
+                thermal_expansivity_values(i/n_pressure,i%n_pressure)=alpha;
+                specific_heat_values(i/n_pressure,i%n_pressure)=cp;
+                vp_values(i/n_pressure,i%n_pressure)=vp;
+                vs_values(i/n_pressure,i%n_pressure)=vs;
+                enthalpy_values(i/n_pressure,i%n_pressure)=h;
 
                 i++;
               }
@@ -419,7 +554,7 @@ namespace aspect
                   if (in.fail() || (cp <= std::numeric_limits<double>::min()))
                     {
                       in.clear();
-                      cp = specific_heat_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                      cp = specific_heat_values((i-1)%n_temperature,(i-1)/n_temperature);
                     }
                   else
                     cp *= 1e3; // conversion from [J/g/K] to [J/kg/K]
@@ -428,7 +563,7 @@ namespace aspect
                   if (in.fail() || (alpha_eff <= std::numeric_limits<double>::min()))
                     {
                       in.clear();
-                      alpha_eff = thermal_expansivity_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                      alpha_eff = thermal_expansivity_values((i-1)%n_temperature,(i-1)/n_temperature);
                     }
                   else
                     {
@@ -445,8 +580,8 @@ namespace aspect
                   if (in.eof())
                     break;
 
-                  specific_heat_values[i/n_pressure][i%n_pressure]=cp;
-                  thermal_expansivity_values[i/n_pressure][i%n_pressure]=alpha_eff;
+                  specific_heat_values(i/n_pressure,i%n_pressure)=cp;
+                  thermal_expansivity_values(i/n_pressure,i%n_pressure)=alpha_eff;
 
                   i++;
                 }
@@ -506,12 +641,7 @@ namespace aspect
           max_temp = min_temp + (n_temperature-1) * delta_temp;
           max_press = min_press + (n_pressure-1) * delta_press;
 
-          density_values.reinit(n_temperature,n_pressure);
-          thermal_expansivity_values.reinit(n_temperature,n_pressure);
-          specific_heat_values.reinit(n_temperature,n_pressure);
-          vp_values.reinit(n_temperature,n_pressure);
-          vs_values.reinit(n_temperature,n_pressure);
-          enthalpy_values.reinit(n_temperature,n_pressure);
+          property_values.reinit(n_temperature,n_pressure,n_properties);
 
           unsigned int i = 0;
           while (!in.eof())
@@ -523,49 +653,49 @@ namespace aspect
               if (in.fail())
                 {
                   in.clear();
-                  rho = density_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                  rho = density_values((i-1)%n_temperature,(i-1)/n_temperature);
                 }
               in >> alpha;
               if (in.fail())
                 {
                   in.clear();
-                  alpha = thermal_expansivity_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                  alpha = thermal_expansivity_values((i-1)%n_temperature,(i-1)/n_temperature);
                 }
               in >> cp;
               if (in.fail())
                 {
                   in.clear();
-                  cp = specific_heat_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                  cp = specific_heat_values((i-1)%n_temperature,(i-1)/n_temperature);
                 }
               in >> vp;
               if (in.fail())
                 {
                   in.clear();
-                  vp = vp_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                  vp = vp_values((i-1)%n_temperature,(i-1)/n_temperature);
                 }
               in >> vs;
               if (in.fail())
                 {
                   in.clear();
-                  vs = vs_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                  vs = vs_values((i-1)%n_temperature,(i-1)/n_temperature);
                 }
               in >> h;
               if (in.fail())
                 {
                   in.clear();
-                  h = enthalpy_values[(i-1)%n_temperature][(i-1)/n_temperature];
+                  h = enthalpy_values((i-1)%n_temperature,(i-1)/n_temperature);
                 }
 
               std::getline(in, temp);
               if (in.eof())
                 break;
 
-              density_values[i%n_temperature][i/n_temperature]=rho;
-              thermal_expansivity_values[i%n_temperature][i/n_temperature]=alpha;
-              specific_heat_values[i%n_temperature][i/n_temperature]=cp;
-              vp_values[i%n_temperature][i/n_temperature]=vp;
-              vs_values[i%n_temperature][i/n_temperature]=vs;
-              enthalpy_values[i%n_temperature][i/n_temperature]=h;
+              density_values(i%n_temperature,i/n_temperature)=rho;
+              thermal_expansivity_values(i%n_temperature,i/n_temperature)=alpha;
+              specific_heat_values(i%n_temperature,i/n_temperature)=cp;
+              vp_values(i%n_temperature,i/n_temperature)=vp;
+              vs_values(i%n_temperature,i/n_temperature)=vs;
+              enthalpy_values(i%n_temperature,i/n_temperature)=h;
 
               i++;
             }
@@ -22,6 +22,7 @@
 #include <aspect/utilities.h>
 #include <deal.II/fe/fe_values.h>
 #include <deal.II/base/signaling_nan.h>
+#include <deal.II/base/vectorization.h>
 #include <aspect/newton.h>
 #include <aspect/adiabatic_conditions/interface.h>
 #include <aspect/gravity_model/interface.h>
@@ -76,13 +77,14 @@ namespace aspect
     {
       Assert(in.n_evaluation_points() == 1, ExcInternalError());
 
-      const std::vector<double> volume_fractions = MaterialUtilities::compute_volume_fractions(in.composition[0], get_volumetric_composition_mask());
+      const std::vector<double> composition = in.composition[0];
+      const std::vector<double> volume_fractions = MaterialUtilities::compute_volume_fractions(composition, get_volumetric_composition_mask());
 
       /* The following returns whether or not the material is plastically yielding
        * as documented in evaluate.
        */
       const std::pair<std::vector<double>, std::vector<bool>> calculate_viscosities =
-                                                             calculate_isostrain_viscosities(volume_fractions, in.pressure[0], in.temperature[0], in.composition[0], in.strain_rate[0], viscous_flow_law, yield_mechanism);
+                                                             calculate_isostrain_viscosities(volume_fractions, in.pressure[0], in.temperature[0], composition, in.strain_rate[0], viscous_flow_law, yield_mechanism);
 
       std::vector<double>::const_iterator max_composition = std::max_element(volume_fractions.begin(), volume_fractions.end());
       const bool plastic_yielding = calculate_viscosities.second[std::distance(volume_fractions.begin(), max_composition)];
@@ -92,6 +94,46 @@ namespace aspect
 
 
 
+    template <int dim>
+    void
+    ViscoPlastic<dim>::
+    is_yielding(const MaterialModelInputs<dim> &in,
+                std::vector<bool> &plastic_yielding) const
+    {
+      plastic_yielding.resize(in.n_evaluation_points());
+
+      const ComponentMask volumetric_compositions = get_volumetric_composition_mask();
+
+      // Without elasticity, compute the yielding of all compositions at all
+      // points at once. With elasticity, every point is computed separately
+      // in the loop below.
+      std::vector<std::vector<double> > isostrain_viscosities;
+      std::vector<std::vector<bool> > isostrain_yielding;
+      if (use_elasticity == false)
+        calculate_isostrain_viscosities_vectorized(in, viscous_flow_law, yield_mechanism,
+                                                   isostrain_viscosities, isostrain_yielding);
+
+      std::vector<double> composition;
+      for (unsigned int i=0; i < in.n_evaluation_points(); ++i)
+        {
+          in.composition.get_point_values(i, composition);
+          const std::vector<double> volume_fractions = MaterialUtilities::compute_volume_fractions(composition, volumetric_compositions);
+
+          // As in evaluate, decide based on the maximum composition if the material is yielding.
+          const unsigned int max_composition = std::distance(volume_fractions.begin(),
+                                                             std::max_element(volume_fractions.begin(), volume_fractions.end()));
+
+          if (use_elasticity == false)
+            plastic_yielding[i] = isostrain_yielding[i][max_composition];
+          else
+            plastic_yielding[i] = calculate_isostrain_viscosities(volume_fractions, in.pressure[i], in.temperature[i],
+                                                                  composition, in.strain_rate[i],
+                                                                  viscous_flow_law, yield_mechanism).second[max_composition];
+        }
+    }
+
+
+
     template <int dim>
     PlasticAdditionalOutputs<dim>::PlasticAdditionalOutputs (const unsigned int n_points)
       :
@@ -126,6 +168,17 @@ namespace aspect
 
 
 
+    template <int dim>
+    bool
+    PlasticAdditionalOutputs<dim>::reset ()
+    {
+      for (std::vector<double> *values : {&cohesions, &friction_angles, &yielding})
+        std::fill (values->begin(), values->end(), numbers::signaling_nan<double>());
+      return true;
+    }
+
+
+
     template <int dim>
     std::pair<std::vector<double>, std::vector<bool> >
     ViscoPlastic<dim>::
@@ -318,6 +371,189 @@ namespace aspect
     }
 
 
+
+    template <int dim>
+    void
+    ViscoPlastic<dim>::
+    calculate_isostrain_viscosities_vectorized (const MaterialModel::MaterialModelInputs<dim> &in,
+                                                const ViscosityScheme &viscous_type,
+                                                const YieldScheme &yield_type,
+                                                std::vector<std::vector<double> > &composition_viscosities,
+                                                std::vector<std::vector<bool> > &composition_yielding) const
+    {
+      Assert(use_elasticity == false, ExcNotImplemented());
+
+      const unsigned int n_points = in.n_evaluation_points();
+      composition_viscosities.resize(n_points);
+      composition_yielding.resize(n_points);
+
+      if (n_points == 0)
+        return;
+
+      const unsigned int n_compositions = in.composition.n_fields() + 1;
+      for (unsigned int i=0; i<n_points; ++i)
+        {
+          composition_viscosities[i].assign(n_compositions, numbers::signaling_nan<double>());
+          composition_yielding[i].assign(n_compositions, false);
+        }
+
+      const unsigned int n_lanes =
+#if DEAL_II_VERSION_GTE(9,2,0)
+        VectorizedArray<double>::size();
+#else
+        VectorizedArray<double>::n_array_elements;
+#endif
+
+      const VectorizedArray<double> max_yield_stress = make_vectorized_array(drucker_prager_parameters.max_yield_stress);
+
+      // The compositional field values of the points in the current batch,
+      // needed for the strain weakening factors
+      std::vector<std::vector<double> > lane_compositions (n_lanes);
+
+      for (unsigned int first_point=0; first_point<n_points; first_point+=n_lanes)
+        {
+          // The last batch may contain fewer points than there are lanes. The
+          // unused lanes repeat the last point, so that all lanes hold valid
+          // values, but their results are discarded.
+          const unsigned int n_filled_lanes = std::min(n_lanes, n_points-first_point);
+          const auto point_index = [&](const unsigned int lane) -> unsigned int
+          {
+            return first_point + std::min(lane, n_filled_lanes-1);
+          };
+
+          // Gather the inputs of all points of this batch. As in
+          // calculate_isostrain_viscosities(), a reference strain rate is used
+          // in the first iteration of the first time step.
+          VectorizedArray<double> pressure;
+          VectorizedArray<double> temperature;
+          VectorizedArray<double> edot_ii;
+          for (unsigned int v=0; v<n_lanes; ++v)
+            {
+              const unsigned int i = point_index(v);
+              pressure[v] = in.pressure[i];
+              temperature[v] = in.temperature[i];
+              in.composition.get_point_values(i, lane_compositions[v]);
+
+              const bool use_reference_strainrate = (this->get_timestep_number() == 0) &&
+                                                    (in.strain_rate[i].norm() <= std::numeric_limits<double>::min());
+              if (use_reference_strainrate)
+                edot_ii[v] = ref_strain_rate;
+              else
+                edot_ii[v] = std::max(std::sqrt(std::fabs(second_invariant(deviator(in.strain_rate[i])))),
+                                      min_strain_rate);
+            }
+
+          const VectorizedArray<double> temperature_for_viscosity = temperature + adiabatic_temperature_gradient_for_viscosity*pressure;
+          for (unsigned int v=0; v<n_filled_lanes; ++v)
+            AssertThrow(temperature_for_viscosity[v] != 0, ExcMessage(
+                          "The temperature used in the calculation of the visco-plastic rheology is zero. "
+                          "This is not allowed, because this value is used to divide through. It is probably "
+                          "being caused by the temperature being zero somewhere in the model. The relevant "
+                          "values for debugging are: temperature (" + Utilities::to_string(temperature[v]) +
+                          "), adiabatic_temperature_gradient_for_viscosity ("
+                          + Utilities::to_string(adiabatic_temperature_gradient_for_viscosity) + ") and pressure ("
+                          + Utilities::to_string(pressure[v]) + ")."));
+
+          const VectorizedArray<double> pressure_for_plasticity = std::max(pressure, make_vectorized_array(0.0));
+
+          // The steps below are the same as in calculate_isostrain_viscosities()
+          // without elasticity, see there for a description.
+          for (unsigned int j=0; j<n_compositions; ++j)
+            {
+              const VectorizedArray<double> viscosity_diffusion = diffusion_creep.compute_viscosity(pressure, temperature_for_viscosity, j);
+              const VectorizedArray<double> viscosity_dislocation = dislocation_creep.compute_viscosity(edot_ii, pressure, temperature_for_viscosity, j);
+
+              VectorizedArray<double> viscosity_pre_yield;
+              switch (viscous_type)
+                {
+                  case diffusion:
+                  {
+                    viscosity_pre_yield = viscosity_diffusion;
+                    break;
+                  }
+                  case dislocation:
+                  {
+                    viscosity_pre_yield = viscosity_dislocation;
+                    break;
+                  }
+                  case composite:
+                  {
+                    viscosity_pre_yield = (viscosity_diffusion * viscosity_dislocation)/
+                                          (viscosity_diffusion + viscosity_dislocation);
+                    break;
+                  }
+                  default:
+                  {
+                    AssertThrow(false, ExcNotImplemented());
+                    break;
+                  }
+                }
+
+              viscosity_pre_yield = constant_viscosity_prefactors.compute_viscosity(viscosity_pre_yield, j);
+
+              const VectorizedArray<double> current_stress = 2. * viscosity_pre_yield * edot_ii;
+
+              // The strain weakening factors depend on the compositional fields
+              // of each point, and are therefore computed lane by lane.
+              VectorizedArray<double> current_cohesion;
+              VectorizedArray<double> current_friction;
+              VectorizedArray<double> viscous_weakening;
+              for (unsigned int v=0; v<n_lanes; ++v)
+                {
+                  const std::array<double, 3> weakening_factors = strain_rheology.compute_strain_weakening_factors(j, lane_compositions[v]);
+                  current_cohesion[v] = drucker_prager_parameters.cohesions[j] * weakening_factors[0];
+                  current_friction[v] = drucker_prager_parameters.angles_internal_friction[j] * weakening_factors[1];
+                  viscous_weakening[v] = weakening_factors[2];
+                }
+              viscosity_pre_yield *= viscous_weakening;
+
+              const VectorizedArray<double> yield_stress = drucker_prager_plasticity.compute_yield_stress(current_cohesion,
+                                                           current_friction,
+                                                           pressure_for_plasticity,
+                                                           max_yield_stress);
+
+              VectorizedArray<double> viscosity_yield = viscosity_pre_yield;
+              switch (yield_type)
+                {
+                  case stress_limiter:
+                  {
+                    const VectorizedArray<double> viscosity_limiter = yield_stress / (2.0 * ref_strain_rate)
+                                                                      * std::pow((edot_ii/ref_strain_rate),
+                                                                                 1./exponents_stress_limiter[j] - 1.0);
+                    viscosity_yield = 1. / ( 1./viscosity_limiter + 1./viscosity_pre_yield);
+                    break;
+                  }
+                  case drucker_prager:
+                  {
+                    // The plastic viscosity is computed for all lanes, but only
+                    // used for the points whose stress exceeds the yield stress.
+                    const VectorizedArray<double> viscosity_plastic = drucker_prager_plasticity.compute_viscosity(current_cohesion,
+                                                                      current_friction,
+                                                                      pressure_for_plasticity,
+                                                                      edot_ii,
+                                                                      max_yield_stress);
+                    for (unsigned int v=0; v<n_filled_lanes; ++v)
+                      if (current_stress[v] >= yield_stress[v])
+                        {
+                          viscosity_yield[v] = viscosity_plastic[v];
+                          composition_yielding[first_point+v][j] = true;
+                        }
+                    break;
+                  }
+                  default:
+                  {
+                    AssertThrow(false, ExcNotImplemented());
+                    break;
+                  }
+                }
+
+              for (unsigned int v=0; v<n_filled_lanes; ++v)
+                composition_viscosities[first_point+v][j] = std::min(std::max(viscosity_yield[v], min_visc), max_visc);
+            }
+        }
+    }
+
+
     template <int dim>
     void
     ViscoPlastic<dim>::
@@ -335,11 +571,13 @@ namespace aspect
           plastic_out->friction_angles[i] = 0;
           plastic_out->yielding[i] = plastic_yielding ? 1 : 0;
 
+          const std::vector<double> composition = in.composition[i];
+
           // set to weakened values, or unweakened values when strain weakening is not used
           for (unsigned int j=0; j < volume_fractions.size(); ++j)
             {
               // Calculate the strain weakening factors and weakened values
-              const std::array<double, 3> weakening_factors = strain_rheology.compute_strain_weakening_factors(j, in.composition[i]);
+              const std::array<double, 3> weakening_factors = strain_rheology.compute_strain_weakening_factors(j, composition);
               plastic_out->cohesions[i]   += volume_fractions[j] * (drucker_prager_parameters.cohesions[j] * weakening_factors[0]);
               // Also convert radians to degrees
               plastic_out->friction_angles[i] += 180.0/numbers::PI * volume_fractions[j] * (drucker_prager_parameters.angles_internal_friction[j] * weakening_factors[1]);
@@ -369,6 +607,8 @@ namespace aspect
 
           const double finite_difference_accuracy = 1e-7;
 
+          const std::vector<double> composition = in.composition[i];
+
           // For each independent component, compute the derivative.
           for (unsigned int component = 0; component < SymmetricTensor<2,dim>::n_independent_components; ++component)
             {
@@ -384,7 +624,7 @@ namespace aspect
                                                                     * Utilities::nth_basis_for_symmetric_tensors<dim>(component);
               std::vector<double> eta_component =
                 calculate_isostrain_viscosities(volume_fractions, in.pressure[i],
-                                                in.temperature[i], in.composition[i],
+                                                in.temperature[i], composition,
                                                 strain_rate_difference,
                                                 viscous_flow_law,yield_mechanism).first;
 
@@ -410,7 +650,7 @@ namespace aspect
 
           const std::vector<double> viscosity_difference =
             calculate_isostrain_viscosities(volume_fractions, pressure_difference,
-                                            in.temperature[i], in.composition[i], in.strain_rate[i],
+                                            in.temperature[i], composition, in.strain_rate[i],
                                             viscous_flow_law, yield_mechanism).first;
 
 
@@ -493,6 +733,19 @@ namespace aspect
       // While the number of phases is fixed, the value of the phase function is updated for every point
       std::vector<double> phase_function_values(phase_function.n_phase_transitions(), 0.0);
 
+      // Without elasticity, the viscosities of all points are computed at once
+      // by the vectorized rheology kernels before the loop over all points.
+      const bool use_vectorized_viscosities = in.requests_property(MaterialProperties::viscosity) &&
+                                              (use_elasticity == false);
+      std::vector<std::vector<double> > isostrain_viscosities;
+      std::vector<std::vector<bool> > isostrain_yielding;
+      if (use_vectorized_viscosities)
+        calculate_isostrain_viscosities_vectorized(in, viscous_flow_law, yield_mechanism,
+                                                   isostrain_viscosities, isostrain_yielding);
+
+      // The compositional field values at one point, reused for all points
+      std::vector<double> composition;
+
       // Loop through all requested points
       for (unsigned int i=0; i < in.n_evaluation_points(); ++i)
         {
@@ -527,7 +780,8 @@ namespace aspect
                                                   phase_function.n_phase_transitions_for_each_composition(),
                                                   eos_outputs);
 
-          const std::vector<double> volume_fractions = MaterialUtilities::compute_volume_fractions(in.composition[i], volumetric_compositions);
+          in.composition.get_point_values(i, composition);
+          const std::vector<double> volume_fractions = MaterialUtilities::compute_volume_fractions(composition, volumetric_compositions);
 
           // not strictly correct if thermal expansivities are different, since we are interpreting
           // these compositions as volume fractions, but the error introduced should not be too bad.
@@ -573,8 +827,15 @@ namespace aspect
               // isostrain amongst all compositions, allowing calculation of the viscosity ratio.
               // TODO: This is only consistent with viscosity averaging if the arithmetic averaging
               // scheme is chosen. It would be useful to have a function to calculate isostress viscosities.
-              const std::pair<std::vector<double>, std::vector<bool> > calculate_viscosities =
-                calculate_isostrain_viscosities(volume_fractions, in.pressure[i], in.temperature[i], in.composition[i], in.strain_rate[i],viscous_flow_law,yield_mechanism);
+              std::pair<std::vector<double>, std::vector<bool> > calculate_viscosities;
+              if (use_vectorized_viscosities)
+                {
+                  calculate_viscosities.first.swap(isostrain_viscosities[i]);
+                  calculate_viscosities.second.swap(isostrain_yielding[i]);
+                }
+              else
+                calculate_viscosities =
+                  calculate_isostrain_viscosities(volume_fractions, in.pressure[i], in.temperature[i], composition, in.strain_rate[i],viscous_flow_law,yield_mechanism);
 
               // The isostrain condition implies that the viscosity averaging should be arithmetic (see above).
               // We have given the user freedom to apply alternative bounds, because in diffusion-dominated
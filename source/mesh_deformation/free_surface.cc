@@ -64,6 +64,12 @@ namespace aspect
           return;
         }
 
+      // The stabilization term only contributes to the matrix, which is not
+      // assembled if it does not need to be rebuilt (e.g., if the matrix-free
+      // Stokes solver applies the term itself).
+      if (!scratch.rebuild_stokes_matrix)
+        return;
+
       const Introspection<dim> &introspection = this->introspection();
       const FiniteElement<dim> &fe = this->get_fe();
 
@@ -186,6 +192,15 @@ namespace aspect
 
 
 
+    template <int dim>
+    double
+    FreeSurface<dim>::get_stabilization_theta () const
+    {
+      return free_surface_theta;
+    }
+
+
+
     template <int dim>
     void FreeSurface<dim>::set_assemblers(const SimulatorAccess<dim> &,
                                           aspect::Assemblers::Manager<dim> &assemblers) const
@@ -22,6 +22,7 @@
 #include <aspect/mesh_deformation/interface.h>
 #include <aspect/simulator.h>
 #include <aspect/global.h>
+#include <aspect/stokes_matrix_free.h>
 
 #include <deal.II/dofs/dof_renumbering.h>
 #include <deal.II/dofs/dof_accessor.h>
@@ -30,6 +31,9 @@
 #include <deal.II/fe/fe_values.h>
 #include <deal.II/fe/fe_q.h>
 #include <deal.II/fe/mapping_q1_eulerian.h>
+#include <deal.II/fe/mapping_q_eulerian.h>
+
+#include <deal.II/multigrid/mg_transfer_matrix_free.h>
 
 #include <deal.II/lac/sparsity_tools.h>
 
@@ -323,6 +327,15 @@ namespace aspect
       // is needed for the ALE corrections.
       interpolate_mesh_velocity();
 
+      // The matrix-free Stokes solver stores the geometry of the mesh
+      // on all multigrid levels, so it needs to be told about the new
+      // shape of the mesh.
+      if (sim.stokes_matrix_free)
+        {
+          update_multilevel_deformation();
+          sim.stokes_matrix_free->update_mapping();
+        }
+
       // After changing the mesh we need to rebuild things
       sim.rebuild_stokes_matrix = sim.rebuild_stokes_preconditioner = true;
     }
@@ -682,6 +695,76 @@ namespace aspect
       // Now reset the mapping of the simulator to be something that captures mesh deformation in time.
       sim.mapping.reset (new MappingQ1Eulerian<dim, LinearAlgebra::Vector> (mesh_deformation_dof_handler,
                                                                             mesh_displacements));
+
+      // The matrix-free GMG Stokes solver also needs a description of the
+      // deformed mesh on each multigrid level.
+      if (sim.stokes_matrix_free)
+        {
+#if DEAL_II_VERSION_GTE(9,2,0)
+          mesh_deformation_dof_handler.distribute_mg_dofs();
+
+          level_displacement_transfer.clear();
+          level_displacement_transfer.build(mesh_deformation_dof_handler);
+          distributed_mesh_displacements.reinit(mesh_locally_owned,
+                                                mesh_locally_relevant,
+                                                sim.mpi_communicator);
+
+          // The mappings store references to the displacement vectors, so
+          // we need to destroy them first.
+          const unsigned int n_levels = sim.triangulation.n_global_levels();
+          level_mappings.resize(0, n_levels-1);
+          level_displacements.resize(0, n_levels-1);
+
+          for (unsigned int level = 0; level < n_levels; ++level)
+            {
+              IndexSet relevant_mg_dofs;
+              DoFTools::extract_locally_relevant_level_dofs(mesh_deformation_dof_handler,
+                                                            level,
+                                                            relevant_mg_dofs);
+              level_displacements[level].reinit(mesh_deformation_dof_handler.locally_owned_mg_dofs(level),
+                                                relevant_mg_dofs,
+                                                sim.mpi_communicator);
+
+              level_mappings[level].reset(new MappingQEulerian<dim, dealii::LinearAlgebra::distributed::Vector<double> >
+                                          (/* degree = */ 1,
+                                           mesh_deformation_dof_handler,
+                                           level_displacements[level],
+                                           level));
+            }
+
+          update_multilevel_deformation();
+#else
+          AssertThrow(false, ExcMessage("The matrix-free Stokes solver with mesh deformation "
+                                        "requires deal.II 9.2 or newer."));
+#endif
+        }
+    }
+
+
+
+    template <int dim>
+    void MeshDeformationHandler<dim>::update_multilevel_deformation ()
+    {
+      if (!sim.stokes_matrix_free)
+        return;
+
+      // Copy the displacements into a deal.II vector that the multigrid
+      // transfer can work with. The vector and the transfer are set up in
+      // setup_dofs().
+      distributed_mesh_displacements.zero_out_ghosts();
+      for (const auto index : mesh_locally_owned)
+        distributed_mesh_displacements(index) = mesh_displacements(index);
+      distributed_mesh_displacements.update_ghost_values();
+
+      level_displacement_transfer.interpolate_to_mg(mesh_deformation_dof_handler,
+                                                    level_displacements,
+                                                    distributed_mesh_displacements);
+
+      // The level mappings need the displacements of all vertices of the
+      // locally relevant level cells:
+      for (unsigned int level = level_displacements.min_level();
+           level <= level_displacements.max_level(); ++level)
+        level_displacements[level].update_ghost_values();
     }
 
 
@@ -730,6 +813,17 @@ namespace aspect
 
 
 
+    template <int dim>
+    const Mapping<dim> &
+    MeshDeformationHandler<dim>::get_level_mapping (const unsigned int level) const
+    {
+      Assert(level_mappings.n_levels() > 0 && level_mappings[level] != nullptr,
+             ExcMessage("Level mappings are only available for the matrix-free GMG Stokes solver."));
+      return *level_mappings[level];
+    }
+
+
+
     template <int dim>
     std::string
     get_valid_model_names_pattern ()
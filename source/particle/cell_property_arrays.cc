@@ -0,0 +1,113 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <aspect/particle/cell_property_arrays.h>
+
+namespace aspect
+{
+  namespace Particle
+  {
+    template <int dim>
+    CellPropertyArrays<dim>::CellPropertyArrays ()
+      :
+      n_particles_in_cell (0)
+    {}
+
+
+
+    template <int dim>
+    void
+    CellPropertyArrays<dim>::reinit (const typename ParticleHandler<dim>::particle_iterator_range &particles,
+                                     const ComponentMask &selected_properties)
+    {
+      n_particles_in_cell = std::distance(particles.begin(), particles.end());
+
+      const unsigned int n_properties = (n_particles_in_cell > 0
+                                         ?
+                                         particles.begin()->get_properties().size()
+                                         :
+                                         selected_properties.size());
+
+      Assert (selected_properties.represents_n_components(n_properties),
+              ExcMessage ("The component mask of the selected particle properties needs "
+                          "to have one entry for every particle property."));
+
+      selected_property_indices.clear();
+      array_index.assign(n_properties, numbers::invalid_unsigned_int);
+      for (unsigned int i=0; i<n_properties; ++i)
+        if (selected_properties[i] == true)
+          {
+            array_index[i] = selected_property_indices.size();
+            selected_property_indices.push_back(i);
+          }
+
+      property_values.resize_fast(selected_property_indices.size() * n_particles_in_cell);
+
+      // Accessing the properties of a particle is comparably expensive, so
+      // loop over the particles only once and copy all selected properties
+      // of each particle into their arrays.
+      unsigned int particle_index = 0;
+      for (typename ParticleHandler<dim>::particle_iterator particle = particles.begin();
+           particle != particles.end(); ++particle, ++particle_index)
+        {
+          const ArrayView<const double> properties = particle->get_properties();
+
+          for (unsigned int a=0; a<selected_property_indices.size(); ++a)
+            property_values[a * n_particles_in_cell + particle_index] = properties[selected_property_indices[a]];
+        }
+    }
+
+
+
+    template <int dim>
+    void
+    CellPropertyArrays<dim>::write_properties (const typename ParticleHandler<dim>::particle_iterator_range &particles) const
+    {
+      Assert (static_cast<unsigned int>(std::distance(particles.begin(), particles.end())) == n_particles_in_cell,
+              ExcMessage ("The number of particles does not match the number of particles "
+                          "this object was initialized with."));
+
+      unsigned int particle_index = 0;
+      for (typename ParticleHandler<dim>::particle_iterator particle = particles.begin();
+           particle != particles.end(); ++particle, ++particle_index)
+        {
+          const ArrayView<double> properties = particle->get_properties();
+
+          for (unsigned int a=0; a<selected_property_indices.size(); ++a)
+            properties[selected_property_indices[a]] = property_values[a * n_particles_in_cell + particle_index];
+        }
+    }
+  }
+}
+
+
+// explicit instantiation of the functions we implement in this file
+namespace aspect
+{
+  namespace Particle
+  {
+#define INSTANTIATE(dim) \
+  template class CellPropertyArrays<dim>;
+
+    ASPECT_INSTANTIATE(INSTANTIATE)
+
+#undef INSTANTIATE
+  }
+}
@@ -20,7 +20,10 @@
 
 #include <aspect/particle/generator/interface.h>
 
+#include <aspect/compat.h>
+
 #include <tuple>
+#include <deal.II/grid/filtered_iterator.h>
 #include <deal.II/grid/grid_tools.h>
 
 #include <boost/lexical_cast.hpp>
@@ -33,13 +36,17 @@ namespace aspect
     {
       template <int dim>
       Interface<dim>::Interface()
+        :
+        local_bounding_boxes_are_valid(false)
       {}
 
 
 
       template <int dim>
       Interface<dim>::~Interface ()
-      {}
+      {
+        mesh_changed_connection.disconnect();
+      }
 
 
 
@@ -49,6 +56,57 @@ namespace aspect
       {
         const unsigned int my_rank = Utilities::MPI::this_mpi_process(this->get_mpi_communicator());
         random_number_generator.seed(5432+my_rank);
+
+        grid_cache = std_cxx14::make_unique<GridTools::Cache<dim> >(this->get_triangulation(),
+                                                                     this->get_mapping());
+
+        mesh_changed_connection = this->get_triangulation().signals.any_change.connect(
+                                    [&]()
+        {
+          local_bounding_boxes_are_valid = false;
+          last_cell = typename Triangulation<dim>::active_cell_iterator();
+        });
+      }
+
+
+
+      template <int dim>
+      void
+      Interface<dim>::compute_local_bounding_boxes () const
+      {
+        local_bounding_boxes.clear();
+
+        double max_cell_diameter = 0.0;
+        for (const auto &cell : this->get_triangulation().active_cell_iterators())
+          if (cell->is_locally_owned())
+            max_cell_diameter = std::max(cell->diameter(), max_cell_diameter);
+
+        if (max_cell_diameter > 0.0)
+          {
+            // Merge the boxes of the cells on a coarse level to keep their
+            // number small
+            const std::vector<BoundingBox<dim> > boxes
+              = GridTools::compute_mesh_predicate_bounding_box(this->get_triangulation(),
+                                                               std::function<bool (const typename Triangulation<dim>::active_cell_iterator &)>
+                                                               (IteratorFilters::LocallyOwnedCell()),
+                                                               std::min(this->get_triangulation().n_levels() - 1, 2u),
+                                                               /*allow_merge=*/ true);
+
+            // The boxes only contain the vertices of the cells, but curved
+            // cells can extend beyond them, by less than their diameter
+            for (const auto &box : boxes)
+              {
+                std::pair<Point<dim>,Point<dim> > corners = box.get_boundary_points();
+                for (unsigned int d=0; d<dim; ++d)
+                  {
+                    corners.first[d] -= max_cell_diameter;
+                    corners.second[d] += max_cell_diameter;
+                  }
+                local_bounding_boxes.emplace_back(corners);
+              }
+          }
+
+        local_bounding_boxes_are_valid = true;
       }
 
 
@@ -58,19 +116,40 @@ namespace aspect
       Interface<dim>::generate_particle(const Point<dim> &position,
                                         const types::particle_index id) const
       {
+        Assert (grid_cache != nullptr,
+                ExcMessage ("The particle generator needs to be initialized before generating particles."));
+
+        if (local_bounding_boxes_are_valid == false)
+          compute_local_bounding_boxes();
+
+        // Reject positions that are far away from all locally owned cells
+        // without searching the mesh
+        bool is_in_local_box = false;
+        for (const auto &box : local_bounding_boxes)
+          if (box.point_inside(position))
+            {
+              is_in_local_box = true;
+              break;
+            }
+
+        AssertThrow(is_in_local_box,
+                    ExcParticlePointNotInDomain());
+
         // Try to find the cell of the given position. If the position is not
         // in the domain on the local process, throw a ExcParticlePointNotInDomain
         // exception.
         try
           {
-            std::pair<const typename parallel::distributed::Triangulation<dim>::active_cell_iterator,
-                Point<dim> > it =
-                  GridTools::find_active_cell_around_point<> (this->get_mapping(), this->get_triangulation(), position);
+            const std::pair<const typename Triangulation<dim>::active_cell_iterator,
+                  Point<dim> > it =
+                    GridTools::find_active_cell_around_point<dim,dim> (*grid_cache, position, last_cell);
 
             // Only try to add the point if the cell it is in, is on this processor
-            AssertThrow(it.first->is_locally_owned(),
+            AssertThrow(it.first.state() == IteratorState::valid && it.first->is_locally_owned(),
                         ExcParticlePointNotInDomain());
 
+            last_cell = it.first;
+
             const Particle<dim> particle(position, it.second, id);
             const Particles::internal::LevelInd cell(it.first->level(), it.first->index());
             return std::make_pair(cell,particle);
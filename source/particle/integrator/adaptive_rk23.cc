@@ -0,0 +1,446 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+ This file is part of ASPECT.
+
+ ASPECT is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2, or (at your option)
+ any later version.
+
+ ASPECT is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with ASPECT; see the file LICENSE.  If not see
+ <http://www.gnu.org/licenses/>.
+ */
+
+#include <aspect/particle/integrator/adaptive_rk23.h>
+
+#include <deal.II/base/mpi.h>
+
+namespace aspect
+{
+  namespace Particle
+  {
+    namespace Integrator
+    {
+      template <int dim>
+      AdaptiveRK23<dim>::AdaptiveRK23()
+        :
+        integrator_substep(0),
+        n_unfinished_particles(0),
+        relative_tolerance(1e-4),
+        minimum_substep_fraction(0.01)
+      {}
+
+
+
+      template <int dim>
+      void
+      AdaptiveRK23<dim>::integrate_particle (const typename ParticleHandler<dim>::particle_iterator &particle,
+                                             ParticleState &state,
+                                             const Tensor<1,dim> &old_velocity,
+                                             const Tensor<1,dim> &velocity,
+                                             const double dt) const
+      {
+        // The velocity at the current location of the particle at the given
+        // fraction of the time step
+        const auto velocity_at = [&](const double time_fraction) -> Tensor<1,dim>
+        {
+          return (1.0 - time_fraction) * old_velocity + time_fraction * velocity;
+        };
+
+        const double h = state.substep_fraction * dt;
+        std::array<Tensor<1,dim>,3> &k = state.stage_velocities;
+
+        switch (state.stage)
+          {
+            case 0:
+            {
+              k[0] = velocity_at(state.time_fraction);
+              break;
+            }
+
+            case 1:
+            {
+              k[1] = velocity_at(state.time_fraction + 0.5 * state.substep_fraction);
+              particle->set_location(state.start_location + 0.75 * h * k[1]);
+              state.stage = 2;
+              return;
+            }
+
+            case 2:
+            {
+              k[2] = velocity_at(state.time_fraction + 0.75 * state.substep_fraction);
+              particle->set_location(state.start_location + h * (2./9. * k[0] + 1./3. * k[1] + 4./9. * k[2]));
+              state.stage = 3;
+              return;
+            }
+
+            case 3:
+            {
+              // The particle is at the third order solution of the substep.
+              // Compare it with the embedded second order solution, which
+              // additionally requires the velocity at the new location.
+              const Point<dim> new_location = particle->get_location();
+              const Tensor<1,dim> k_new = velocity_at(state.time_fraction + state.substep_fraction);
+
+              const double error = h * (5./72. * k[0] - 1./12. * k[1] - 1./9. * k[2] + 1./8. * k_new).norm();
+              const double allowed_error = relative_tolerance * new_location.distance(state.start_location);
+
+              // Scale the substep length such that the error of the next
+              // substep is close to the allowed error, but do not change it
+              // by too much at once.
+              const double scaling_factor = (error > 0.0
+                                             ?
+                                             std::min(std::max(0.9 * std::cbrt(allowed_error / error), 0.2), 5.0)
+                                             :
+                                             5.0);
+
+              if (error <= allowed_error || state.substep_fraction <= minimum_substep_fraction * (1.0 + 1e-12))
+                {
+                  // Accept the substep. The velocity at the new location is
+                  // the first stage of the next substep.
+                  state.time_fraction += state.substep_fraction;
+                  state.start_location = new_location;
+                  k[0] = k_new;
+
+                  const double next_substep_fraction = std::max(state.substep_fraction * scaling_factor,
+                                                                minimum_substep_fraction);
+
+                  if (state.time_fraction >= 1.0 - 1e-12)
+                    {
+                      state.substep_fraction = std::min(next_substep_fraction, 1.0);
+                      state.stage = finished_stage;
+                      return;
+                    }
+
+                  state.substep_fraction = std::min(next_substep_fraction, 1.0 - state.time_fraction);
+                }
+              else
+                {
+                  // Reject the substep and repeat it with a shorter length.
+                  // The first stage is still valid.
+                  state.substep_fraction = std::max(state.substep_fraction * scaling_factor,
+                                                    minimum_substep_fraction);
+                }
+              break;
+            }
+
+            case finished_stage:
+              return;
+
+            default:
+              Assert(false, ExcInternalError());
+          }
+
+        // Start a new substep from the current start location, for which the
+        // velocity of the first stage is known.
+        particle->set_location(state.start_location + 0.5 * state.substep_fraction * dt * k[0]);
+        state.stage = 1;
+      }
+
+
+
+      template <int dim>
+      void
+      AdaptiveRK23<dim>::local_integrate_step(const typename ParticleHandler<dim>::particle_iterator &begin_particle,
+                                              const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                                              const std::vector<Tensor<1,dim> > &old_velocities,
+                                              const std::vector<Tensor<1,dim> > &velocities,
+                                              const double dt)
+      {
+        Assert(static_cast<unsigned int> (std::distance(begin_particle, end_particle)) == old_velocities.size(),
+               ExcMessage("The particle integrator expects the old velocity vector to be of equal size "
+                          "to the number of particles to advect. For some unknown reason they are different, "
+                          "most likely something went wrong in the calling function."));
+
+        Assert(old_velocities.size() == velocities.size(),
+               ExcMessage("The particle integrator expects the velocity vector to be of equal size "
+                          "to the number of particles to advect. For some unknown reason they are different, "
+                          "most likely something went wrong in the calling function."));
+
+        typename std::vector<Tensor<1,dim> >::const_iterator old_velocity = old_velocities.begin();
+        typename std::vector<Tensor<1,dim> >::const_iterator velocity = velocities.begin();
+
+        unsigned int cell_unfinished_particles = 0;
+
+        if (integrator_substep == 0)
+          {
+            // This function is called for several cells at the same time. We
+            // therefore collect the new states of the particles of this cell,
+            // and only insert them into the map once we hold the lock.
+            // previous_particle_states is only read during the integration.
+            std::vector<std::pair<types::particle_index, ParticleState> > cell_states;
+            cell_states.reserve(velocities.size());
+
+            for (typename ParticleHandler<dim>::particle_iterator it = begin_particle;
+                 it != end_particle; ++it, ++velocity, ++old_velocity)
+              {
+                ParticleState state;
+                state.start_location = it->get_location();
+                state.time_fraction = 0.0;
+                state.stage = 0;
+
+                // Start with the length of the last substep of the previous
+                // time step, or with the whole time step for new particles
+                const auto previous_state = previous_particle_states.find(it->get_id());
+                state.substep_fraction = (previous_state != previous_particle_states.end()
+                                          ?
+                                          previous_state->second.substep_fraction
+                                          :
+                                          1.0);
+
+                integrate_particle(it, state, *old_velocity, *velocity, dt);
+                cell_states.emplace_back(it->get_id(), state);
+
+                if (state.stage != finished_stage)
+                  ++cell_unfinished_particles;
+              }
+
+            std::lock_guard<std::mutex> lock(data_mutex);
+            particle_states.insert(cell_states.begin(), cell_states.end());
+            n_unfinished_particles += cell_unfinished_particles;
+          }
+        else
+          {
+            // In all later steps, the map entries already exist and every
+            // entry is only modified by the thread that works on the cell
+            // of the particle, which can happen concurrently.
+            for (typename ParticleHandler<dim>::particle_iterator it = begin_particle;
+                 it != end_particle; ++it, ++velocity, ++old_velocity)
+              {
+                const auto state = particle_states.find(it->get_id());
+                Assert(state != particle_states.end(),
+                       ExcMessage("The adaptive RK23 integrator did not find the integration "
+                                  "state of a particle."));
+
+                integrate_particle(it, state->second, *old_velocity, *velocity, dt);
+
+                if (state->second.stage != finished_stage)
+                  ++cell_unfinished_particles;
+              }
+
+            std::lock_guard<std::mutex> lock(data_mutex);
+            n_unfinished_particles += cell_unfinished_particles;
+          }
+      }
+
+
+
+      template <int dim>
+      bool
+      AdaptiveRK23<dim>::new_integration_step()
+      {
+        const bool continue_integration
+          = (Utilities::MPI::max(n_unfinished_particles, this->get_mpi_communicator()) > 0);
+
+        n_unfinished_particles = 0;
+
+        if (continue_integration)
+          ++integrator_substep;
+        else
+          {
+            // Keep the states of this time step to initialize the substep
+            // lengths in the next one. Particles that were removed in the
+            // meantime are dropped from the map at the end of the next time
+            // step.
+            previous_particle_states.swap(particle_states);
+            particle_states.clear();
+            integrator_substep = 0;
+          }
+
+        return continue_integration;
+      }
+
+
+
+      template <int dim>
+      std::size_t
+      AdaptiveRK23<dim>::get_data_size() const
+      {
+        // The start location and the three stage velocities, as well as the
+        // time fraction, the substep fraction, and the stage. The data is
+        // also needed between time steps to keep the substep length.
+        return (4 * dim + 3) * sizeof(double);
+      }
+
+
+
+      template <int dim>
+      const void *
+      AdaptiveRK23<dim>::read_data(const typename ParticleHandler<dim>::particle_iterator &particle,
+                                   const void *data)
+      {
+        const double *integrator_data = static_cast<const double *> (data);
+
+        // Between time steps, only the states of the previous time step are
+        // kept.
+        ParticleState &state = (integrator_substep == 0
+                                ?
+                                previous_particle_states[particle->get_id()]
+                                :
+                                particle_states[particle->get_id()]);
+
+        for (unsigned int i=0; i<dim; ++i)
+          state.start_location[i] = *integrator_data++;
+
+        for (unsigned int s=0; s<3; ++s)
+          for (unsigned int i=0; i<dim; ++i)
+            state.stage_velocities[s][i] = *integrator_data++;
+
+        state.time_fraction = *integrator_data++;
+        state.substep_fraction = *integrator_data++;
+        state.stage = static_cast<unsigned int>(*integrator_data++);
+
+        return static_cast<const void *> (integrator_data);
+      }
+
+
+
+      template <int dim>
+      void *
+      AdaptiveRK23<dim>::write_data(const typename ParticleHandler<dim>::particle_iterator &particle,
+                                    void *data) const
+      {
+        double *integrator_data = static_cast<double *> (data);
+
+        ParticleState state;
+        auto it = particle_states.find(particle->get_id());
+        if (it != particle_states.end())
+          state = it->second;
+        else
+          {
+            it = previous_particle_states.find(particle->get_id());
+            if (it != previous_particle_states.end())
+              state = it->second;
+            else
+              {
+                // A particle that has not been integrated yet
+                state.start_location = particle->get_location();
+                state.time_fraction = 0.0;
+                state.substep_fraction = 1.0;
+                state.stage = finished_stage;
+              }
+          }
+
+        for (unsigned int i=0; i<dim; ++i,++integrator_data)
+          *integrator_data = state.start_location[i];
+
+        for (unsigned int s=0; s<3; ++s)
+          for (unsigned int i=0; i<dim; ++i,++integrator_data)
+            *integrator_data = state.stage_velocities[s][i];
+
+        *integrator_data++ = state.time_fraction;
+        *integrator_data++ = state.substep_fraction;
+        *integrator_data++ = state.stage;
+
+        return static_cast<void *> (integrator_data);
+      }
+
+
+
+      template <int dim>
+      void
+      AdaptiveRK23<dim>::declare_parameters (ParameterHandler &prm)
+      {
+        prm.enter_subsection("Postprocess");
+        {
+          prm.enter_subsection("Particles");
+          {
+            prm.enter_subsection("Integrator");
+            {
+              prm.enter_subsection("Adaptive RK23");
+              {
+                prm.declare_entry ("Relative tolerance", "1e-4",
+                                   Patterns::Double (0.),
+                                   "The allowed error of the trajectory of a particle in one "
+                                   "substep, relative to the distance the particle moved in "
+                                   "this substep. The error is estimated by the difference "
+                                   "between the third order and the embedded second order "
+                                   "solution. Smaller values lead to shorter substeps in "
+                                   "regions where the velocity varies strongly along the "
+                                   "path of the particles.");
+                prm.declare_entry ("Minimum substep fraction", "0.01",
+                                   Patterns::Double (0., 1.),
+                                   "The smallest allowed substep length as a fraction of the "
+                                   "time step. Substeps of this length are accepted regardless "
+                                   "of their error. This bounds the number of substeps, and "
+                                   "therefore the number of integration steps, per time step.");
+              }
+              prm.leave_subsection();
+            }
+            prm.leave_subsection();
+          }
+          prm.leave_subsection();
+        }
+        prm.leave_subsection();
+      }
+
+
+
+      template <int dim>
+      void
+      AdaptiveRK23<dim>::parse_parameters (ParameterHandler &prm)
+      {
+        prm.enter_subsection("Postprocess");
+        {
+          prm.enter_subsection("Particles");
+          {
+            prm.enter_subsection("Integrator");
+            {
+              prm.enter_subsection("Adaptive RK23");
+              {
+                relative_tolerance = prm.get_double ("Relative tolerance");
+                minimum_substep_fraction = prm.get_double ("Minimum substep fraction");
+
+                AssertThrow(minimum_substep_fraction > 0.0,
+                            ExcMessage("The minimum substep fraction of the adaptive RK23 "
+                                       "integrator needs to be larger than zero."));
+              }
+              prm.leave_subsection();
+            }
+            prm.leave_subsection();
+          }
+          prm.leave_subsection();
+        }
+        prm.leave_subsection();
+      }
+    }
+  }
+}
+
+
+// explicit instantiations
+namespace aspect
+{
+  namespace Particle
+  {
+    namespace Integrator
+    {
+      ASPECT_REGISTER_PARTICLE_INTEGRATOR(AdaptiveRK23,
+                                          "adaptive rk23",
+                                          "Adaptive third order Runge Kutta integrator based on the "
+                                          "embedded scheme of Bogacki and Shampine. Every particle "
+                                          "moves through the time step in its own sequence of substeps, "
+                                          "whose lengths are controlled by the difference between the "
+                                          "third order and the embedded second order solution. Each stage "
+                                          "of a substep requires one integration step, i.e., one evaluation "
+                                          "of the velocity for all particles. A time step therefore takes "
+                                          "at least four integration steps: three for the stages of the first "
+                                          "substep and one for the velocity at its end point, which is "
+                                          "needed for the error estimate. Particles in smooth flow can cover "
+                                          "the whole time step with this one substep, while every further "
+                                          "or repeated substep, e.g. in regions where the velocity varies "
+                                          "strongly along the path of a particle, adds three integration "
+                                          "steps. The integration continues until all particles have reached "
+                                          "the end of the time step. Velocities between the old and new time "
+                                          "are interpolated linearly. The parameters are set in the subsection "
+                                          "`Postprocess/Particles/Integrator/Adaptive RK23'.")
+    }
+  }
+}
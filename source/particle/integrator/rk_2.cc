@@ -53,6 +53,14 @@ namespace aspect
         typename std::vector<Tensor<1,dim> >::const_iterator old_velocity = old_velocities.begin();
         typename std::vector<Tensor<1,dim> >::const_iterator velocity = velocities.begin();
 
+        // This function is called for several cells at the same time. We
+        // therefore collect the new entries of loc0 for this cell, and only
+        // insert them into the map once we hold the lock. In the second
+        // step the map is only read, which can happen concurrently.
+        std::vector<std::pair<types::particle_index, Point<dim> > > cell_loc0;
+        if (integrator_substep == 0)
+          cell_loc0.reserve(velocities.size());
+
         for (typename ParticleHandler<dim>::particle_iterator it = begin_particle;
              it != end_particle; ++it, ++velocity, ++old_velocity)
           {
@@ -60,12 +68,12 @@ namespace aspect
             const Point<dim> loc = it->get_location();
             if (integrator_substep == 0)
               {
-                loc0[particle_id] = loc;
+                cell_loc0.emplace_back(particle_id, loc);
                 it->set_location(loc + 0.5 * dt * (*old_velocity));
               }
             else if (integrator_substep == 1)
               {
-                it->set_location(loc0[particle_id] + dt * (*old_velocity + *velocity) / 2.0);
+                it->set_location(loc0.find(particle_id)->second + dt * (*old_velocity + *velocity) / 2.0);
               }
             else
               {
@@ -73,6 +81,12 @@ namespace aspect
                        ExcMessage("The RK2 integrator should never continue after two integration steps."));
               }
           }
+
+        if (cell_loc0.size() > 0)
+          {
+            std::lock_guard<std::mutex> lock(data_mutex);
+            loc0.insert(cell_loc0.begin(), cell_loc0.end());
+          }
       }
 
       template <int dim>
@@ -132,10 +146,13 @@ namespace aspect
 
         double *integrator_data = static_cast<double *> (data);
 
-        // Write location data
+        // Write location data. Between time steps, e.g., when a checkpoint
+        // is created, no data is stored, and the current location is written
+        // instead.
         const typename std::map<types::particle_index, Point<dim> >::const_iterator it = loc0.find(particle->get_id());
+        const Point<dim> location = (it != loc0.end() ? it->second : particle->get_location());
         for (unsigned int i=0; i<dim; ++i,++integrator_data)
-          *integrator_data = it->second(i);
+          *integrator_data = location(i);
 
         return static_cast<void *> (integrator_data);
       }
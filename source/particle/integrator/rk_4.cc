@@ -55,30 +55,49 @@ namespace aspect
         typename std::vector<Tensor<1,dim> >::const_iterator old_velocity = old_velocities.begin();
         typename std::vector<Tensor<1,dim> >::const_iterator velocity = velocities.begin();
 
+        // This function is called for several cells at the same time. We
+        // therefore collect the new entries of the maps for this cell, and
+        // only insert them once we hold the lock. Every step only reads
+        // from maps that are not modified during that step, which can
+        // happen concurrently.
+        std::vector<std::pair<types::particle_index, Point<dim> > > cell_loc0;
+        std::vector<std::pair<types::particle_index, Tensor<1,dim> > > cell_k;
+        if (integrator_substep < 3)
+          cell_k.reserve(velocities.size());
+        if (integrator_substep == 0)
+          cell_loc0.reserve(velocities.size());
+
         for (typename ParticleHandler<dim>::particle_iterator it = begin_particle;
              it != end_particle; ++it, ++velocity, ++old_velocity)
           {
             const types::particle_index particle_id = it->get_id();
             if (integrator_substep == 0)
               {
-                loc0[particle_id] = it->get_location();
-                k1[particle_id] = dt * (*old_velocity);
-                it->set_location(it->get_location() + 0.5*k1[particle_id]);
+                const Tensor<1,dim> k1_value = dt * (*old_velocity);
+                cell_loc0.emplace_back(particle_id, it->get_location());
+                cell_k.emplace_back(particle_id, k1_value);
+                it->set_location(it->get_location() + 0.5*k1_value);
               }
             else if (integrator_substep == 1)
               {
-                k2[particle_id] = dt * (*old_velocity + *velocity) / 2.0;
-                it->set_location(loc0[particle_id] + 0.5*k2[particle_id]);
+                const Tensor<1,dim> k2_value = dt * (*old_velocity + *velocity) / 2.0;
+                cell_k.emplace_back(particle_id, k2_value);
+                it->set_location(loc0.find(particle_id)->second + 0.5*k2_value);
               }
             else if (integrator_substep == 2)
               {
-                k3[particle_id] = dt * (*old_velocity + *velocity) / 2.0;
-                it->set_location(loc0[particle_id] + k3[particle_id]);
+                const Tensor<1,dim> k3_value = dt * (*old_velocity + *velocity) / 2.0;
+                cell_k.emplace_back(particle_id, k3_value);
+                it->set_location(loc0.find(particle_id)->second + k3_value);
               }
             else if (integrator_substep == 3)
               {
                 const Tensor<1,dim> k4 = dt * (*velocity);
-                it->set_location(loc0[particle_id] + (k1[particle_id] + 2.0*k2[particle_id] + 2.0*k3[particle_id] + k4)/6.0);
+                it->set_location(loc0.find(particle_id)->second
+                                 + (k1.find(particle_id)->second
+                                    + 2.0*k2.find(particle_id)->second
+                                    + 2.0*k3.find(particle_id)->second
+                                    + k4)/6.0);
               }
             else
               {
@@ -86,6 +105,19 @@ namespace aspect
                        ExcMessage("The RK4 integrator should never continue after four integration steps."));
               }
           }
+
+        if (cell_k.size() > 0)
+          {
+            std::map<types::particle_index, Tensor<1,dim> > &k = (integrator_substep == 0
+                                                                  ?
+                                                                  k1
+                                                                  :
+                                                                  (integrator_substep == 1 ? k2 : k3));
+
+            std::lock_guard<std::mutex> lock(data_mutex);
+            loc0.insert(cell_loc0.begin(), cell_loc0.end());
+            k.insert(cell_k.begin(), cell_k.end());
+          }
       }
 
       template <int dim>
@@ -162,23 +194,22 @@ namespace aspect
 
         double *integrator_data = static_cast<double *> (data);
 
-        // Write location data
+        // Write location data. Between time steps, e.g., when a checkpoint
+        // is created, no data is stored, and the current location and zero
+        // velocities are written instead.
         typename std::map<types::particle_index, Point<dim> >::const_iterator it = loc0.find(particle->get_id());
+        const Point<dim> location = (it != loc0.end() ? it->second : particle->get_location());
         for (unsigned int i=0; i<dim; ++i,++integrator_data)
-          *integrator_data = it->second(i);
+          *integrator_data = location(i);
 
         // Write k1, k2 and k3
-        typename std::map<types::particle_index, Tensor<1,dim> >::const_iterator it_k = k1.find(particle->get_id());
-        for (unsigned int i=0; i<dim; ++i,++integrator_data)
-          *integrator_data = it_k->second[i];
-
-        it_k = k2.find(particle->get_id());
-        for (unsigned int i=0; i<dim; ++i,++integrator_data)
-          *integrator_data = it_k->second[i];
-
-        it_k = k3.find(particle->get_id());
-        for (unsigned int i=0; i<dim; ++i,++integrator_data)
-          *integrator_data = it_k->second[i];
+        for (const auto *k : {&k1, &k2, &k3})
+          {
+            typename std::map<types::particle_index, Tensor<1,dim> >::const_iterator it_k = k->find(particle->get_id());
+            const Tensor<1,dim> velocity = (it_k != k->end() ? it_k->second : Tensor<1,dim>());
+            for (unsigned int i=0; i<dim; ++i,++integrator_data)
+              *integrator_data = velocity[i];
+          }
 
         return static_cast<void *> (integrator_data);
       }
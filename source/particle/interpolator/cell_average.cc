@@ -74,19 +74,22 @@ namespace aspect
 
         if (n_particles > 0)
           {
-            for (typename ParticleHandler<dim>::particle_iterator particle = particle_range.begin();
-                 particle != particle_range.end(); ++particle)
-              {
-                const ArrayView<const double> &particle_properties = particle->get_properties();
-
-                for (unsigned int i = 0; i < particle_properties.size(); ++i)
-                  if (selected_properties[i])
-                    cell_properties[i] += particle_properties[i];
-              }
+            // Copy each selected property of all particles into a contiguous
+            // array, so that the sums below stream over memory with unit stride
+            CellPropertyArrays<dim> &cell_property_arrays = property_arrays.get();
+            cell_property_arrays.reinit(particle_range, selected_properties);
 
             for (unsigned int i = 0; i < n_particle_properties; ++i)
               if (selected_properties[i])
-                cell_properties[i] /= n_particles;
+                {
+                  const ArrayView<const double> property_values = cell_property_arrays.get_property_values(i);
+
+                  double sum = 0.0;
+                  for (unsigned int p = 0; p < n_particles; ++p)
+                    sum += property_values[p];
+
+                  cell_properties[i] = sum / n_particles;
+                }
           }
         // If there are no particles in this cell use the average of the
         // neighboring cells.
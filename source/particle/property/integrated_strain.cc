@@ -38,45 +38,51 @@ namespace aspect
 
       template <int dim>
       void
-      IntegratedStrain<dim>::update_particle_property(const unsigned int data_position,
-                                                      const Vector<double> &/*solution*/,
-                                                      const std::vector<Tensor<1,dim> > &gradients,
-                                                      typename ParticleHandler<dim>::particle_iterator &particle) const
+      IntegratedStrain<dim>::update_particle_properties(const unsigned int data_position,
+                                                        const ArrayView<const double> &/*solution*/,
+                                                        const ArrayView<const Tensor<1,dim> > &gradients,
+                                                        typename ParticleHandler<dim>::particle_iterator_range &particles) const
       {
-        auto &data = particle->get_properties();
+        const double dt = this->get_timestep();
+        const unsigned int n_components = this->introspection().n_components;
 
-        Tensor<2,dim> old_strain;
-        for (unsigned int i = 0; i < Tensor<2,dim>::n_independent_components ; ++i)
-          old_strain[Tensor<2,dim>::unrolled_to_component_indices(i)] = data[data_position + i];
+        unsigned int p = 0;
+        for (typename ParticleHandler<dim>::particle_iterator particle = particles.begin();
+             particle != particles.end(); ++particle, ++p)
+          {
+            auto &data = particle->get_properties();
 
-        Tensor<2,dim> grad_u;
-        for (unsigned int d=0; d<dim; ++d)
-          grad_u[d] = gradients[d];
+            Tensor<2,dim> old_strain;
+            for (unsigned int i = 0; i < Tensor<2,dim>::n_independent_components ; ++i)
+              old_strain[Tensor<2,dim>::unrolled_to_component_indices(i)] = data[data_position + i];
 
-        const double dt = this->get_timestep();
+            Tensor<2,dim> grad_u;
+            for (unsigned int d=0; d<dim; ++d)
+              grad_u[d] = gradients[p*n_components + this->introspection().component_indices.velocities[d]];
 
-        Tensor<2,dim> new_strain;
+            Tensor<2,dim> new_strain;
 
-        // here we integrate the equation
-        // new_deformation_gradient = velocity_gradient * old_deformation_gradient
-        // using a RK4 integration scheme.
-        const Tensor<2,dim> k1 = grad_u * old_strain * dt;
-        new_strain = old_strain + 0.5*k1;
+            // here we integrate the equation
+            // new_deformation_gradient = velocity_gradient * old_deformation_gradient
+            // using a RK4 integration scheme.
+            const Tensor<2,dim> k1 = grad_u * old_strain * dt;
+            new_strain = old_strain + 0.5*k1;
 
-        const Tensor<2,dim> k2 = grad_u * new_strain * dt;
-        new_strain = old_strain + 0.5*k2;
+            const Tensor<2,dim> k2 = grad_u * new_strain * dt;
+            new_strain = old_strain + 0.5*k2;
 
-        const Tensor<2,dim> k3 = grad_u * new_strain * dt;
-        new_strain = old_strain + k3;
+            const Tensor<2,dim> k3 = grad_u * new_strain * dt;
+            new_strain = old_strain + k3;
 
-        const Tensor<2,dim> k4 = grad_u * new_strain * dt;
+            const Tensor<2,dim> k4 = grad_u * new_strain * dt;
 
-        // the new strain is the rotated old strain plus the
-        // strain of the current time step
-        new_strain = old_strain + (k1 + 2.0*k2 + 2.0*k3 + k4)/6.0;
+            // the new strain is the rotated old strain plus the
+            // strain of the current time step
+            new_strain = old_strain + (k1 + 2.0*k2 + 2.0*k3 + k4)/6.0;
 
-        for (unsigned int i = 0; i < Tensor<2,dim>::n_independent_components ; ++i)
-          data[data_position + i] = new_strain[Tensor<2,dim>::unrolled_to_component_indices(i)];
+            for (unsigned int i = 0; i < Tensor<2,dim>::n_independent_components ; ++i)
+              data[data_position + i] = new_strain[Tensor<2,dim>::unrolled_to_component_indices(i)];
+          }
       }
 
       template <int dim>
@@ -233,6 +233,43 @@ namespace aspect
 
 
 
+      template <int dim>
+      void
+      Interface<dim>::update_particle_properties (const unsigned int data_position,
+                                                  const ArrayView<const double> &solution,
+                                                  const ArrayView<const Tensor<1,dim> > &gradients,
+                                                  typename ParticleHandler<dim>::particle_iterator_range &particles) const
+      {
+        const unsigned int n_particles = std::distance(particles.begin(), particles.end());
+        if (n_particles == 0)
+          return;
+
+        // Copy the data of each particle into the objects expected by
+        // update_particle_property(). These are created once per cell and
+        // reused for all particles.
+        const unsigned int n_components = solution.size() / n_particles;
+        Vector<double> particle_solution (n_components);
+        std::vector<Tensor<1,dim> > particle_gradients (n_components);
+
+        unsigned int i = 0;
+        for (typename ParticleHandler<dim>::particle_iterator particle = particles.begin();
+             particle != particles.end(); ++particle, ++i)
+          {
+            for (unsigned int c=0; c<n_components; ++c)
+              {
+                particle_solution[c] = solution[i*n_components+c];
+                particle_gradients[c] = gradients[i*n_components+c];
+              }
+
+            update_particle_property(data_position,
+                                     particle_solution,
+                                     particle_gradients,
+                                     particle);
+          }
+      }
+
+
+
       template <int dim>
       void
       Interface<dim>::update_one_particle_property (const unsigned int,
@@ -437,6 +474,32 @@ namespace aspect
 
 
 
+      template <int dim>
+      void
+      Manager<dim>::update_particles (typename ParticleHandler<dim>::particle_iterator_range &particles,
+                                      const ArrayView<const double> &solution,
+                                      const ArrayView<const Tensor<1,dim> > &gradients) const
+      {
+        Assert(solution.size() % std::max<std::size_t>(std::distance(particles.begin(), particles.end()), 1) == 0,
+               ExcMessage("The number of solution values that are passed to the particle "
+                          "property update needs to be a multiple of the number of particles."));
+        Assert(solution.size() == gradients.size(),
+               ExcMessage("The number of solution values and gradients that are passed "
+                          "to the particle property update need to be the same."));
+
+        unsigned int plugin_index = 0;
+        for (typename std::list<std::unique_ptr<Interface<dim> > >::const_iterator
+             p = property_list.begin(); p!=property_list.end(); ++p,++plugin_index)
+          {
+            (*p)->update_particle_properties(property_information.get_position_by_plugin_index(plugin_index),
+                                             solution,
+                                             gradients,
+                                             particles);
+          }
+      }
+
+
+
       template <int dim>
       UpdateTimeFlags
       Manager<dim>::need_update () const
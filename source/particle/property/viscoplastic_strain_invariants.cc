@@ -33,8 +33,7 @@ namespace aspect
       template <int dim>
       ViscoPlasticStrainInvariant<dim>::ViscoPlasticStrainInvariant ()
         :
-        n_components(0),
-        material_inputs(1,0)
+        n_components(0)
       {}
 
       template <int dim>
@@ -45,7 +44,6 @@ namespace aspect
                     ExcMessage("This initial condition only makes sense in combination with the visco_plastic material model."));
 
         n_components = 0;
-        material_inputs = MaterialModel::MaterialModelInputs<dim>(1,this->n_compositional_fields());
 
         // Find out which fields are used.
         if (this->introspection().compositional_name_exists("plastic_strain"))
@@ -81,72 +79,94 @@ namespace aspect
 
       template <int dim>
       void
-      ViscoPlasticStrainInvariant<dim>::update_particle_property(const unsigned int data_position,
-                                                                 const Vector<double> &solution,
-                                                                 const std::vector<Tensor<1,dim> > &gradients,
-                                                                 typename ParticleHandler<dim>::particle_iterator &particle) const
+      ViscoPlasticStrainInvariant<dim>::update_particle_properties(const unsigned int data_position,
+                                                                   const ArrayView<const double> &solution,
+                                                                   const ArrayView<const Tensor<1,dim> > &gradients,
+                                                                   typename ParticleHandler<dim>::particle_iterator_range &particles) const
       {
         // Current timestep
         const double dt = this->get_timestep();
 
-        // Velocity gradients
-        Tensor<2,dim> grad_u;
-        for (unsigned int d=0; d<dim; ++d)
-          grad_u[d] = gradients[d];
+        // Find out which fields are used. This is the same for all particles.
+        const bool use_plastic_strain = this->introspection().compositional_name_exists("plastic_strain");
+        const bool use_viscous_strain = this->introspection().compositional_name_exists("viscous_strain");
+        const bool use_total_strain = this->introspection().compositional_name_exists("total_strain");
 
-        material_inputs.pressure[0] = solution[this->introspection().component_indices.pressure];
-        material_inputs.temperature[0] = solution[this->introspection().component_indices.temperature];
-        material_inputs.position[0] = particle->get_location();
-
-        // Calculate strain rate from velocity gradients
-        material_inputs.strain_rate[0] = symmetrize (grad_u);
-
-        // Put compositional fields into single variable
-        for (unsigned int i = 0; i < this->n_compositional_fields(); i++)
-          {
-            material_inputs.composition[0][i] = solution[this->introspection().component_indices.compositional_fields[i]];
-          }
-
-        // Find out plastic yielding by calling function in material model.
         const MaterialModel::ViscoPlastic<dim> &viscoplastic
           = Plugins::get_plugin_as_type<const MaterialModel::ViscoPlastic<dim>>(this->get_material_model());
 
-        const bool plastic_yielding = viscoplastic.is_yielding(material_inputs);
-
+        const unsigned int n_particles = std::distance(particles.begin(), particles.end());
+        const unsigned int n_solution_components = this->introspection().n_components;
 
-        /* Next take the integrated strain invariant from the prior time step. When
-         * there are two fields (plastic and viscous), this assumes plastic
-         * strain is always in data position one and viscous strain in position two.
-         * In this case old_strain will first be given the plastic strain, and then,
-         * if there is no plastic yielding it will update to the viscous strain instead.
-         */
-        auto &data = particle->get_properties();
-        double old_strain = data[data_position];
-        if (n_components == 2 && plastic_yielding == false)
-          old_strain = data[data_position+(n_components-1)];
+        // Fill one set of material model inputs with the data of all
+        // particles of the cell, so that the yielding of all particles is
+        // determined by a single call to the material model.
+        MaterialModel::MaterialModelInputs<dim> material_inputs(n_particles,this->n_compositional_fields());
 
+        unsigned int p = 0;
+        for (typename ParticleHandler<dim>::particle_iterator particle = particles.begin();
+             particle != particles.end(); ++particle, ++p)
+          {
+            const double *particle_solution = &solution[p*n_solution_components];
+            const Tensor<1,dim> *particle_gradients = &gradients[p*n_solution_components];
 
-        // Calculate strain rate second invariant
-        const double edot_ii = std::sqrt(std::fabs(second_invariant(deviator(material_inputs.strain_rate[0]))));
-
-        // New strain is the old strain plus dt*edot_ii
-        const double new_strain = old_strain + dt*edot_ii;
+            // Velocity gradients
+            Tensor<2,dim> grad_u;
+            for (unsigned int d=0; d<dim; ++d)
+              grad_u[d] = particle_gradients[this->introspection().component_indices.velocities[d]];
 
+            material_inputs.pressure[p] = particle_solution[this->introspection().component_indices.pressure];
+            material_inputs.temperature[p] = particle_solution[this->introspection().component_indices.temperature];
+            material_inputs.position[p] = particle->get_location();
 
-        /* Once we know whether the particle underwent plastic, viscous, or
-         * total strain assign the new strain to the correct data position.
-         * NOTE: This assumes that total strain cannot be used in combination with the
-         * other fields. If this changes in the future, this will need to be updated.
-         * */
-        if (this->introspection().compositional_name_exists("plastic_strain") && plastic_yielding == true)
-          data[data_position] = new_strain;
+            // Calculate strain rate from velocity gradients
+            material_inputs.strain_rate[p] = symmetrize (grad_u);
 
-        if (this->introspection().compositional_name_exists("viscous_strain") && plastic_yielding == false)
-          data[data_position+(n_components-1)] = new_strain;
+            for (unsigned int i = 0; i < this->n_compositional_fields(); i++)
+              material_inputs.composition(p,i) = particle_solution[this->introspection().component_indices.compositional_fields[i]];
+          }
 
-        if (this->introspection().compositional_name_exists("total_strain"))
-          data[data_position] = new_strain;
+        // Find out plastic yielding of all particles by calling the function in the material model.
+        std::vector<bool> plastic_yielding;
+        viscoplastic.is_yielding(material_inputs, plastic_yielding);
 
+        p = 0;
+        for (typename ParticleHandler<dim>::particle_iterator particle = particles.begin();
+             particle != particles.end(); ++particle, ++p)
+          {
+            /* Next take the integrated strain invariant from the prior time step. When
+             * there are two fields (plastic and viscous), this assumes plastic
+             * strain is always in data position one and viscous strain in position two.
+             * In this case old_strain will first be given the plastic strain, and then,
+             * if there is no plastic yielding it will update to the viscous strain instead.
+             */
+            auto &data = particle->get_properties();
+            double old_strain = data[data_position];
+            if (n_components == 2 && plastic_yielding[p] == false)
+              old_strain = data[data_position+(n_components-1)];
+
+
+            // Calculate strain rate second invariant
+            const double edot_ii = std::sqrt(std::fabs(second_invariant(deviator(material_inputs.strain_rate[p]))));
+
+            // New strain is the old strain plus dt*edot_ii
+            const double new_strain = old_strain + dt*edot_ii;
+
+
+            /* Once we know whether the particle underwent plastic, viscous, or
+             * total strain assign the new strain to the correct data position.
+             * NOTE: This assumes that total strain cannot be used in combination with the
+             * other fields. If this changes in the future, this will need to be updated.
+             * */
+            if (use_plastic_strain && plastic_yielding[p] == true)
+              data[data_position] = new_strain;
+
+            if (use_viscous_strain && plastic_yielding[p] == false)
+              data[data_position+(n_components-1)] = new_strain;
+
+            if (use_total_strain)
+              data[data_position] = new_strain;
+          }
       }
 
 
@@ -0,0 +1,465 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <aspect/particle/solution_evaluator.h>
+#include <aspect/compat.h>
+
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_tools.h>
+#include <deal.II/fe/mapping_cartesian.h>
+#include <deal.II/fe/mapping_q.h>
+#include <deal.II/fe/mapping_q_generic.h>
+
+namespace aspect
+{
+  namespace Particle
+  {
+    namespace internal
+    {
+      namespace
+      {
+        /**
+         * Evaluate the function $\sum_i c_i \phi_i$ and its gradient on the
+         * reference cell at one point, where $\phi_i$ are the tensor products
+         * of @p n_1d one-dimensional polynomials in lexicographic numbering
+         * and $c_i$ are the @p coefficients. @p values_1d and
+         * @p derivatives_1d contain the values and derivatives of the
+         * one-dimensional polynomials at the coordinates of the point,
+         * the ones for coordinate direction $d$ starting at index
+         * $d \cdot n_{1d}$.
+         *
+         * Since the coefficients for a fixed index of the polynomial in the
+         * last coordinate direction are stored contiguously, the sum is
+         * factorized by contracting one coordinate direction after the
+         * other, which requires $\mathcal O(n_{1d}^{dim})$ instead of
+         * $\mathcal O(dim \cdot n_{1d}^{dim})$ operations.
+         */
+        template <int dim>
+        std::pair<double,Tensor<1,dim> >
+        evaluate_tensor_product (const double *coefficients,
+                                 const unsigned int n_1d,
+                                 const double *values_1d,
+                                 const double *derivatives_1d)
+        {
+          const unsigned int slice_size = Utilities::fixed_power<dim-1>(n_1d);
+
+          std::pair<double,Tensor<1,dim> > result (0., Tensor<1,dim>());
+          for (unsigned int k=0; k<n_1d; ++k)
+            {
+              const std::pair<double,Tensor<1,dim-1> > slice
+                = evaluate_tensor_product<dim-1>(coefficients + k*slice_size,
+                                                 n_1d,
+                                                 values_1d,
+                                                 derivatives_1d);
+
+              const double value = values_1d[(dim-1)*n_1d + k];
+              result.first += value * slice.first;
+              for (unsigned int d=0; d<dim-1; ++d)
+                result.second[d] += value * slice.second[d];
+              result.second[dim-1] += derivatives_1d[(dim-1)*n_1d + k] * slice.first;
+            }
+          return result;
+        }
+
+
+
+        template <>
+        std::pair<double,Tensor<1,1> >
+        evaluate_tensor_product<1> (const double *coefficients,
+                                    const unsigned int n_1d,
+                                    const double *values_1d,
+                                    const double *derivatives_1d)
+        {
+          std::pair<double,Tensor<1,1> > result (0., Tensor<1,1>());
+          for (unsigned int k=0; k<n_1d; ++k)
+            {
+              result.first += coefficients[k] * values_1d[k];
+              result.second[0] += coefficients[k] * derivatives_1d[k];
+            }
+          return result;
+        }
+
+
+
+        /**
+         * Check whether the shape functions of @p fe are the tensor
+         * products of @p polynomials_1d, numbered by @p lexicographic_numbering,
+         * by comparing them at a point inside the reference cell.
+         */
+        template <int dim>
+        bool
+        shape_functions_are_tensor_products (const FiniteElement<dim> &fe,
+                                             const std::vector<Polynomials::Polynomial<double> > &polynomials_1d,
+                                             const std::vector<unsigned int> &lexicographic_numbering)
+        {
+          const unsigned int n_1d = polynomials_1d.size();
+          if (lexicographic_numbering.size() != fe.dofs_per_cell
+              ||
+              Utilities::fixed_power<dim>(n_1d) != fe.dofs_per_cell)
+            return false;
+
+          Point<dim> point;
+          for (unsigned int d=0; d<dim; ++d)
+            point[d] = 0.31 + 0.17 * d;
+
+          std::vector<double> values_1d (dim * n_1d);
+          std::vector<double> derivatives_1d (dim * n_1d);
+          for (unsigned int d=0; d<dim; ++d)
+            for (unsigned int k=0; k<n_1d; ++k)
+              {
+                double value_and_derivative[2];
+                polynomials_1d[k].value(point[d], 1, value_and_derivative);
+                values_1d[d*n_1d + k] = value_and_derivative[0];
+                derivatives_1d[d*n_1d + k] = value_and_derivative[1];
+              }
+
+          std::vector<double> coefficients (fe.dofs_per_cell, 0.);
+          for (unsigned int i=0; i<fe.dofs_per_cell; ++i)
+            {
+              coefficients[lexicographic_numbering[i]] = 1.;
+              const std::pair<double,Tensor<1,dim> > tensor_product_value
+                = evaluate_tensor_product<dim>(coefficients.data(), n_1d,
+                                               values_1d.data(), derivatives_1d.data());
+              coefficients[lexicographic_numbering[i]] = 0.;
+
+              if (std::abs(tensor_product_value.first - fe.shape_value(i, point)) > 1e-10
+                  ||
+                  (tensor_product_value.second - fe.shape_grad(i, point)).norm() > 1e-10 * n_1d * n_1d)
+                return false;
+            }
+
+          return true;
+        }
+      }
+
+
+
+      template <int dim>
+      SolutionEvaluator<dim>::SolutionEvaluator (const Mapping<dim> &mapping,
+                                                 const FiniteElement<dim> &fe,
+                                                 const ComponentMask &evaluated_components,
+                                                 const UpdateFlags update_flags)
+        :
+        mapping (mapping),
+        fe (fe),
+        evaluated_components (evaluated_components),
+        update_flags (update_flags),
+        base_element_data (fe.n_base_elements()),
+        local_dof_indices (fe.dofs_per_cell)
+      {
+        Assert (evaluated_components.represents_n_components(fe.n_components()),
+                ExcMessage ("The component mask needs to have one entry for every "
+                            "component of the finite element."));
+
+        for (unsigned int b=0; b<fe.n_base_elements(); ++b)
+          {
+            BaseElementData &data = base_element_data[b];
+            const FiniteElement<dim> &base_element = fe.base_element(b);
+
+            data.is_evaluated = false;
+            data.is_tensor_product = false;
+
+            const bool is_fe_q = (dynamic_cast<const FE_Q<dim> *>(&base_element) != nullptr);
+            const bool is_fe_dgq = (dynamic_cast<const FE_DGQ<dim> *>(&base_element) != nullptr);
+
+            if ((is_fe_q || is_fe_dgq) && base_element.degree > 0)
+              {
+                // Both elements use Lagrange polynomials with the Gauss-Lobatto
+                // points as support points by default. The shape functions
+                // of FE_Q are numbered hierarchically, the ones of FE_DGQ
+                // lexicographically. Elements that were created with other
+                // support points are detected by the check below, and are
+                // treated like all other elements.
+                data.polynomials_1d
+                  = Polynomials::generate_complete_Lagrange_basis(QGaussLobatto<1>(base_element.degree+1).get_points());
+
+                if (is_fe_q)
+                  data.lexicographic_numbering = FETools::hierarchic_to_lexicographic_numbering<dim>(base_element.degree);
+                else
+                  {
+                    data.lexicographic_numbering.resize(base_element.dofs_per_cell);
+                    for (unsigned int i=0; i<base_element.dofs_per_cell; ++i)
+                      data.lexicographic_numbering[i] = i;
+                  }
+
+                data.is_tensor_product = shape_functions_are_tensor_products(base_element,
+                                                                             data.polynomials_1d,
+                                                                             data.lexicographic_numbering);
+              }
+          }
+
+        for (unsigned int c=0; c<fe.n_components(); ++c)
+          if (evaluated_components[c] == true)
+            base_element_data[fe.component_to_base_index(c).first].is_evaluated = true;
+
+        if (update_flags & update_gradients)
+          {
+            // Determine the polynomial degree of the mapping. The mapping
+            // is then described exactly by the Lagrange polynomials at the
+            // Gauss-Lobatto points of this degree, and its Jacobian can be
+            // computed from the mapped Gauss-Lobatto points.
+            unsigned int mapping_degree = numbers::invalid_unsigned_int;
+            if (const MappingQGeneric<dim> *mapping_q_generic = dynamic_cast<const MappingQGeneric<dim> *>(&mapping))
+              mapping_degree = mapping_q_generic->get_degree();
+            else if (const MappingQ<dim> *mapping_q = dynamic_cast<const MappingQ<dim> *>(&mapping))
+              mapping_degree = mapping_q->get_degree();
+            else if (dynamic_cast<const MappingCartesian<dim> *>(&mapping) != nullptr)
+              mapping_degree = 1;
+
+            AssertThrow (mapping_degree != numbers::invalid_unsigned_int,
+                         ExcMessage ("The evaluation of solution gradients at the particle "
+                                     "positions is only implemented for the mapping classes "
+                                     "MappingCartesian, MappingQ, and MappingQGeneric, and "
+                                     "the classes derived from them."));
+
+            const QGaussLobatto<1> support_points_1d (mapping_degree+1);
+            mapping_polynomials_1d = Polynomials::generate_complete_Lagrange_basis(support_points_1d.get_points());
+            mapping_support_points = std_cxx14::make_unique<FEValues<dim> >(mapping,
+                                                                            fe,
+                                                                            QGaussLobatto<dim>(mapping_degree+1),
+                                                                            update_quadrature_points);
+          }
+      }
+
+
+
+      template <int dim>
+      SolutionEvaluator<dim>::SolutionEvaluator (const SolutionEvaluator<dim> &evaluator)
+        :
+        SolutionEvaluator (evaluator.mapping,
+                           evaluator.fe,
+                           evaluator.evaluated_components,
+                           evaluator.update_flags)
+      {}
+
+
+
+      template <int dim>
+      void
+      SolutionEvaluator<dim>::evaluate_polynomials_1d (const std::vector<Polynomials::Polynomial<double> > &polynomials,
+                                                       Table<3,double> &values_1d,
+                                                       Table<3,double> &derivatives_1d) const
+      {
+        const unsigned int n_1d = polynomials.size();
+        values_1d.reinit(TableIndices<3>(points.size(), dim, n_1d));
+        derivatives_1d.reinit(TableIndices<3>(points.size(), dim, n_1d));
+
+        for (unsigned int q=0; q<points.size(); ++q)
+          for (unsigned int d=0; d<dim; ++d)
+            for (unsigned int k=0; k<n_1d; ++k)
+              {
+                double value_and_derivative[2];
+                polynomials[k].value(points[q][d], 1, value_and_derivative);
+                values_1d(q,d,k) = value_and_derivative[0];
+                derivatives_1d(q,d,k) = value_and_derivative[1];
+              }
+      }
+
+
+
+      template <int dim>
+      void
+      SolutionEvaluator<dim>::reinit (const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                      const std::vector<Point<dim> > &reference_positions)
+      {
+        points = reference_positions;
+        reinit_points (cell);
+      }
+
+
+
+      template <int dim>
+      void
+      SolutionEvaluator<dim>::reinit (const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                      const typename Particles::ParticleHandler<dim>::particle_iterator_range &particles)
+      {
+        points.clear();
+        for (const auto &particle : particles)
+          points.push_back(particle.get_reference_location());
+
+        reinit_points (cell);
+      }
+
+
+
+      template <int dim>
+      void
+      SolutionEvaluator<dim>::reinit_points (const typename DoFHandler<dim>::active_cell_iterator &cell)
+      {
+        const unsigned int n_points = points.size();
+
+        // The result arrays are always sized, so that get_values() and
+        // get_gradients() return arrays of the expected size even for the
+        // data that is not computed. Their memory is reused if the number of
+        // points does not grow.
+        values.reinit(n_points, fe.n_components());
+        gradients.reinit(n_points, fe.n_components());
+
+        if (!(update_flags & (update_values | update_gradients)))
+          return;
+
+        cell->get_dof_indices (local_dof_indices);
+
+        for (unsigned int b=0; b<base_element_data.size(); ++b)
+          {
+            BaseElementData &data = base_element_data[b];
+            if (data.is_evaluated == false)
+              continue;
+
+            if (data.is_tensor_product)
+              evaluate_polynomials_1d (data.polynomials_1d,
+                                       data.values_1d,
+                                       data.derivatives_1d);
+            else
+              {
+                const FiniteElement<dim> &base_element = fe.base_element(b);
+
+                if (update_flags & update_values)
+                  {
+                    data.shape_values.reinit(n_points, base_element.dofs_per_cell);
+                    for (unsigned int q=0; q<n_points; ++q)
+                      for (unsigned int i=0; i<base_element.dofs_per_cell; ++i)
+                        data.shape_values(q,i) = base_element.shape_value(i, points[q]);
+                  }
+
+                if (update_flags & update_gradients)
+                  {
+                    data.shape_gradients.reinit(n_points, base_element.dofs_per_cell);
+                    for (unsigned int q=0; q<n_points; ++q)
+                      for (unsigned int i=0; i<base_element.dofs_per_cell; ++i)
+                        data.shape_gradients(q,i) = base_element.shape_grad(i, points[q]);
+                  }
+              }
+          }
+
+        if (update_flags & update_gradients)
+          {
+            mapping_support_points->reinit(cell);
+            const std::vector<Point<dim> > &support_points = mapping_support_points->get_quadrature_points();
+
+            evaluate_polynomials_1d (mapping_polynomials_1d,
+                                     mapping_values_1d,
+                                     mapping_derivatives_1d);
+
+            // Row d of the Jacobian is the reference gradient of coordinate d
+            // of the mapped points.
+            jacobians.resize(n_points);
+            coefficients.resize(support_points.size());
+            for (unsigned int d=0; d<dim; ++d)
+              {
+                for (unsigned int i=0; i<support_points.size(); ++i)
+                  coefficients[i] = support_points[i][d];
+
+                for (unsigned int q=0; q<n_points; ++q)
+                  jacobians[q][d] = evaluate_tensor_product<dim>(coefficients.data(),
+                                                                 mapping_polynomials_1d.size(),
+                                                                 &mapping_values_1d(q,0,0),
+                                                                 &mapping_derivatives_1d(q,0,0)).second;
+              }
+
+            inverse_jacobians.resize(n_points);
+            for (unsigned int q=0; q<n_points; ++q)
+              inverse_jacobians[q] = invert(jacobians[q]);
+          }
+      }
+
+
+
+      template <int dim>
+      void
+      SolutionEvaluator<dim>::evaluate (const LinearAlgebra::BlockVector &solution)
+      {
+        const unsigned int n_points = points.size();
+
+        for (unsigned int c=0; c<fe.n_components(); ++c)
+          {
+            if (evaluated_components[c] == false)
+              continue;
+
+            const unsigned int base = fe.component_to_base_index(c).first;
+            const BaseElementData &data = base_element_data[base];
+            const unsigned int dofs_per_base_element = fe.base_element(base).dofs_per_cell;
+
+            coefficients.resize(dofs_per_base_element);
+            for (unsigned int i=0; i<dofs_per_base_element; ++i)
+              coefficients[data.is_tensor_product ? data.lexicographic_numbering[i] : i]
+                = solution[local_dof_indices[fe.component_to_system_index(c,i)]];
+
+            for (unsigned int q=0; q<n_points; ++q)
+              {
+                double value = 0.;
+                Tensor<1,dim> reference_gradient;
+
+                if (data.is_tensor_product)
+                  {
+                    const std::pair<double,Tensor<1,dim> > value_and_gradient
+                      = evaluate_tensor_product<dim>(coefficients.data(),
+                                                     data.polynomials_1d.size(),
+                                                     &data.values_1d(q,0,0),
+                                                     &data.derivatives_1d(q,0,0));
+                    value = value_and_gradient.first;
+                    reference_gradient = value_and_gradient.second;
+                  }
+                else
+                  {
+                    if (update_flags & update_values)
+                      for (unsigned int i=0; i<dofs_per_base_element; ++i)
+                        value += coefficients[i] * data.shape_values(q,i);
+
+                    if (update_flags & update_gradients)
+                      for (unsigned int i=0; i<dofs_per_base_element; ++i)
+                        reference_gradient += coefficients[i] * data.shape_gradients(q,i);
+                  }
+
+                if (update_flags & update_values)
+                  values(q,c) = value;
+
+                // Transform the gradient from the reference cell to the real
+                // cell, i.e., multiply it by the transpose of the inverse
+                // Jacobian of the mapping.
+                if (update_flags & update_gradients)
+                  gradients(q,c) = reference_gradient * inverse_jacobians[q];
+              }
+          }
+      }
+    }
+  }
+}
+
+
+// explicit instantiation of the functions we implement in this file
+namespace aspect
+{
+  namespace Particle
+  {
+    namespace internal
+    {
+#define INSTANTIATE(dim) \
+  template class SolutionEvaluator<dim>;
+
+      ASPECT_INSTANTIATE(INSTANTIATE)
+
+#undef INSTANTIATE
+    }
+  }
+}
@@ -26,19 +26,32 @@
 #include <aspect/geometry_model/two_merged_boxes.h>
 #include <aspect/citation_info.h>
 
+#include <deal.II/base/bounding_box.h>
+#include <deal.II/base/mpi.h>
+#include <deal.II/base/multithread_info.h>
 #include <deal.II/base/quadrature_lib.h>
-#include <deal.II/fe/fe_values.h>
+#include <deal.II/base/thread_local_storage.h>
+#include <deal.II/base/work_stream.h>
 #include <deal.II/grid/grid_tools.h>
+#include <deal.II/grid/filtered_iterator.h>
 #include <boost/serialization/map.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
 namespace aspect
 {
   namespace Particle
   {
     template <int dim>
     World<dim>::World()
+      :
+      use_measured_cell_cost(false),
+      cell_cost_to_weight(0.0)
     {}
 
     template <int dim>
@@ -151,21 +164,38 @@ namespace aspect
         particle_handler->register_load_callback_function(false);
       });
 
-      signals.pre_checkpoint_store_user_data.connect(
-        [&] (typename parallel::distributed::Triangulation<dim> &)
-      {
+      if (separate_checkpoint_file)
+        {
+          signals.pre_checkpoint_store_user_data.connect(
+            [&] (typename parallel::distributed::Triangulation<dim> &)
+          {
+            this->save_particles(this->get_output_directory() + "restart.particles.new");
+          });
+
+          signals.post_resume_load_user_data.connect(
+            [&] (typename parallel::distributed::Triangulation<dim> &)
+          {
+            this->load_particles(this->get_output_directory() + "restart.particles");
+          });
+        }
+      else
+        {
+          signals.pre_checkpoint_store_user_data.connect(
+            [&] (typename parallel::distributed::Triangulation<dim> &)
+          {
 #if !DEAL_II_VERSION_GTE(9,1,0)
-        particle_handler->register_store_callback_function(false);
+            particle_handler->register_store_callback_function(false);
 #else
-        particle_handler->register_store_callback_function();
+            particle_handler->register_store_callback_function();
 #endif
-      });
+          });
 
-      signals.post_resume_load_user_data.connect(
-        [&] (typename parallel::distributed::Triangulation<dim> &)
-      {
-        particle_handler->register_load_callback_function(true);
-      });
+          signals.post_resume_load_user_data.connect(
+            [&] (typename parallel::distributed::Triangulation<dim> &)
+          {
+            particle_handler->register_load_callback_function(true);
+          });
+        }
 
       signals.post_refinement_load_user_data.connect(
         [&] (typename parallel::distributed::Triangulation<dim> &)
@@ -173,6 +203,32 @@ namespace aspect
         this->apply_particle_per_cell_bounds();
       });
 
+      if (use_measured_cell_cost)
+        {
+          reset_cell_cost();
+
+          // The weights of the cells are requested during the refinement,
+          // when no collective communication is possible, so compute the
+          // conversion of the measured times into weights beforehand.
+          signals.pre_refinement_store_user_data.connect(
+            [&] (typename parallel::distributed::Triangulation<dim> &)
+          {
+            this->compute_cell_cost_to_weight_factor();
+          });
+
+          signals.post_refinement_load_user_data.connect(
+            [&] (typename parallel::distributed::Triangulation<dim> &)
+          {
+            this->reset_cell_cost();
+          });
+
+          signals.post_resume_load_user_data.connect(
+            [&] (typename parallel::distributed::Triangulation<dim> &)
+          {
+            this->reset_cell_cost();
+          });
+        }
+
       signals.post_resume_load_user_data.connect(
         [&] (typename parallel::distributed::Triangulation<dim> &)
       {
@@ -327,6 +383,33 @@ namespace aspect
 #endif
         return 0;
 
+      if (use_measured_cell_cost && cell_cost_to_weight > 0.0)
+        {
+          const std::vector<double> &material_model_time = this->get_material_model_evaluation_time();
+
+          double cell_cost = 0.0;
+          if (status == parallel::distributed::Triangulation<dim>::CELL_PERSIST
+              || status == parallel::distributed::Triangulation<dim>::CELL_REFINE)
+            {
+              const unsigned int index = cell->active_cell_index();
+              cell_cost = particle_cell_time[index] + material_model_time[index];
+            }
+          else if (status == parallel::distributed::Triangulation<dim>::CELL_COARSEN)
+            {
+              for (unsigned int child_index = 0; child_index < GeometryInfo<dim>::max_children_per_cell; ++child_index)
+                {
+                  const unsigned int index = cell->child(child_index)->active_cell_index();
+                  cell_cost += particle_cell_time[index] + material_model_time[index];
+                }
+            }
+          else
+            Assert (false, ExcInternalError());
+
+          // Limit the weight of a single cell, so that the sum of all
+          // weights can not overflow
+          return static_cast<unsigned int>(std::min(cell_cost_to_weight * cell_cost, 1e6));
+        }
+
       if (status == parallel::distributed::Triangulation<dim>::CELL_PERSIST
           || status == parallel::distributed::Triangulation<dim>::CELL_REFINE)
         {
@@ -348,6 +431,77 @@ namespace aspect
     }
 
 
+    template <int dim>
+    void
+    World<dim>::compute_cell_cost_to_weight_factor()
+    {
+      const std::vector<double> &material_model_time = this->get_material_model_evaluation_time();
+      if (particle_cell_time.size() != this->get_triangulation().n_active_cells())
+        particle_cell_time.assign(this->get_triangulation().n_active_cells(), 0.);
+
+      AssertDimension (material_model_time.size(), this->get_triangulation().n_active_cells());
+
+      double measured_time = 0.0;
+      for (const auto &cell : this->get_triangulation().active_cell_iterators())
+        if (cell->is_locally_owned())
+          measured_time += particle_cell_time[cell->active_cell_index()]
+                           + material_model_time[cell->active_cell_index()];
+
+      // Every cell carries a base weight of 1000 for the work that is done
+      // for all cells alike (e.g., in the linear solvers), and that is not
+      // measured per cell. To put the measured times on the same scale,
+      // estimate the wall time of this work per cell, and choose the factor
+      // such that a cell whose measured time equals this estimate gets an
+      // additional weight of 1000. The weights are then proportional to
+      // the estimated run time of every cell.
+      //
+      // The measured times of the cells are summed over all threads, so
+      // they are divided by the number of threads to get wall time,
+      // assuming that the work was evenly distributed across threads. The
+      // wall time that was not measured also contains the time a process
+      // waited for other processes, e.g., in the solvers, which is the
+      // imbalance that the weights should remove and not work of its cells.
+      // The process with the most work waits the least, so use the smallest
+      // unmeasured time per locally owned cell of all processes.
+      const double n_threads = MultithreadInfo::n_threads();
+      const double unmeasured_time = std::max(cell_cost_timer.wall_time() - measured_time / n_threads, 0.0);
+
+      const unsigned int n_locally_owned_cells = this->get_triangulation().n_locally_owned_active_cells();
+      const double unmeasured_time_per_cell
+        = Utilities::MPI::min((n_locally_owned_cells > 0
+                               ?
+                               unmeasured_time / n_locally_owned_cells
+                               :
+                               std::numeric_limits<double>::max()),
+                              this->get_mpi_communicator());
+
+      // If no time was measured at all (e.g., no particles were advected and
+      // the Stokes system was not assembled since the mesh last changed),
+      // every cell would get a weight of zero. Fall back to the weights
+      // computed from the number of particles in that case, which is
+      // indicated by a zero factor (see cell_weight()).
+      const double global_measured_time = Utilities::MPI::sum(measured_time, this->get_mpi_communicator());
+
+      cell_cost_to_weight = (unmeasured_time_per_cell > 0.0 && global_measured_time > 0.0
+                             ?
+                             1000.0 / (unmeasured_time_per_cell * n_threads)
+                             :
+                             0.0);
+    }
+
+
+
+    template <int dim>
+    void
+    World<dim>::reset_cell_cost()
+    {
+      particle_cell_time.assign(this->get_triangulation().n_active_cells(), 0.);
+      cell_cost_to_weight = 0.0;
+      cell_cost_timer.restart();
+    }
+
+
+
     template <int dim>
     std::map<types::subdomain_id, unsigned int>
     World<dim>::get_subdomain_id_to_neighbor_map() const
@@ -457,6 +611,65 @@ namespace aspect
         }
     }
 
+    namespace
+    {
+      // The loops over all cells with particles do all of their work on
+      // the particles of the current cell, and therefore do not need any
+      // scratch or copy data.
+      struct ParticleLoopScratchData {};
+      struct ParticleLoopCopyData {};
+    }
+
+    template <int dim>
+    void
+    World<dim>::loop_over_cells_with_particles(const std::function<void (const typename DoFHandler<dim>::active_cell_iterator &,
+                                                                         const typename ParticleHandler<dim>::particle_iterator_range &)> &cell_worker,
+                                                     const bool measure_cell_cost)
+    {
+      typedef
+      FilteredIterator<typename DoFHandler<dim>::active_cell_iterator>
+      CellFilter;
+
+      const bool record_time = measure_cell_cost && use_measured_cell_cost;
+      if (record_time && particle_cell_time.size() != this->get_triangulation().n_active_cells())
+        particle_cell_time.assign(this->get_triangulation().n_active_cells(), 0.);
+
+      auto worker = [&](const typename DoFHandler<dim>::active_cell_iterator &cell,
+                        ParticleLoopScratchData &,
+                        ParticleLoopCopyData &)
+      {
+        const typename ParticleHandler<dim>::particle_iterator_range
+        particles_in_cell = particle_handler->particles_in_cell(cell);
+
+        // Only work on cells that contain particles
+        if (particles_in_cell.begin() != particles_in_cell.end())
+          {
+            const auto start = std::chrono::steady_clock::now();
+
+            cell_worker(cell, particles_in_cell);
+
+            // Every cell is only worked on by one thread, so the entries
+            // can be updated concurrently
+            if (record_time)
+              particle_cell_time[cell->active_cell_index()]
+              += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+          }
+      };
+
+      auto copier = [](const ParticleLoopCopyData &)
+      {};
+
+      WorkStream::
+      run (CellFilter (IteratorFilters::LocallyOwnedCell(),
+                       this->get_dof_handler().begin_active()),
+           CellFilter (IteratorFilters::LocallyOwnedCell(),
+                       this->get_dof_handler().end()),
+           worker,
+           copier,
+           ParticleLoopScratchData(),
+           ParticleLoopCopyData());
+    }
+
     template <int dim>
     void
     World<dim>::local_initialize_particles(const typename ParticleHandler<dim>::particle_iterator &begin_particle,
@@ -470,133 +683,59 @@ namespace aspect
     void
     World<dim>::local_update_particles(const typename DoFHandler<dim>::active_cell_iterator &cell,
                                        const typename ParticleHandler<dim>::particle_iterator &begin_particle,
-                                       const typename ParticleHandler<dim>::particle_iterator &end_particle)
+                                       const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                                       internal::SolutionEvaluator<dim> &evaluator)
     {
-      const unsigned int particles_in_cell = std::distance(begin_particle,end_particle);
-      const unsigned int solution_components = this->introspection().n_components;
-
-      Vector<double>              value (solution_components);
-      std::vector<Tensor<1,dim> > gradient (solution_components,Tensor<1,dim>());
+      typename ParticleHandler<dim>::particle_iterator_range particles (begin_particle, end_particle);
 
-      std::vector<Vector<double> >              values(particles_in_cell,value);
-      std::vector<std::vector<Tensor<1,dim> > > gradients(particles_in_cell,gradient);
-      std::vector<Point<dim> >                  positions(particles_in_cell);
-
-      typename ParticleHandler<dim>::particle_iterator it = begin_particle;
-      for (unsigned int i = 0; it!=end_particle; ++it,++i)
-        {
-          positions[i] = it->get_reference_location();
-        }
+      // The evaluator owns the arrays of the values and gradients at the
+      // particle positions, which are reused for all cells.
+      evaluator.reinit (cell, particles);
 
-      const Quadrature<dim> quadrature_formula(positions);
       const UpdateFlags update_flags = property_manager->get_needed_update_flags();
-      FEValues<dim> fe_value (this->get_mapping(),
-                              this->get_fe(),
-                              quadrature_formula,
-                              update_flags);
-
-      fe_value.reinit (cell);
-      if (update_flags & update_values)
-        fe_value.get_function_values (this->get_solution(),
-                                      values);
-      if (update_flags & update_gradients)
-        fe_value.get_function_gradients (this->get_solution(),
-                                         gradients);
-
-      it = begin_particle;
-      for (unsigned int i = 0; it!=end_particle; ++it,++i)
-        {
-          property_manager->update_one_particle(it,
-                                                values[i],
-                                                gradients[i]);
-        }
+      if (update_flags & (update_values | update_gradients))
+        evaluator.evaluate (this->get_solution());
+
+      property_manager->update_particles(particles,
+                                         evaluator.get_values(),
+                                         evaluator.get_gradients());
     }
 
     template <int dim>
     void
     World<dim>::local_advect_particles(const typename DoFHandler<dim>::active_cell_iterator &cell,
                                        const typename ParticleHandler<dim>::particle_iterator &begin_particle,
-                                       const typename ParticleHandler<dim>::particle_iterator &end_particle)
+                                       const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                                       internal::SolutionEvaluator<dim> &evaluator)
     {
       const unsigned int particles_in_cell = std::distance(begin_particle,end_particle);
 
       std::vector<Tensor<1,dim> >  velocity(particles_in_cell);
       std::vector<Tensor<1,dim> >  old_velocity(particles_in_cell);
 
-      // Below we manually evaluate the solution at all support points of the
-      // current cell, and then use the shape functions to interpolate the
-      // solution to the particle points. All of this can be done with less
-      // code using an FEValues object, but since this object initializes a lot
-      // of memory for other purposes and we can not reuse the FEValues object
-      // for other cells, it is much faster to do the work manually. Also this
-      // function is quite performance critical.
-
-      std::vector<types::global_dof_index> cell_dof_indices (this->get_fe().dofs_per_cell);
-      cell->get_dof_indices (cell_dof_indices);
-
-      const FiniteElement<dim> &velocity_fe = this->get_fe().base_element(this->introspection()
-                                                                          .base_elements.velocities);
-
       const bool compute_fluid_velocity = this->include_melt_transport() &&
                                           property_manager->get_data_info().fieldname_exists("melt_presence");
 
-      const unsigned int fluid_component_index = (compute_fluid_velocity ?
-                                                  this->introspection().variable("fluid velocity").first_component_index
-                                                  :
-                                                  numbers::invalid_unsigned_int);
+      // In regions without melt, the fluid velocity equals the solid velocity,
+      // so we can use it for all particles.
+      const unsigned int velocity_component_index = (compute_fluid_velocity ?
+                                                     this->introspection().variable("fluid velocity").first_component_index
+                                                     :
+                                                     this->introspection().component_indices.velocities[0]);
 
-      // In regions without melt, the fluid velocity equals the solid velocity, so we can use it for all particles.
-      std::vector<bool> use_fluid_velocity((compute_fluid_velocity ?
-                                            particles_in_cell
-                                            :
-                                            0), compute_fluid_velocity);
+      // The shape functions are evaluated at the particle positions only
+      // once, and are then used for both the current and the old solution.
+      evaluator.reinit (cell, typename ParticleHandler<dim>::particle_iterator_range(begin_particle, end_particle));
 
-      for (unsigned int j=0; j<velocity_fe.dofs_per_cell; ++j)
-        {
-          Tensor<1,dim> velocity_at_support_point;
-          Tensor<1,dim> old_velocity_at_support_point;
-
-          for (unsigned int dir=0; dir<dim; ++dir)
-            {
-              const unsigned int support_point_index
-                = this->get_fe().component_to_system_index(this->introspection()
-                                                           .component_indices.velocities[dir],j);
-
-              velocity_at_support_point[dir] = this->get_solution()[cell_dof_indices[support_point_index]];
-              old_velocity_at_support_point[dir] = this->get_old_solution()[cell_dof_indices[support_point_index]];
-            }
-
-          Tensor<1,dim> fluid_velocity_at_support_point;
-          Tensor<1,dim> old_fluid_velocity_at_support_point;
-
-          if (compute_fluid_velocity)
-            for (unsigned int dir=0; dir<dim; ++dir)
-              {
-                const unsigned int support_point_index
-                  = this->get_fe().component_to_system_index(fluid_component_index + dir,j);
-
-                fluid_velocity_at_support_point[dir] = this->get_solution()[cell_dof_indices[support_point_index]];
-                old_fluid_velocity_at_support_point[dir] = this->get_old_solution()[cell_dof_indices[support_point_index]];
-              }
+      evaluator.evaluate (this->get_solution());
+      for (unsigned int i=0; i<particles_in_cell; ++i)
+        for (unsigned int d=0; d<dim; ++d)
+          velocity[i][d] = evaluator.get_value(i, velocity_component_index + d);
 
-          typename ParticleHandler<dim>::particle_iterator it = begin_particle;
-          for (unsigned int particle_index = 0; it!=end_particle; ++it,++particle_index)
-            {
-              // melt FE uses the same FE so the shape value is the same
-              const double shape_value = velocity_fe.shape_value(j,it->get_reference_location());
-
-              if (compute_fluid_velocity && use_fluid_velocity[particle_index])
-                {
-                  velocity[particle_index] += fluid_velocity_at_support_point * shape_value;
-                  old_velocity[particle_index] += old_fluid_velocity_at_support_point * shape_value;
-                }
-              else
-                {
-                  velocity[particle_index] += velocity_at_support_point * shape_value;
-                  old_velocity[particle_index] += old_velocity_at_support_point * shape_value;
-                }
-            }
-        }
+      evaluator.evaluate (this->get_old_solution());
+      for (unsigned int i=0; i<particles_in_cell; ++i)
+        for (unsigned int d=0; d<dim; ++d)
+          old_velocity[i][d] = evaluator.get_value(i, velocity_component_index + d);
 
       integrator->local_integrate_step(begin_particle,
                                        end_particle,
@@ -650,14 +789,16 @@ namespace aspect
         particle->set_property_pool(particle_handler->get_property_pool());
 
 
-      // TODO: Change this loop over all cells to use the WorkStream interface
       if (property_manager->get_n_property_components() > 0)
         {
           TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Initialize properties");
 
           particle_handler->get_property_pool().reserve(2 * particle_handler->n_locally_owned_particles());
 
-          // Loop over all cells and initialize the particles cell-wise
+          // Loop over all cells and initialize the particles cell-wise.
+          // Unlike the update and advection of the particles, this loop
+          // stays serial: initializing a particle allocates its properties
+          // in the property pool, which is not thread-safe.
           for (const auto &cell : this->get_dof_handler().active_cell_iterators())
             if (cell->is_locally_owned())
               {
@@ -669,6 +810,7 @@ namespace aspect
                   local_initialize_particles(particles_in_cell.begin(),
                                              particles_in_cell.end());
               }
+
           if (update_ghost_particles &&
               dealii::Utilities::MPI::n_mpi_processes(this->get_mpi_communicator()) > 1)
             {
@@ -680,27 +822,41 @@ namespace aspect
 
     template <int dim>
     void
-    World<dim>::update_particles()
+    World<dim>::update_particles(const bool exchange_ghost_particles)
     {
-      // TODO: Change this loop over all cells to use the WorkStream interface
-
       if (property_manager->get_n_property_components() > 0)
         {
           TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Update properties");
 
+          // Every thread creates its own copy of the evaluator, which is
+          // then reused for all cells this thread works on
+          Threads::ThreadLocalStorage<internal::SolutionEvaluator<dim> >
+          evaluators (internal::SolutionEvaluator<dim>(this->get_mapping(),
+                                                       this->get_fe(),
+                                                       ComponentMask(this->introspection().n_components, true),
+                                                       property_manager->get_needed_update_flags()));
+
+          const auto cell_worker = [&](const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                       const typename ParticleHandler<dim>::particle_iterator_range &particles_in_cell)
+          {
+            local_update_particles(cell,
+                                   particles_in_cell.begin(),
+                                   particles_in_cell.end(),
+                                   evaluators.get());
+          };
+
           // Loop over all cells and update the particles cell-wise
-          for (const auto &cell : this->get_dof_handler().active_cell_iterators())
-            if (cell->is_locally_owned())
-              {
-                typename ParticleHandler<dim>::particle_iterator_range
-                particles_in_cell = particle_handler->particles_in_cell(cell);
+          loop_over_cells_with_particles(cell_worker,
+                                         /*measure_cell_cost=*/ true);
+        }
 
-                // Only update particles, if there are any in this cell
-                if (particles_in_cell.begin() != particles_in_cell.end())
-                  local_update_particles(cell,
-                                         particles_in_cell.begin(),
-                                         particles_in_cell.end());
-              }
+      // The ghost particles are copies of the updated particles. Their
+      // exchange allocates and frees properties in the property pool, so it
+      // must not run while the threads above write into the pool.
+      if (exchange_ghost_particles)
+        {
+          TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Exchange ghosts");
+          particle_handler->exchange_ghost_particles();
         }
     }
 
@@ -709,22 +865,30 @@ namespace aspect
     World<dim>::advect_particles()
     {
       {
-        // TODO: Change this loop over all cells to use the WorkStream interface
         TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Advect");
 
+        // Only the values of the velocity components (and the fluid velocity
+        // components in models with melt transport) are needed for the advection
+        ComponentMask velocity_components = this->introspection().component_masks.velocities;
+        if (this->include_melt_transport())
+          velocity_components = velocity_components | this->introspection().variable("fluid velocity").component_mask;
+
+        Threads::ThreadLocalStorage<internal::SolutionEvaluator<dim> >
+        evaluators (internal::SolutionEvaluator<dim>(this->get_mapping(),
+                                                     this->get_fe(),
+                                                     velocity_components,
+                                                     update_values));
+
         // Loop over all cells and advect the particles cell-wise
-        for (const auto &cell : this->get_dof_handler().active_cell_iterators())
-          if (cell->is_locally_owned())
-            {
-              const typename ParticleHandler<dim>::particle_iterator_range
-              particles_in_cell = particle_handler->particles_in_cell(cell);
-
-              // Only advect particles, if there are any in this cell
-              if (particles_in_cell.begin() != particles_in_cell.end())
-                local_advect_particles(cell,
-                                       particles_in_cell.begin(),
-                                       particles_in_cell.end());
-            }
+        loop_over_cells_with_particles([&](const typename DoFHandler<dim>::active_cell_iterator &cell,
+                                           const typename ParticleHandler<dim>::particle_iterator_range &particles_in_cell)
+        {
+          local_advect_particles(cell,
+                                 particles_in_cell.begin(),
+                                 particles_in_cell.end(),
+                                 evaluators.get());
+        },
+        /*measure_cell_cost=*/ true);
 
         // If particles fell out of the mesh, put them back in if they have crossed
         // a periodic boundary. If they have left the mesh otherwise, they will be
@@ -753,14 +917,14 @@ namespace aspect
 
       apply_particle_per_cell_bounds();
 
-      // Update particle properties
-      if (property_manager->need_update() == Property::update_time_step)
-        update_particles();
+      // Update particle properties, and afterwards exchange the new ghost
+      // particles.
+      const bool exchange_ghost_particles = update_ghost_particles &&
+                                            dealii::Utilities::MPI::n_mpi_processes(this->get_mpi_communicator()) > 1;
 
-      // Now that all particle information was updated, exchange the new
-      // ghost particles.
-      if (update_ghost_particles &&
-          dealii::Utilities::MPI::n_mpi_processes(this->get_mpi_communicator()) > 1)
+      if (property_manager->need_update() == Property::update_time_step)
+        update_particles(exchange_ghost_particles);
+      else if (exchange_ghost_particles)
         {
           TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Exchange ghosts");
           particle_handler->exchange_ghost_particles();
@@ -783,6 +947,373 @@ namespace aspect
       ia >> (*this);
     }
 
+    template <int dim>
+    bool
+    World<dim>::uses_measured_cell_cost () const
+    {
+      return use_measured_cell_cost;
+    }
+
+
+
+    template <int dim>
+    bool
+    World<dim>::use_separate_checkpoint_file () const
+    {
+      return separate_checkpoint_file;
+    }
+
+
+
+    namespace
+    {
+      /**
+       * The number of entries of the header of a particle checkpoint file.
+       */
+      const unsigned int n_checkpoint_header_entries = 4;
+
+
+
+      /**
+       * Convert the number of entries @p n_entries of an array that one
+       * process reads or writes into the count argument of the MPI-IO
+       * functions.
+       */
+      int
+      to_mpi_count (const std::uint64_t n_entries)
+      {
+        AssertThrow (n_entries <= static_cast<std::uint64_t>(std::numeric_limits<int>::max()),
+                     ExcMessage ("The particle checkpoint can not read or write more than "
+                                 + Utilities::to_string(std::numeric_limits<int>::max())
+                                 + " entries of one array on a single process."));
+        return static_cast<int>(n_entries);
+      }
+    }
+
+
+
+    template <int dim>
+    void
+    World<dim>::save_particles (const std::string &filename) const
+    {
+      TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Save checkpoint");
+
+      const MPI_Comm communicator = this->get_mpi_communicator();
+      const unsigned int n_properties = property_manager->get_n_property_components();
+      const std::size_t integrator_data_size = integrator->get_data_size();
+
+      const std::uint64_t n_local_particles = particle_handler->n_locally_owned_particles();
+      const std::uint64_t n_particles = Utilities::MPI::sum(n_local_particles, communicator);
+
+      // Every process writes its particles behind the ones of all
+      // processes with a lower rank
+      std::uint64_t first_local_particle = 0;
+      int ierr = MPI_Exscan(&n_local_particles, &first_local_particle, 1, MPI_UINT64_T, MPI_SUM, communicator);
+      AssertThrowMPI(ierr);
+      if (Utilities::MPI::this_mpi_process(communicator) == 0)
+        first_local_particle = 0;
+
+      // Copy the particle data into one contiguous array per quantity
+      std::vector<std::uint64_t> ids (n_local_particles);
+      std::vector<double> locations (n_local_particles * dim);
+      std::vector<double> properties (n_local_particles * n_properties);
+      std::vector<char> integrator_data (n_local_particles * integrator_data_size);
+
+      unsigned int i = 0;
+      for (typename ParticleHandler<dim>::particle_iterator particle = particle_handler->begin();
+           particle != particle_handler->end(); ++particle, ++i)
+        {
+          ids[i] = particle->get_id();
+
+          const Point<dim> location = particle->get_location();
+          for (unsigned int d=0; d<dim; ++d)
+            locations[i*dim + d] = location[d];
+
+          if (n_properties > 0)
+            {
+              const ArrayView<const double> particle_properties = particle->get_properties();
+              for (unsigned int p=0; p<n_properties; ++p)
+                properties[p*n_local_particles + i] = particle_properties[p];
+            }
+
+          // Integrators like the adaptive RK23 integrator keep data of the
+          // particles between time steps
+          if (integrator_data_size > 0)
+            integrator->write_data(particle, &integrator_data[i*integrator_data_size]);
+        }
+
+      MPI_File file;
+      ierr = MPI_File_open(communicator, filename.c_str(),
+                           MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                           MPI_INFO_NULL, &file);
+      AssertThrow (ierr == MPI_SUCCESS,
+                   ExcMessage ("Unable to open the particle checkpoint file <" + filename + "> for writing."));
+
+      // Remove the content of a file that might exist from an earlier run
+      ierr = MPI_File_set_size(file, 0);
+      AssertThrowMPI(ierr);
+
+      if (Utilities::MPI::this_mpi_process(communicator) == 0)
+        {
+          const std::uint64_t header[n_checkpoint_header_entries] = {dim, n_properties, n_particles, integrator_data_size};
+          ierr = MPI_File_write_at(file, 0, header, n_checkpoint_header_entries, MPI_UINT64_T, MPI_STATUS_IGNORE);
+          AssertThrowMPI(ierr);
+        }
+
+      const MPI_Offset ids_offset = n_checkpoint_header_entries * sizeof(std::uint64_t);
+      const MPI_Offset locations_offset = ids_offset + n_particles * sizeof(std::uint64_t);
+      const MPI_Offset properties_offset = locations_offset + n_particles * dim * sizeof(double);
+      const MPI_Offset integrator_data_offset = properties_offset + n_particles * n_properties * sizeof(double);
+
+      ierr = MPI_File_write_at_all(file,
+                                   ids_offset + first_local_particle * sizeof(std::uint64_t),
+                                   ids.data(), to_mpi_count(n_local_particles),
+                                   MPI_UINT64_T, MPI_STATUS_IGNORE);
+      AssertThrowMPI(ierr);
+
+      ierr = MPI_File_write_at_all(file,
+                                   locations_offset + first_local_particle * dim * sizeof(double),
+                                   locations.data(), to_mpi_count(n_local_particles * dim),
+                                   MPI_DOUBLE, MPI_STATUS_IGNORE);
+      AssertThrowMPI(ierr);
+
+      for (unsigned int p=0; p<n_properties; ++p)
+        {
+          ierr = MPI_File_write_at_all(file,
+                                       properties_offset + (p * n_particles + first_local_particle) * sizeof(double),
+                                       properties.data() + p * n_local_particles, to_mpi_count(n_local_particles),
+                                       MPI_DOUBLE, MPI_STATUS_IGNORE);
+          AssertThrowMPI(ierr);
+        }
+
+      ierr = MPI_File_write_at_all(file,
+                                   integrator_data_offset + first_local_particle * integrator_data_size,
+                                   integrator_data.data(), to_mpi_count(n_local_particles * integrator_data_size),
+                                   MPI_BYTE, MPI_STATUS_IGNORE);
+      AssertThrowMPI(ierr);
+
+      ierr = MPI_File_close(&file);
+      AssertThrowMPI(ierr);
+    }
+
+
+
+    template <int dim>
+    void
+    World<dim>::load_particles (const std::string &filename)
+    {
+      TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Load checkpoint");
+
+      AssertThrow (Utilities::fexists(filename),
+                   ExcMessage ("You are trying to restart a previous computation "
+                               "with particles stored in a separate file, but the file <"
+                               + filename
+                               + "> does not appear to exist! Maybe the checkpoint was "
+                               "created without the parameter `Postprocess/Particles/"
+                               "Use separate checkpoint file'?"));
+
+      const MPI_Comm communicator = this->get_mpi_communicator();
+      const unsigned int n_properties = property_manager->get_n_property_components();
+
+      MPI_File file;
+      int ierr = MPI_File_open(communicator, filename.c_str(),
+                               MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+      AssertThrow (ierr == MPI_SUCCESS,
+                   ExcMessage ("Unable to open the particle checkpoint file <" + filename + "> for reading."));
+
+      std::uint64_t header[n_checkpoint_header_entries];
+      ierr = MPI_File_read_at_all(file, 0, header, n_checkpoint_header_entries, MPI_UINT64_T, MPI_STATUS_IGNORE);
+      AssertThrowMPI(ierr);
+
+      AssertThrow (header[0] == dim,
+                   ExcMessage ("The particle checkpoint file <" + filename + "> was written by a model "
+                               "of a different dimension."));
+      AssertThrow (header[1] == n_properties,
+                   ExcMessage ("The number of particle properties stored in the particle checkpoint file <"
+                               + filename + "> (" + Utilities::to_string(header[1])
+                               + ") is not the same as the number of properties of the "
+                               "particles in the current model ("
+                               + Utilities::to_string(n_properties) + ")."));
+
+      const std::size_t integrator_data_size = integrator->get_data_size();
+      AssertThrow (header[3] == integrator_data_size,
+                   ExcMessage ("The size of the integrator data stored in the particle checkpoint file <"
+                               + filename + "> (" + Utilities::to_string(header[3])
+                               + " bytes per particle) is not the same as the one of the particle "
+                               "integrator of the current model ("
+                               + Utilities::to_string(integrator_data_size) + " bytes). Did you "
+                               "change the particle integrator?"));
+
+      // Every process reads an equally sized contiguous part of the
+      // particles, independent of the number of processes that wrote them
+      const std::uint64_t n_particles = header[2];
+      const std::uint64_t my_id = Utilities::MPI::this_mpi_process(communicator);
+      const std::uint64_t n_processes = Utilities::MPI::n_mpi_processes(communicator);
+      const std::uint64_t first_local_particle = n_particles * my_id / n_processes;
+      const std::uint64_t n_local_particles = n_particles * (my_id + 1) / n_processes - first_local_particle;
+
+      std::vector<std::uint64_t> ids (n_local_particles);
+      std::vector<double> locations (n_local_particles * dim);
+      std::vector<double> properties (n_local_particles * n_properties);
+      std::vector<char> integrator_data (n_local_particles * integrator_data_size);
+
+      const MPI_Offset ids_offset = n_checkpoint_header_entries * sizeof(std::uint64_t);
+      const MPI_Offset locations_offset = ids_offset + n_particles * sizeof(std::uint64_t);
+      const MPI_Offset properties_offset = locations_offset + n_particles * dim * sizeof(double);
+      const MPI_Offset integrator_data_offset = properties_offset + n_particles * n_properties * sizeof(double);
+
+      ierr = MPI_File_read_at_all(file,
+                                  ids_offset + first_local_particle * sizeof(std::uint64_t),
+                                  ids.data(), to_mpi_count(n_local_particles),
+                                  MPI_UINT64_T, MPI_STATUS_IGNORE);
+      AssertThrowMPI(ierr);
+
+      ierr = MPI_File_read_at_all(file,
+                                  locations_offset + first_local_particle * dim * sizeof(double),
+                                  locations.data(), to_mpi_count(n_local_particles * dim),
+                                  MPI_DOUBLE, MPI_STATUS_IGNORE);
+      AssertThrowMPI(ierr);
+
+      for (unsigned int p=0; p<n_properties; ++p)
+        {
+          ierr = MPI_File_read_at_all(file,
+                                      properties_offset + (p * n_particles + first_local_particle) * sizeof(double),
+                                      properties.data() + p * n_local_particles, to_mpi_count(n_local_particles),
+                                      MPI_DOUBLE, MPI_STATUS_IGNORE);
+          AssertThrowMPI(ierr);
+        }
+
+      ierr = MPI_File_read_at_all(file,
+                                  integrator_data_offset + first_local_particle * integrator_data_size,
+                                  integrator_data.data(), to_mpi_count(n_local_particles * integrator_data_size),
+                                  MPI_BYTE, MPI_STATUS_IGNORE);
+      AssertThrowMPI(ierr);
+
+      ierr = MPI_File_close(&file);
+      AssertThrowMPI(ierr);
+
+      std::vector<Point<dim> > particle_locations (n_local_particles);
+      std::vector<std::vector<double> > particle_properties (n_properties > 0 ? n_local_particles : 0,
+                                                             std::vector<double>(n_properties));
+      std::vector<types::particle_index> particle_ids (n_local_particles);
+      for (unsigned int i=0; i<n_local_particles; ++i)
+        {
+          particle_ids[i] = ids[i];
+          for (unsigned int d=0; d<dim; ++d)
+            particle_locations[i][d] = locations[i*dim + d];
+          for (unsigned int p=0; p<n_properties; ++p)
+            particle_properties[i][p] = properties[p*n_local_particles + i];
+        }
+
+      // Send every particle to the processes whose locally owned cells
+      // might contain it. The bounding boxes are computed on a coarse level
+      // of the mesh to keep their number small.
+      double max_cell_diameter = 0.0;
+      for (const auto &cell : this->get_triangulation().active_cell_iterators())
+        if (cell->is_locally_owned())
+          max_cell_diameter = std::max(cell->diameter(), max_cell_diameter);
+
+      std::vector<BoundingBox<dim> > local_bounding_boxes;
+      if (max_cell_diameter > 0.0)
+        {
+          const std::vector<BoundingBox<dim> > boxes
+            = GridTools::compute_mesh_predicate_bounding_box(this->get_triangulation(),
+                                                             std::function<bool (const typename Triangulation<dim>::active_cell_iterator &)>
+                                                             (IteratorFilters::LocallyOwnedCell()),
+                                                             std::min(this->get_triangulation().n_levels() - 1, 2u),
+                                                             /*allow_merge=*/ true);
+
+          // The boxes only contain the vertices of the cells, but curved
+          // or deformed cells can extend beyond them, by less than their
+          // diameter
+          for (const auto &box : boxes)
+            {
+              std::pair<Point<dim>,Point<dim> > corners = box.get_boundary_points();
+              for (unsigned int d=0; d<dim; ++d)
+                {
+                  corners.first[d] -= max_cell_diameter;
+                  corners.second[d] += max_cell_diameter;
+                }
+              local_bounding_boxes.emplace_back(corners);
+            }
+        }
+
+      const std::vector<std::vector<BoundingBox<dim> > > global_bounding_boxes
+        = Utilities::MPI::all_gather(communicator, local_bounding_boxes);
+
+      const std::map<unsigned int, IndexSet> new_owners
+        = particle_handler->insert_global_particles(particle_locations,
+                                                    global_bounding_boxes,
+                                                    particle_properties,
+                                                    particle_ids);
+
+      // Particles that are not inside any of the bounding boxes, or not
+      // inside the cells of the processes they were sent to, are silently
+      // dropped by the particle handler. Make sure this did not happen.
+      AssertThrow (particle_handler->n_global_particles() == n_particles,
+                   ExcMessage ("The particle checkpoint file <" + filename + "> contains "
+                               + Utilities::to_string(n_particles) + " particles, but only "
+                               + Utilities::to_string(particle_handler->n_global_particles())
+                               + " of them could be placed into the cells of the mesh."));
+
+      if (integrator_data_size > 0)
+        {
+          // Send the integrator data of every particle to the process that
+          // now owns the particle, together with the id of the particle
+          const std::size_t record_size = sizeof(types::particle_index) + integrator_data_size;
+          const unsigned int my_rank = Utilities::MPI::this_mpi_process(communicator);
+
+          std::map<unsigned int, std::vector<char> > records_to_send;
+          for (const auto &owner : new_owners)
+            {
+              std::vector<char> &records = records_to_send[owner.first];
+              records.resize(owner.second.n_elements() * record_size);
+
+              char *record = records.data();
+              for (const auto index : owner.second)
+                {
+                  const types::particle_index id = particle_ids[index];
+                  std::memcpy(record, &id, sizeof(types::particle_index));
+                  std::memcpy(record + sizeof(types::particle_index),
+                              &integrator_data[index * integrator_data_size],
+                              integrator_data_size);
+                  record += record_size;
+                }
+            }
+
+          std::map<unsigned int, std::vector<char> > received_records;
+          if (records_to_send.find(my_rank) != records_to_send.end())
+            {
+              received_records[my_rank] = std::move(records_to_send[my_rank]);
+              records_to_send.erase(my_rank);
+            }
+          for (auto &records : Utilities::MPI::some_to_some(communicator, records_to_send))
+            received_records[records.first] = std::move(records.second);
+
+          std::map<types::particle_index, const char *> integrator_data_of_particle;
+          for (const auto &records : received_records)
+            for (std::size_t r=0; r<records.second.size(); r+=record_size)
+              {
+                types::particle_index id;
+                std::memcpy(&id, &records.second[r], sizeof(types::particle_index));
+                integrator_data_of_particle[id] = &records.second[r] + sizeof(types::particle_index);
+              }
+
+          for (typename ParticleHandler<dim>::particle_iterator particle = particle_handler->begin();
+               particle != particle_handler->end(); ++particle)
+            {
+              const auto data = integrator_data_of_particle.find(particle->get_id());
+              AssertThrow (data != integrator_data_of_particle.end(),
+                           ExcMessage ("The integrator data of particle "
+                                       + Utilities::to_string(particle->get_id())
+                                       + " was not sent to the process that owns the particle."));
+              integrator->read_data(particle, data->second);
+            }
+        }
+    }
+
+
+
     template <int dim>
     void
     World<dim>::declare_parameters (ParameterHandler &prm)
@@ -833,6 +1364,26 @@ namespace aspect
                              "particle weight is recommended. Before adding the weights "
                              "of particles, each cell already carries a weight of 1000 to "
                              "account for the cost of field-based computations.");
+          prm.declare_entry ("Use measured cell cost", "false",
+                             Patterns::Bool (),
+                             "Whether the weights of the cells for the `repartition' "
+                             "particle load balancing strategy are computed from the "
+                             "measured cost of each cell, instead of from the number of "
+                             "particles in the cell and the `Particle weight'. If set to "
+                             "true, the time spent on updating and advecting the particles "
+                             "of each cell, and the time spent on evaluating the material "
+                             "model in each cell during the assembly of the Stokes and "
+                             "advection systems and in the matrix-free Stokes solver "
+                             "are measured between two refinement steps. If the material "
+                             "model outputs are cached, only the evaluations that can not "
+                             "use cached outputs contribute noticeably. The remaining run "
+                             "time per cell, taken from the process that waits the least "
+                             "for other processes, is attributed equally to all cells, and "
+                             "corresponds to the weight of 1000 every cell carries. This "
+                             "balances the actual run time better than a fixed weight if "
+                             "the cost per particle or per cell varies, e.g., because of "
+                             "material models with internal iterations. Until the first "
+                             "measurement is available, the `Particle weight' is used.");
           prm.declare_entry ("Update ghost particles", "false",
                              Patterns::Bool (),
                              "Some particle interpolation algorithms require knowledge "
@@ -840,6 +1391,18 @@ namespace aspect
                              "particles in ghost cells need to be exchanged between the "
                              "processes neighboring this cell. This parameter determines "
                              "whether this transport is happening.");
+          prm.declare_entry ("Use separate checkpoint file", "false",
+                             Patterns::Bool (),
+                             "Whether the particles are written into a separate file "
+                             "`restart.particles' when a checkpoint is created, instead "
+                             "of being stored together with the cells of the mesh. The file "
+                             "is written and read by all processes at the same time using "
+                             "MPI-IO, and the particles are stored independently of the "
+                             "mesh and of the number of processes, so a model can be "
+                             "restarted efficiently on a different number of processes. "
+                             "This is recommended for models with many particles. The "
+                             "parameter needs to have the same value when the checkpoint "
+                             "is created and when the model is resumed from it.");
         }
         prm.leave_subsection ();
       }
@@ -890,8 +1453,10 @@ namespace aspect
                                  "that is smaller than or equal to the 'Maximum particles per cell' parameter."));
 
           particle_weight = prm.get_integer("Particle weight");
+          use_measured_cell_cost = prm.get_bool("Use measured cell cost");
 
           update_ghost_particles = prm.get_bool("Update ghost particles");
+          separate_checkpoint_file = prm.get_bool("Use separate checkpoint file");
 
           const std::vector<std::string> strategies = Utilities::split_string_list(prm.get ("Load balancing strategy"));
           AssertThrow(Utilities::has_unique_entries(strategies),
@@ -66,12 +66,11 @@ namespace aspect
 
       if (this->is_stokes_matrix_free())
         {
-          double mg_transfer_mem = this->get_stokes_matrix_free().get_mg_transfer_A().memory_consumption()
-                                   + this->get_stokes_matrix_free().get_mg_transfer_S().memory_consumption();
+          double mg_transfer_mem = this->get_stokes_matrix_free().get_mg_transfer_memory_consumption();
           statistics.add_value ("MGTransfer memory consumption (MB) ", mg_transfer_mem/mb);
 
           double visc_table_mem = this->get_stokes_matrix_free().get_active_viscosity_table().memory_consumption()
-                                  + this->get_stokes_matrix_free().get_level_viscosity_tables().memory_consumption();
+                                  + this->get_stokes_matrix_free().get_level_viscosity_tables_memory_consumption();
           statistics.add_value ("Matrix-free viscosity tables memory consumption (MB) ", visc_table_mem/mb);
         }
 
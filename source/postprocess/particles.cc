@@ -40,7 +40,8 @@ namespace aspect
       ParticleOutput<dim>::build_patches(const dealii::Particles::ParticleHandler<dim> &particle_handler,
                                          const aspect::Particle::Property::ParticlePropertyInformation &property_information,
                                          const std::vector<std::string> &exclude_output_properties,
-                                         const bool only_group_3d_vectors)
+                                         const bool only_group_3d_vectors,
+                                         const unsigned int output_stride)
       {
         // First store the names of the data fields that should be written
         dataset_names.reserve(property_information.n_components()+1);
@@ -114,11 +115,17 @@ namespace aspect
           }
 
         // Now build the actual patch data
-        patches.resize(particle_handler.n_locally_owned_particles());
+        patches.reserve(particle_handler.n_locally_owned_particles() / output_stride + 1);
         typename dealii::Particles::ParticleHandler<dim>::particle_iterator particle = particle_handler.begin();
 
-        for (unsigned int i=0; particle != particle_handler.end(); ++particle, ++i)
+        for (; particle != particle_handler.end(); ++particle)
           {
+            if (particle->get_id() % output_stride != 0)
+              continue;
+
+            const unsigned int i = patches.size();
+            patches.emplace_back();
+
             patches[i].vertices[0] = particle->get_location();
             patches[i].patch_index = i;
             patches[i].n_subdivisions = 1;
@@ -184,7 +191,9 @@ namespace aspect
       last_output_time (std::numeric_limits<double>::quiet_NaN())
       ,output_file_number (numbers::invalid_unsigned_int),
       group_files(0),
-      write_in_background_thread(false)
+      write_in_background_thread(false),
+      output_stride(1),
+      compression_level(DataOutBase::VtkFlags::best_compression)
     {}
 
     template <int dim>
@@ -357,7 +366,8 @@ namespace aspect
       data_out.build_patches(world.get_particle_handler(),
                              world.get_property_manager().get_data_info(),
                              exclude_output_properties,
-                             output_hdf5);
+                             output_hdf5,
+                             output_stride);
 
       // Now prepare everything for writing the output and choose output format
       std::string particle_file_prefix = "particles-" + Utilities::int_to_string (output_file_number, 5);
@@ -432,6 +442,7 @@ namespace aspect
               DataOutBase::VtkFlags vtk_flags;
               vtk_flags.cycle = this->get_timestep_number();
               vtk_flags.time = time_in_years_or_seconds;
+              vtk_flags.compression_level = compression_level;
 
               data_out.set_flags (vtk_flags);
 
@@ -647,6 +658,27 @@ namespace aspect
                              "A comma seperated list of strings which exclude all particle"
                              "property fields which contain these strings. If one of the "
                              "entries is 'all', only a id will be provided for every point.");
+
+          prm.declare_entry ("Output stride", "1",
+                             Patterns::Integer(1),
+                             "Write only a subset of the particles to the output files, "
+                             "namely the particles whose id is a multiple of this number. "
+                             "Since the id of a particle does not change, the same particles "
+                             "are written in every output step, and the paths of these "
+                             "particles can be followed over time. For models with many "
+                             "particles this reduces the size of the output and the time "
+                             "spent writing it by approximately this factor. A value of 1 "
+                             "writes all particles.");
+
+          prm.declare_entry ("Compression level", "best compression",
+                             Patterns::Selection("best compression|best speed|default|none"),
+                             "The level of lossless zlib compression of the data in VTU "
+                             "files. `best compression' creates the smallest files, but "
+                             "compressing large amounts of particle data this way can take "
+                             "longer than writing the uncompressed data. `best speed' "
+                             "compresses considerably faster at the cost of slightly larger "
+                             "files, and `none' writes the data without compression. This "
+                             "parameter has no effect on other output formats.");
         }
         prm.leave_subsection ();
       }
@@ -719,6 +751,18 @@ namespace aspect
             }
 
           exclude_output_properties = Utilities::split_string_list(prm.get("Exclude output properties"));
+          output_stride = prm.get_integer("Output stride");
+
+          if (prm.get("Compression level") == "best compression")
+            compression_level = DataOutBase::VtkFlags::best_compression;
+          else if (prm.get("Compression level") == "best speed")
+            compression_level = DataOutBase::VtkFlags::best_speed;
+          else if (prm.get("Compression level") == "default")
+            compression_level = DataOutBase::VtkFlags::default_compression;
+          else if (prm.get("Compression level") == "none")
+            compression_level = DataOutBase::VtkFlags::no_compression;
+          else
+            AssertThrow (false, ExcNotImplemented());
         }
         prm.leave_subsection ();
       }
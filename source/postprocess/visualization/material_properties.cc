@@ -99,16 +99,18 @@ namespace aspect
         Assert (computed_quantities.size() == n_quadrature_points,    ExcInternalError());
         Assert (input_data.solution_values[0].size() == this->introspection().n_components,           ExcInternalError());
 
-        MaterialModel::MaterialModelInputs<dim> in(input_data,
-                                                   this->introspection());
-        MaterialModel::MaterialModelOutputs<dim> out(n_quadrature_points,
-                                                     this->n_compositional_fields());
+        typename MaterialModel::ScratchPool<dim>::Scratch &scratch = scratch_pool.get(n_quadrature_points,
+                                                                                      this->n_compositional_fields());
+        MaterialModel::MaterialModelInputs<dim> &in = scratch.inputs;
+        MaterialModel::MaterialModelOutputs<dim> &out = scratch.outputs;
+        in.reinit(input_data, this->introspection());
 
         this->get_material_model().evaluate(in, out);
 
-        std::vector<double> melt_fractions(n_quadrature_points);
+        std::vector<double> melt_fractions;
         if (std::find(property_names.begin(), property_names.end(), "melt fraction") != property_names.end())
           {
+            melt_fractions.resize(n_quadrature_points);
             AssertThrow(Plugins::plugin_type_matches<const MaterialModel::MeltFractionModel<dim>> (this->get_material_model()),
                         ExcMessage("You are trying to visualize the melt fraction, but the material"
                                    "model you use does not actually compute a melt fraction."));
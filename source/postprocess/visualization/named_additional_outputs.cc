@@ -36,7 +36,13 @@ namespace aspect
       NamedAdditionalOutputs<dim>::
       NamedAdditionalOutputs ()
         :
-        DataPostprocessor<dim> ()
+        DataPostprocessor<dim> (),
+        // The additional outputs are attached once, and reset in place for
+        // every later evaluation
+        scratch_pool ([this](typename MaterialModel::ScratchPool<dim>::Scratch &scratch)
+      {
+        this->get_material_model().create_additional_named_outputs(scratch.outputs);
+      })
       {}
 
 
@@ -121,12 +127,12 @@ namespace aspect
         Assert (input_data.solution_values[0].size() == this->introspection().n_components,
                 ExcInternalError());
 
-        MaterialModel::MaterialModelInputs<dim> in(input_data,
-                                                   this->introspection());
-        MaterialModel::MaterialModelOutputs<dim> out(n_quadrature_points,
-                                                     this->n_compositional_fields());
+        typename MaterialModel::ScratchPool<dim>::Scratch &scratch = scratch_pool.get(n_quadrature_points,
+                                                                                      this->n_compositional_fields());
+        MaterialModel::MaterialModelInputs<dim> &in = scratch.inputs;
+        MaterialModel::MaterialModelOutputs<dim> &out = scratch.outputs;
+        in.reinit(input_data, this->introspection());
 
-        this->get_material_model().create_additional_named_outputs(out);
         this->get_material_model().evaluate(in, out);
 
         unsigned int field_index = 0;
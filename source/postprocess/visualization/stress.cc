@@ -42,10 +42,11 @@ namespace aspect
         Assert (input_data.solution_values[0].size() == this->introspection().n_components,   ExcInternalError());
         Assert (input_data.solution_gradients[0].size() == this->introspection().n_components,  ExcInternalError());
 
-        MaterialModel::MaterialModelInputs<dim> in(input_data,
-                                                   this->introspection());
-        MaterialModel::MaterialModelOutputs<dim> out(n_quadrature_points,
-                                                     this->n_compositional_fields());
+        typename MaterialModel::ScratchPool<dim>::Scratch &scratch = scratch_pool.get(n_quadrature_points,
+                                                                                      this->n_compositional_fields());
+        MaterialModel::MaterialModelInputs<dim> &in = scratch.inputs;
+        MaterialModel::MaterialModelOutputs<dim> &out = scratch.outputs;
+        in.reinit(input_data, this->introspection());
 
         // Compute the viscosity...
         this->get_material_model().evaluate(in, out);
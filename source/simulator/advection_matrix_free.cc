@@ -0,0 +1,674 @@
+/*
+  Copyright (C) 2020 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <aspect/advection_matrix_free.h>
+#include <aspect/simulator/assemblers/interface.h>
+
+#include <deal.II/dofs/dof_renumbering.h>
+#include <deal.II/dofs/dof_accessor.h>
+#include <deal.II/dofs/dof_tools.h>
+
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/std_cxx14/memory.h>
+#include <deal.II/lac/solver_gmres.h>
+
+
+
+namespace aspect
+{
+  namespace
+  {
+    /**
+     * Copy the locally owned entries of @p in into @p out. Both vectors
+     * need to have the same parallel partitioning, which is the case for
+     * the vectors of the matrix-free operator and the corresponding block
+     * of the solution vectors of the simulator.
+     */
+    void copy (dealii::LinearAlgebra::distributed::Vector<double> &out,
+               const LinearAlgebra::Vector &in)
+    {
+      Assert(out.locally_owned_elements() == in.locally_owned_elements(),
+             ExcNotImplemented());
+
+      for (const auto idx : in.locally_owned_elements())
+        out(idx) = in(idx);
+    }
+
+
+
+    void copy (LinearAlgebra::Vector &out,
+               const dealii::LinearAlgebra::distributed::Vector<double> &in)
+    {
+      Assert(out.locally_owned_elements() == in.locally_owned_elements(),
+             ExcNotImplemented());
+
+      for (const auto idx : out.locally_owned_elements())
+        out(idx) = in(idx);
+      out.compress(VectorOperation::insert);
+    }
+  }
+
+
+
+  /**
+   * Advection-diffusion operator
+   */
+  template <int dim, int degree, int n_q_points_1d, typename number>
+  MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,number>::AdvectionDiffusionOperator ()
+    :
+    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >()
+  {}
+
+  template <int dim, int degree, int n_q_points_1d, typename number>
+  void
+  MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,number>::clear ()
+  {
+    mass_coefficient = nullptr;
+    velocity = nullptr;
+    diffusion = nullptr;
+    supg_tau = nullptr;
+    supg_conductivity = nullptr;
+    MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::clear();
+  }
+
+  template <int dim, int degree, int n_q_points_1d, typename number>
+  void
+  MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,number>::
+  fill_cell_data (const Table<2, VectorizedArray<number>> &mass_coefficient_table,
+                  const Table<2, Tensor<1,dim,VectorizedArray<number>>> &velocity_table,
+                  const Table<2, VectorizedArray<number>> &diffusion_table,
+                  const Table<2, VectorizedArray<number>> &supg_tau_table,
+                  const Table<2, VectorizedArray<number>> &supg_conductivity_table,
+                  const double time_step,
+                  const double bdf2_factor,
+                  const bool use_supg)
+  {
+    mass_coefficient = &mass_coefficient_table;
+    velocity = &velocity_table;
+    diffusion = &diffusion_table;
+    supg_tau = &supg_tau_table;
+    supg_conductivity = &supg_conductivity_table;
+
+    this->time_step = time_step;
+    this->bdf2_factor = bdf2_factor;
+    this->use_supg = use_supg;
+  }
+
+  template <int dim, int degree, int n_q_points_1d, typename number>
+  void
+  MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,number>
+  ::apply_cell (FEEvaluation<dim,degree,n_q_points_1d,1,number> &field,
+                const unsigned int cell) const
+  {
+    // The SUPG residual contains the Laplacian of the field:
+    field.evaluate (true, true, use_supg);
+
+    for (unsigned int q=0; q<field.n_q_points; ++q)
+      {
+        const VectorizedArray<number> mass = (*mass_coefficient)(cell, q);
+        const Tensor<1,dim,VectorizedArray<number>> &current_u = (*velocity)(cell, q);
+        const Tensor<1,dim,VectorizedArray<number>> gradient = field.get_gradient(q);
+
+        // The time discrete advection terms, which are tested with the
+        // shape functions. See Assemblers::AdvectionSystem for the
+        // definition of all terms.
+        const VectorizedArray<number> advection_terms
+          = mass * (time_step * (current_u * gradient) + bdf2_factor * field.get_value(q));
+
+        Tensor<1,dim,VectorizedArray<number>> gradient_terms
+          = (time_step * (*diffusion)(cell, q)) * gradient;
+
+        if (use_supg)
+          {
+            // The residual of the equation is tested with the streamline
+            // derivative of the shape functions. Note that we assume that
+            // the conductivity is constant, like the matrix-based assembly.
+            const VectorizedArray<number> residual
+              = advection_terms
+                - time_step * (*supg_conductivity)(cell, q) * field.get_laplacian(q);
+
+            gradient_terms += ((*supg_tau)(cell, q) * mass * residual) * current_u;
+          }
+
+        field.submit_value (advection_terms, q);
+        field.submit_gradient (gradient_terms, q);
+      }
+
+    field.integrate (true, true);
+  }
+
+  template <int dim, int degree, int n_q_points_1d, typename number>
+  void
+  MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,number>
+  ::local_apply (const dealii::MatrixFree<dim, number>                 &data,
+                 dealii::LinearAlgebra::distributed::Vector<number>       &dst,
+                 const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                 const std::pair<unsigned int, unsigned int>           &cell_range) const
+  {
+    FEEvaluation<dim,degree,n_q_points_1d,1,number> field (data, this->selected_rows[0]);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        field.reinit (cell);
+        field.read_dof_values (src);
+        apply_cell (field, cell);
+        field.distribute_local_to_global (dst);
+      }
+  }
+
+  template <int dim, int degree, int n_q_points_1d, typename number>
+  void
+  MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,number>
+  ::apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
+               const dealii::LinearAlgebra::distributed::Vector<number> &src) const
+  {
+    MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::
+    data->cell_loop(&AdvectionDiffusionOperator::local_apply, this, dst, src);
+  }
+
+  template <int dim, int degree, int n_q_points_1d, typename number>
+  void
+  MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,number>
+  ::compute_diagonal ()
+  {
+    this->inverse_diagonal_entries.
+    reset(new DiagonalMatrix<dealii::LinearAlgebra::distributed::Vector<number> >());
+    this->diagonal_entries.
+    reset(new DiagonalMatrix<dealii::LinearAlgebra::distributed::Vector<number> >());
+
+    dealii::LinearAlgebra::distributed::Vector<number> &inverse_diagonal =
+      this->inverse_diagonal_entries->get_vector();
+    dealii::LinearAlgebra::distributed::Vector<number> &diagonal =
+      this->diagonal_entries->get_vector();
+
+    unsigned int dummy = 0;
+    this->data->initialize_dof_vector(inverse_diagonal, this->selected_rows[0]);
+    this->data->initialize_dof_vector(diagonal, this->selected_rows[0]);
+
+    this->data->cell_loop (&AdvectionDiffusionOperator::local_compute_diagonal, this,
+                           diagonal, dummy);
+
+    this->set_constrained_entries_to_one(diagonal);
+    inverse_diagonal = diagonal;
+    const unsigned int local_size = inverse_diagonal.local_size();
+    for (unsigned int i=0; i<local_size; ++i)
+      {
+        Assert(inverse_diagonal.local_element(i) != 0.,
+               ExcMessage("No diagonal entry of the advection-diffusion "
+                          "operator should be zero"));
+        inverse_diagonal.local_element(i)
+          =1./inverse_diagonal.local_element(i);
+      }
+  }
+
+  template <int dim, int degree, int n_q_points_1d, typename number>
+  void
+  MatrixFreeAdvectionOperators::AdvectionDiffusionOperator<dim,degree,n_q_points_1d,number>
+  ::local_compute_diagonal (const MatrixFree<dim,number>                     &data,
+                            dealii::LinearAlgebra::distributed::Vector<number>  &dst,
+                            const unsigned int &,
+                            const std::pair<unsigned int,unsigned int>       &cell_range) const
+  {
+    FEEvaluation<dim,degree,n_q_points_1d,1,number> field (data, this->selected_rows[0]);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        field.reinit (cell);
+        AlignedVector<VectorizedArray<number> > diagonal(field.dofs_per_cell);
+        for (unsigned int i=0; i<field.dofs_per_cell; ++i)
+          {
+            for (unsigned int j=0; j<field.dofs_per_cell; ++j)
+              field.begin_dof_values()[j] = VectorizedArray<number>();
+            field.begin_dof_values()[i] = make_vectorized_array<number> (1.);
+
+            apply_cell (field, cell);
+
+            diagonal[i] = field.begin_dof_values()[i];
+          }
+
+        for (unsigned int i=0; i<field.dofs_per_cell; ++i)
+          field.begin_dof_values()[i] = diagonal[i];
+        field.distribute_local_to_global (dst);
+      }
+  }
+
+
+
+  template <int dim>
+  std::unique_ptr<AdvectionMatrixFreeHandler<dim> >
+  AdvectionMatrixFreeHandler<dim>::create (Simulator<dim> &simulator,
+                                           const typename Simulator<dim>::AdvectionField &advection_field)
+  {
+    // Use the same quadrature formula as Simulator::assemble_advection_system(),
+    // since the coefficients are computed while assembling the right-hand side.
+    const unsigned int degree = advection_field.polynomial_degree(simulator.introspection);
+    const unsigned int n_q_points_1d = degree + (simulator.parameters.stokes_velocity_degree+1)/2;
+
+    switch (degree)
+      {
+        case 1:
+          if (n_q_points_1d == 2)
+            return std_cxx14::make_unique<AdvectionMatrixFreeHandlerImplementation<dim,1,2>>(simulator, advection_field);
+          else if (n_q_points_1d == 3)
+            return std_cxx14::make_unique<AdvectionMatrixFreeHandlerImplementation<dim,1,3>>(simulator, advection_field);
+          break;
+        case 2:
+          if (n_q_points_1d == 3)
+            return std_cxx14::make_unique<AdvectionMatrixFreeHandlerImplementation<dim,2,3>>(simulator, advection_field);
+          else if (n_q_points_1d == 4)
+            return std_cxx14::make_unique<AdvectionMatrixFreeHandlerImplementation<dim,2,4>>(simulator, advection_field);
+          break;
+        case 3:
+          if (n_q_points_1d == 4)
+            return std_cxx14::make_unique<AdvectionMatrixFreeHandlerImplementation<dim,3,4>>(simulator, advection_field);
+          else if (n_q_points_1d == 5)
+            return std_cxx14::make_unique<AdvectionMatrixFreeHandlerImplementation<dim,3,5>>(simulator, advection_field);
+          break;
+        default:
+          break;
+      }
+
+    AssertThrow(false, ExcMessage("The matrix-free advection solver does not support the "
+                                  "combination of the finite element degree of the "
+                                  + std::string(advection_field.is_temperature() ? "temperature" : "compositional fields")
+                                  + " and the Stokes velocity degree you selected."));
+    return nullptr;
+  }
+
+
+
+  template <int dim, int degree, int n_q_points_1d>
+  AdvectionMatrixFreeHandlerImplementation<dim,degree,n_q_points_1d>::
+  AdvectionMatrixFreeHandlerImplementation (Simulator<dim> &simulator,
+                                            const typename Simulator<dim>::AdvectionField &advection_field)
+    :
+    sim(simulator),
+    field_type(advection_field.field_type),
+    n_fields(advection_field.is_temperature() ? 1 : simulator.introspection.n_compositional_fields),
+    fe(simulator.finite_element.base_element(advection_field.base_element(simulator.introspection))),
+    dof_handler(simulator.triangulation),
+    matrix_free_timestep_number(numbers::invalid_unsigned_int),
+    diagonal_is_computed(false)
+  {
+    AssertThrow(fe.degree == degree && fe.n_components() == 1,
+                ExcInternalError());
+    AssertThrow(!advection_field.is_discontinuous(sim.introspection),
+                ExcMessage("The matrix-free advection solver can only be used with "
+                           "continuous finite elements."));
+  }
+
+
+
+  template <int dim, int degree, int n_q_points_1d>
+  unsigned int
+  AdvectionMatrixFreeHandlerImplementation<dim,degree,n_q_points_1d>::
+  dof_index (const typename Simulator<dim>::AdvectionField &advection_field) const
+  {
+    Assert(advection_field.field_type == field_type, ExcInternalError());
+
+    if (advection_field.is_temperature())
+      return 0;
+    else
+      return advection_field.compositional_variable;
+  }
+
+
+
+  template <int dim, int degree, int n_q_points_1d>
+  void
+  AdvectionMatrixFreeHandlerImplementation<dim,degree,n_q_points_1d>::
+  extract_constraints (const typename Simulator<dim>::AdvectionField &advection_field,
+                       ConstraintMatrix &field_constraints,
+                       IndexSet &field_constrained_dofs) const
+  {
+    // The degrees of freedom of dof_handler are numbered in the same way
+    // as the degrees of freedom of the simulator within the block of the
+    // field, so we only need to shift the indices by the start of the block:
+    const unsigned int block_idx = advection_field.block_index(sim.introspection);
+    const types::global_dof_index block_start = sim.system_rhs.get_block_indices().block_start(block_idx);
+
+    IndexSet locally_relevant_dofs;
+    DoFTools::extract_locally_relevant_dofs (dof_handler,
+                                             locally_relevant_dofs);
+
+    field_constraints.clear();
+    field_constraints.reinit(locally_relevant_dofs);
+    field_constrained_dofs.clear();
+    field_constrained_dofs.set_size(dof_handler.n_dofs());
+
+    for (const auto i : locally_relevant_dofs)
+      if (sim.current_constraints.is_constrained(block_start + i))
+        {
+          field_constraints.add_line(i);
+          field_constrained_dofs.add_index(i);
+
+          for (const auto &entry : *sim.current_constraints.get_constraint_entries(block_start + i))
+            {
+              Assert(entry.first >= block_start && entry.first < block_start + dof_handler.n_dofs(),
+                     ExcMessage("The constraints of an advected field may only couple "
+                                "degrees of freedom of the same field."));
+              field_constraints.add_entry(i, entry.first - block_start, entry.second);
+            }
+        }
+
+    field_constraints.close();
+    field_constrained_dofs.compress();
+  }
+
+
+
+  template <int dim, int degree, int n_q_points_1d>
+  void
+  AdvectionMatrixFreeHandlerImplementation<dim,degree,n_q_points_1d>::setup_dofs ()
+  {
+    dof_handler.clear();
+    dof_handler.distribute_dofs(fe);
+
+    DoFRenumbering::hierarchical(dof_handler);
+
+    // The constraints of the fields are only known once the simulator
+    // has computed its current constraints, so the matrix-free storage is
+    // set up in setup_operator():
+    constraints.clear();
+    constrained_dofs.clear();
+    cell_batch_of_active_cell.clear();
+    advection_matrix.clear();
+    matrix_free.reset();
+  }
+
+
+
+  template <int dim, int degree, int n_q_points_1d>
+  void
+  AdvectionMatrixFreeHandlerImplementation<dim,degree,n_q_points_1d>::reinit_matrix_free ()
+  {
+    constraints.clear();
+    constraints.resize(n_fields);
+    constrained_dofs.clear();
+    constrained_dofs.resize(n_fields);
+
+    for (unsigned int f=0; f<n_fields; ++f)
+      {
+        const typename Simulator<dim>::AdvectionField advection_field
+          = (field_type == Simulator<dim>::AdvectionField::temperature_field
+             ?
+             Simulator<dim>::AdvectionField::temperature()
+             :
+             Simulator<dim>::AdvectionField::composition(f));
+        extract_constraints (advection_field, constraints[f], constrained_dofs[f]);
+      }
+
+    const bool use_supg = (sim.parameters.advection_stabilization_method
+                           == Parameters<dim>::AdvectionStabilizationMethod::supg);
+
+    typename MatrixFree<dim,double>::AdditionalData additional_data;
+    additional_data.tasks_parallel_scheme =
+      MatrixFree<dim,double>::AdditionalData::none;
+    additional_data.mapping_update_flags = (update_values | update_gradients | update_JxW_values |
+                                            (use_supg ? update_hessians : UpdateFlags(0)));
+
+    // All fields share the same DoFHandler and therefore the same mapping
+    // data, but each field has its own constraints:
+    const std::vector<const DoFHandler<dim>*> dof_handlers (n_fields, &dof_handler);
+    std::vector<const ConstraintMatrix *> field_constraints;
+    for (const auto &c : constraints)
+      field_constraints.push_back(&c);
+
+    advection_matrix.clear();
+    matrix_free.reset(new MatrixFree<dim,double>());
+    matrix_free->reinit(*sim.mapping, dof_handlers, field_constraints,
+                        QGauss<1>(n_q_points_1d), additional_data);
+    matrix_free_timestep_number = sim.timestep_number;
+
+    const unsigned int n_cells = matrix_free->n_macro_cells();
+    const unsigned int n_q_points = Utilities::pow(n_q_points_1d, dim);
+
+    cell_batch_of_active_cell.assign(sim.triangulation.n_active_cells(),
+                                     std::make_pair(numbers::invalid_unsigned_int, numbers::invalid_unsigned_int));
+    for (unsigned int cell=0; cell<n_cells; ++cell)
+      for (unsigned int i=0; i<matrix_free->n_components_filled(cell); ++i)
+        cell_batch_of_active_cell[matrix_free->get_cell_iterator(cell,i)->active_cell_index()]
+          = std::make_pair(cell, i);
+
+    mass_coefficient_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    velocity_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    diffusion_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    if (use_supg)
+      {
+        supg_tau_table.reinit(TableIndices<2>(n_cells, n_q_points));
+        supg_conductivity_table.reinit(TableIndices<2>(n_cells, n_q_points));
+      }
+    else
+      {
+        supg_tau_table.reinit(TableIndices<2>(0, 0));
+        supg_conductivity_table.reinit(TableIndices<2>(0, 0));
+      }
+
+    // Make sure the coefficients of unused vectorization lanes are zero,
+    // the other lanes are overwritten by fill_cell_coefficients():
+    for (unsigned int cell=0; cell<n_cells; ++cell)
+      for (unsigned int q=0; q<n_q_points; ++q)
+        {
+          mass_coefficient_table(cell, q) = 0.;
+          velocity_table(cell, q) = Tensor<1,dim,VectorizedArray<double>>();
+          diffusion_table(cell, q) = 0.;
+          if (use_supg)
+            {
+              supg_tau_table(cell, q) = 0.;
+              supg_conductivity_table(cell, q) = 0.;
+            }
+        }
+  }
+
+
+
+  template <int dim, int degree, int n_q_points_1d>
+  void
+  AdvectionMatrixFreeHandlerImplementation<dim,degree,n_q_points_1d>::
+  setup_operator (const typename Simulator<dim>::AdvectionField &advection_field)
+  {
+    const unsigned int index = dof_index(advection_field);
+
+    // With a deforming mesh, the mapping changes in every time step.
+    // Otherwise, we only need to set up the matrix-free storage again if
+    // the constrained degrees of freedom of the field changed (e.g., because
+    // of time dependent boundary conditions). Since setting up the storage
+    // requires communication, all processes need to agree on this.
+    bool reinit = (!matrix_free
+                   ||
+                   (sim.parameters.mesh_deformation_enabled
+                    && matrix_free_timestep_number != sim.timestep_number));
+    if (!reinit)
+      {
+        ConstraintMatrix field_constraints;
+        IndexSet field_constrained_dofs;
+        extract_constraints(advection_field, field_constraints, field_constrained_dofs);
+        reinit = !(field_constrained_dofs == constrained_dofs[index]);
+      }
+
+    if (Utilities::MPI::max(reinit ? 1 : 0, sim.mpi_communicator) == 1)
+      reinit_matrix_free();
+
+    const bool use_supg = (sim.parameters.advection_stabilization_method
+                           == Parameters<dim>::AdvectionStabilizationMethod::supg);
+
+    // See Assemblers::AdvectionSystem for the definition of these constants:
+    const bool use_bdf2_scheme = (sim.timestep_number > 1);
+    const double bdf2_factor = (use_bdf2_scheme)? ((2*sim.time_step + sim.old_time_step) /
+                                                   (sim.time_step + sim.old_time_step)) : 1.0;
+
+    advection_matrix.clear();
+    advection_matrix.initialize(matrix_free, std::vector<unsigned int>(1, index));
+    advection_matrix.fill_cell_data(mass_coefficient_table,
+                                    velocity_table,
+                                    diffusion_table,
+                                    supg_tau_table,
+                                    supg_conductivity_table,
+                                    sim.time_step,
+                                    bdf2_factor,
+                                    use_supg);
+    diagonal_is_computed = false;
+  }
+
+
+
+  template <int dim, int degree, int n_q_points_1d>
+  void
+  AdvectionMatrixFreeHandlerImplementation<dim,degree,n_q_points_1d>::
+  fill_cell_coefficients (const typename Simulator<dim>::AdvectionField &advection_field,
+                          const typename DoFHandler<dim>::active_cell_iterator &cell,
+                          const internal::Assembly::Scratch::AdvectionSystem<dim> &scratch)
+  {
+    const std::pair<unsigned int, unsigned int> cell_batch = cell_batch_of_active_cell[cell->active_cell_index()];
+    Assert(cell_batch.first != numbers::invalid_unsigned_int,
+           ExcMessage("The matrix-free advection solver only supports the assembly on locally owned cells."));
+
+    const unsigned int n_q_points = scratch.finite_element_values.n_quadrature_points;
+    Assert(n_q_points == mass_coefficient_table.size(1), ExcInternalError());
+
+    const bool use_supg = (sim.parameters.advection_stabilization_method
+                           == Parameters<dim>::AdvectionStabilizationMethod::supg);
+    const bool advection_field_is_temperature = advection_field.is_temperature();
+
+    // Each cell only writes into its own vectorization lane, so this
+    // function can be called for different cells concurrently. The
+    // quadrature points of FEValues with a QGauss formula are numbered in
+    // the same (lexicographic) order as the ones of FEEvaluation.
+    // See Assemblers::AdvectionSystem for the definition of the coefficients.
+    for (unsigned int q=0; q<n_q_points; ++q)
+      {
+        const double density_c_P =
+          ((advection_field_is_temperature)
+           ?
+           scratch.material_model_outputs.densities[q] *
+           scratch.material_model_outputs.specific_heat[q]
+           :
+           1.0);
+
+        const double latent_heat_LHS =
+          ((advection_field_is_temperature)
+           ?
+           scratch.heating_model_outputs.lhs_latent_heat_terms[q]
+           :
+           0.0);
+
+        Tensor<1,dim> current_u = scratch.current_velocity_values[q];
+        // Subtract off the mesh velocity for ALE corrections if necessary
+        if (sim.parameters.mesh_deformation_enabled)
+          current_u -= scratch.mesh_velocity_values[q];
+
+        const double conductivity = (advection_field_is_temperature
+                                     ?
+                                     scratch.material_model_outputs.thermal_conductivities[q]
+                                     :
+                                     0.0);
+
+        mass_coefficient_table(cell_batch.first, q)[cell_batch.second] = density_c_P + latent_heat_LHS;
+        for (unsigned int d=0; d<dim; ++d)
+          velocity_table(cell_batch.first, q)[d][cell_batch.second] = current_u[d];
+
+        if (use_supg)
+          {
+            diffusion_table(cell_batch.first, q)[cell_batch.second] = conductivity;
+            supg_tau_table(cell_batch.first, q)[cell_batch.second] = scratch.artificial_viscosity;
+            supg_conductivity_table(cell_batch.first, q)[cell_batch.second] = conductivity;
+          }
+        else
+          diffusion_table(cell_batch.first, q)[cell_batch.second] = std::max (conductivity, scratch.artificial_viscosity);
+      }
+  }
+
+
+
+  template <int dim, int degree, int n_q_points_1d>
+  double
+  AdvectionMatrixFreeHandlerImplementation<dim,degree,n_q_points_1d>::
+  solve (const typename Simulator<dim>::AdvectionField &advection_field,
+         SolverControl &solver_control,
+         LinearAlgebra::Vector &solution)
+  {
+    Assert(advection_matrix.get_matrix_free() != nullptr,
+           ExcMessage("setup_operator() needs to be called before the system can be solved."));
+
+    const unsigned int block_idx = advection_field.block_index(sim.introspection);
+
+    dealii::LinearAlgebra::distributed::Vector<double> solution_copy;
+    dealii::LinearAlgebra::distributed::Vector<double> rhs_copy;
+    dealii::LinearAlgebra::distributed::Vector<double> residual;
+    advection_matrix.initialize_dof_vector(solution_copy);
+    advection_matrix.initialize_dof_vector(rhs_copy);
+    advection_matrix.initialize_dof_vector(residual);
+
+    // The constrained entries of the right-hand side are zero, since the
+    // right-hand side was assembled using the constraints, and the
+    // constrained entries of the initial guess have been set to zero.
+    // The operator is the identity on these entries, so they stay zero.
+    copy(solution_copy, solution);
+    copy(rhs_copy, sim.system_rhs.block(block_idx));
+
+    // Compute the residual before we solve and return this at the end.
+    // This is used in the nonlinear solver.
+    advection_matrix.vmult(residual, solution_copy);
+    residual.sadd(-1., 1., rhs_copy);
+    const double initial_residual = residual.l2_norm();
+
+    // The operator is not symmetric, so we use a GMRES solver that is
+    // preconditioned by the inverse of the diagonal of the operator.
+    // Fields that share the operator also share its diagonal.
+    if (!diagonal_is_computed)
+      {
+        advection_matrix.compute_diagonal();
+        diagonal_is_computed = true;
+      }
+
+    SolverGMRES<dealii::LinearAlgebra::distributed::Vector<double> >
+    solver(solver_control,
+           SolverGMRES<dealii::LinearAlgebra::distributed::Vector<double> >::AdditionalData(sim.parameters.advection_gmres_restart_length,true));
+
+    solver.solve(advection_matrix,
+                 solution_copy,
+                 rhs_copy,
+                 *advection_matrix.get_matrix_diagonal_inverse());
+
+    copy(solution, solution_copy);
+
+    return initial_residual;
+  }
+}
+
+
+
+// explicit instantiation of the functions we implement in this file
+namespace aspect
+{
+#define INSTANTIATE(dim) \
+  template class AdvectionMatrixFreeHandler<dim>; \
+  template class AdvectionMatrixFreeHandlerImplementation<dim,1,2>; \
+  template class AdvectionMatrixFreeHandlerImplementation<dim,1,3>; \
+  template class AdvectionMatrixFreeHandlerImplementation<dim,2,3>; \
+  template class AdvectionMatrixFreeHandlerImplementation<dim,2,4>; \
+  template class AdvectionMatrixFreeHandlerImplementation<dim,3,4>; \
+  template class AdvectionMatrixFreeHandlerImplementation<dim,3,5>;
+
+  ASPECT_INSTANTIATE(INSTANTIATE)
+
+#undef INSTANTIATE
+}
@@ -33,6 +33,7 @@
 #include <aspect/simulator/assemblers/advection.h>
 
 #include <aspect/stokes_matrix_free.h>
+#include <aspect/advection_matrix_free.h>
 
 #include <deal.II/base/quadrature_lib.h>
 #include <deal.II/base/work_stream.h>
@@ -47,6 +48,7 @@
 #include <deal.II/dofs/dof_tools.h>
 #include <deal.II/fe/fe_values.h>
 
+#include <chrono>
 #include <limits>
 
 
@@ -84,20 +86,18 @@ namespace aspect
     else
       material_model_inputs.strain_rate.resize(0);
 
-    // the values of the compositional fields are stored as block vectors for each field
-    // we have to extract them in this structure
-    std::vector<std::vector<double> > composition_values (introspection.n_compositional_fields,
-                                                          std::vector<double> (n_q_points));
-
+    // the material model inputs store the values of each compositional field at all
+    // quadrature points contiguously, so we can extract one field after the other
+    // and copy its values as a whole
+    std::vector<double> composition_values (n_q_points);
     for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-      input_finite_element_values[introspection.extractors.compositional_fields[c]].get_function_values(input_solution,
-          composition_values[c]);
-
-    // then we copy these values to exchange the inner and outer vector, because for the material
-    // model we need a vector with values of all the compositional fields for every quadrature point
-    for (unsigned int q=0; q<n_q_points; ++q)
-      for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-        material_model_inputs.composition[q][c] = composition_values[c][q];
+      {
+        input_finite_element_values[introspection.extractors.compositional_fields[c]].get_function_values(input_solution,
+            composition_values);
+        const ArrayView<double> field_values = material_model_inputs.composition.field_values(c);
+        AssertDimension (field_values.size(), composition_values.size());
+        std::copy (composition_values.begin(), composition_values.end(), field_values.begin());
+      }
 
     DEAL_II_DISABLE_EXTRA_DIAGNOSTICS
     material_model_inputs.cell = &cell;
@@ -108,6 +108,42 @@ namespace aspect
 
 
 
+  template <int dim>
+  void
+  Simulator<dim>::
+  evaluate_material_model (const MaterialModel::MaterialModelInputs<dim> &material_model_inputs,
+                           MaterialModel::MaterialModelOutputs<dim>      &material_model_outputs) const
+  {
+    // Measure the time of the evaluation on the current cell if it is used
+    // for load balancing, i.e., if the vector is not empty. Every cell is
+    // only worked on by one thread at a time, so the entries can be updated
+    // concurrently. If the outputs are cached, an evaluation that reuses
+    // the cached outputs only adds the time needed to copy them, so the
+    // time of a cell is the time of the evaluations that were actually
+    // necessary.
+    const bool measure_time = (!material_model_evaluation_time.empty()
+                               && material_model_inputs.current_cell.state() == IteratorState::valid);
+    const auto evaluation_start = (measure_time
+                                   ?
+                                   std::chrono::steady_clock::now()
+                                   :
+                                   std::chrono::steady_clock::time_point());
+
+    if (parameters.cache_material_model_outputs)
+      material_model_cache.evaluate(*material_model,
+                                    material_model_inputs,
+                                    material_model_outputs);
+    else
+      material_model->evaluate(material_model_inputs,
+                               material_model_outputs);
+
+    if (measure_time)
+      material_model_evaluation_time[material_model_inputs.current_cell->active_cell_index()]
+      += std::chrono::duration<double>(std::chrono::steady_clock::now() - evaluation_start).count();
+  }
+
+
+
   namespace
   {
     // This function initializes the simulator access for all assemblers
@@ -328,8 +364,8 @@ namespace aspect
     for (unsigned int i=0; i<assemblers->stokes_preconditioner.size(); ++i)
       assemblers->stokes_preconditioner[i]->create_additional_material_model_outputs(scratch.material_model_outputs);
 
-    material_model->evaluate(scratch.material_model_inputs,
-                             scratch.material_model_outputs);
+    evaluate_material_model(scratch.material_model_inputs,
+                            scratch.material_model_outputs);
     MaterialModel::MaterialAveraging::average (parameters.material_averaging,
                                                cell,
                                                scratch.finite_element_values.get_quadrature(),
@@ -584,8 +620,8 @@ namespace aspect
     for (unsigned int i=0; i<assemblers->stokes_system.size(); ++i)
       assemblers->stokes_system[i]->create_additional_material_model_outputs(scratch.material_model_outputs);
 
-    material_model->evaluate(scratch.material_model_inputs,
-                             scratch.material_model_outputs);
+    evaluate_material_model(scratch.material_model_inputs,
+                            scratch.material_model_outputs);
     MaterialModel::MaterialAveraging::average (parameters.material_averaging,
                                                cell,
                                                scratch.finite_element_values.get_quadrature(),
@@ -936,8 +972,8 @@ namespace aspect
                                                           scratch.finite_element_values,
                                                           introspection);
 
-    material_model->evaluate(scratch.material_model_inputs,
-                             scratch.material_model_outputs);
+    evaluate_material_model(scratch.material_model_inputs,
+                            scratch.material_model_outputs);
     if (parameters.formulation_temperature_equation ==
         Parameters<dim>::Formulation::TemperatureEquation::reference_density_profile)
       {
@@ -1087,6 +1123,51 @@ namespace aspect
       }
   }
 
+  template <int dim>
+  void Simulator<dim>::
+  local_assemble_advection_system_rhs (const AdvectionField     &advection_field,
+                                       internal::Assembly::Scratch::AdvectionSystem<dim> &scratch,
+                                       internal::Assembly::CopyData::AdvectionSystem<dim> &data)
+  {
+    const unsigned int advection_dofs_per_cell = data.local_dof_indices.size();
+
+    const FEValuesExtractors::Scalar solution_field = advection_field.scalar_extractor(introspection);
+
+    const unsigned int solution_component = advection_field.component_index(introspection);
+
+    // the dof indices of the cell have already been stored in the scratch
+    // object by local_assemble_advection_system()
+    for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell; /*increment at end of loop*/)
+      {
+        if (finite_element.system_to_component_index(i).first == solution_component)
+          {
+            data.local_dof_indices[i_advection] = scratch.local_dof_indices[i];
+            ++i_advection;
+          }
+        ++i;
+      }
+
+    data.local_matrix = 0;
+    data.local_rhs = 0;
+
+    scratch.finite_element_values[solution_field].get_function_values (old_solution,
+                                                                       scratch.old_field_values);
+    scratch.finite_element_values[solution_field].get_function_values (old_old_solution,
+                                                                       scratch.old_old_field_values);
+
+    // the assemblers determine the field they work on from the scratch
+    // object, everything else stored in it is the same for both fields
+    const AdvectionField *assembled_field = scratch.advection_field;
+    scratch.advection_field = &advection_field;
+
+    for (unsigned int i=0; i<assemblers->advection_system.size(); ++i)
+      assemblers->advection_system[i]->execute(scratch,data);
+
+    scratch.advection_field = assembled_field;
+  }
+
+
+
   template <int dim>
   void
   Simulator<dim>::
@@ -1095,6 +1176,17 @@ namespace aspect
   {
     // copy entries into the global matrix. note that these local contributions
     // only correspond to the advection dofs, as assembled above
+    if (use_matrix_free_advection_solver(advection_field))
+      {
+        // the matrix-free solver only needs the right hand side, but we still
+        // need the local matrix to account for inhomogeneous constraints
+        current_constraints.distribute_local_to_global (data.local_rhs,
+                                                        data.local_dof_indices,
+                                                        system_rhs,
+                                                        data.local_matrix);
+        return;
+      }
+
     current_constraints.distribute_local_to_global (data.local_matrix,
                                                     data.local_rhs,
                                                     data.local_dof_indices,
@@ -1138,23 +1230,54 @@ namespace aspect
   template <int dim>
   void Simulator<dim>::assemble_advection_system (const AdvectionField &advection_field)
   {
+    assemble_advection_system (std::vector<AdvectionField>(1, advection_field));
+  }
+
+
+
+  template <int dim>
+  void Simulator<dim>::assemble_advection_system (const std::vector<AdvectionField> &advection_fields)
+  {
+    Assert (advection_fields.size() > 0, ExcInternalError());
+
+    // The matrix is assembled for the first field, all other fields
+    // only contribute their right hand side
+    const AdvectionField &advection_field = advection_fields[0];
+
+    if (advection_fields.size() > 1)
+      for (const auto &field : advection_fields)
+        Assert (!field.is_temperature()
+                && advection_system_uses_default_assemblers_only(field),
+                ExcMessage("Only compositional fields that are assembled by the default "
+                           "advection assemblers can share the same matrix."));
+
     TimerOutput::Scope timer (computing_timer, (advection_field.is_temperature() ?
                                                 "Assemble temperature system" :
                                                 "Assemble composition system"));
 
     const unsigned int block_idx = advection_field.block_index(introspection);
 
-    if (!advection_field.is_temperature() && advection_field.compositional_variable!=0)
+    // If the field is solved matrix-free, we only assemble the right hand side,
+    // and store the coefficients of the operator while doing so
+    const bool use_matrix_free = use_matrix_free_advection_solver(advection_field);
+
+    if (use_matrix_free)
+      get_advection_matrix_free_handler(advection_field).setup_operator(advection_field);
+    else
       {
-        // Allocate the system matrix for the current compositional field by
-        // reusing the Trilinos sparsity pattern from the matrix stored for
-        // composition 0 (this is the place we allocate the matrix at).
-        const unsigned int block0_idx = AdvectionField::composition(0).block_index(introspection);
-        system_matrix.block(block_idx, block_idx).reinit(system_matrix.block(block0_idx, block0_idx));
-      }
+        if (!advection_field.is_temperature() && advection_field.compositional_variable!=0)
+          {
+            // Allocate the system matrix for the current compositional field by
+            // reusing the Trilinos sparsity pattern from the matrix stored for
+            // composition 0 (this is the place we allocate the matrix at).
+            const unsigned int block0_idx = AdvectionField::composition(0).block_index(introspection);
+            system_matrix.block(block_idx, block_idx).reinit(system_matrix.block(block0_idx, block0_idx));
+          }
 
-    system_matrix.block(block_idx, block_idx) = 0;
-    system_rhs.block(block_idx) = 0;
+        system_matrix.block(block_idx, block_idx) = 0;
+      }
+    for (const auto &field : advection_fields)
+      system_rhs.block(field.block_index(introspection)) = 0;
 
 
     typedef
@@ -1206,16 +1329,32 @@ namespace aspect
                                            :
                                            update_default);
 
+    // There is one copy data object per field. The first one holds the
+    // local matrix that is shared by all fields.
     auto worker = [&](const typename DoFHandler<dim>::active_cell_iterator &cell,
                       internal::Assembly::Scratch::AdvectionSystem<dim> &scratch,
-                      internal::Assembly::CopyData::AdvectionSystem<dim> &data)
+                      std::vector<internal::Assembly::CopyData::AdvectionSystem<dim> > &data)
     {
-      this->local_assemble_advection_system(advection_field, viscosity_per_cell, cell, scratch, data);
+      this->local_assemble_advection_system(advection_field, viscosity_per_cell, cell, scratch, data[0]);
+
+      if (use_matrix_free)
+        this->get_advection_matrix_free_handler(advection_field).fill_cell_coefficients(advection_field, cell, scratch);
+
+      for (unsigned int i=1; i<advection_fields.size(); ++i)
+        this->local_assemble_advection_system_rhs(advection_fields[i], scratch, data[i]);
     };
 
-    auto copier = [&](const internal::Assembly::CopyData::AdvectionSystem<dim> &data)
+    auto copier = [&](const std::vector<internal::Assembly::CopyData::AdvectionSystem<dim> > &data)
     {
-      this->copy_local_to_global_advection_system(advection_field, data);
+      this->copy_local_to_global_advection_system(advection_field, data[0]);
+
+      // we still need the shared local matrix to account for inhomogeneous
+      // constraints of the other fields
+      for (unsigned int i=1; i<advection_fields.size(); ++i)
+        current_constraints.distribute_local_to_global (data[i].local_rhs,
+                                                        data[i].local_dof_indices,
+                                                        system_rhs,
+                                                        data[0].local_matrix);
     };
 
     WorkStream::
@@ -1240,11 +1379,14 @@ namespace aspect
                                face_update_flags,
                                introspection.n_compositional_fields,
                                advection_field),
-         internal::Assembly::CopyData::
-         AdvectionSystem<dim> (finite_element.base_element(advection_field.base_element(introspection)),
-                               allocate_neighbor_contributions));
-
-    system_matrix.compress(VectorOperation::add);
+         std::vector<internal::Assembly::CopyData::AdvectionSystem<dim> >
+         (advection_fields.size(),
+          internal::Assembly::CopyData::
+          AdvectionSystem<dim> (finite_element.base_element(advection_field.base_element(introspection)),
+                                allocate_neighbor_contributions)));
+
+    if (!use_matrix_free)
+      system_matrix.compress(VectorOperation::add);
     system_rhs.compress(VectorOperation::add);
   }
 }
@@ -1283,13 +1425,21 @@ namespace aspect
   template void Simulator<dim>::copy_local_to_global_advection_system ( \
                                                                         const AdvectionField          &advection_field, \
                                                                         const internal::Assembly::CopyData::AdvectionSystem<dim> &data); \
+  template void Simulator<dim>::local_assemble_advection_system_rhs ( \
+                                                                      const AdvectionField          &advection_field, \
+                                                                      internal::Assembly::Scratch::AdvectionSystem<dim>  &scratch, \
+                                                                      internal::Assembly::CopyData::AdvectionSystem<dim> &data); \
   template void Simulator<dim>::assemble_advection_system (const AdvectionField     &advection_field); \
+  template void Simulator<dim>::assemble_advection_system (const std::vector<AdvectionField> &advection_fields); \
   template void Simulator<dim>::compute_material_model_input_values ( \
                                                                       const LinearAlgebra::BlockVector                      &input_solution, \
                                                                       const FEValuesBase<dim,dim>                           &input_finite_element_values, \
                                                                       const DoFHandler<dim>::active_cell_iterator  &cell, \
                                                                       const bool                                             compute_strainrate, \
-                                                                      MaterialModel::MaterialModelInputs<dim>               &material_model_inputs) const;
+                                                                      MaterialModel::MaterialModelInputs<dim>               &material_model_inputs) const; \
+  template void Simulator<dim>::evaluate_material_model ( \
+                                                          const MaterialModel::MaterialModelInputs<dim> &material_model_inputs, \
+                                                          MaterialModel::MaterialModelOutputs<dim>      &material_model_outputs) const;
 
 
 
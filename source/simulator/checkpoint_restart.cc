@@ -23,6 +23,7 @@
 #include <aspect/utilities.h>
 #include <aspect/mesh_deformation/interface.h>
 #include <aspect/melt.h>
+#include <aspect/stokes_matrix_free.h>
 
 #include <deal.II/base/mpi.h>
 #include <deal.II/grid/grid_tools.h>
@@ -400,6 +401,12 @@ namespace aspect
                            parameters.output_directory + "restart.mesh_variable.data.old");
               }
 #endif
+
+            if (Utilities::fexists(parameters.output_directory + "restart.particles"))
+              {
+                move_file (parameters.output_directory + "restart.particles",
+                           parameters.output_directory + "restart.particles.old");
+              }
           }
 
         move_file (parameters.output_directory + "restart.mesh.new",
@@ -419,6 +426,15 @@ namespace aspect
           }
 #endif
 
+        // The particles are only stored in a separate file if requested
+        // by the particle world, see Particle::World::save_particles()
+        if (particle_world.get() != nullptr
+            && particle_world->use_separate_checkpoint_file())
+          {
+            move_file (parameters.output_directory + "restart.particles.new",
+                       parameters.output_directory + "restart.particles");
+          }
+
         // from now on, we know that if we get into this
         // function again that a snapshot has previously
         // been written
@@ -505,6 +521,14 @@ namespace aspect
 
         mesh_deformation_trans.deserialize (fs_system);
         mesh_deformation->mesh_displacements = distributed_mesh_displacements;
+
+        // The matrix-free Stokes solver needs to know about the
+        // geometry of the (deformed) mesh we just restored.
+        if (stokes_matrix_free)
+          {
+            mesh_deformation->update_multilevel_deformation();
+            stokes_matrix_free->update_mapping();
+          }
       }
 
     // read zlib compressed resume.z
@@ -26,6 +26,7 @@
 #include <aspect/volume_of_fluid/handler.h>
 #include <aspect/newton.h>
 #include <aspect/stokes_matrix_free.h>
+#include <aspect/advection_matrix_free.h>
 #include <aspect/mesh_deformation/interface.h>
 #include <aspect/citation_info.h>
 #include <aspect/postprocess/particles.h>
@@ -388,13 +389,32 @@ namespace aspect
 
     if (parameters.stokes_solver_type == Parameters<dim>::StokesSolverType::block_gmg)
       {
+        // The number type of the multigrid hierarchy is a template
+        // argument as well, so we need to know it before creating the object:
+        bool use_single_precision_multigrid = false;
+        prm.enter_subsection ("Solver parameters");
+        {
+          prm.enter_subsection ("Matrix Free");
+          {
+            use_single_precision_multigrid = prm.get_bool ("Use single precision multigrid");
+          }
+          prm.leave_subsection ();
+        }
+        prm.leave_subsection ();
+
         switch (parameters.stokes_velocity_degree)
           {
             case 2:
-              stokes_matrix_free = std_cxx14::make_unique<StokesMatrixFreeHandlerImplementation<dim,2>>(*this, prm);
+              if (use_single_precision_multigrid)
+                stokes_matrix_free = std_cxx14::make_unique<StokesMatrixFreeHandlerImplementation<dim,2,float>>(*this, prm);
+              else
+                stokes_matrix_free = std_cxx14::make_unique<StokesMatrixFreeHandlerImplementation<dim,2,double>>(*this, prm);
               break;
             case 3:
-              stokes_matrix_free = std_cxx14::make_unique<StokesMatrixFreeHandlerImplementation<dim,3>>(*this, prm);
+              if (use_single_precision_multigrid)
+                stokes_matrix_free = std_cxx14::make_unique<StokesMatrixFreeHandlerImplementation<dim,3,float>>(*this, prm);
+              else
+                stokes_matrix_free = std_cxx14::make_unique<StokesMatrixFreeHandlerImplementation<dim,3,double>>(*this, prm);
               break;
             default:
               AssertThrow(false, ExcMessage("The finite element degree for the Stokes system you selected is not supported yet."));
@@ -516,6 +536,21 @@ namespace aspect
     // now that all member variables have been set up, also
     // connect the functions that will actually do the assembly
     set_assemblers();
+
+    // which fields can be solved matrix-free depends on the assemblers,
+    // so we can only set up the matrix-free advection solvers now
+    if (parameters.use_matrix_free_advection_solver)
+      {
+        if (use_matrix_free_advection_solver(AdvectionField::temperature()))
+          temperature_matrix_free = AdvectionMatrixFreeHandler<dim>::create(*this, AdvectionField::temperature());
+
+        for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
+          if (use_matrix_free_advection_solver(AdvectionField::composition(c)))
+            {
+              composition_matrix_free = AdvectionMatrixFreeHandler<dim>::create(*this, AdvectionField::composition(c));
+              break;
+            }
+      }
   }
 
 
@@ -700,6 +735,7 @@ namespace aspect
     // TODO: implement this for all plugins that might need it at one place.
     // Temperature BC are currently updated in compute_current_constraints
     material_model->update();
+    material_model_cache.clear();
     gravity_model->update();
     heating_model_manager.update();
     adiabatic_conditions->update();
@@ -987,13 +1023,18 @@ namespace aspect
     // matrix based algebraic multigrid.
     if (solver_scheme_solves_stokes_equations(parameters))
       {
-        // The matrix-free solver does not work with melt transport
-        Assert(!(parameters.include_melt_transport && stokes_matrix_free),
-               ExcNotImplemented());
-
         if (stokes_matrix_free)
           {
-            // nothing couples in the matrix free solver
+            // nothing in the Stokes system couples in the matrix free solver,
+            // but with melt transport the fluid velocity is computed from
+            // a mass matrix problem in MeltHandler::compute_melt_variables()
+            if (parameters.include_melt_transport)
+              {
+                const unsigned int first_fluid_c_i = introspection.variable("fluid velocity").first_component_index;
+                for (unsigned int c=0; c<dim; ++c)
+                  for (unsigned int d=0; d<dim; ++d)
+                    coupling[first_fluid_c_i+c][first_fluid_c_i+d] = DoFTools::always;
+              }
           }
         else if (parameters.include_melt_transport)
           {
@@ -1054,16 +1095,43 @@ namespace aspect
           }
       }
 
-    // Only enable temperature coupling if temperature block is needed
+    // Only enable temperature coupling if temperature block is needed,
+    // which is not the case if the temperature is solved matrix-free
     if (solver_scheme_solves_advection_equations(parameters)
         &&
-        parameters.temperature_method != Parameters<dim>::AdvectionFieldMethod::prescribed_field)
+        parameters.temperature_method != Parameters<dim>::AdvectionFieldMethod::prescribed_field
+        &&
+        !use_matrix_free_advection_solver(AdvectionField::temperature()))
       coupling[x.temperature][x.temperature] = DoFTools::always;
 
+    // Compositional fields that are solved matrix-free do not need a
+    // matrix block either
+    bool compositional_fields_need_matrix_block_for_solver = compositional_fields_need_matrix_block(introspection);
+    if (compositional_fields_need_matrix_block_for_solver
+        && parameters.use_matrix_free_advection_solver)
+      {
+        compositional_fields_need_matrix_block_for_solver = false;
+        for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
+          {
+            const AdvectionField adv_field (AdvectionField::composition(c));
+            switch (adv_field.advection_method(introspection))
+              {
+                case Parameters<dim>::AdvectionFieldMethod::fem_field:
+                case Parameters<dim>::AdvectionFieldMethod::fem_melt_field:
+                case Parameters<dim>::AdvectionFieldMethod::prescribed_field_with_diffusion:
+                  if (!use_matrix_free_advection_solver(adv_field))
+                    compositional_fields_need_matrix_block_for_solver = true;
+                  break;
+                default:
+                  break;
+              }
+          }
+      }
+
     // Only enable composition coupling if a composition block is needed
     if (solver_scheme_solves_advection_equations(parameters)
         &&
-        compositional_fields_need_matrix_block(introspection))
+        compositional_fields_need_matrix_block_for_solver)
       {
         // If we need at least one compositional field block, we
         // create a matrix block in the first compositional block. Its sparsity
@@ -1527,6 +1595,16 @@ namespace aspect
     // patterns and matrices until we have current_constraints.
     rebuild_sparsity_and_matrices = true;
 
+    // The measured cost of the cells and the cached material model
+    // outputs refer to the previous mesh. The time of the material model
+    // evaluation is only measured if the particles use it for load
+    // balancing.
+    if (particle_world.get() != nullptr && particle_world->uses_measured_cell_cost())
+      material_model_evaluation_time.assign(triangulation.n_active_cells(), 0.);
+    else
+      material_model_evaluation_time.clear();
+    material_model_cache.clear();
+
     system_rhs.reinit(introspection.index_sets.system_partitioning, mpi_communicator);
     solution.reinit(introspection.index_sets.system_partitioning, introspection.index_sets.system_relevant_partitioning, mpi_communicator);
     old_solution.reinit(introspection.index_sets.system_partitioning, introspection.index_sets.system_relevant_partitioning, mpi_communicator);
@@ -1545,6 +1623,10 @@ namespace aspect
     // Setup matrix-free dofs
     if (stokes_matrix_free)
       stokes_matrix_free->setup_dofs();
+    if (temperature_matrix_free)
+      temperature_matrix_free->setup_dofs();
+    if (composition_matrix_free)
+      composition_matrix_free->setup_dofs();
   }
 
 
@@ -1852,6 +1934,14 @@ namespace aspect
           mesh_deformation_trans->interpolate (system_tmp);
           mesh_deformation->mesh_vertex_constraints.distribute (distributed_mesh_displacements);
           mesh_deformation->mesh_displacements = distributed_mesh_displacements;
+
+          // The matrix-free Stokes solver needs to know about the
+          // geometry of the (deformed) mesh we just restored.
+          if (stokes_matrix_free)
+            {
+              mesh_deformation->update_multilevel_deformation();
+              stokes_matrix_free->update_mapping();
+            }
         }
 
       // Possibly load data of plugins associated with cells
@@ -527,7 +527,7 @@ namespace aspect
                                                               solution,
                                                               scratch.finite_element_values,
                                                               introspection);
-        material_model->evaluate(scratch.material_model_inputs,scratch.material_model_outputs);
+        evaluate_material_model(scratch.material_model_inputs,scratch.material_model_outputs);
         heating_model_manager.evaluate(scratch.material_model_inputs,scratch.material_model_outputs,scratch.heating_model_outputs);
 
         if (parameters.formulation_temperature_equation
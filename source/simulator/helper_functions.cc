@@ -23,8 +23,11 @@
 #include <aspect/melt.h>
 #include <aspect/volume_of_fluid/handler.h>
 #include <aspect/newton.h>
+#include <aspect/advection_matrix_free.h>
 #include <aspect/global.h>
 
+#include <aspect/simulator/assemblers/interface.h>
+#include <aspect/simulator/assemblers/advection.h>
 #include <aspect/geometry_model/interface.h>
 #include <aspect/heating_model/interface.h>
 #include <aspect/heating_model/adiabatic_heating.h>
@@ -61,6 +64,7 @@
 #include <iostream>
 #include <iomanip>
 #include <locale>
+#include <numeric>
 #include <string>
 
 
@@ -1359,6 +1363,186 @@ namespace aspect
 
 
 
+  template <int dim>
+  bool
+  Simulator<dim>::advection_system_uses_default_assemblers_only (const AdvectionField &advection_field) const
+  {
+    if (advection_field.is_discontinuous(introspection))
+      return false;
+
+    const typename Parameters<dim>::AdvectionFieldMethod::Kind advection_method
+      = (advection_field.is_temperature()
+         ?
+         parameters.temperature_method
+         :
+         advection_field.advection_method(introspection));
+    if (advection_method != Parameters<dim>::AdvectionFieldMethod::fem_field)
+      return false;
+
+    // No face terms are assembled for the field...
+    if ((!assemblers->advection_system_on_boundary_face.empty() ||
+         !assemblers->advection_system_on_interior_face.empty())
+        &&
+        assemblers->advection_system_assembler_on_face_properties[advection_field.field_index()].need_face_finite_element_evaluation)
+      return false;
+
+    // ...and only the terms of Assemblers::AdvectionSystem. The
+    // Assemblers::DiffusionSystem does not contribute to fields that
+    // are solved with the finite element method.
+    for (const auto &assembler : assemblers->advection_system)
+      if (typeid(*assembler) != typeid(Assemblers::AdvectionSystem<dim>)
+          &&
+          typeid(*assembler) != typeid(Assemblers::DiffusionSystem<dim>))
+        return false;
+
+    return true;
+  }
+
+
+
+  template <int dim>
+  bool
+  Simulator<dim>::use_matrix_free_advection_solver (const AdvectionField &advection_field) const
+  {
+    // The matrix-free operator only implements the terms of
+    // Assemblers::AdvectionSystem
+    return (parameters.use_matrix_free_advection_solver
+            &&
+            advection_system_uses_default_assemblers_only(advection_field));
+  }
+
+
+
+  template <int dim>
+  std::vector<std::vector<typename Simulator<dim>::AdvectionField> >
+  Simulator<dim>::group_compositional_fields_with_identical_matrices () const
+  {
+    // Computing the artificial viscosity requires a loop over all cells
+    // that is otherwise done while assembling the systems
+    TimerOutput::Scope timer (computing_timer, "Assemble composition system");
+
+    std::vector<std::vector<AdvectionField> > groups;
+    std::vector<Vector<double> > viscosity_per_group;
+
+    for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
+      {
+        const AdvectionField advection_field = AdvectionField::composition(c);
+
+        // If only the default assemblers are used, the matrix of a
+        // compositional field only depends on the field itself through its
+        // constraints and its artificial viscosity, since compositional
+        // fields have no physical diffusivity and a mass term of one.
+        if (!advection_system_uses_default_assemblers_only(advection_field))
+          {
+            groups.emplace_back(1, advection_field);
+            viscosity_per_group.emplace_back();
+            continue;
+          }
+
+        Vector<double> viscosity_per_cell (triangulation.n_active_cells());
+        get_artificial_viscosity(viscosity_per_cell, advection_field);
+
+        bool found_group = false;
+        for (unsigned int g=0; g<groups.size() && !found_group; ++g)
+          {
+            // only the first field of a group has its viscosity stored
+            if (viscosity_per_group[g].size() == 0)
+              continue;
+
+            const AdvectionField &group_field = groups[g][0];
+            bool identical = true;
+
+            // Compare the artificial viscosity on all locally owned cells.
+            // Both fields use the same computation, so identical values
+            // are bitwise identical.
+            for (const auto &cell : dof_handler.active_cell_iterators())
+              if (cell->is_locally_owned()
+                  &&
+                  viscosity_per_cell[cell->active_cell_index()] != viscosity_per_group[g][cell->active_cell_index()])
+                {
+                  identical = false;
+                  break;
+                }
+
+            // Compare the constraints of all locally owned degrees of
+            // freedom of the two blocks. All compositional fields use the
+            // same element, so the degrees of freedom of the two blocks are
+            // numbered in the same order.
+            const unsigned int block = advection_field.block_index(introspection);
+            const unsigned int group_block = group_field.block_index(introspection);
+            const types::global_dof_index block_start
+              = std::accumulate(introspection.system_dofs_per_block.begin(),
+                                introspection.system_dofs_per_block.begin() + block,
+                                types::global_dof_index(0));
+            const types::global_dof_index group_block_start
+              = std::accumulate(introspection.system_dofs_per_block.begin(),
+                                introspection.system_dofs_per_block.begin() + group_block,
+                                types::global_dof_index(0));
+
+            const IndexSet &locally_owned_dofs = introspection.index_sets.system_partitioning[block];
+            for (auto index = locally_owned_dofs.begin(); identical && index != locally_owned_dofs.end(); ++index)
+              {
+                const auto *entries = current_constraints.get_constraint_entries(block_start + *index);
+                const auto *group_entries = current_constraints.get_constraint_entries(group_block_start + *index);
+
+                if ((entries == nullptr) != (group_entries == nullptr))
+                  identical = false;
+                else if (entries != nullptr)
+                  {
+                    if (entries->size() != group_entries->size())
+                      identical = false;
+                    else
+                      for (unsigned int i=0; i<entries->size(); ++i)
+                        if ((*entries)[i].first - block_start != (*group_entries)[i].first - group_block_start
+                            ||
+                            (*entries)[i].second != (*group_entries)[i].second)
+                          identical = false;
+                  }
+              }
+
+            // all processes need to agree, since the fields of a group are
+            // assembled and solved together
+            if (Utilities::MPI::min(identical ? 1 : 0, mpi_communicator) == 1)
+              {
+                groups[g].push_back(advection_field);
+                found_group = true;
+              }
+          }
+
+        if (!found_group)
+          {
+            groups.emplace_back(1, advection_field);
+            viscosity_per_group.emplace_back(std::move(viscosity_per_cell));
+          }
+      }
+
+    return groups;
+  }
+
+
+
+  template <int dim>
+  AdvectionMatrixFreeHandler<dim> &
+  Simulator<dim>::get_advection_matrix_free_handler (const AdvectionField &advection_field) const
+  {
+    Assert (use_matrix_free_advection_solver(advection_field),
+            ExcMessage("The " + std::string(advection_field.is_temperature() ? "temperature" : "compositional field")
+                       + " is not solved with the matrix-free advection solver."));
+
+    if (advection_field.is_temperature())
+      {
+        Assert (temperature_matrix_free, ExcInternalError());
+        return *temperature_matrix_free;
+      }
+    else
+      {
+        Assert (composition_matrix_free, ExcInternalError());
+        return *composition_matrix_free;
+      }
+  }
+
+
+
   template <int dim>
   void Simulator<dim>::apply_limiter_to_dg_solutions (const AdvectionField &advection_field)
   {
@@ -1725,6 +1909,11 @@ namespace aspect
     // So even though we touch some DoF more than once, we always start from the same value, compute the
     // same value, and then overwrite the same value in distributed_vector.
     // TODO: make this more efficient.
+    // The accumulated updates are reset on every cell, but their memory is
+    // reused for all cells.
+    std::vector<std::vector<double> > accumulated_reactions_C (quadrature_C.size(),std::vector<double> (introspection.n_compositional_fields));
+    std::vector<double> accumulated_reactions_T (quadrature_T.size());
+
     for (const auto &cell : dof_handler.active_cell_iterators())
       if (cell->is_locally_owned())
         {
@@ -1737,8 +1926,9 @@ namespace aspect
               in_T.reinit(fe_values_T, cell, introspection, solution);
             }
 
-          std::vector<std::vector<double> > accumulated_reactions_C (quadrature_C.size(),std::vector<double> (introspection.n_compositional_fields));
-          std::vector<double> accumulated_reactions_T (quadrature_T.size());
+          for (unsigned int j=0; j<quadrature_C.size(); ++j)
+            std::fill (accumulated_reactions_C[j].begin(), accumulated_reactions_C[j].end(), 0.0);
+          std::fill (accumulated_reactions_T.begin(), accumulated_reactions_T.end(), 0.0);
 
           // Make the reaction time steps: We have to update the values of compositional fields and the temperature.
           // Because temperature and composition might use different finite elements, we loop through their elements
@@ -2518,6 +2708,10 @@ namespace aspect
   template void Simulator<dim>::write_plugin_graph(std::ostream &) const; \
   template double Simulator<dim>::compute_initial_stokes_residual(); \
   template bool Simulator<dim>::stokes_matrix_depends_on_solution() const; \
+  template bool Simulator<dim>::advection_system_uses_default_assemblers_only(const AdvectionField &advection_field) const; \
+  template bool Simulator<dim>::use_matrix_free_advection_solver(const AdvectionField &advection_field) const; \
+  template std::vector<std::vector<Simulator<dim>::AdvectionField> > Simulator<dim>::group_compositional_fields_with_identical_matrices() const; \
+  template AdvectionMatrixFreeHandler<dim> &Simulator<dim>::get_advection_matrix_free_handler(const AdvectionField &advection_field) const; \
   template void Simulator<dim>::interpolate_onto_velocity_system(const TensorFunction<1,dim> &func, LinearAlgebra::Vector &vec);\
   template void Simulator<dim>::apply_limiter_to_dg_solutions(const AdvectionField &advection_field); \
   template void Simulator<dim>::compute_reactions(); \
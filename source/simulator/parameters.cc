@@ -336,6 +336,38 @@ namespace aspect
                            "increasing this number increases the memory usage "
                            "of the advection solver, and makes individual "
                            "iterations more expensive.");
+
+        prm.declare_entry ("Use matrix-free advection solver", "false",
+                           Patterns::Bool (),
+                           "Whether to solve the linear systems of the temperature and "
+                           "compositional field equations with a matrix-free operator "
+                           "instead of assembling a sparse matrix for each field. The "
+                           "right-hand side is still assembled cell by cell, but the "
+                           "operator is applied on the fly using sum factorization and "
+                           "the system is solved with a GMRES solver preconditioned "
+                           "by the diagonal of the operator. This is only supported for "
+                           "continuous finite elements of polynomial degree 1 to 3 that "
+                           "are assembled by the default advection assemblers; all other "
+                           "fields (e.g., discontinuous fields, fields with melt "
+                           "transport, or temperature fields with boundary heat flux "
+                           "terms) are still solved with the matrix-based solver.");
+
+        prm.declare_entry ("Reuse matrix for identical compositional fields", "false",
+                           Patterns::Bool (),
+                           "Whether to detect compositional fields whose linear systems "
+                           "share the same matrix, and to assemble and precondition this "
+                           "matrix only once for all of them. This is the case for "
+                           "continuous fields that are advected with the finite element "
+                           "method by the default advection assemblers, have the same "
+                           "boundary conditions, and end up with the same artificial "
+                           "viscosity in every cell (which is always true when using "
+                           "SUPG stabilization). The right-hand sides of these fields "
+                           "are assembled in the same loop over all cells, and each of "
+                           "them is then solved with the shared matrix and "
+                           "preconditioner (or the shared matrix-free operator). The "
+                           "results are the same as without this option, but models "
+                           "with many compositional fields need considerably less time "
+                           "for the assembly and the preconditioner setup.");
       }
       prm.leave_subsection();
 
@@ -348,7 +380,9 @@ namespace aspect
                            "multigrid solver currently has a limited implementation and therefore "
                            "may trigger Asserts in the code when used. If this is the case, "
                            "please switch to 'block AMG'. Additionally, the block GMG solver requires "
-                           "using material model averaging.");
+                           "using material model averaging. Models with melt transport can only use the "
+                           "block GMG solver if 'Allow melt transport' is set in the subsection "
+                           "'Solver parameters/Matrix Free', see there for its limitations.");
 
         prm.declare_entry ("Use direct solver for Stokes system", "false",
                            Patterns::Bool(),
@@ -1252,6 +1286,18 @@ namespace aspect
                          "More averaging schemes are available in the averaging material "
                          "model. This material model is a ``compositing material model'' "
                          "which can be used in combination with other material models.");
+
+      prm.declare_entry ("Cache material model outputs", "false",
+                         Patterns::Bool (),
+                         "Whether to store the material model outputs computed on each cell "
+                         "during the assembly of the linear systems and the computation of "
+                         "the artificial viscosity, and to reuse them if the material model "
+                         "is evaluated again on the same cell with identical inputs, e.g., "
+                         "for the Stokes system and the Stokes preconditioner. This saves "
+                         "time for expensive material models, but requires memory for the "
+                         "inputs and outputs at all quadrature points of all cells. Outputs "
+                         "are only reused within one time step. Evaluations that use "
+                         "additional material model inputs or outputs are never reused.");
     }
     prm.leave_subsection ();
 
@@ -1335,6 +1381,8 @@ namespace aspect
       prm.enter_subsection ("Advection solver parameters");
       {
         advection_gmres_restart_length     = prm.get_integer("GMRES solver restart length");
+        use_matrix_free_advection_solver   = prm.get_bool("Use matrix-free advection solver");
+        reuse_matrix_for_identical_compositional_fields = prm.get_bool("Reuse matrix for identical compositional fields");
       }
       prm.leave_subsection ();
 
@@ -1921,6 +1969,7 @@ namespace aspect
       material_averaging
         = MaterialModel::MaterialAveraging::parse_averaging_operation_name
           (prm.get ("Material averaging"));
+      cache_material_model_outputs = prm.get_bool ("Cache material model outputs");
     }
     prm.leave_subsection ();
 
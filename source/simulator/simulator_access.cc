@@ -363,6 +363,15 @@ namespace aspect
   }
 
 
+
+  template <int dim>
+  const MaterialModel::EvaluationCache<dim> &
+  SimulatorAccess<dim>::get_material_model_cache () const
+  {
+    return simulator->material_model_cache;
+  }
+
+
   template <int dim>
   void
   SimulatorAccess<dim>::compute_material_model_input_values (const LinearAlgebra::BlockVector                            &input_solution,
@@ -750,6 +759,15 @@ namespace aspect
             ExcMessage("You can not call this function if the matrix-free Stokes solver is not used."));
     return *(simulator->stokes_matrix_free);
   }
+
+
+
+  template <int dim>
+  const std::vector<double> &
+  SimulatorAccess<dim>::get_material_model_evaluation_time () const
+  {
+    return simulator->material_model_evaluation_time;
+  }
 }
 
 
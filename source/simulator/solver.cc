@@ -23,6 +23,7 @@
 #include <aspect/global.h>
 #include <aspect/melt.h>
 #include <aspect/stokes_matrix_free.h>
+#include <aspect/advection_matrix_free.h>
 
 #include <deal.II/base/signaling_nan.h>
 #include <deal.II/lac/solver_gmres.h>
@@ -409,163 +410,204 @@ namespace aspect
   template <int dim>
   double Simulator<dim>::solve_advection (const AdvectionField &advection_field)
   {
-    double advection_solver_tolerance = -1;
-    unsigned int block_idx = advection_field.block_index(introspection);
+    return solve_advection (std::vector<AdvectionField>(1, advection_field))[0];
+  }
 
-    std::string field_name = (advection_field.is_temperature()
-                              ?
-                              "temperature"
-                              :
-                              introspection.name_for_compositional_index(advection_field.compositional_variable) + " composition");
 
-    if (advection_field.is_temperature())
-      advection_solver_tolerance = parameters.temperature_solver_tolerance;
-    else
-      advection_solver_tolerance = parameters.composition_solver_tolerance;
 
-    const double tolerance = std::max(1e-50,
-                                      advection_solver_tolerance*system_rhs.block(block_idx).l2_norm());
+  template <int dim>
+  std::vector<double> Simulator<dim>::solve_advection (const std::vector<AdvectionField> &advection_fields)
+  {
+    Assert (advection_fields.size() > 0, ExcInternalError());
 
-    SolverControl solver_control (1000, tolerance);
+    // All fields share the matrix stored in the block of the first field,
+    // and the preconditioner that is built from it
+    const AdvectionField &matrix_field = advection_fields[0];
+    const unsigned int matrix_block_idx = matrix_field.block_index(introspection);
 
-    solver_control.enable_history_data();
+    // If the fields are solved matrix-free, there is no matrix to check
+    // or to build a preconditioner from
+    const bool use_matrix_free = use_matrix_free_advection_solver(matrix_field);
 
-    SolverGMRES<LinearAlgebra::Vector>   solver (solver_control,
-                                                 SolverGMRES<LinearAlgebra::Vector>::AdditionalData(parameters.advection_gmres_restart_length,true));
+    LinearAlgebra::PreconditionILU preconditioner;
+    bool preconditioner_is_built = false;
+
+    std::vector<double> initial_residuals (advection_fields.size(), 0.);
 
-    // check if matrix and/or RHS are zero
-    // note: to avoid a warning, we compare against numeric_limits<double>::min() instead of 0 here
-    if (system_rhs.block(block_idx).l2_norm() <= std::numeric_limits<double>::min())
+    for (unsigned int f=0; f<advection_fields.size(); ++f)
       {
-        pcout << "   Skipping " + field_name + " solve because RHS is zero." << std::endl;
-        solution.block(block_idx) = 0;
+        const AdvectionField &advection_field = advection_fields[f];
 
-        // signal successful solver and signal residual of zero
-        solver_control.check(0, 0.0);
-        signals.post_advection_solver(*this,
-                                      advection_field.is_temperature(),
-                                      advection_field.compositional_variable,
-                                      solver_control);
+        double advection_solver_tolerance = -1;
+        unsigned int block_idx = advection_field.block_index(introspection);
 
-        return 0;
-      }
+        std::string field_name = (advection_field.is_temperature()
+                                  ?
+                                  "temperature"
+                                  :
+                                  introspection.name_for_compositional_index(advection_field.compositional_variable) + " composition");
 
-    AssertThrow(system_matrix.block(block_idx,
-                                    block_idx).linfty_norm() > std::numeric_limits<double>::min(),
-                ExcMessage ("The " + field_name + " equation can not be solved, because the matrix is zero, "
-                            "but the right-hand side is nonzero."));
+        if (advection_field.is_temperature())
+          advection_solver_tolerance = parameters.temperature_solver_tolerance;
+        else
+          advection_solver_tolerance = parameters.composition_solver_tolerance;
 
-    LinearAlgebra::PreconditionILU preconditioner;
-    // first build without diagonal strengthening:
-    build_advection_preconditioner(advection_field, preconditioner, 0.);
+        const double tolerance = std::max(1e-50,
+                                          advection_solver_tolerance*system_rhs.block(block_idx).l2_norm());
 
-    TimerOutput::Scope timer (computing_timer, (advection_field.is_temperature() ?
-                                                "Solve temperature system" :
-                                                "Solve composition system"));
-    if (advection_field.is_temperature())
-      {
-        pcout << "   Solving temperature system... " << std::flush;
-      }
-    else
-      {
-        pcout << "   Solving "
-              << introspection.name_for_compositional_index(advection_field.compositional_variable)
-              << " system "
-              << "... " << std::flush;
-      }
+        SolverControl solver_control (1000, tolerance);
 
-    // Create distributed vector (we need all blocks here even though we only
-    // solve for the current block) because only have a ConstraintMatrix
-    // for the whole system, current_linearization_point contains our initial guess.
-    LinearAlgebra::BlockVector distributed_solution (
-      introspection.index_sets.system_partitioning,
-      mpi_communicator);
-    distributed_solution.block(block_idx) = current_linearization_point.block (block_idx);
-
-    // Temporary vector to hold the residual, we don't need a BlockVector here.
-    LinearAlgebra::Vector temp (
-      introspection.index_sets.system_partitioning[block_idx],
-      mpi_communicator);
-
-    current_constraints.set_zero(distributed_solution);
-
-    // Compute the residual before we solve and return this at the end.
-    // This is used in the nonlinear solver.
-    const double initial_residual = system_matrix.block(block_idx,block_idx).residual
-                                    (temp,
-                                     distributed_solution.block(block_idx),
-                                     system_rhs.block(block_idx));
-
-    // solve the linear system:
-    try
-      {
+        solver_control.enable_history_data();
+
+        SolverGMRES<LinearAlgebra::Vector>   solver (solver_control,
+                                                     SolverGMRES<LinearAlgebra::Vector>::AdditionalData(parameters.advection_gmres_restart_length,true));
+
+        // check if matrix and/or RHS are zero
+        // note: to avoid a warning, we compare against numeric_limits<double>::min() instead of 0 here
+        if (system_rhs.block(block_idx).l2_norm() <= std::numeric_limits<double>::min())
+          {
+            pcout << "   Skipping " + field_name + " solve because RHS is zero." << std::endl;
+            solution.block(block_idx) = 0;
+
+            // signal successful solver and signal residual of zero
+            solver_control.check(0, 0.0);
+            signals.post_advection_solver(*this,
+                                          advection_field.is_temperature(),
+                                          advection_field.compositional_variable,
+                                          solver_control);
+
+            continue;
+          }
+
+        if (!use_matrix_free && !preconditioner_is_built)
+          {
+            AssertThrow(system_matrix.block(matrix_block_idx,
+                                            matrix_block_idx).linfty_norm() > std::numeric_limits<double>::min(),
+                        ExcMessage ("The " + field_name + " equation can not be solved, because the matrix is zero, "
+                                    "but the right-hand side is nonzero."));
+
+            // first build without diagonal strengthening:
+            build_advection_preconditioner(matrix_field, preconditioner, 0.);
+            preconditioner_is_built = true;
+          }
+
+        TimerOutput::Scope timer (computing_timer, (advection_field.is_temperature() ?
+                                                    "Solve temperature system" :
+                                                    "Solve composition system"));
+        if (advection_field.is_temperature())
+          {
+            pcout << "   Solving temperature system... " << std::flush;
+          }
+        else
+          {
+            pcout << "   Solving "
+                  << introspection.name_for_compositional_index(advection_field.compositional_variable)
+                  << " system "
+                  << "... " << std::flush;
+          }
+
+        // Create distributed vector (we need all blocks here even though we only
+        // solve for the current block) because only have a ConstraintMatrix
+        // for the whole system, current_linearization_point contains our initial guess.
+        LinearAlgebra::BlockVector distributed_solution (
+          introspection.index_sets.system_partitioning,
+          mpi_communicator);
+        distributed_solution.block(block_idx) = current_linearization_point.block (block_idx);
+
+        // Temporary vector to hold the residual, we don't need a BlockVector here.
+        LinearAlgebra::Vector temp (
+          introspection.index_sets.system_partitioning[block_idx],
+          mpi_communicator);
+
+        current_constraints.set_zero(distributed_solution);
+
+        // Compute the residual before we solve and return this at the end.
+        // This is used in the nonlinear solver. The matrix-free solver
+        // computes the residual itself.
+        if (!use_matrix_free)
+          initial_residuals[f] = system_matrix.block(matrix_block_idx,matrix_block_idx).residual
+                                 (temp,
+                                  distributed_solution.block(block_idx),
+                                  system_rhs.block(block_idx));
+
+        // solve the linear system:
         try
           {
-            solver.solve (system_matrix.block(block_idx,block_idx),
-                          distributed_solution.block(block_idx),
-                          system_rhs.block(block_idx),
-                          preconditioner);
+            if (use_matrix_free)
+              initial_residuals[f] = get_advection_matrix_free_handler(advection_field).solve(advection_field,
+                                     solver_control,
+                                     distributed_solution.block(block_idx));
+            else
+              {
+                try
+                  {
+                    solver.solve (system_matrix.block(matrix_block_idx,matrix_block_idx),
+                                  distributed_solution.block(block_idx),
+                                  system_rhs.block(block_idx),
+                                  preconditioner);
+                  }
+                catch (const std::exception &exc)
+                  {
+                    // Try rebuilding the preconditioner with diagonal strengthening. In general,
+                    // this increases the number of iterations needed, but helps in rare situations,
+                    // especially when SUPG is used. The strengthened preconditioner is
+                    // also used for all remaining fields that share the matrix.
+                    pcout << "retrying linear solve with different preconditioner..." << std::endl;
+                    build_advection_preconditioner(matrix_field, preconditioner, 1e-5);
+                    solver.solve (system_matrix.block(matrix_block_idx,matrix_block_idx),
+                                  distributed_solution.block(block_idx),
+                                  system_rhs.block(block_idx),
+                                  preconditioner);
+                  }
+              }
           }
+        // if the solver fails, report the error from processor 0 with some additional
+        // information about its location, and throw a quiet exception on all other
+        // processors
         catch (const std::exception &exc)
           {
-            // Try rebuilding the preconditioner with diagonal strengthening. In general,
-            // this increases the number of iterations needed, but helps in rare situations,
-            // especially when SUPG is used.
-            pcout << "retrying linear solve with different preconditioner..." << std::endl;
-            build_advection_preconditioner(advection_field, preconditioner, 1e-5);
-            solver.solve (system_matrix.block(block_idx,block_idx),
-                          distributed_solution.block(block_idx),
-                          system_rhs.block(block_idx),
-                          preconditioner);
+            // signal unsuccessful solver
+            signals.post_advection_solver(*this,
+                                          advection_field.is_temperature(),
+                                          advection_field.compositional_variable,
+                                          solver_control);
+
+            if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
+              {
+                linear_solver_failed("iterative advection solver",
+                                     parameters.output_directory+"solver_history.txt",
+                                     std::vector<SolverControl> {solver_control},
+                                     exc);
+              }
+            else
+              throw QuietException();
           }
 
-      }
-    // if the solver fails, report the error from processor 0 with some additional
-    // information about its location, and throw a quiet exception on all other
-    // processors
-    catch (const std::exception &exc)
-      {
-        // signal unsuccessful solver
+        // signal successful solver
         signals.post_advection_solver(*this,
                                       advection_field.is_temperature(),
                                       advection_field.compositional_variable,
                                       solver_control);
 
-        if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
-          {
-            linear_solver_failed("iterative advection solver",
-                                 parameters.output_directory+"solver_history.txt",
-                                 std::vector<SolverControl> {solver_control},
-                                 exc);
-          }
-        else
-          throw QuietException();
+        current_constraints.distribute (distributed_solution);
+        solution.block(block_idx) = distributed_solution.block(block_idx);
+
+        // print number of iterations and also record it in the
+        // statistics file
+        pcout << solver_control.last_step()
+              << " iterations." << std::endl;
+
+        if ((advection_field.is_temperature()
+             && parameters.use_discontinuous_temperature_discretization
+             && parameters.use_limiter_for_discontinuous_temperature_solution)
+            ||
+            (!advection_field.is_temperature()
+             && parameters.use_discontinuous_composition_discretization
+             && parameters.use_limiter_for_discontinuous_composition_solution))
+          apply_limiter_to_dg_solutions(advection_field);
       }
 
-    // signal successful solver
-    signals.post_advection_solver(*this,
-                                  advection_field.is_temperature(),
-                                  advection_field.compositional_variable,
-                                  solver_control);
-
-    current_constraints.distribute (distributed_solution);
-    solution.block(block_idx) = distributed_solution.block(block_idx);
-
-    // print number of iterations and also record it in the
-    // statistics file
-    pcout << solver_control.last_step()
-          << " iterations." << std::endl;
-
-    if ((advection_field.is_temperature()
-         && parameters.use_discontinuous_temperature_discretization
-         && parameters.use_limiter_for_discontinuous_temperature_solution)
-        ||
-        (!advection_field.is_temperature()
-         && parameters.use_discontinuous_composition_discretization
-         && parameters.use_limiter_for_discontinuous_composition_solution))
-      apply_limiter_to_dg_solutions(advection_field);
-
-    return initial_residual;
+    return initial_residuals;
   }
 
 
@@ -968,6 +1010,7 @@ namespace aspect
 {
 #define INSTANTIATE(dim) \
   template double Simulator<dim>::solve_advection (const AdvectionField &); \
+  template std::vector<double> Simulator<dim>::solve_advection (const std::vector<AdvectionField> &); \
   template std::pair<double,double> Simulator<dim>::solve_stokes ();
 
   ASPECT_INSTANTIATE(INSTANTIATE)
@@ -200,6 +200,29 @@ namespace aspect
         Assert(initial_residual->size() == introspection.n_compositional_fields, ExcInternalError());
       }
 
+    // Each compositional field is assembled and solved on its own, unless
+    // requested otherwise: then compositional fields that share the same
+    // matrix are assembled and solved together when the first field of each
+    // group is encountered in the loop below, and skipped afterwards.
+    std::vector<std::vector<AdvectionField> > groups;
+    if (parameters.reuse_matrix_for_identical_compositional_fields)
+      groups = group_compositional_fields_with_identical_matrices();
+    else
+      for (unsigned int c=0; c < introspection.n_compositional_fields; ++c)
+        groups.emplace_back(1, AdvectionField::composition(c));
+
+    std::vector<const std::vector<AdvectionField> *> fields_sharing_matrix (introspection.n_compositional_fields, nullptr);
+    for (const auto &group : groups)
+      fields_sharing_matrix[group[0].compositional_variable] = &group;
+
+    // All fields that are advected by particles are interpolated together
+    // when the first of them is encountered in the loop below.
+    std::vector<AdvectionField> particle_fields;
+    for (unsigned int c=0; c < introspection.n_compositional_fields; ++c)
+      if (AdvectionField::composition(c).advection_method(introspection)
+          == Parameters<dim>::AdvectionFieldMethod::particles)
+        particle_fields.push_back(AdvectionField::composition(c));
+
     for (unsigned int c=0; c < introspection.n_compositional_fields; ++c)
       {
         const AdvectionField adv_field (AdvectionField::composition(c));
@@ -210,6 +233,10 @@ namespace aspect
             case Parameters<dim>::AdvectionFieldMethod::fem_melt_field:
             case Parameters<dim>::AdvectionFieldMethod::prescribed_field_with_diffusion:
             {
+              // skip fields that were already solved together with another field
+              if (fields_sharing_matrix[c] == nullptr)
+                break;
+
               // if this is a prescribed field with diffusion, we first have to copy the material model
               // outputs into the prescribed field before we assemble and solve the equation
               if (method == Parameters<dim>::AdvectionFieldMethod::prescribed_field_with_diffusion)
@@ -224,12 +251,19 @@ namespace aspect
                   old_solution.block(adv_field.block_index(introspection)) = solution.block(adv_field.block_index(introspection));
                 }
 
-              assemble_advection_system (adv_field);
+              // the matrix is only assembled for the current field, all
+              // other fields that share it only assemble their right hand side
+              const std::vector<AdvectionField> &fields = *fields_sharing_matrix[c];
+              assemble_advection_system (fields);
 
               if (compute_initial_residual)
-                (*initial_residual)[c] = system_rhs.block(introspection.block_indices.compositional_fields[c]).l2_norm();
+                for (const auto &field : fields)
+                  (*initial_residual)[field.compositional_variable]
+                    = system_rhs.block(field.block_index(introspection)).l2_norm();
 
-              current_residual[c] = solve_advection(adv_field);
+              const std::vector<double> residuals = solve_advection(fields);
+              for (unsigned int i=0; i<fields.size(); ++i)
+                current_residual[fields[i].compositional_variable] = residuals[i];
 
               // Release the contents of the matrix block we used again:
               const unsigned int block_idx = adv_field.block_index(introspection);
@@ -244,7 +278,8 @@ namespace aspect
 
             case Parameters<dim>::AdvectionFieldMethod::particles:
             {
-              interpolate_particle_properties(adv_field);
+              if (c == particle_fields[0].compositional_variable)
+                interpolate_particle_properties(particle_fields);
               break;
             }
 
@@ -377,11 +412,6 @@ namespace aspect
   void Simulator<dim>::assemble_and_solve_defect_correction_Stokes(DefectCorrectionResiduals &dcr,
                                                                    bool use_picard)
   {
-    // The matrix-free GMG Stokes preconditioner is currently not implemented for the Newton solver.
-    if (stokes_matrix_free)
-      AssertThrow(newton_handler->parameters.newton_derivative_scaling_factor==0,
-                  ExcNotImplemented());
-
     /**
      * copied from solver.cc
      */
@@ -22,6 +22,8 @@
 #include <aspect/stokes_matrix_free.h>
 #include <aspect/citation_info.h>
 #include <aspect/melt.h>
+#include <aspect/newton.h>
+#include <aspect/mesh_deformation/free_surface.h>
 
 #include <deal.II/dofs/dof_renumbering.h>
 #include <deal.II/dofs/dof_accessor.h>
@@ -34,6 +36,7 @@
 #include <deal.II/fe/fe_values.h>
 
 #include <deal.II/base/signaling_nan.h>
+#include <deal.II/base/std_cxx14/memory.h>
 #include <deal.II/lac/solver_gmres.h>
 #include <deal.II/lac/read_write_vector.templates.h>
 
@@ -431,6 +434,42 @@ namespace aspect
     }
 
 
+    /**
+     * A preconditioner for the Schur complement approximation that either
+     * applies a GMG V-cycle or, if no multigrid hierarchy is available for
+     * the pressure (as for the discontinuous FE_DGP element), the inverse
+     * of the diagonal of the operator. Exactly one of the two pointers
+     * given to the constructor must be non-null.
+     */
+    template <class GMGPreconditionerType, class DiagonalPreconditionerType>
+    class SchurComplementPreconditioner
+    {
+      public:
+        SchurComplementPreconditioner (const GMGPreconditionerType      *gmg_preconditioner,
+                                       const DiagonalPreconditionerType *diagonal_preconditioner)
+          :
+          gmg_preconditioner (gmg_preconditioner),
+          diagonal_preconditioner (diagonal_preconditioner)
+        {
+          Assert((gmg_preconditioner == nullptr) != (diagonal_preconditioner == nullptr),
+                 ExcMessage("Exactly one of the two preconditioners must be given."));
+        }
+
+        void vmult (dealii::LinearAlgebra::distributed::Vector<double>       &dst,
+                    const dealii::LinearAlgebra::distributed::Vector<double> &src) const
+        {
+          if (gmg_preconditioner != nullptr)
+            gmg_preconditioner->vmult(dst, src);
+          else
+            diagonal_preconditioner->vmult(dst, src);
+        }
+
+      private:
+        const GMGPreconditionerType      *gmg_preconditioner;
+        const DiagonalPreconditionerType *diagonal_preconditioner;
+    };
+
+
     /**
      * Implement the block Schur preconditioner for the Stokes system.
      */
@@ -669,7 +708,13 @@ namespace aspect
   template <int dim, int degree_v, typename number>
   MatrixFreeStokesOperators::StokesOperator<dim,degree_v,number>::StokesOperator ()
     :
-    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >()
+    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >(),
+    newton_viscosity_derivative(nullptr),
+    newton_strain_rate(nullptr),
+    newton_pressure_derivative(nullptr),
+    symmetrize_newton_terms(false),
+    reference_density_gradient(nullptr),
+    free_surface_stabilization(nullptr)
   {}
 
   template <int dim, int degree_v, typename number>
@@ -677,6 +722,12 @@ namespace aspect
   MatrixFreeStokesOperators::StokesOperator<dim,degree_v,number>::clear ()
   {
     viscosity = nullptr;
+    newton_viscosity_derivative = nullptr;
+    newton_strain_rate = nullptr;
+    newton_pressure_derivative = nullptr;
+    reference_density_gradient = nullptr;
+    free_surface_stabilization = nullptr;
+    free_surface_boundary_indicators.clear();
     MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::BlockVector<number> >::clear();
   }
 
@@ -690,6 +741,45 @@ namespace aspect
     viscosity = &viscosity_table;
     this->pressure_scaling = pressure_scaling;
     this->is_compressible = is_compressible;
+
+    // The Newton terms need to be set again for each new linearization point,
+    // and the reference density gradient whenever the mesh changes:
+    newton_viscosity_derivative = nullptr;
+    newton_strain_rate = nullptr;
+    newton_pressure_derivative = nullptr;
+    reference_density_gradient = nullptr;
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::StokesOperator<dim,degree_v,number>::
+  set_newton_derivatives (const Table<2, SymmetricTensor<2,dim,VectorizedArray<number>>> &viscosity_derivative_table,
+                          const Table<2, SymmetricTensor<2,dim,VectorizedArray<number>>> &strain_rate_table,
+                          const Table<2, VectorizedArray<number>> &pressure_derivative_table,
+                          const bool symmetrize)
+  {
+    newton_viscosity_derivative = &viscosity_derivative_table;
+    newton_strain_rate = &strain_rate_table;
+    newton_pressure_derivative = &pressure_derivative_table;
+    symmetrize_newton_terms = symmetrize;
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::StokesOperator<dim,degree_v,number>::
+  set_implicit_reference_density_gradient (const Table<2, Tensor<1,dim,VectorizedArray<number>>> &reference_density_gradient_table)
+  {
+    reference_density_gradient = &reference_density_gradient_table;
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::StokesOperator<dim,degree_v,number>::
+  set_free_surface_stabilization (const Table<2, Tensor<1,dim,VectorizedArray<number>>> &stabilization_table,
+                                  const std::set<types::boundary_id> &free_surface_boundary_indicators)
+  {
+    free_surface_stabilization = &stabilization_table;
+    this->free_surface_boundary_indicators = free_surface_boundary_indicators;
   }
 
   template <int dim, int degree_v, typename number>
@@ -717,13 +807,16 @@ namespace aspect
     const bool use_viscosity_at_quadrature_points
       = (viscosity->size(1) == velocity.n_q_points);
 
+    const bool apply_newton_terms = (newton_viscosity_derivative != nullptr);
+    const bool apply_reference_density_term = (reference_density_gradient != nullptr);
+
     for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
       {
         VectorizedArray<number> viscosity_x_2 = 2.0*(*viscosity)(cell, 0);
 
         velocity.reinit (cell);
         velocity.read_dof_values (src.block(0));
-        velocity.evaluate (false,true,false);
+        velocity.evaluate (apply_reference_density_term,true,false);
         pressure.reinit (cell);
         pressure.read_dof_values (src.block(1));
         pressure.evaluate (true,false,false);
@@ -738,7 +831,29 @@ namespace aspect
                                                           velocity.get_symmetric_gradient (q);
             VectorizedArray<number> pres = pressure.get_value(q);
             VectorizedArray<number> div = trace(sym_grad_u);
-            pressure.submit_value(-pressure_scaling*div, q);
+
+            // Implicit reference density profile formulation, see
+            // Assemblers::StokesImplicitReferenceDensityCompressibilityTerm:
+            if (apply_reference_density_term)
+              pressure.submit_value(-pressure_scaling*(div + (*reference_density_gradient)(cell, q) * velocity.get_value(q)), q);
+            else
+              pressure.submit_value(-pressure_scaling*div, q);
+
+            // Newton linearization terms, see Assemblers::NewtonStokesIncompressibleTerms:
+            SymmetricTensor<2,dim,VectorizedArray<number>> newton_terms;
+            if (apply_newton_terms)
+              {
+                const SymmetricTensor<2,dim,VectorizedArray<number>> &deta_deps = (*newton_viscosity_derivative)(cell, q);
+                const SymmetricTensor<2,dim,VectorizedArray<number>> &strain_rate = (*newton_strain_rate)(cell, q);
+
+                if (symmetrize_newton_terms)
+                  newton_terms = (deta_deps * sym_grad_u) * strain_rate
+                                 + (strain_rate * sym_grad_u) * deta_deps;
+                else
+                  newton_terms = 2.0 * (deta_deps * sym_grad_u) * strain_rate;
+
+                newton_terms += (pressure_scaling * (*newton_pressure_derivative)(cell, q) * pres) * strain_rate;
+              }
 
             sym_grad_u *= viscosity_x_2;
 
@@ -749,6 +864,9 @@ namespace aspect
               for (unsigned int d=0; d<dim; ++d)
                 sym_grad_u[d][d] -= viscosity_x_2/3.0*div;
 
+            if (apply_newton_terms)
+              sym_grad_u += newton_terms;
+
             velocity.submit_symmetric_gradient(sym_grad_u, q);
           }
 
@@ -759,14 +877,66 @@ namespace aspect
       }
   }
 
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::StokesOperator<dim,degree_v,number>
+  ::local_apply_face (const dealii::MatrixFree<dim, number> &,
+                      dealii::LinearAlgebra::distributed::BlockVector<number> &,
+                      const dealii::LinearAlgebra::distributed::BlockVector<number> &,
+                      const std::pair<unsigned int, unsigned int> &) const
+  {}
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::StokesOperator<dim,degree_v,number>
+  ::local_apply_boundary_face (const dealii::MatrixFree<dim, number>                 &data,
+                               dealii::LinearAlgebra::distributed::BlockVector<number>       &dst,
+                               const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                               const std::pair<unsigned int, unsigned int>           &face_range) const
+  {
+    FEFaceEvaluation<dim,degree_v,degree_v+1,dim,number> velocity_boundary (data, true, 0);
+    const unsigned int n_inner_faces = data.n_inner_face_batches();
+
+    for (unsigned int face=face_range.first; face<face_range.second; ++face)
+      {
+        if (free_surface_boundary_indicators.find(data.get_boundary_id(face))
+            == free_surface_boundary_indicators.end())
+          continue;
+
+        velocity_boundary.reinit (face);
+        velocity_boundary.read_dof_values (src.block(0));
+        velocity_boundary.evaluate (true,false);
+
+        for (unsigned int q=0; q<velocity_boundary.n_q_points; ++q)
+          {
+            // The stabilization term is -(theta dt rho g . v)(u . n), see
+            // Assemblers::ApplyStabilization for the matrix-based version.
+            const Tensor<1,dim,VectorizedArray<number>> u = velocity_boundary.get_value(q);
+            const VectorizedArray<number> u_dot_n = u * velocity_boundary.get_normal_vector(q);
+
+            velocity_boundary.submit_value(-u_dot_n * (*free_surface_stabilization)(face-n_inner_faces, q), q);
+          }
+
+        velocity_boundary.integrate (true,false);
+        velocity_boundary.distribute_local_to_global (dst.block(0));
+      }
+  }
+
   template <int dim, int degree_v, typename number>
   void
   MatrixFreeStokesOperators::StokesOperator<dim,degree_v,number>
   ::apply_add (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
                const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const
   {
-    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >::
-    data->cell_loop(&StokesOperator::local_apply, this, dst, src);
+    if (free_surface_stabilization != nullptr)
+      MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >::
+      data->loop(&StokesOperator::local_apply,
+                 &StokesOperator::local_apply_face,
+                 &StokesOperator::local_apply_boundary_face,
+                 this, dst, src);
+    else
+      MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >::
+      data->cell_loop(&StokesOperator::local_apply, this, dst, src);
   }
 
   /**
@@ -947,13 +1117,389 @@ namespace aspect
       }
   }
 
+  /**
+   * Stokes operator with melt transport
+   */
+  template <int dim, int degree_v, typename number>
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>::MeltStokesOperator ()
+    :
+    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >(),
+    viscosity(nullptr),
+    darcy_coefficient(nullptr),
+    one_over_compaction_viscosity(nullptr),
+    p_c_scale(nullptr),
+    fluid_density_gradient(nullptr)
+  {}
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>::clear ()
+  {
+    viscosity = nullptr;
+    darcy_coefficient = nullptr;
+    one_over_compaction_viscosity = nullptr;
+    p_c_scale = nullptr;
+    fluid_density_gradient = nullptr;
+    MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::BlockVector<number> >::clear();
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>::
+  fill_cell_data (const Table<2, VectorizedArray<number>> &viscosity_table,
+                  const Table<2, VectorizedArray<number>> &darcy_coefficient_table,
+                  const Table<2, VectorizedArray<number>> &one_over_compaction_viscosity_table,
+                  const Table<2, VectorizedArray<number>> &p_c_scale_table,
+                  const Table<2, Tensor<1,dim,VectorizedArray<number>>> &fluid_density_gradient_table,
+                  const double pressure_scaling)
+  {
+    viscosity = &viscosity_table;
+    darcy_coefficient = &darcy_coefficient_table;
+    one_over_compaction_viscosity = &one_over_compaction_viscosity_table;
+    p_c_scale = &p_c_scale_table;
+    fluid_density_gradient = &fluid_density_gradient_table;
+    this->pressure_scaling = pressure_scaling;
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>
+  ::compute_diagonal ()
+  {
+    // As for the Stokes operator without melt, the diagonal of the entire
+    // system is not needed anywhere.
+    Assert(false, ExcNotImplemented());
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>
+  ::do_cell_integral (FEEvaluation<dim,degree_v,degree_v+1,dim,number> &velocity,
+                      FEEvaluation<dim,degree_v-1,degree_v+1,2,number> &pressure,
+                      const unsigned int cell) const
+  {
+    const bool use_viscosity_at_quadrature_points
+      = (viscosity->size(1) == velocity.n_q_points);
+    const bool is_compressible = (fluid_density_gradient->size(0) > 0);
+    const number pressure_scaling_squared = pressure_scaling*pressure_scaling;
+
+    velocity.evaluate (false,true,false);
+    pressure.evaluate (true,true,false);
+
+    VectorizedArray<number> viscosity_x_2 = 2.0*(*viscosity)(cell, 0);
+
+    for (unsigned int q=0; q<velocity.n_q_points; ++q)
+      {
+        // Only update the viscosity if a Q1 projection is used.
+        if (use_viscosity_at_quadrature_points)
+          viscosity_x_2 = 2.0*(*viscosity)(cell, q);
+
+        const VectorizedArray<number> K_D = (*darcy_coefficient)(cell, q);
+        const VectorizedArray<number> p_c_scale_q = (*p_c_scale)(cell, q);
+
+        SymmetricTensor<2,dim,VectorizedArray<number>> sym_grad_u =
+                                                      velocity.get_symmetric_gradient (q);
+        const VectorizedArray<number> div = trace(sym_grad_u);
+
+        // The first pressure component is the fluid pressure p_f, the
+        // second one the compaction pressure p_c.
+        const Tensor<1,2,VectorizedArray<number>> pres = pressure.get_value(q);
+        const Tensor<1,2,Tensor<1,dim,VectorizedArray<number>>> grad_pres = pressure.get_gradient(q);
+
+        // See Assemblers::MeltStokesSystem for the matrix-based version of
+        // the following terms.
+        Tensor<1,2,VectorizedArray<number>> pressure_value;
+        pressure_value[0] = -pressure_scaling*div;
+        if (is_compressible)
+          pressure_value[0] += pressure_scaling_squared * ((*fluid_density_gradient)(cell, q) * grad_pres[0]);
+        pressure_value[1] = -pressure_scaling*p_c_scale_q*div
+                            - pressure_scaling_squared*p_c_scale_q*p_c_scale_q
+                            *(*one_over_compaction_viscosity)(cell, q)*pres[1];
+
+        Tensor<1,2,Tensor<1,dim,VectorizedArray<number>>> pressure_gradient;
+        pressure_gradient[0] = -pressure_scaling_squared*K_D*grad_pres[0];
+
+        pressure.submit_value(pressure_value, q);
+        pressure.submit_gradient(pressure_gradient, q);
+
+        sym_grad_u *= viscosity_x_2;
+
+        for (unsigned int d=0; d<dim; ++d)
+          sym_grad_u[d][d] -= viscosity_x_2/3.0*div
+                              + pressure_scaling*(pres[0] + p_c_scale_q*pres[1]);
+
+        velocity.submit_symmetric_gradient(sym_grad_u, q);
+      }
+
+    velocity.integrate (false,true);
+    pressure.integrate (true,true);
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>
+  ::local_apply (const dealii::MatrixFree<dim, number>                 &data,
+                 dealii::LinearAlgebra::distributed::BlockVector<number>       &dst,
+                 const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                 const std::pair<unsigned int, unsigned int>           &cell_range) const
+  {
+    FEEvaluation<dim,degree_v,degree_v+1,dim,number> velocity (data, 0);
+    FEEvaluation<dim,degree_v-1,degree_v+1,2,number> pressure (data, 1);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        velocity.reinit (cell);
+        velocity.read_dof_values (src.block(0));
+        pressure.reinit (cell);
+        pressure.read_dof_values (src.block(1));
+
+        do_cell_integral (velocity, pressure, cell);
+
+        velocity.distribute_local_to_global (dst.block(0));
+        pressure.distribute_local_to_global (dst.block(1));
+      }
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>
+  ::local_apply_without_constraints (const dealii::MatrixFree<dim, number>                 &data,
+                                     dealii::LinearAlgebra::distributed::BlockVector<number>       &dst,
+                                     const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                                     const std::pair<unsigned int, unsigned int>           &cell_range) const
+  {
+    FEEvaluation<dim,degree_v,degree_v+1,dim,number> velocity (data, 0);
+    FEEvaluation<dim,degree_v-1,degree_v+1,2,number> pressure (data, 1);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        velocity.reinit (cell);
+        velocity.read_dof_values_plain (src.block(0));
+        pressure.reinit (cell);
+        pressure.read_dof_values_plain (src.block(1));
+
+        do_cell_integral (velocity, pressure, cell);
+
+        velocity.distribute_local_to_global (dst.block(0));
+        pressure.distribute_local_to_global (dst.block(1));
+      }
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>
+  ::apply_add (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+               const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const
+  {
+    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >::
+    data->cell_loop(&MeltStokesOperator::local_apply, this, dst, src);
+  }
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::MeltStokesOperator<dim,degree_v,number>
+  ::apply_add_without_constraints (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                                   const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const
+  {
+    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >::
+    data->cell_loop(&MeltStokesOperator::local_apply_without_constraints, this, dst, src);
+  }
+
+  /**
+   * Schur complement approximation for the Stokes system with melt transport
+   */
+  template <int dim, int degree_p, typename number>
+  MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,degree_p,number>::MeltSchurComplementOperator ()
+    :
+    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >(),
+    viscosity(nullptr),
+    darcy_coefficient(nullptr),
+    one_over_compaction_viscosity(nullptr),
+    p_c_scale(nullptr)
+  {}
+
+  template <int dim, int degree_p, typename number>
+  void
+  MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,degree_p,number>::clear ()
+  {
+    viscosity = nullptr;
+    darcy_coefficient = nullptr;
+    one_over_compaction_viscosity = nullptr;
+    p_c_scale = nullptr;
+    MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::clear();
+  }
+
+  template <int dim, int degree_p, typename number>
+  void
+  MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,degree_p,number>::
+  fill_cell_data (const Table<2, VectorizedArray<number>> &viscosity_table,
+                  const Table<2, VectorizedArray<number>> &darcy_coefficient_table,
+                  const Table<2, VectorizedArray<number>> &one_over_compaction_viscosity_table,
+                  const Table<2, VectorizedArray<number>> &p_c_scale_table,
+                  const double pressure_scaling)
+  {
+    viscosity = &viscosity_table;
+    darcy_coefficient = &darcy_coefficient_table;
+    one_over_compaction_viscosity = &one_over_compaction_viscosity_table;
+    p_c_scale = &p_c_scale_table;
+    this->pressure_scaling = pressure_scaling;
+  }
+
+  template <int dim, int degree_p, typename number>
+  void
+  MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,degree_p,number>
+  ::do_quadrature_point_operations (FEEvaluation<dim,degree_p,degree_p+2,2,number> &pressure,
+                                    const unsigned int cell) const
+  {
+    const bool use_viscosity_at_quadrature_points
+      = (viscosity->size(1) == pressure.n_q_points);
+    const number pressure_scaling_squared = pressure_scaling*pressure_scaling;
+
+    // The /= operator for VectorizedArray results in a foating point operation
+    // (divide by 0) since the (*viscosity)(cell) array is not completely filled.
+    // Therefore, we need to divide each entry manually.
+    const unsigned int n_components_filled = this->get_matrix_free()->n_components_filled(cell);
+
+    VectorizedArray<number> one_over_viscosity = make_vectorized_array<number>(0.);
+    for (unsigned int c=0; c<n_components_filled; ++c)
+      one_over_viscosity[c] = 1./(*viscosity)(cell, 0)[c];
+
+    for (unsigned int q=0; q<pressure.n_q_points; ++q)
+      {
+        // Only update the viscosity if a Q1 projection is used.
+        if (use_viscosity_at_quadrature_points)
+          for (unsigned int c=0; c<n_components_filled; ++c)
+            one_over_viscosity[c] = 1./(*viscosity)(cell, q)[c];
+
+        const VectorizedArray<number> p_c_scale_q = (*p_c_scale)(cell, q);
+        const Tensor<1,2,VectorizedArray<number>> pres = pressure.get_value(q);
+
+        // See Assemblers::MeltStokesPreconditioner for the matrix-based
+        // version of the following terms.
+        const VectorizedArray<number> scaled_pressure_sum
+          = pressure_scaling_squared*one_over_viscosity*(pres[0] + p_c_scale_q*pres[1]);
+
+        Tensor<1,2,VectorizedArray<number>> pressure_value;
+        pressure_value[0] = scaled_pressure_sum;
+        pressure_value[1] = p_c_scale_q*scaled_pressure_sum
+                            + pressure_scaling_squared*p_c_scale_q*p_c_scale_q
+                            *(*one_over_compaction_viscosity)(cell, q)*pres[1];
+
+        Tensor<1,2,Tensor<1,dim,VectorizedArray<number>>> pressure_gradient;
+        pressure_gradient[0] = pressure_scaling_squared*(*darcy_coefficient)(cell, q)*pressure.get_gradient(q)[0];
+
+        pressure.submit_value(pressure_value, q);
+        pressure.submit_gradient(pressure_gradient, q);
+      }
+  }
+
+  template <int dim, int degree_p, typename number>
+  void
+  MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,degree_p,number>
+  ::local_apply (const dealii::MatrixFree<dim, number>                 &data,
+                 dealii::LinearAlgebra::distributed::Vector<number>       &dst,
+                 const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                 const std::pair<unsigned int, unsigned int>           &cell_range) const
+  {
+    FEEvaluation<dim,degree_p,degree_p+2,2,number> pressure (data);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        pressure.reinit (cell);
+        pressure.read_dof_values(src);
+        pressure.evaluate (true, true);
+        do_quadrature_point_operations (pressure, cell);
+        pressure.integrate (true, true);
+        pressure.distribute_local_to_global (dst);
+      }
+  }
+
+  template <int dim, int degree_p, typename number>
+  void
+  MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,degree_p,number>
+  ::apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
+               const dealii::LinearAlgebra::distributed::Vector<number> &src) const
+  {
+    MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::
+    data->cell_loop(&MeltSchurComplementOperator::local_apply, this, dst, src);
+  }
+
+  template <int dim, int degree_p, typename number>
+  void
+  MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,degree_p,number>
+  ::compute_diagonal ()
+  {
+    this->inverse_diagonal_entries.
+    reset(new DiagonalMatrix<dealii::LinearAlgebra::distributed::Vector<number> >());
+    this->diagonal_entries.
+    reset(new DiagonalMatrix<dealii::LinearAlgebra::distributed::Vector<number> >());
+
+    dealii::LinearAlgebra::distributed::Vector<number> &inverse_diagonal =
+      this->inverse_diagonal_entries->get_vector();
+    dealii::LinearAlgebra::distributed::Vector<number> &diagonal =
+      this->diagonal_entries->get_vector();
+
+    unsigned int dummy = 0;
+    this->data->initialize_dof_vector(inverse_diagonal);
+    this->data->initialize_dof_vector(diagonal);
+
+    this->data->cell_loop (&MeltSchurComplementOperator::local_compute_diagonal, this,
+                           diagonal, dummy);
+
+    this->set_constrained_entries_to_one(diagonal);
+    inverse_diagonal = diagonal;
+    const unsigned int local_size = inverse_diagonal.local_size();
+    for (unsigned int i=0; i<local_size; ++i)
+      {
+        Assert(inverse_diagonal.local_element(i) > 0.,
+               ExcMessage("No diagonal entry in a positive definite operator "
+                          "should be zero"));
+        inverse_diagonal.local_element(i)
+          =1./inverse_diagonal.local_element(i);
+      }
+  }
+
+  template <int dim, int degree_p, typename number>
+  void
+  MatrixFreeStokesOperators::MeltSchurComplementOperator<dim,degree_p,number>
+  ::local_compute_diagonal (const MatrixFree<dim,number>                     &data,
+                            dealii::LinearAlgebra::distributed::Vector<number>  &dst,
+                            const unsigned int &,
+                            const std::pair<unsigned int,unsigned int>       &cell_range) const
+  {
+    FEEvaluation<dim,degree_p,degree_p+2,2,number> pressure (data, 0);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        pressure.reinit (cell);
+        AlignedVector<VectorizedArray<number> > diagonal(pressure.dofs_per_cell);
+        for (unsigned int i=0; i<pressure.dofs_per_cell; ++i)
+          {
+            for (unsigned int j=0; j<pressure.dofs_per_cell; ++j)
+              pressure.begin_dof_values()[j] = VectorizedArray<number>();
+            pressure.begin_dof_values()[i] = make_vectorized_array<number> (1.);
+
+            pressure.evaluate (true,true,false);
+            do_quadrature_point_operations (pressure, cell);
+            pressure.integrate (true,true);
+
+            diagonal[i] = pressure.begin_dof_values()[i];
+          }
+
+        for (unsigned int i=0; i<pressure.dofs_per_cell; ++i)
+          pressure.begin_dof_values()[i] = diagonal[i];
+        pressure.distribute_local_to_global (dst);
+      }
+  }
+
   /**
    * Velocity block operator
    */
   template <int dim, int degree_v, typename number>
   MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>::ABlockOperator ()
     :
-    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >()
+    MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >(),
+    free_surface_stabilization(nullptr)
   {}
 
   template <int dim, int degree_v, typename number>
@@ -961,6 +1507,8 @@ namespace aspect
   MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>::clear ()
   {
     viscosity = nullptr;
+    free_surface_stabilization = nullptr;
+    free_surface_boundary_indicators.clear();
     MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::clear();
   }
 
@@ -974,6 +1522,16 @@ namespace aspect
     this->is_compressible = is_compressible;
   }
 
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>::
+  set_free_surface_stabilization (const Table<2, Tensor<1,dim,VectorizedArray<number>>> &stabilization_table,
+                                  const std::set<types::boundary_id> &free_surface_boundary_indicators)
+  {
+    free_surface_stabilization = &stabilization_table;
+    this->free_surface_boundary_indicators = free_surface_boundary_indicators;
+  }
+
   template <int dim, int degree_v, typename number>
   void
   MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>
@@ -1017,14 +1575,68 @@ namespace aspect
       }
   }
 
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>
+  ::local_apply_face (const dealii::MatrixFree<dim, number> &,
+                      dealii::LinearAlgebra::distributed::Vector<number> &,
+                      const dealii::LinearAlgebra::distributed::Vector<number> &,
+                      const std::pair<unsigned int, unsigned int> &) const
+  {}
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>
+  ::local_apply_boundary_face (const dealii::MatrixFree<dim, number>                 &data,
+                               dealii::LinearAlgebra::distributed::Vector<number>       &dst,
+                               const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                               const std::pair<unsigned int, unsigned int>           &face_range) const
+  {
+    FEFaceEvaluation<dim,degree_v,degree_v+1,dim,number> velocity_boundary (data, true, 0);
+    const unsigned int n_inner_faces = data.n_inner_face_batches();
+
+    for (unsigned int face=face_range.first; face<face_range.second; ++face)
+      {
+        if (free_surface_boundary_indicators.find(data.get_boundary_id(face))
+            == free_surface_boundary_indicators.end())
+          continue;
+
+        velocity_boundary.reinit (face);
+        velocity_boundary.read_dof_values (src);
+        velocity_boundary.evaluate (true,false);
+
+        for (unsigned int q=0; q<velocity_boundary.n_q_points; ++q)
+          {
+            // Symmetric part of the stabilization term
+            // -(theta dt rho g . v)(u . n):
+            const Tensor<1,dim,VectorizedArray<number>> u = velocity_boundary.get_value(q);
+            const Tensor<1,dim,VectorizedArray<number>> normal = velocity_boundary.get_normal_vector(q);
+            const Tensor<1,dim,VectorizedArray<number>> &stabilization = (*free_surface_stabilization)(face-n_inner_faces, q);
+
+            velocity_boundary.submit_value(make_vectorized_array<number>(-0.5)
+                                           * ((u * normal) * stabilization + (u * stabilization) * normal), q);
+          }
+
+        velocity_boundary.integrate (true,false);
+        velocity_boundary.distribute_local_to_global (dst);
+      }
+  }
+
   template <int dim, int degree_v, typename number>
   void
   MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>
   ::apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
                const dealii::LinearAlgebra::distributed::Vector<number> &src) const
   {
-    MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::
-    data->cell_loop(&ABlockOperator::local_apply, this, dst, src);
+    if (free_surface_stabilization != nullptr)
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::
+      data->loop(&ABlockOperator::local_apply,
+                 &ABlockOperator::local_apply_face,
+                 &ABlockOperator::local_apply_boundary_face,
+                 this, dst, src);
+    else
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::
+      data->cell_loop(&ABlockOperator::local_apply, this, dst, src);
   }
 
   template <int dim, int degree_v, typename number>
@@ -1038,8 +1650,14 @@ namespace aspect
       this->inverse_diagonal_entries->get_vector();
     this->data->initialize_dof_vector(inverse_diagonal);
     unsigned int dummy = 0;
-    this->data->cell_loop (&ABlockOperator::local_compute_diagonal, this,
-                           inverse_diagonal, dummy);
+    if (free_surface_stabilization != nullptr)
+      this->data->loop (&ABlockOperator::local_compute_diagonal,
+                        &ABlockOperator::local_compute_diagonal_face,
+                        &ABlockOperator::local_compute_diagonal_boundary_face,
+                        this, inverse_diagonal, dummy);
+    else
+      this->data->cell_loop (&ABlockOperator::local_compute_diagonal, this,
+                             inverse_diagonal, dummy);
 
     this->set_constrained_entries_to_one(inverse_diagonal);
 
@@ -1110,6 +1728,61 @@ namespace aspect
       }
   }
 
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>
+  ::local_compute_diagonal_face (const MatrixFree<dim,number> &,
+                                 dealii::LinearAlgebra::distributed::Vector<number> &,
+                                 const unsigned int &,
+                                 const std::pair<unsigned int,unsigned int> &) const
+  {}
+
+  template <int dim, int degree_v, typename number>
+  void
+  MatrixFreeStokesOperators::ABlockOperator<dim,degree_v,number>
+  ::local_compute_diagonal_boundary_face (const MatrixFree<dim,number>                     &data,
+                                          dealii::LinearAlgebra::distributed::Vector<number>  &dst,
+                                          const unsigned int &,
+                                          const std::pair<unsigned int,unsigned int>       &face_range) const
+  {
+    FEFaceEvaluation<dim,degree_v,degree_v+1,dim,number> velocity_boundary (data, true, 0);
+    const unsigned int n_inner_faces = data.n_inner_face_batches();
+
+    for (unsigned int face=face_range.first; face<face_range.second; ++face)
+      {
+        if (free_surface_boundary_indicators.find(data.get_boundary_id(face))
+            == free_surface_boundary_indicators.end())
+          continue;
+
+        velocity_boundary.reinit (face);
+        AlignedVector<VectorizedArray<number> > diagonal(velocity_boundary.dofs_per_cell);
+        for (unsigned int i=0; i<velocity_boundary.dofs_per_cell; ++i)
+          {
+            for (unsigned int j=0; j<velocity_boundary.dofs_per_cell; ++j)
+              velocity_boundary.begin_dof_values()[j] = VectorizedArray<number>();
+            velocity_boundary.begin_dof_values()[i] = make_vectorized_array<number> (1.);
+
+            velocity_boundary.evaluate (true,false);
+            for (unsigned int q=0; q<velocity_boundary.n_q_points; ++q)
+              {
+                const Tensor<1,dim,VectorizedArray<number>> u = velocity_boundary.get_value(q);
+                const Tensor<1,dim,VectorizedArray<number>> normal = velocity_boundary.get_normal_vector(q);
+                const Tensor<1,dim,VectorizedArray<number>> &stabilization = (*free_surface_stabilization)(face-n_inner_faces, q);
+
+                velocity_boundary.submit_value(make_vectorized_array<number>(-0.5)
+                                               * ((u * normal) * stabilization + (u * stabilization) * normal), q);
+              }
+            velocity_boundary.integrate (true,false);
+
+            diagonal[i] = velocity_boundary.begin_dof_values()[i];
+          }
+
+        for (unsigned int i=0; i<velocity_boundary.dofs_per_cell; ++i)
+          velocity_boundary.begin_dof_values()[i] = diagonal[i];
+        velocity_boundary.distribute_local_to_global (dst);
+      }
+  }
+
 
 
   template <int dim, int degree_v, typename number>
@@ -1142,19 +1815,45 @@ namespace aspect
   template <int dim>
   void StokesMatrixFreeHandler<dim>::declare_parameters(ParameterHandler &prm)
   {
-    StokesMatrixFreeHandlerImplementation<dim,2>::declare_parameters(prm);
+    StokesMatrixFreeHandlerImplementation<dim,2,double>::declare_parameters(prm);
   }
 
 
 
-  template <int dim, int velocity_degree>
+  template <int dim, int velocity_degree, typename GMGNumberType>
   void
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::declare_parameters(ParameterHandler &prm)
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::declare_parameters(ParameterHandler &prm)
   {
     prm.enter_subsection ("Solver parameters");
     prm.enter_subsection ("Matrix Free");
     {
-
+      prm.declare_entry ("Use single precision multigrid", "false",
+                         Patterns::Bool(),
+                         "If set to true, the geometric multigrid preconditioner of the "
+                         "matrix-free Stokes solver (level operators, smoothers, and "
+                         "transfer operators) uses single precision floating point "
+                         "numbers, while the outer Krylov solver and the Stokes operator "
+                         "on the active mesh still use double precision. This doubles the "
+                         "number of values processed per vectorized instruction and halves "
+                         "the memory traffic of the multigrid V-cycles, but may increase "
+                         "the number of iterations of the Stokes solver, in particular for "
+                         "large viscosity contrasts. The number of Stokes iterations is "
+                         "reported in the statistics file as usual.");
+
+      prm.declare_entry ("Allow melt transport", "false",
+                         Patterns::Bool(),
+                         "If set to true, the 'block GMG' Stokes solver can be selected in "
+                         "models with melt transport, otherwise such models need to use the "
+                         "'block AMG' Stokes solver. This is an experimental option for "
+                         "testing the matrix-free operators of the Stokes system with melt "
+                         "transport on small models, not a multigrid solver for these "
+                         "models: geometric multigrid is only used for the solid velocity "
+                         "block. There is no multigrid preconditioner for the fluid and "
+                         "compaction pressure block, whose Schur complement approximation is "
+                         "only preconditioned by a Chebyshev iteration around its diagonal "
+                         "on the active mesh. The number of Stokes iterations therefore "
+                         "grows with mesh refinement, and 'block AMG' remains the solver to "
+                         "use for models with melt transport.");
     }
     prm.leave_subsection ();
     prm.leave_subsection ();
@@ -1162,13 +1861,13 @@ namespace aspect
 
 
 
-  template <int dim, int velocity_degree>
-  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::parse_parameters(ParameterHandler &prm)
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::parse_parameters(ParameterHandler &prm)
   {
     prm.enter_subsection ("Solver parameters");
     prm.enter_subsection ("Matrix Free");
     {
-
+      allow_melt_transport = prm.get_bool ("Allow melt transport");
     }
     prm.leave_subsection ();
     prm.leave_subsection ();
@@ -1176,17 +1875,27 @@ namespace aspect
 
 
 
-  template <int dim, int velocity_degree>
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::StokesMatrixFreeHandlerImplementation (Simulator<dim> &simulator,
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::StokesMatrixFreeHandlerImplementation (Simulator<dim> &simulator,
       ParameterHandler &prm)
     : sim(simulator),
+      allow_melt_transport(false),
 
       dof_handler_v(simulator.triangulation),
       dof_handler_p(simulator.triangulation),
       dof_handler_projection(simulator.triangulation),
 
       fe_v (FE_Q<dim>(sim.parameters.stokes_velocity_degree), dim),
-      fe_p (FE_Q<dim>(sim.parameters.stokes_velocity_degree-1),1),
+      // Use the same pressure element as the Simulator, i.e. either FE_Q or
+      // FE_DGP if a locally conservative discretization is requested. With
+      // melt transport, the pressure block consists of the fluid and the
+      // compaction pressure, which share the same element:
+      fe_p (sim.finite_element.base_element(sim.parameters.include_melt_transport
+                                            ?
+                                            sim.introspection.variable("fluid pressure").base_index
+                                            :
+                                            sim.introspection.base_elements.pressure),
+            sim.parameters.include_melt_transport ? 2 : 1),
 
       // The finite element used to describe the viscosity on the active level
       // and to project the viscosity to GMG levels needs to be DGQ1 if we are
@@ -1204,24 +1913,48 @@ namespace aspect
     parse_parameters(prm);
     CitationInfo::add("mf");
 
-    // This requires: porting the additional stabilization terms and using a
-    // different mapping in the MatrixFree operators:
-    AssertThrow(!sim.parameters.mesh_deformation_enabled, ExcNotImplemented());
-    // Sorry, not any time soon:
-    AssertThrow(!sim.parameters.include_melt_transport, ExcNotImplemented());
-    // Not very difficult to do, but will require a different mass matrix
-    // operator:
-    AssertThrow(!sim.parameters.use_locally_conservative_discretization, ExcNotImplemented());
-
+    // Mesh deformation requires a mapping on each multigrid level, which
+    // needs MappingQEulerian support for level vectors:
+#if !DEAL_II_VERSION_GTE(9,2,0)
+    AssertThrow(!sim.parameters.mesh_deformation_enabled,
+                ExcMessage("Mesh deformation with the matrix-free Stokes solver requires "
+                           "a deal.II version newer than 9.1"));
+#endif
+    // With melt transport, the free surface stabilization and the
+    // discontinuous compaction pressure are not implemented:
+    if (sim.parameters.include_melt_transport)
+      {
+        AssertThrow(allow_melt_transport,
+                    ExcMessage("The matrix-free Stokes solver only has a geometric multigrid "
+                               "preconditioner for the velocity block in models with melt "
+                               "transport. Set 'Allow melt transport' in the subsection "
+                               "'Solver parameters/Matrix Free' to use it anyway, or use "
+                               "the 'block AMG' Stokes solver."));
+        AssertThrow(!sim.parameters.mesh_deformation_enabled,
+                    ExcMessage("The matrix-free Stokes solver does not support "
+                               "mesh deformation in models with melt transport."));
+        AssertThrow(!sim.melt_handler->melt_parameters.use_discontinuous_p_c,
+                    ExcMessage("The matrix-free Stokes solver requires a continuous "
+                               "compaction pressure in models with melt transport."));
+      }
 
     // sanity check:
     Assert(sim.introspection.variable("velocity").block_index==0, ExcNotImplemented());
-    Assert(sim.introspection.variable("pressure").block_index==1, ExcNotImplemented());
-
-    // This is not terribly complicated, but we need to check that constraints
-    // are set correctly, that the preconditioner converges, and requires
-    // testing.
-    AssertThrow(sim.geometry_model->get_periodic_boundary_pairs().size()==0, ExcNotImplemented());
+    if (sim.parameters.include_melt_transport)
+      {
+        Assert(sim.introspection.variable("fluid pressure").block_index==1, ExcNotImplemented());
+        Assert(sim.introspection.variable("compaction pressure").block_index==1, ExcNotImplemented());
+      }
+    else
+      Assert(sim.introspection.variable("pressure").block_index==1, ExcNotImplemented());
+
+    // Periodic boundaries require MGConstrainedDoFs to provide the level
+    // constraints for periodic faces:
+#if !DEAL_II_VERSION_GTE(9,3,0)
+    AssertThrow(sim.geometry_model->get_periodic_boundary_pairs().size()==0,
+                ExcMessage("Periodic boundaries with the matrix-free Stokes solver require "
+                           "a deal.II version newer than 9.2"));
+#endif
 
     // We currently only support averaging that gives a constant value:
     using avg = MaterialModel::MaterialAveraging::AveragingOperation;
@@ -1233,12 +1966,6 @@ namespace aspect
                            "is enabled. If no averaging is desired, consider using ``project to Q1 only "
                            "viscosity''."));
 
-    // Currently cannot solve compressible flow with implicit reference density
-    if (sim.material_model->is_compressible() == true)
-      AssertThrow(sim.parameters.formulation_mass_conservation !=
-                  Parameters<dim>::Formulation::MassConservation::implicit_reference_density_profile,
-                  ExcNotImplemented());
-
     {
       const unsigned int n_vect_doubles =
 #if DEAL_II_VERSION_GTE(9,2,0)
@@ -1248,17 +1975,186 @@ namespace aspect
 #endif
       const unsigned int n_vect_bits = 8 * sizeof(double) * n_vect_doubles;
 
-      sim.pcout << "Vectorization over " << n_vect_doubles
-                << " doubles = " << n_vect_bits << " bits ("
-                << dealii::Utilities::System::get_current_vectorization_level()
-                << "), VECTORIZATION_LEVEL=" << DEAL_II_COMPILER_VECTORIZATION_LEVEL
-                << std::endl;
-    }
+      sim.pcout << "Vectorization over " << n_vect_doubles
+                << " doubles = " << n_vect_bits << " bits ("
+                << dealii::Utilities::System::get_current_vectorization_level()
+                << "), VECTORIZATION_LEVEL=" << DEAL_II_COMPILER_VECTORIZATION_LEVEL
+                << std::endl;
+    }
+  }
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::
+  make_periodicity_constraints (const DoFHandler<dim> &dof_handler,
+                                ConstraintMatrix &constraints) const
+  {
+    using periodic_boundary_set
+      = std::set< std::pair< std::pair< types::boundary_id, types::boundary_id>, unsigned int> >;
+    const periodic_boundary_set pbs = sim.geometry_model->get_periodic_boundary_pairs();
+
+    for (const auto &p : pbs)
+      DoFTools::make_periodicity_constraints(dof_handler,
+                                             p.first.first,  // first boundary id
+                                             p.first.second, // second boundary id
+                                             p.second,       // cartesian direction for translational symmetry
+                                             constraints);
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  const Mapping<dim> &
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_level_mapping (const unsigned int level) const
+  {
+    if (sim.parameters.mesh_deformation_enabled)
+      return sim.mesh_deformation->get_level_mapping(level);
+    else
+      return *sim.mapping;
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  bool
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::apply_free_surface_stabilization () const
+  {
+    return sim.parameters.mesh_deformation_enabled
+           && !sim.mesh_deformation->get_free_surface_boundary_indicators().empty()
+           && sim.mesh_deformation->template has_matching_postprocessor<MeshDeformation::FreeSurface<dim> >();
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  bool
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::use_Schur_complement_GMG () const
+  {
+    // MGTransferMatrixFree does not support the discontinuous FE_DGP
+    // pressure, and we do not have level operators for the two pressures
+    // of the melt system:
+    return !sim.parameters.use_locally_conservative_discretization
+           && !sim.parameters.include_melt_transport;
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  template <typename number>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::
+  fill_free_surface_stabilization_table (const MatrixFree<dim,number> &matrix_free,
+                                         const dealii::LinearAlgebra::distributed::Vector<double> &density_vector,
+                                         const unsigned int level,
+                                         Table<2, Tensor<1,dim,VectorizedArray<number>>> &stabilization_table) const
+  {
+    const double theta = sim.mesh_deformation->template get_matching_postprocessor<MeshDeformation::FreeSurface<dim> >()
+                         .get_stabilization_theta();
+
+    FEFaceEvaluation<dim,velocity_degree,velocity_degree+1,dim,number> velocity_boundary (matrix_free, true, 0);
+
+    const unsigned int n_inner_faces = matrix_free.n_inner_face_batches();
+    const unsigned int n_boundary_faces = matrix_free.n_boundary_face_batches();
+    const unsigned int n_lanes =
+#if DEAL_II_VERSION_GTE(9,2,0)
+      VectorizedArray<number>::size();
+#else
+      VectorizedArray<number>::n_array_elements;
+#endif
+
+    stabilization_table.reinit(TableIndices<2>(n_boundary_faces, velocity_boundary.n_q_points));
+
+    // On the active mesh, the density is evaluated at the quadrature points
+    // of the face from the current solution, as in the matrix-based
+    // Assemblers::ApplyStabilization.
+    const QGauss<dim-1> face_quadrature (velocity_degree+1);
+    FEFaceValues<dim> fe_face_values (*sim.mapping,
+                                      sim.finite_element,
+                                      face_quadrature,
+                                      update_values |
+                                      update_gradients |
+                                      update_quadrature_points);
+    MaterialModel::MaterialModelInputs<dim> face_in(face_quadrature.size(), sim.introspection.n_compositional_fields);
+    MaterialModel::MaterialModelOutputs<dim> face_out(face_quadrature.size(), sim.introspection.n_compositional_fields);
+
+    std::vector<double> densities(velocity_boundary.n_q_points);
+    std::vector<Point<dim> > q_points(velocity_boundary.n_q_points);
+    std::vector<types::global_dof_index> local_dof_indices(fe_projection.dofs_per_cell);
+    for (unsigned int face=n_inner_faces; face<n_inner_faces+n_boundary_faces; ++face)
+      {
+        velocity_boundary.reinit(face);
+        const auto &face_info = matrix_free.get_face_info(face);
+
+        for (unsigned int v=0; v<matrix_free.n_active_entries_per_face_batch(face); ++v)
+          {
+            for (unsigned int q=0; q<velocity_boundary.n_q_points; ++q)
+              {
+                const Point<dim,VectorizedArray<number>> q_point_batch = velocity_boundary.quadrature_point(q);
+                for (unsigned int d=0; d<dim; ++d)
+                  q_points[q][d] = q_point_batch[d][v];
+              }
+
+            // Find the cell adjacent to this face
+            const unsigned int cell_index = face_info.cells_interior[v];
+            const typename DoFHandler<dim>::cell_iterator FEQ_cell =
+              matrix_free.get_cell_iterator(cell_index / n_lanes, cell_index % n_lanes);
+
+            if (level == numbers::invalid_unsigned_int)
+              {
+                const typename DoFHandler<dim>::active_cell_iterator cell(&(sim.triangulation),
+                                                                          FEQ_cell->level(),
+                                                                          FEQ_cell->index(),
+                                                                          &(sim.dof_handler));
+                fe_face_values.reinit(cell, face_info.interior_face_no);
+                sim.compute_material_model_input_values(sim.solution,
+                                                        fe_face_values,
+                                                        cell,
+                                                        false,
+                                                        face_in);
+                sim.evaluate_material_model(face_in, face_out);
+
+                // FEFaceEvaluation may number the quadrature points of the
+                // face differently than FEFaceValues, so match them by their
+                // location.
+                for (unsigned int q=0; q<velocity_boundary.n_q_points; ++q)
+                  {
+                    unsigned int closest_point = 0;
+                    for (unsigned int k=1; k<face_quadrature.size(); ++k)
+                      if (q_points[q].distance_square(fe_face_values.quadrature_point(k))
+                          < q_points[q].distance_square(fe_face_values.quadrature_point(closest_point)))
+                        closest_point = k;
+                    densities[q] = face_out.densities[closest_point];
+                  }
+              }
+            else
+              {
+                // The level operators are only used in the preconditioner,
+                // and, like the viscosity, use the cellwise averaged density
+                // interpolated from the active mesh.
+                const typename DoFHandler<dim>::cell_iterator DG_cell(&(sim.triangulation),
+                                                                      FEQ_cell->level(),
+                                                                      FEQ_cell->index(),
+                                                                      &dof_handler_projection);
+                DG_cell->get_mg_dof_indices(local_dof_indices);
+                std::fill(densities.begin(), densities.end(), density_vector(local_dof_indices[0]));
+              }
+
+            for (unsigned int q=0; q<velocity_boundary.n_q_points; ++q)
+              {
+                const Tensor<1,dim> stabilization = theta * sim.time_step * densities[q]
+                                                    * sim.gravity_model->gravity_vector(q_points[q]);
+                for (unsigned int d=0; d<dim; ++d)
+                  stabilization_table(face-n_inner_faces, q)[d][v] = stabilization[d];
+              }
+          }
+      }
   }
 
 
-  template <int dim, int velocity_degree>
-  double StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_workload_imbalance ()
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  double StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_workload_imbalance ()
   {
     unsigned int n_proc = Utilities::MPI::n_mpi_processes(sim.triangulation.get_communicator());
     unsigned int n_global_levels = sim.triangulation.n_global_levels();
@@ -1291,12 +2187,26 @@ namespace aspect
   }
 
 
-  template <int dim, int velocity_degree>
-  void StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::evaluate_material_model ()
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::evaluate_material_model ()
   {
+    // The melt cells, and with them the constraints on the compaction
+    // pressure, may have changed since the operators were set up:
+    if (sim.parameters.include_melt_transport && update_melt_constraints())
+      setup_operators();
+
     dealii::LinearAlgebra::distributed::Vector<double> active_viscosity_vector(dof_handler_projection.locally_owned_dofs(),
                                                                                sim.triangulation.get_communicator());
 
+    // The free surface stabilization on the multigrid levels needs the
+    // cellwise averaged density, which is interpolated from the active mesh.
+    const bool use_free_surface_stabilization = apply_free_surface_stabilization();
+    dealii::LinearAlgebra::distributed::Vector<double> active_density_vector;
+    if (use_free_surface_stabilization)
+      active_density_vector.reinit(dof_handler_projection.locally_owned_dofs(),
+                                   sim.triangulation.get_communicator());
+    std::vector<types::global_dof_index> projection_dof_indices(fe_projection.dofs_per_cell);
+
     const QGauss<dim> quadrature_formula (sim.parameters.stokes_velocity_degree+1);
 
     double min_el = std::numeric_limits<double>::max();
@@ -1333,7 +2243,7 @@ namespace aspect
 
         // Query the material model for the active level viscosities
         sim.material_model->fill_additional_material_model_inputs(in, sim.current_linearization_point, fe_values, sim.introspection);
-        sim.material_model->evaluate(in, out);
+        sim.evaluate_material_model(in, out);
 
         // If using a cellwise average for viscosity, average the values here.
         // When the projection is computed, this will set the viscosity exactly
@@ -1353,11 +2263,25 @@ namespace aspect
 
             values[i] = out.viscosities[i];
           }
+
+        if (use_free_surface_stabilization)
+          {
+            double mean_density = 0.;
+            for (unsigned int q=0; q<out.densities.size(); ++q)
+              mean_density += out.densities[q];
+            mean_density /= out.densities.size();
+
+            cell->get_dof_indices(projection_dof_indices);
+            for (const auto index : projection_dof_indices)
+              active_density_vector(index) = mean_density;
+          }
         return;
       },
       active_viscosity_vector);
 
       active_viscosity_vector.compress(VectorOperation::insert);
+      if (use_free_surface_stabilization)
+        active_density_vector.compress(VectorOperation::insert);
     }
 
     FEValues<dim> fe_values_projection (*(sim.mapping),
@@ -1416,18 +2340,76 @@ namespace aspect
         }
     }
 
-    const bool is_compressible = sim.material_model->is_compressible();
+    // The melt system always contains the compressible term of the A block:
+    const bool is_compressible = sim.material_model->is_compressible()
+                                 || sim.parameters.include_melt_transport;
 
     stokes_matrix.fill_cell_data(active_viscosity_table,
                                  sim.pressure_scaling,
                                  is_compressible);
 
+    if (sim.assemble_newton_stokes_system
+        && sim.newton_handler->parameters.newton_derivative_scaling_factor != 0)
+      {
+        fill_newton_derivative_tables();
+        stokes_matrix.set_newton_derivatives(active_newton_viscosity_derivative_table,
+                                             active_newton_strain_rate_table,
+                                             active_newton_pressure_derivative_table,
+                                             (sim.newton_handler->parameters.velocity_block_stabilization
+                                              & Newton::Parameters::Stabilization::symmetric)
+                                             != Newton::Parameters::Stabilization::none);
+      }
+
+    if (sim.parameters.formulation_mass_conservation ==
+        Parameters<dim>::Formulation::MassConservation::implicit_reference_density_profile)
+      {
+        fill_reference_density_gradient_table();
+        stokes_matrix.set_implicit_reference_density_gradient(active_reference_density_gradient_table);
+      }
+
     if (sim.parameters.n_expensive_stokes_solver_steps > 0)
+      A_block_matrix.fill_cell_data(active_viscosity_table,
+                                    is_compressible);
+
+    // The Schur complement approximation on the active level is needed for
+    // the expensive solver and, without GMG, to compute the diagonal used
+    // as preconditioner:
+    if (!sim.parameters.include_melt_transport
+        && (sim.parameters.n_expensive_stokes_solver_steps > 0 || !use_Schur_complement_GMG()))
+      Schur_complement_block_matrix.fill_cell_data(active_viscosity_table,
+                                                   sim.pressure_scaling);
+
+    if (sim.parameters.include_melt_transport)
+      {
+        fill_melt_tables();
+        melt_stokes_matrix.fill_cell_data(active_viscosity_table,
+                                          active_melt_darcy_coefficient_table,
+                                          active_melt_one_over_compaction_viscosity_table,
+                                          active_melt_p_c_scale_table,
+                                          active_melt_fluid_density_gradient_table,
+                                          sim.pressure_scaling);
+        melt_Schur_complement_matrix.fill_cell_data(active_viscosity_table,
+                                                    active_melt_darcy_coefficient_table,
+                                                    active_melt_one_over_compaction_viscosity_table,
+                                                    active_melt_p_c_scale_table,
+                                                    sim.pressure_scaling);
+      }
+
+    if (use_free_surface_stabilization)
       {
-        A_block_matrix.fill_cell_data(active_viscosity_table,
-                                      is_compressible);
-        Schur_complement_block_matrix.fill_cell_data(active_viscosity_table,
-                                                     sim.pressure_scaling);
+        const std::set<types::boundary_id> &free_surface_boundary_indicators
+          = sim.mesh_deformation->get_free_surface_boundary_indicators();
+
+        fill_free_surface_stabilization_table(*stokes_matrix.get_matrix_free(),
+                                              active_density_vector,
+                                              numbers::invalid_unsigned_int,
+                                              active_free_surface_stabilization_table);
+
+        stokes_matrix.set_free_surface_stabilization(active_free_surface_stabilization_table,
+                                                     free_surface_boundary_indicators);
+        if (sim.parameters.n_expensive_stokes_solver_steps > 0)
+          A_block_matrix.set_free_surface_stabilization(active_free_surface_stabilization_table,
+                                                        free_surface_boundary_indicators);
       }
 
     // Project active viscosity vector to multilevel vectors
@@ -1441,6 +2423,16 @@ namespace aspect
                                level_viscosity_vector,
                                active_viscosity_vector);
 
+    MGLevelObject<dealii::LinearAlgebra::distributed::Vector<double> > level_density_vector;
+    if (use_free_surface_stabilization)
+      {
+        level_density_vector.resize(0,n_levels-1);
+        transfer.interpolate_to_mg(dof_handler_projection,
+                                   level_density_vector,
+                                   active_density_vector);
+        level_free_surface_stabilization_tables.resize(0,n_levels-1);
+      }
+
     level_viscosity_tables.resize(0,n_levels-1);
 
     for (unsigned int level=0; level<n_levels; ++level)
@@ -1493,15 +2485,306 @@ namespace aspect
 
         mg_matrices_A_block[level].fill_cell_data (level_viscosity_tables[level],
                                                    is_compressible);
-        mg_matrices_Schur_complement[level].fill_cell_data (level_viscosity_tables[level],
-                                                            sim.pressure_scaling);
+        if (use_Schur_complement_GMG())
+          mg_matrices_Schur_complement[level].fill_cell_data (level_viscosity_tables[level],
+                                                              sim.pressure_scaling);
+
+        if (use_free_surface_stabilization)
+          {
+            fill_free_surface_stabilization_table(*mg_matrices_A_block[level].get_matrix_free(),
+                                                  level_density_vector[level],
+                                                  level,
+                                                  level_free_surface_stabilization_tables[level]);
+            mg_matrices_A_block[level].set_free_surface_stabilization(level_free_surface_stabilization_tables[level],
+                                                                      sim.mesh_deformation->get_free_surface_boundary_indicators());
+          }
+      }
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::fill_newton_derivative_tables ()
+  {
+    AssertThrow(!sim.material_model->is_compressible(),
+                ExcMessage("The Newton solver with the matrix-free Stokes solver is currently "
+                           "only implemented for incompressible models."));
+
+    const Newton::Parameters &newton_parameters = sim.newton_handler->parameters;
+    const double derivative_scaling_factor = newton_parameters.newton_derivative_scaling_factor;
+    const bool use_spd_factor = (newton_parameters.velocity_block_stabilization
+                                 & Newton::Parameters::Stabilization::PD)
+                                != Newton::Parameters::Stabilization::none;
+
+    const MatrixFree<dim,double> &matrix_free = *stokes_matrix.get_matrix_free();
+    const QGauss<dim> quadrature_formula (sim.parameters.stokes_velocity_degree+1);
+    const unsigned int n_cells = matrix_free.n_macro_cells();
+    const unsigned int n_q_points = quadrature_formula.size();
+
+    // The quadrature points of FEValues and FEEvaluation are both ordered
+    // lexicographically, so we can evaluate the material model with
+    // FEValues and store the results by FEEvaluation quadrature point.
+    FEValues<dim> fe_values (*sim.mapping,
+                             sim.finite_element,
+                             quadrature_formula,
+                             update_values   |
+                             update_gradients |
+                             update_quadrature_points |
+                             update_JxW_values);
+
+    MaterialModel::MaterialModelInputs<dim> in(n_q_points, sim.introspection.n_compositional_fields);
+    MaterialModel::MaterialModelOutputs<dim> out(n_q_points, sim.introspection.n_compositional_fields);
+    NewtonHandler<dim>::create_material_model_outputs(out);
+
+    active_newton_viscosity_derivative_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    active_newton_strain_rate_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    active_newton_pressure_derivative_table.reinit(TableIndices<2>(n_cells, n_q_points));
+
+    for (unsigned int cell=0; cell<n_cells; ++cell)
+      for (unsigned int i=0; i<matrix_free.n_components_filled(cell); ++i)
+        {
+          const typename DoFHandler<dim>::active_cell_iterator matrix_free_cell =
+            matrix_free.get_cell_iterator(cell,i);
+          const typename DoFHandler<dim>::active_cell_iterator FEQ_cell(&sim.triangulation,
+                                                                        matrix_free_cell->level(),
+                                                                        matrix_free_cell->index(),
+                                                                        &(sim.dof_handler));
+
+          fe_values.reinit (FEQ_cell);
+          in.reinit(fe_values, FEQ_cell, sim.introspection, sim.current_linearization_point);
+
+          sim.material_model->fill_additional_material_model_inputs(in, sim.current_linearization_point, fe_values, sim.introspection);
+          sim.evaluate_material_model(in, out);
+
+          const MaterialModel::MaterialModelDerivatives<dim> *derivatives
+            = out.template get_additional_output<MaterialModel::MaterialModelDerivatives<dim> >();
+          AssertThrow(derivatives != nullptr,
+                      ExcMessage ("Error: The Newton method requires the material to "
+                                  "compute derivatives."));
+
+          for (unsigned int q=0; q<n_q_points; ++q)
+            {
+              const SymmetricTensor<2,dim> &strain_rate = in.strain_rate[q];
+              const SymmetricTensor<2,dim> &viscosity_derivative_wrt_strain_rate
+                = derivatives->viscosity_derivative_wrt_strain_rate[q];
+
+              const double alpha = use_spd_factor
+                                   ?
+                                   Utilities::compute_spd_factor<dim>(out.viscosities[q], strain_rate,
+                                                                      viscosity_derivative_wrt_strain_rate,
+                                                                      newton_parameters.SPD_safety_factor)
+                                   :
+                                   1.0;
+
+              for (unsigned int d=0; d<dim; ++d)
+                for (unsigned int e=d; e<dim; ++e)
+                  {
+                    active_newton_viscosity_derivative_table(cell, q)[d][e][i]
+                      = derivative_scaling_factor * alpha * viscosity_derivative_wrt_strain_rate[d][e];
+                    active_newton_strain_rate_table(cell, q)[d][e][i] = strain_rate[d][e];
+                  }
+
+              active_newton_pressure_derivative_table(cell, q)[i]
+                = derivative_scaling_factor * 2.0 * derivatives->viscosity_derivative_wrt_pressure[q];
+            }
+        }
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::fill_reference_density_gradient_table ()
+  {
+    const MatrixFree<dim,double> &matrix_free = *stokes_matrix.get_matrix_free();
+    const QGauss<dim> quadrature_formula (sim.parameters.stokes_velocity_degree+1);
+    const unsigned int n_cells = matrix_free.n_macro_cells();
+    const unsigned int n_q_points = quadrature_formula.size();
+
+    // As in fill_newton_derivative_tables(), the FEValues quadrature points
+    // are ordered in the same way as the ones of FEEvaluation.
+    FEValues<dim> fe_values (*sim.mapping,
+                             fe_v,
+                             quadrature_formula,
+                             update_quadrature_points);
+
+    active_reference_density_gradient_table.reinit(TableIndices<2>(n_cells, n_q_points));
+
+    for (unsigned int cell=0; cell<n_cells; ++cell)
+      for (unsigned int i=0; i<matrix_free.n_components_filled(cell); ++i)
+        {
+          fe_values.reinit (matrix_free.get_cell_iterator(cell,i));
+
+          for (unsigned int q=0; q<n_q_points; ++q)
+            {
+              const Point<dim> &position = fe_values.quadrature_point(q);
+              const Tensor<1,dim> gravity = sim.gravity_model->gravity_vector(position);
+              const Tensor<1,dim> drho_dz = sim.adiabatic_conditions->density_derivative(position)
+                                            * gravity / gravity.norm();
+              const double one_over_rho = 1.0/sim.adiabatic_conditions->density(position);
+
+              for (unsigned int d=0; d<dim; ++d)
+                active_reference_density_gradient_table(cell, q)[d][i] = one_over_rho * drho_dz[d];
+            }
+        }
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::fill_melt_tables ()
+  {
+    const MatrixFree<dim,double> &matrix_free = *melt_stokes_matrix.get_matrix_free();
+    const QGauss<dim> quadrature_formula (sim.parameters.stokes_velocity_degree+1);
+    const unsigned int n_cells = matrix_free.n_macro_cells();
+    const unsigned int n_q_points = quadrature_formula.size();
+    const bool is_compressible = sim.material_model->is_compressible();
+
+    // As in fill_newton_derivative_tables(), the FEValues quadrature points
+    // are ordered in the same way as the ones of FEEvaluation.
+    FEValues<dim> fe_values (*sim.mapping,
+                             sim.finite_element,
+                             quadrature_formula,
+                             update_values   |
+                             update_gradients |
+                             update_quadrature_points |
+                             update_JxW_values);
+
+    MaterialModel::MaterialModelInputs<dim> in(n_q_points, sim.introspection.n_compositional_fields);
+    MaterialModel::MaterialModelOutputs<dim> out(n_q_points, sim.introspection.n_compositional_fields);
+    MeltHandler<dim>::create_material_model_outputs(out);
+
+    const MaterialModel::MeltInterface<dim> &melt_material_model
+      = Plugins::get_plugin_as_type<const MaterialModel::MeltInterface<dim>>(*sim.material_model);
+
+    active_melt_darcy_coefficient_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    active_melt_one_over_compaction_viscosity_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    active_melt_p_c_scale_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    if (is_compressible)
+      active_melt_fluid_density_gradient_table.reinit(TableIndices<2>(n_cells, n_q_points));
+    else
+      active_melt_fluid_density_gradient_table.reinit(TableIndices<2>(0, 0));
+
+    for (unsigned int cell=0; cell<n_cells; ++cell)
+      {
+        const unsigned int n_components_filled = matrix_free.n_components_filled(cell);
+
+        // Make sure the coefficients of unused vectorization lanes are zero:
+        for (unsigned int q=0; q<n_q_points; ++q)
+          {
+            active_melt_darcy_coefficient_table(cell, q) = 0.;
+            active_melt_one_over_compaction_viscosity_table(cell, q) = 0.;
+            active_melt_p_c_scale_table(cell, q) = 0.;
+            if (is_compressible)
+              active_melt_fluid_density_gradient_table(cell, q) = Tensor<1,dim,VectorizedArray<double>>();
+          }
+
+        for (unsigned int i=0; i<n_components_filled; ++i)
+          {
+            const typename DoFHandler<dim>::active_cell_iterator matrix_free_cell =
+              matrix_free.get_cell_iterator(cell,i);
+            const typename DoFHandler<dim>::active_cell_iterator FEQ_cell(&sim.triangulation,
+                                                                          matrix_free_cell->level(),
+                                                                          matrix_free_cell->index(),
+                                                                          &(sim.dof_handler));
+
+            fe_values.reinit (FEQ_cell);
+            in.reinit(fe_values, FEQ_cell, sim.introspection, sim.current_linearization_point);
+
+            sim.material_model->fill_additional_material_model_inputs(in, sim.current_linearization_point, fe_values, sim.introspection);
+            sim.evaluate_material_model(in, out);
+
+            MaterialModel::MaterialAveraging::average (sim.parameters.material_averaging,
+                                                       FEQ_cell,
+                                                       quadrature_formula,
+                                                       *sim.mapping,
+                                                       out);
+
+            const MaterialModel::MeltOutputs<dim> *melt_outputs
+              = out.template get_additional_output<MaterialModel::MeltOutputs<dim> >();
+            Assert(melt_outputs != nullptr, ExcInternalError());
+
+            // See Assemblers::MeltStokesSystem for the definition of the
+            // coefficients:
+            const double p_c_scale = melt_material_model.p_c_scale(in, out, *sim.melt_handler, true);
+
+            for (unsigned int q=0; q<n_q_points; ++q)
+              {
+                const double K_D = sim.melt_handler->limited_darcy_coefficient(melt_outputs->permeabilities[q] / melt_outputs->fluid_viscosities[q],
+                                                                               p_c_scale > 0);
+
+                active_melt_darcy_coefficient_table(cell, q)[i] = K_D;
+                active_melt_one_over_compaction_viscosity_table(cell, q)[i] = 1.0/melt_outputs->compaction_viscosities[q];
+                active_melt_p_c_scale_table(cell, q)[i] = p_c_scale;
+
+                if (is_compressible)
+                  for (unsigned int d=0; d<dim; ++d)
+                    active_melt_fluid_density_gradient_table(cell, q)[d][i]
+                      = K_D * melt_outputs->fluid_density_gradients[q][d] / melt_outputs->fluid_densities[q];
+              }
+          }
       }
   }
 
 
 
-  template <int dim, int velocity_degree>
-  void StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::correct_stokes_rhs()
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  bool StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::update_melt_constraints ()
+  {
+    IndexSet locally_relevant_dofs;
+    DoFTools::extract_locally_relevant_dofs (dof_handler_p,
+                                             locally_relevant_dofs);
+
+    // As in MeltHandler::add_current_constraints(), first pick all relevant
+    // compaction pressure dofs (the second component of fe_p)...
+    const ComponentMask p_c_mask (std::vector<bool> {false, true});
+    IndexSet new_constrained_p_c_dofs = locally_relevant_dofs
+                                        & Utilities::extract_locally_active_dofs_with_component<dim>(dof_handler_p, p_c_mask);
+
+    // ...then subtract the ones that belong to locally owned melt cells:
+    IndexSet nonzero_p_c_dofs(dof_handler_p.n_dofs());
+    std::vector<types::global_dof_index> local_dof_indices(fe_p.dofs_per_cell);
+    for (const auto &cell : dof_handler_p.active_cell_iterators())
+      if (cell->is_locally_owned())
+        {
+          const typename DoFHandler<dim>::active_cell_iterator FEQ_cell(&sim.triangulation,
+                                                                        cell->level(),
+                                                                        cell->index(),
+                                                                        &(sim.dof_handler));
+          if (!sim.melt_handler->is_melt_cell(FEQ_cell))
+            continue;
+
+          cell->get_dof_indices(local_dof_indices);
+          for (unsigned int i=0; i<fe_p.dofs_per_cell; ++i)
+            if (fe_p.system_to_component_index(i).first == 1)
+              nonzero_p_c_dofs.add_index(local_dof_indices[i]);
+        }
+    new_constrained_p_c_dofs.subtract_set(nonzero_p_c_dofs);
+
+    // The matrix-free operators need to be rebuilt on all processes if the
+    // constraints changed on any of them:
+    const bool locally_unchanged = (constrained_p_c_dofs.size() == new_constrained_p_c_dofs.size()
+                                    && constrained_p_c_dofs == new_constrained_p_c_dofs);
+    const bool constraints_changed
+      = (Utilities::MPI::max(locally_unchanged ? 0 : 1, sim.mpi_communicator) == 1);
+    if (!constraints_changed)
+      return false;
+
+    constrained_p_c_dofs = new_constrained_p_c_dofs;
+
+    constraints_p.clear();
+    constraints_p.reinit(locally_relevant_dofs);
+    make_periodicity_constraints(dof_handler_p, constraints_p);
+    DoFTools::make_hanging_node_constraints (dof_handler_p, constraints_p);
+    constraints_p.add_lines(constrained_p_c_dofs);
+    constraints_p.close();
+
+    return true;
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::correct_stokes_rhs()
   {
     const bool is_compressible = sim.material_model->is_compressible();
 
@@ -1519,53 +2802,104 @@ namespace aspect
     sim.current_constraints.distribute(u0);
     u0.update_ghost_values();
 
-    FEEvaluation<dim,velocity_degree,velocity_degree+1,dim,double>
-    velocity (*stokes_matrix.get_matrix_free(), 0);
-    FEEvaluation<dim,velocity_degree-1,velocity_degree+1,1,double>
-    pressure (*stokes_matrix.get_matrix_free(), 1);
-
-    const bool use_viscosity_at_quadrature_points
-      = (active_viscosity_table.size(1) == velocity.n_q_points);
-
-    for (unsigned int cell=0; cell<stokes_matrix.get_matrix_free()->n_macro_cells(); ++cell)
+    if (sim.parameters.include_melt_transport)
+      {
+        // The melt operator can be applied directly to the constrained
+        // values, see MeltStokesOperator::apply_add_without_constraints():
+        melt_stokes_matrix.apply_add_without_constraints(rhs_correction, u0);
+        rhs_correction *= -1.0;
+      }
+    else
       {
-        VectorizedArray<double> viscosity_x_2 = 2.0*active_viscosity_table(cell, 0);
+        FEEvaluation<dim,velocity_degree,velocity_degree+1,dim,double>
+        velocity (*stokes_matrix.get_matrix_free(), 0);
+        FEEvaluation<dim,velocity_degree-1,velocity_degree+1,1,double>
+        pressure (*stokes_matrix.get_matrix_free(), 1);
 
-        velocity.reinit (cell);
-        velocity.read_dof_values_plain (u0.block(0));
-        velocity.evaluate (false,true,false);
-        pressure.reinit (cell);
-        pressure.read_dof_values_plain (u0.block(1));
-        pressure.evaluate (true,false,false);
+        const bool use_viscosity_at_quadrature_points
+          = (active_viscosity_table.size(1) == velocity.n_q_points);
 
-        for (unsigned int q=0; q<velocity.n_q_points; ++q)
+        const bool apply_reference_density_term
+          = (sim.parameters.formulation_mass_conservation ==
+             Parameters<dim>::Formulation::MassConservation::implicit_reference_density_profile);
+
+        for (unsigned int cell=0; cell<stokes_matrix.get_matrix_free()->n_macro_cells(); ++cell)
           {
-            // Only update the viscosity if a Q1 projection is used.
-            if (use_viscosity_at_quadrature_points)
-              viscosity_x_2 = 2.0*active_viscosity_table(cell, q);
+            VectorizedArray<double> viscosity_x_2 = 2.0*active_viscosity_table(cell, 0);
 
-            SymmetricTensor<2,dim,VectorizedArray<double>> sym_grad_u =
-                                                          velocity.get_symmetric_gradient (q);
-            VectorizedArray<double> pres = pressure.get_value(q);
-            VectorizedArray<double> div = trace(sym_grad_u);
-            pressure.submit_value   (sim.pressure_scaling*div, q);
+            velocity.reinit (cell);
+            velocity.read_dof_values_plain (u0.block(0));
+            velocity.evaluate (apply_reference_density_term,true,false);
+            pressure.reinit (cell);
+            pressure.read_dof_values_plain (u0.block(1));
+            pressure.evaluate (true,false,false);
 
-            sym_grad_u *= viscosity_x_2;
+            for (unsigned int q=0; q<velocity.n_q_points; ++q)
+              {
+                // Only update the viscosity if a Q1 projection is used.
+                if (use_viscosity_at_quadrature_points)
+                  viscosity_x_2 = 2.0*active_viscosity_table(cell, q);
 
-            for (unsigned int d=0; d<dim; ++d)
-              sym_grad_u[d][d] -= sim.pressure_scaling*pres;
+                SymmetricTensor<2,dim,VectorizedArray<double>> sym_grad_u =
+                                                              velocity.get_symmetric_gradient (q);
+                VectorizedArray<double> pres = pressure.get_value(q);
+                VectorizedArray<double> div = trace(sym_grad_u);
+                if (apply_reference_density_term)
+                  pressure.submit_value (sim.pressure_scaling*(div + active_reference_density_gradient_table(cell, q) * velocity.get_value(q)), q);
+                else
+                  pressure.submit_value (sim.pressure_scaling*div, q);
 
-            if (is_compressible)
-              for (unsigned int d=0; d<dim; ++d)
-                sym_grad_u[d][d] -= viscosity_x_2/3.0*div;
+                sym_grad_u *= viscosity_x_2;
+
+                for (unsigned int d=0; d<dim; ++d)
+                  sym_grad_u[d][d] -= sim.pressure_scaling*pres;
+
+                if (is_compressible)
+                  for (unsigned int d=0; d<dim; ++d)
+                    sym_grad_u[d][d] -= viscosity_x_2/3.0*div;
+
+                velocity.submit_symmetric_gradient(-1.0*sym_grad_u, q);
+              }
 
-            velocity.submit_symmetric_gradient(-1.0*sym_grad_u, q);
+            velocity.integrate (false,true);
+            velocity.distribute_local_to_global (rhs_correction.block(0));
+            pressure.integrate (true,false);
+            pressure.distribute_local_to_global (rhs_correction.block(1));
           }
+      }
 
-        velocity.integrate (false,true);
-        velocity.distribute_local_to_global (rhs_correction.block(0));
-        pressure.integrate (true,false);
-        pressure.distribute_local_to_global (rhs_correction.block(1));
+    // Velocity constraints may also touch free surface boundaries, in which
+    // case the stabilization term contributes to the correction as well.
+    if (apply_free_surface_stabilization())
+      {
+        const MatrixFree<dim,double> &matrix_free = *stokes_matrix.get_matrix_free();
+        const std::set<types::boundary_id> &free_surface_boundary_indicators
+          = sim.mesh_deformation->get_free_surface_boundary_indicators();
+
+        FEFaceEvaluation<dim,velocity_degree,velocity_degree+1,dim,double>
+        velocity_boundary (matrix_free, true, 0);
+
+        const unsigned int n_inner_faces = matrix_free.n_inner_face_batches();
+        for (unsigned int face=n_inner_faces; face<n_inner_faces+matrix_free.n_boundary_face_batches(); ++face)
+          {
+            if (free_surface_boundary_indicators.find(matrix_free.get_boundary_id(face))
+                == free_surface_boundary_indicators.end())
+              continue;
+
+            velocity_boundary.reinit (face);
+            velocity_boundary.read_dof_values_plain (u0.block(0));
+            velocity_boundary.evaluate (true,false);
+
+            for (unsigned int q=0; q<velocity_boundary.n_q_points; ++q)
+              {
+                const VectorizedArray<double> u_dot_n
+                  = velocity_boundary.get_value(q) * velocity_boundary.get_normal_vector(q);
+                velocity_boundary.submit_value(u_dot_n * active_free_surface_stabilization_table(face-n_inner_faces, q), q);
+              }
+
+            velocity_boundary.integrate (true,false);
+            velocity_boundary.distribute_local_to_global (rhs_correction.block(0));
+          }
       }
     rhs_correction.compress(VectorOperation::add);
 
@@ -1578,17 +2912,16 @@ namespace aspect
 
 
 
-  template <int dim, int velocity_degree>
-  std::pair<double,double> StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::solve()
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  std::pair<double,double> StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::solve()
   {
-    double initial_nonlinear_residual = numbers::signaling_nan<double>();
-    double final_linear_residual      = numbers::signaling_nan<double>();
-
-    // Below we define all the objects needed to build the GMG preconditioner:
-    using vector_t = dealii::LinearAlgebra::distributed::Vector<double>;
+    // Below we define all the objects needed to build the GMG preconditioner.
+    // The multigrid hierarchy works on vectors of GMGNumberType, which may
+    // be float even though the outer solver uses double:
+    using vector_t = dealii::LinearAlgebra::distributed::Vector<GMGNumberType>;
 
     // ABlock GMG Smoother: Chebyshev, degree 4
-    typedef PreconditionChebyshev<ABlockMatrixType,vector_t> ASmootherType;
+    typedef PreconditionChebyshev<GMGABlockMatrixType,vector_t> ASmootherType;
     mg::SmootherRelaxation<ASmootherType, vector_t>
     mg_smoother_A;
     {
@@ -1614,30 +2947,31 @@ namespace aspect
     }
 
     // Schur complement matrix GMG Smoother: Chebyshev, degree 4
-    typedef PreconditionChebyshev<SchurComplementMatrixType,vector_t> MSmootherType;
+    typedef PreconditionChebyshev<GMGSchurComplementMatrixType,vector_t> MSmootherType;
     mg::SmootherRelaxation<MSmootherType, vector_t>
     mg_smoother_Schur(4);
-    {
-      MGLevelObject<typename MSmootherType::AdditionalData> smoother_data_Schur;
-      smoother_data_Schur.resize(0, sim.triangulation.n_global_levels()-1);
-      for (unsigned int level = 0; level<sim.triangulation.n_global_levels(); ++level)
-        {
-          if (level > 0)
-            {
-              smoother_data_Schur[level].smoothing_range = 15.;
-              smoother_data_Schur[level].degree = 4;
-              smoother_data_Schur[level].eig_cg_n_iterations = 10;
-            }
-          else
-            {
-              smoother_data_Schur[0].smoothing_range = 1e-3;
-              smoother_data_Schur[0].degree = 8;
-              smoother_data_Schur[0].eig_cg_n_iterations = 100;
-            }
-          smoother_data_Schur[level].preconditioner = mg_matrices_Schur_complement[level].get_matrix_diagonal_inverse();
-        }
-      mg_smoother_Schur.initialize(mg_matrices_Schur_complement, smoother_data_Schur);
-    }
+    if (use_Schur_complement_GMG())
+      {
+        MGLevelObject<typename MSmootherType::AdditionalData> smoother_data_Schur;
+        smoother_data_Schur.resize(0, sim.triangulation.n_global_levels()-1);
+        for (unsigned int level = 0; level<sim.triangulation.n_global_levels(); ++level)
+          {
+            if (level > 0)
+              {
+                smoother_data_Schur[level].smoothing_range = 15.;
+                smoother_data_Schur[level].degree = 4;
+                smoother_data_Schur[level].eig_cg_n_iterations = 10;
+              }
+            else
+              {
+                smoother_data_Schur[0].smoothing_range = 1e-3;
+                smoother_data_Schur[0].degree = 8;
+                smoother_data_Schur[0].eig_cg_n_iterations = 100;
+              }
+            smoother_data_Schur[level].preconditioner = mg_matrices_Schur_complement[level].get_matrix_diagonal_inverse();
+          }
+        mg_smoother_Schur.initialize(mg_matrices_Schur_complement, smoother_data_Schur);
+      }
 
 #if DEAL_II_VERSION_GTE(9,2,0)
     // Estimate the eigenvalues for the Chebyshev smoothers. If not running with
@@ -1650,12 +2984,15 @@ namespace aspect
     for (unsigned int level = 0; level<sim.triangulation.n_global_levels(); ++level)
       {
         vector_t temp_velocity;
-        vector_t temp_pressure;
         mg_matrices_A_block[level].initialize_dof_vector(temp_velocity);
-        mg_matrices_Schur_complement[level].initialize_dof_vector(temp_pressure);
-
         mg_smoother_A[level].estimate_eigenvalues(temp_velocity);
-        mg_smoother_Schur[level].estimate_eigenvalues(temp_pressure);
+
+        if (use_Schur_complement_GMG())
+          {
+            vector_t temp_pressure;
+            mg_matrices_Schur_complement[level].initialize_dof_vector(temp_pressure);
+            mg_smoother_Schur[level].estimate_eigenvalues(temp_pressure);
+          }
       }
 #endif
 
@@ -1667,21 +3004,23 @@ namespace aspect
 
     //Schur complement matrix GMG
     MGCoarseGridApplySmoother<vector_t> mg_coarse_Schur;
-    mg_coarse_Schur.initialize(mg_smoother_Schur);
+    if (use_Schur_complement_GMG())
+      mg_coarse_Schur.initialize(mg_smoother_Schur);
 
     // Interface matrices
     // Ablock GMG
-    MGLevelObject<MatrixFreeOperators::MGInterfaceOperator<ABlockMatrixType> > mg_interface_matrices_A;
+    MGLevelObject<MatrixFreeOperators::MGInterfaceOperator<GMGABlockMatrixType> > mg_interface_matrices_A;
     mg_interface_matrices_A.resize(0, sim.triangulation.n_global_levels()-1);
     for (unsigned int level=0; level<sim.triangulation.n_global_levels(); ++level)
       mg_interface_matrices_A[level].initialize(mg_matrices_A_block[level]);
     mg::Matrix<vector_t > mg_interface_A(mg_interface_matrices_A);
 
     // Schur complement matrix GMG
-    MGLevelObject<MatrixFreeOperators::MGInterfaceOperator<SchurComplementMatrixType> > mg_interface_matrices_Schur;
+    MGLevelObject<MatrixFreeOperators::MGInterfaceOperator<GMGSchurComplementMatrixType> > mg_interface_matrices_Schur;
     mg_interface_matrices_Schur.resize(0, sim.triangulation.n_global_levels()-1);
-    for (unsigned int level=0; level<sim.triangulation.n_global_levels(); ++level)
-      mg_interface_matrices_Schur[level].initialize(mg_matrices_Schur_complement[level]);
+    if (use_Schur_complement_GMG())
+      for (unsigned int level=0; level<sim.triangulation.n_global_levels(); ++level)
+        mg_interface_matrices_Schur[level].initialize(mg_matrices_Schur_complement[level]);
     mg::Matrix<vector_t > mg_interface_Schur(mg_interface_matrices_Schur);
 
     // MG Matrix
@@ -1698,18 +3037,78 @@ namespace aspect
     mg_A.set_edge_matrices(mg_interface_A, mg_interface_A);
 
     // Schur complement matrix GMG
-    Multigrid<vector_t > mg_Schur(mg_matrix_Schur,
-                                  mg_coarse_Schur,
-                                  mg_transfer_Schur_complement,
-                                  mg_smoother_Schur,
-                                  mg_smoother_Schur);
-    mg_Schur.set_edge_matrices(mg_interface_Schur, mg_interface_Schur);
+    std::unique_ptr<Multigrid<vector_t> > mg_Schur;
+    if (use_Schur_complement_GMG())
+      {
+        mg_Schur = std_cxx14::make_unique<Multigrid<vector_t> >(mg_matrix_Schur,
+                                                                mg_coarse_Schur,
+                                                                mg_transfer_Schur_complement,
+                                                                mg_smoother_Schur,
+                                                                mg_smoother_Schur);
+        mg_Schur->set_edge_matrices(mg_interface_Schur, mg_interface_Schur);
+      }
 
     // GMG Preconditioner for ABlock and Schur complement
-    typedef PreconditionMG<dim, vector_t, MGTransferMatrixFree<dim,double> > GMGPreconditioner;
+    typedef PreconditionMG<dim, vector_t, MGTransferMatrixFree<dim,GMGNumberType> > GMGPreconditioner;
     GMGPreconditioner prec_A(dof_handler_v, mg_A, mg_transfer_A_block);
-    GMGPreconditioner prec_Schur(dof_handler_p, mg_Schur, mg_transfer_Schur_complement);
 
+    std::unique_ptr<GMGPreconditioner> prec_Schur_GMG;
+    if (use_Schur_complement_GMG())
+      prec_Schur_GMG = std_cxx14::make_unique<GMGPreconditioner>(dof_handler_p, *mg_Schur, mg_transfer_Schur_complement);
+
+    // There is no multigrid hierarchy for the fluid and compaction pressure
+    // of the melt system, so we precondition its Schur complement
+    // approximation with a Chebyshev iteration based on the diagonal
+    // computed in build_preconditioner() instead. Level operators for the
+    // melt coefficients are not implemented, which is why this solver is
+    // only used with melt transport if 'Allow melt transport' is set:
+    if (sim.parameters.include_melt_transport)
+      {
+        typedef PreconditionChebyshev<MeltSchurComplementMatrixType,dealii::LinearAlgebra::distributed::Vector<double> >
+        MeltSchurComplementPreconditionerType;
+        typename MeltSchurComplementPreconditionerType::AdditionalData chebyshev_data;
+        chebyshev_data.smoothing_range = 1e-3;
+        chebyshev_data.degree = 8;
+        chebyshev_data.eig_cg_n_iterations = 100;
+        chebyshev_data.preconditioner = melt_Schur_complement_matrix.get_matrix_diagonal_inverse();
+
+        MeltSchurComplementPreconditionerType prec_Schur_melt;
+        prec_Schur_melt.initialize(melt_Schur_complement_matrix, chebyshev_data);
+
+        return solve_system(melt_stokes_matrix, melt_Schur_complement_matrix,
+                            prec_A, prec_Schur_melt);
+      }
+
+    // For a discontinuous pressure, use the inverse diagonal of the
+    // Schur complement approximation computed in build_preconditioner():
+    typedef internal::SchurComplementPreconditioner<GMGPreconditioner,
+            DiagonalMatrix<dealii::LinearAlgebra::distributed::Vector<double> > > SchurComplementPreconditionerType;
+    const SchurComplementPreconditionerType
+    prec_Schur (prec_Schur_GMG.get(),
+                (use_Schur_complement_GMG()
+                 ?
+                 nullptr
+                 :
+                 Schur_complement_block_matrix.get_matrix_diagonal_inverse().get()));
+
+    return solve_system(stokes_matrix, Schur_complement_block_matrix,
+                        prec_A, prec_Schur);
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  template <class StokesOperatorType, class SchurComplementOperatorType,
+            class ABlockPreconditionerType, class SchurComplementPreconditionerType>
+  std::pair<double,double>
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::
+  solve_system (const StokesOperatorType                &stokes_operator,
+                const SchurComplementOperatorType       &Schur_complement_operator,
+                const ABlockPreconditionerType          &A_block_preconditioner,
+                const SchurComplementPreconditionerType &Schur_complement_preconditioner)
+  {
+    double initial_nonlinear_residual = numbers::signaling_nan<double>();
+    double final_linear_residual      = numbers::signaling_nan<double>();
 
     // Many parts of the solver depend on the block layout (velocity = 0,
     // pressure = 1). For example the linearized_stokes_initial_guess vector or the StokesBlock matrix
@@ -1787,9 +3186,9 @@ namespace aspect
         dealii::LinearAlgebra::distributed::BlockVector<double> initial_copy(2);
         dealii::LinearAlgebra::distributed::BlockVector<double> rhs_copy(2);
 
-        stokes_matrix.initialize_dof_vector(solution_copy);
-        stokes_matrix.initialize_dof_vector(initial_copy);
-        stokes_matrix.initialize_dof_vector(rhs_copy);
+        stokes_operator.initialize_dof_vector(solution_copy);
+        stokes_operator.initialize_dof_vector(initial_copy);
+        stokes_operator.initialize_dof_vector(rhs_copy);
 
         solution_copy.collect_sizes();
         initial_copy.collect_sizes();
@@ -1800,7 +3199,7 @@ namespace aspect
         internal::ChangeVectorTypes::copy(rhs_copy,distributed_stokes_rhs);
 
         // Compute residual l2_norm
-        stokes_matrix.vmult(solution_copy,initial_copy);
+        stokes_operator.vmult(solution_copy,initial_copy);
         solution_copy.sadd(-1,1,rhs_copy);
         initial_nonlinear_residual = solution_copy.l2_norm();
 
@@ -1814,7 +3213,7 @@ namespace aspect
         // pressure (the current pressure is a good approximation for the static
         // pressure).
         initial_copy.block(0) = 0.;
-        stokes_matrix.vmult(solution_copy,initial_copy);
+        stokes_operator.vmult(solution_copy,initial_copy);
         solution_copy.block(0).sadd(-1,1,rhs_copy.block(0));
 
         const double residual_u = solution_copy.block(0).l2_norm();
@@ -1848,8 +3247,8 @@ namespace aspect
     dealii::LinearAlgebra::distributed::BlockVector<double> solution_copy(2);
     dealii::LinearAlgebra::distributed::BlockVector<double> rhs_copy(2);
 
-    stokes_matrix.initialize_dof_vector(solution_copy);
-    stokes_matrix.initialize_dof_vector(rhs_copy);
+    stokes_operator.initialize_dof_vector(solution_copy);
+    stokes_operator.initialize_dof_vector(rhs_copy);
 
     solution_copy.collect_sizes();
     rhs_copy.collect_sizes();
@@ -1867,18 +3266,18 @@ namespace aspect
     solver_control_expensive.enable_history_data();
 
     // create a cheap preconditioner that consists of only a single V-cycle
-    const internal::BlockSchurGMGPreconditioner<StokesMatrixType, ABlockMatrixType, SchurComplementMatrixType, GMGPreconditioner, GMGPreconditioner>
-    preconditioner_cheap (stokes_matrix, A_block_matrix, Schur_complement_block_matrix,
-                          prec_A, prec_Schur,
+    const internal::BlockSchurGMGPreconditioner<StokesOperatorType, ABlockMatrixType, SchurComplementOperatorType, ABlockPreconditionerType, SchurComplementPreconditionerType>
+    preconditioner_cheap (stokes_operator, A_block_matrix, Schur_complement_operator,
+                          A_block_preconditioner, Schur_complement_preconditioner,
                           /*do_solve_A*/false,
                           /*do_solve_Schur*/false,
                           sim.parameters.linear_solver_A_block_tolerance,
                           sim.parameters.linear_solver_S_block_tolerance);
 
     // create an expensive preconditioner that solves for the A block with CG
-    const internal::BlockSchurGMGPreconditioner<StokesMatrixType, ABlockMatrixType, SchurComplementMatrixType, GMGPreconditioner, GMGPreconditioner>
-    preconditioner_expensive (stokes_matrix, A_block_matrix, Schur_complement_block_matrix,
-                              prec_A, prec_Schur,
+    const internal::BlockSchurGMGPreconditioner<StokesOperatorType, ABlockMatrixType, SchurComplementOperatorType, ABlockPreconditionerType, SchurComplementPreconditionerType>
+    preconditioner_expensive (stokes_operator, A_block_matrix, Schur_complement_operator,
+                              A_block_preconditioner, Schur_complement_preconditioner,
                               /*do_solve_A*/true,
                               /*do_solve_Schur*/true,
                               sim.parameters.linear_solver_A_block_tolerance,
@@ -1909,7 +3308,7 @@ namespace aspect
                    AdditionalData(sim.parameters.stokes_gmres_restart_length+2,
                                   true));
 
-            solver.solve (stokes_matrix,
+            solver.solve (stokes_operator,
                           solution_copy,
                           rhs_copy,
                           preconditioner_cheap);
@@ -1922,7 +3321,7 @@ namespace aspect
                    SolverIDR<dealii::LinearAlgebra::distributed::BlockVector<double> >::
                    AdditionalData(sim.parameters.idr_s_parameter));
 
-            solver.solve (stokes_matrix,
+            solver.solve (stokes_operator,
                           solution_copy,
                           rhs_copy,
                           preconditioner_cheap);
@@ -1958,7 +3357,7 @@ namespace aspect
                          ExcMessage ("The Stokes solver did not converge in the number of requested cheap iterations and "
                                      "you requested 0 for ``Maximum number of expensive Stokes solver steps''. Aborting."));
 
-            solver.solve(stokes_matrix,
+            solver.solve(stokes_operator,
                          solution_copy,
                          rhs_copy,
                          preconditioner_expensive);
@@ -2040,8 +3439,10 @@ namespace aspect
               << (solver_control_expensive.last_step() != numbers::invalid_unsigned_int ?
                   solver_control_expensive.last_step():
                   0)
-              << " iterations.";
-    sim.pcout << std::endl;
+              << " iterations";
+    if (std::is_same<GMGNumberType,float>::value)
+      sim.pcout << " (single precision multigrid)";
+    sim.pcout << '.' << std::endl;
 
     // do some cleanup now that we have the solution
     sim.remove_nullspace(sim.solution, distributed_stokes_solution);
@@ -2050,8 +3451,6 @@ namespace aspect
 
 
     // convert melt pressures
-    // TODO: We assert in the StokesMatrixFreeHandler constructor that we
-    //       are not including melt transport.
     if (sim.parameters.include_melt_transport)
       sim.melt_handler->compute_melt_variables(sim.system_matrix,sim.solution,sim.system_rhs);
 
@@ -2062,8 +3461,8 @@ namespace aspect
 
 
 
-  template <int dim, int velocity_degree>
-  void StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::setup_dofs()
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::setup_dofs()
   {
     // Velocity DoFHandler
     {
@@ -2077,6 +3476,7 @@ namespace aspect
       DoFTools::extract_locally_relevant_dofs (dof_handler_v,
                                                locally_relevant_dofs);
       constraints_v.reinit(locally_relevant_dofs);
+      make_periodicity_constraints(dof_handler_v, constraints_v);
       DoFTools::make_hanging_node_constraints (dof_handler_v, constraints_v);
       sim.compute_initial_velocity_boundary_constraints(constraints_v);
       sim.compute_current_velocity_boundary_constraints(constraints_v);
@@ -2103,8 +3503,13 @@ namespace aspect
       DoFTools::extract_locally_relevant_dofs (dof_handler_p,
                                                locally_relevant_dofs);
       constraints_p.reinit(locally_relevant_dofs);
+      make_periodicity_constraints(dof_handler_p, constraints_p);
       DoFTools::make_hanging_node_constraints (dof_handler_p, constraints_p);
       constraints_p.close();
+
+      // The constraints on the compaction pressure are added in
+      // update_melt_constraints() once the melt cells are known:
+      constrained_p_c_dofs.clear();
     }
 
     // Coefficient transfer objects
@@ -2145,16 +3550,37 @@ namespace aspect
             }
       }
 
-      //Schur complement matrix GMG
-      dof_handler_p.distribute_mg_dofs();
-
+      //Schur complement matrix GMG, see use_Schur_complement_GMG()
       mg_constrained_dofs_Schur_complement.clear();
-      mg_constrained_dofs_Schur_complement.initialize(dof_handler_p);
+      if (use_Schur_complement_GMG())
+        {
+          dof_handler_p.distribute_mg_dofs();
+          mg_constrained_dofs_Schur_complement.initialize(dof_handler_p);
+        }
 
       dof_handler_projection.distribute_mg_dofs();
     }
 
-    // Setup the matrix-free operators
+    setup_operators();
+
+    // Build MG transfer
+    mg_transfer_A_block.clear();
+    mg_transfer_A_block.initialize_constraints(mg_constrained_dofs_A_block);
+    mg_transfer_A_block.build(dof_handler_v);
+
+    mg_transfer_Schur_complement.clear();
+    if (use_Schur_complement_GMG())
+      {
+        mg_transfer_Schur_complement.initialize_constraints(mg_constrained_dofs_Schur_complement);
+        mg_transfer_Schur_complement.build(dof_handler_p);
+      }
+  }
+
+
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::setup_operators()
+  {
     // Stokes matrix
     {
       typename MatrixFree<dim,double>::AdditionalData additional_data;
@@ -2162,6 +3588,9 @@ namespace aspect
         MatrixFree<dim,double>::AdditionalData::none;
       additional_data.mapping_update_flags = (update_values | update_gradients |
                                               update_JxW_values | update_quadrature_points);
+      if (apply_free_surface_stabilization())
+        additional_data.mapping_update_flags_boundary_faces = (update_values | update_JxW_values |
+                                                               update_quadrature_points | update_normal_vectors);
 
       std::vector<const DoFHandler<dim>*> stokes_dofs;
       stokes_dofs.push_back(&dof_handler_v);
@@ -2170,13 +3599,17 @@ namespace aspect
       stokes_constraints.push_back(&constraints_v);
       stokes_constraints.push_back(&constraints_p);
 
-      std::shared_ptr<MatrixFree<dim,double> >
-      stokes_mf_storage(new MatrixFree<dim,double>());
+      stokes_mf_storage.reset(new MatrixFree<dim,double>());
       stokes_mf_storage->reinit(*sim.mapping,stokes_dofs, stokes_constraints,
                                 QGauss<1>(sim.parameters.stokes_velocity_degree+1), additional_data);
       stokes_matrix.clear();
       stokes_matrix.initialize(stokes_mf_storage);
 
+      // The operator for the system with melt transport uses the same
+      // matrix-free storage, with a two-component pressure element:
+      melt_stokes_matrix.clear();
+      if (sim.parameters.include_melt_transport)
+        melt_stokes_matrix.initialize(stokes_mf_storage);
     }
 
     // ABlock matrix
@@ -2186,8 +3619,10 @@ namespace aspect
         MatrixFree<dim,double>::AdditionalData::none;
       additional_data.mapping_update_flags = (update_values | update_gradients |
                                               update_JxW_values | update_quadrature_points);
-      std::shared_ptr<MatrixFree<dim,double> >
-      ablock_mf_storage(new MatrixFree<dim,double>());
+      if (apply_free_surface_stabilization())
+        additional_data.mapping_update_flags_boundary_faces = (update_values | update_JxW_values |
+                                                               update_quadrature_points | update_normal_vectors);
+      ablock_mf_storage.reset(new MatrixFree<dim,double>());
       ablock_mf_storage->reinit(*sim.mapping,dof_handler_v, constraints_v,
                                 QGauss<1>(sim.parameters.stokes_velocity_degree+1), additional_data);
 
@@ -2202,13 +3637,20 @@ namespace aspect
         MatrixFree<dim,double>::AdditionalData::none;
       additional_data.mapping_update_flags = (update_values | update_JxW_values |
                                               update_quadrature_points);
-      std::shared_ptr<MatrixFree<dim,double> >
-      Schur_mf_storage(new MatrixFree<dim,double>());
+      // The Schur complement approximation with melt transport contains
+      // the Darcy term K_D grad(p_f):
+      if (sim.parameters.include_melt_transport)
+        additional_data.mapping_update_flags |= update_gradients;
+      Schur_mf_storage.reset(new MatrixFree<dim,double>());
       Schur_mf_storage->reinit(*sim.mapping,dof_handler_p, constraints_p,
                                QGauss<1>(sim.parameters.stokes_velocity_degree+1), additional_data);
 
       Schur_complement_block_matrix.clear();
-      Schur_complement_block_matrix.initialize(Schur_mf_storage);
+      melt_Schur_complement_matrix.clear();
+      if (sim.parameters.include_melt_transport)
+        melt_Schur_complement_matrix.initialize(Schur_mf_storage);
+      else
+        Schur_complement_block_matrix.initialize(Schur_mf_storage);
     }
 
     // GMG matrices
@@ -2218,6 +3660,7 @@ namespace aspect
       // ABlock GMG
       mg_matrices_A_block.clear_elements();
       mg_matrices_A_block.resize(0, n_levels-1);
+      mg_mf_storage_A_block.resize(0, n_levels-1);
 
       for (unsigned int level=0; level<n_levels; ++level)
         {
@@ -2226,6 +3669,11 @@ namespace aspect
           ConstraintMatrix level_constraints;
           level_constraints.reinit(relevant_dofs);
           level_constraints.add_lines(mg_constrained_dofs_A_block.get_boundary_indices(level));
+#if DEAL_II_VERSION_GTE(9,3,0)
+          // Add the constraints for periodic boundaries on this level:
+          level_constraints.merge(mg_constrained_dofs_A_block.get_level_constraints(level),
+                                  ConstraintMatrix::left_object_wins);
+#endif
           level_constraints.close();
 
           std::set<types::boundary_id> no_flux_boundary
@@ -2238,7 +3686,7 @@ namespace aspect
 
               internal::TangentialBoundaryFunctions::compute_no_normal_flux_constraints_shell(dof_handler_v,
                                                                                               mg_constrained_dofs_A_block,
-                                                                                              *sim.mapping,
+                                                                                              get_level_mapping(level),
                                                                                               level,
                                                                                               0,
                                                                                               no_flux_boundary,
@@ -2256,24 +3704,26 @@ namespace aspect
             }
 
           {
-            typename MatrixFree<dim,double>::AdditionalData additional_data;
+            typename MatrixFree<dim,GMGNumberType>::AdditionalData additional_data;
             additional_data.tasks_parallel_scheme =
-              MatrixFree<dim,double>::AdditionalData::none;
+              MatrixFree<dim,GMGNumberType>::AdditionalData::none;
             additional_data.mapping_update_flags = (update_gradients | update_JxW_values |
                                                     update_quadrature_points);
+            if (apply_free_surface_stabilization())
+              additional_data.mapping_update_flags_boundary_faces = (update_values | update_JxW_values |
+                                                                     update_quadrature_points | update_normal_vectors);
 #if DEAL_II_VERSION_GTE(9,2,0)
             additional_data.mg_level = level;
 #else
             additional_data.level_mg_handler = level;
 #endif
-            std::shared_ptr<MatrixFree<dim,double> >
-            mg_mf_storage_level(new MatrixFree<dim,double>());
-            mg_mf_storage_level->reinit(*sim.mapping, dof_handler_v, level_constraints,
-                                        QGauss<1>(sim.parameters.stokes_velocity_degree+1),
-                                        additional_data);
+            mg_mf_storage_A_block[level].reset(new MatrixFree<dim,GMGNumberType>());
+            mg_mf_storage_A_block[level]->reinit(get_level_mapping(level), dof_handler_v, level_constraints,
+                                                 QGauss<1>(sim.parameters.stokes_velocity_degree+1),
+                                                 additional_data);
 
             mg_matrices_A_block[level].clear();
-            mg_matrices_A_block[level].initialize(mg_mf_storage_level, mg_constrained_dofs_A_block, level);
+            mg_matrices_A_block[level].initialize(mg_mf_storage_A_block[level], mg_constrained_dofs_A_block, level);
 
           }
         }
@@ -2281,62 +3731,97 @@ namespace aspect
       //Schur complement matrix GMG
       mg_matrices_Schur_complement.clear_elements();
       mg_matrices_Schur_complement.resize(0, n_levels-1);
+      mg_mf_storage_Schur_complement.resize(0, n_levels-1);
 
-      for (unsigned int level=0; level<n_levels; ++level)
-        {
-          IndexSet relevant_dofs;
-          DoFTools::extract_locally_relevant_level_dofs(dof_handler_p, level, relevant_dofs);
-          ConstraintMatrix level_constraints;
-          level_constraints.reinit(relevant_dofs);
-          level_constraints.close();
-
+      if (use_Schur_complement_GMG())
+        for (unsigned int level=0; level<n_levels; ++level)
           {
-            typename MatrixFree<dim,double>::AdditionalData additional_data;
-            additional_data.tasks_parallel_scheme =
-              MatrixFree<dim,double>::AdditionalData::none;
-            additional_data.mapping_update_flags = (update_values | update_JxW_values |
-                                                    update_quadrature_points);
+            IndexSet relevant_dofs;
+            DoFTools::extract_locally_relevant_level_dofs(dof_handler_p, level, relevant_dofs);
+            ConstraintMatrix level_constraints;
+            level_constraints.reinit(relevant_dofs);
+#if DEAL_II_VERSION_GTE(9,3,0)
+            level_constraints.merge(mg_constrained_dofs_Schur_complement.get_level_constraints(level));
+#endif
+            level_constraints.close();
+
+            {
+              typename MatrixFree<dim,GMGNumberType>::AdditionalData additional_data;
+              additional_data.tasks_parallel_scheme =
+                MatrixFree<dim,GMGNumberType>::AdditionalData::none;
+              additional_data.mapping_update_flags = (update_values | update_JxW_values |
+                                                      update_quadrature_points);
 #if DEAL_II_VERSION_GTE(9,2,0)
-            additional_data.mg_level = level;
+              additional_data.mg_level = level;
 #else
-            additional_data.level_mg_handler = level;
+              additional_data.level_mg_handler = level;
 #endif
-            std::shared_ptr<MatrixFree<dim,double> >
-            mg_mf_storage_level(new MatrixFree<dim,double>());
-            mg_mf_storage_level->reinit(*sim.mapping, dof_handler_p, level_constraints,
-                                        QGauss<1>(sim.parameters.stokes_velocity_degree+1),
-                                        additional_data);
-
-            mg_matrices_Schur_complement[level].clear();
-            mg_matrices_Schur_complement[level].initialize(mg_mf_storage_level, mg_constrained_dofs_Schur_complement, level);
+              mg_mf_storage_Schur_complement[level].reset(new MatrixFree<dim,GMGNumberType>());
+              mg_mf_storage_Schur_complement[level]->reinit(get_level_mapping(level), dof_handler_p, level_constraints,
+                                                            QGauss<1>(sim.parameters.stokes_velocity_degree+1),
+                                                            additional_data);
+
+              mg_matrices_Schur_complement[level].clear();
+              mg_matrices_Schur_complement[level].initialize(mg_mf_storage_Schur_complement[level], mg_constrained_dofs_Schur_complement, level);
+            }
           }
-        }
     }
+  }
 
-    // Build MG transfer
-    mg_transfer_A_block.clear();
-    mg_transfer_A_block.initialize_constraints(mg_constrained_dofs_A_block);
-    mg_transfer_A_block.build(dof_handler_v);
 
-    mg_transfer_Schur_complement.clear();
-    mg_transfer_Schur_complement.initialize_constraints(mg_constrained_dofs_Schur_complement);
-    mg_transfer_Schur_complement.build(dof_handler_p);
+
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::update_mapping()
+  {
+#if DEAL_II_VERSION_GTE(9,3,0)
+    // Only the geometry of the cells changed, so the constraints, the
+    // partitioning of the degrees of freedom, and the operators stay the
+    // same. The diagonals of the operators are recomputed in
+    // build_preconditioner().
+    stokes_mf_storage->update_mapping(*sim.mapping);
+    ablock_mf_storage->update_mapping(*sim.mapping);
+    Schur_mf_storage->update_mapping(*sim.mapping);
+
+    for (unsigned int level=mg_mf_storage_A_block.min_level(); level<=mg_mf_storage_A_block.max_level(); ++level)
+      mg_mf_storage_A_block[level]->update_mapping(get_level_mapping(level));
+
+    if (use_Schur_complement_GMG())
+      for (unsigned int level=mg_mf_storage_Schur_complement.min_level(); level<=mg_mf_storage_Schur_complement.max_level(); ++level)
+        mg_mf_storage_Schur_complement[level]->update_mapping(get_level_mapping(level));
+#else
+    // MatrixFree::update_mapping() is not available, so set up the
+    // operators from scratch:
+    setup_operators();
+#endif
   }
 
 
 
-  template <int dim, int velocity_degree>
-  void StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::build_preconditioner()
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  void StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::build_preconditioner()
   {
     TimerOutput::Scope timer (this->sim.computing_timer, "Build Stokes preconditioner");
 
-    const bool is_compressible = sim.material_model->is_compressible();
+    // The melt system always contains the compressible term of the A block:
+    const bool is_compressible = sim.material_model->is_compressible()
+                                 || sim.parameters.include_melt_transport;
+
+    // Without GMG, the Schur complement approximation is preconditioned based
+    // on its diagonal on the active level. For a discontinuous pressure,
+    // the (1/eta)-weighted mass matrix of FE_DGP is block diagonal with
+    // nearly diagonal blocks, so the inverse diagonal is almost an exact
+    // inverse. For melt transport, it is used inside a Chebyshev iteration.
+    if (sim.parameters.include_melt_transport)
+      melt_Schur_complement_matrix.compute_diagonal();
+    else if (!use_Schur_complement_GMG())
+      Schur_complement_block_matrix.compute_diagonal();
 
     // Assemble and store the diagonal of the GMG level matrices derived from:
     // 2*eta*(symgrad u, symgrad v) - (if compressible) 2*eta/3*(div u, div v)
     for (unsigned int level=0; level < sim.triangulation.n_global_levels(); ++level)
       {
-        mg_matrices_Schur_complement[level].compute_diagonal();
+        if (use_Schur_complement_GMG())
+          mg_matrices_Schur_complement[level].compute_diagonal();
 
         // If we have a tangential boundary we must compute the A block
         // diagonal outside of the matrix-free object
@@ -2356,7 +3841,7 @@ namespace aspect
                                    sim.mpi_communicator);
 
             QGauss<dim>  quadrature_formula(sim.parameters.stokes_velocity_degree+1);
-            FEValues<dim> fe_values (fe_v, quadrature_formula,
+            FEValues<dim> fe_values (get_level_mapping(level), fe_v, quadrature_formula,
                                      update_values   | update_gradients |
                                      update_quadrature_points | update_JxW_values);
             FEValues<dim> fe_values_projection (*(sim.mapping),
@@ -2383,6 +3868,10 @@ namespace aspect
             // let Dirichlet values win over no normal flux:
             boundary_constraints.merge(mg_constrained_dofs_A_block.get_user_constraint_matrix(level),
                                        ConstraintMatrix::left_object_wins);
+#endif
+#if DEAL_II_VERSION_GTE(9,3,0)
+            boundary_constraints.merge(mg_constrained_dofs_A_block.get_level_constraints(level),
+                                       ConstraintMatrix::left_object_wins);
 #endif
             boundary_constraints.close();
 
@@ -2448,7 +3937,10 @@ namespace aspect
                 }
 
             diagonal_matrix.compress(VectorOperation::add);
-            mg_matrices_A_block[level].set_diagonal(diagonal_matrix.get_vector());
+
+            dealii::LinearAlgebra::distributed::Vector<GMGNumberType> level_diagonal;
+            level_diagonal = diagonal_matrix.get_vector();
+            mg_matrices_A_block[level].set_diagonal(level_diagonal);
           }
         else
           {
@@ -2462,75 +3954,68 @@ namespace aspect
 
 
 
-  template <int dim, int velocity_degree>
+  template <int dim, int velocity_degree, typename GMGNumberType>
   const DoFHandler<dim> &
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_dof_handler_v () const
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_dof_handler_v () const
   {
     return dof_handler_v;
   }
 
 
-  template <int dim, int velocity_degree>
+  template <int dim, int velocity_degree, typename GMGNumberType>
   const DoFHandler<dim> &
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_dof_handler_p () const
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_dof_handler_p () const
   {
     return dof_handler_p;
   }
 
 
-  template <int dim, int velocity_degree>
+  template <int dim, int velocity_degree, typename GMGNumberType>
   const DoFHandler<dim> &
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_dof_handler_projection () const
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_dof_handler_projection () const
   {
     return dof_handler_projection;
   }
 
 
-  template <int dim, int velocity_degree>
+  template <int dim, int velocity_degree, typename GMGNumberType>
   const ConstraintMatrix &
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_constraints_v() const
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_constraints_v() const
   {
     return constraints_v;
   }
 
 
-  template <int dim, int velocity_degree>
+  template <int dim, int velocity_degree, typename GMGNumberType>
   const ConstraintMatrix &
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_constraints_p() const
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_constraints_p() const
   {
     return constraints_p;
   }
 
 
-  template <int dim, int velocity_degree>
-  const MGTransferMatrixFree<dim,double> &
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_mg_transfer_A() const
-  {
-    return mg_transfer_A_block;
-  }
-
-
-  template <int dim, int velocity_degree>
-  const MGTransferMatrixFree<dim,double> &
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_mg_transfer_S() const
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  std::size_t
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_mg_transfer_memory_consumption() const
   {
-    return mg_transfer_Schur_complement;
+    return mg_transfer_A_block.memory_consumption()
+           + mg_transfer_Schur_complement.memory_consumption();
   }
 
 
-  template <int dim, int velocity_degree>
+  template <int dim, int velocity_degree, typename GMGNumberType>
   const Table<2, VectorizedArray<double>> &
-                                       StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_active_viscosity_table() const
+                                       StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_active_viscosity_table() const
   {
     return active_viscosity_table;
   }
 
 
-  template <int dim, int velocity_degree>
-  const MGLevelObject<Table<2, VectorizedArray<double>>> &
-  StokesMatrixFreeHandlerImplementation<dim, velocity_degree>::get_level_viscosity_tables() const
+  template <int dim, int velocity_degree, typename GMGNumberType>
+  std::size_t
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree,GMGNumberType>::get_level_viscosity_tables_memory_consumption() const
   {
-    return level_viscosity_tables;
+    return level_viscosity_tables.memory_consumption();
   }
 
 
@@ -2539,8 +4024,10 @@ namespace aspect
 // explicit instantiation of the functions we implement in this file
 #define INSTANTIATE(dim) \
   template class StokesMatrixFreeHandler<dim>; \
-  template class StokesMatrixFreeHandlerImplementation<dim,2>; \
-  template class StokesMatrixFreeHandlerImplementation<dim,3>;
+  template class StokesMatrixFreeHandlerImplementation<dim,2,double>; \
+  template class StokesMatrixFreeHandlerImplementation<dim,3,double>; \
+  template class StokesMatrixFreeHandlerImplementation<dim,2,float>; \
+  template class StokesMatrixFreeHandlerImplementation<dim,3,float>;
 
   ASPECT_INSTANTIATE(INSTANTIATE)
 
@@ -0,0 +1,104 @@
+#include <aspect/simulator.h>
+#include <iostream>
+
+/*
+ * Launch the following function when this plugin is created. Launch ASPECT
+ * twice to test checkpoint/resume on a different number of processes and
+ * then terminate the outer ASPECT run.
+ */
+int f()
+{
+  if (dealii::Utilities::MPI::this_mpi_process (MPI_COMM_WORLD) != 0)
+    return 0;
+
+  std::cout << "* starting from beginning:" << std::endl;
+
+  // call ASPECT with "--" and pipe an existing input file into it.
+  int ret;
+  std::string command;
+
+  command = ("cd output-checkpoint_06_particles_separate_file ; "
+             "(cat " ASPECT_SOURCE_DIR "/tests/checkpoint_06_particles_separate_file.prm "
+             " ; "
+             " echo 'set Output directory = output1.tmp' "
+             " ; "
+             " rm -rf output1.tmp ; mkdir output1.tmp "
+             ") "
+             "| mpirun -np 1 ../../aspect -- > /dev/null");
+  std::cout << "Executing the following command:\n"
+            << command
+            << std::endl;
+  ret = system (command.c_str());
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+  command = ("cd output-checkpoint_06_particles_separate_file ; "
+             " rm -rf output2.tmp ; mkdir output2.tmp ; "
+             " cp output1.tmp/restart* output2.tmp/");
+  std::cout << "Executing the following command:\n"
+            << command
+            << std::endl;
+  ret = system (command.c_str());
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+
+  std::cout << "* now resuming on two processes:" << std::endl;
+  command = ("cd output-checkpoint_06_particles_separate_file ; "
+             "(cat " ASPECT_SOURCE_DIR "/tests/checkpoint_06_particles_separate_file.prm "
+             " ; "
+             " echo 'set Output directory = output2.tmp' "
+             " ; "
+             " echo 'set Resume computation = true' "
+             ") "
+             "| mpirun -np 2 ../../aspect -- > /dev/null");
+  std::cout << "Executing the following command:\n"
+            << command
+            << std::endl;
+  ret = system (command.c_str());
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+  std::cout << "* now comparing:" << std::endl;
+
+  // Collect the particles of the last time step of both runs, which are
+  // written by a different number of processes, and sort them by their id
+  ret = system ("cd output-checkpoint_06_particles_separate_file ; "
+                "for run in 1 2 ; do "
+                "  cat output$run.tmp/particles/particles-00009.*.gnuplot "
+                "    | grep -v -e '^#' -e '^ *$' | sort -n -k3 > particles-00009.gnuplot$run ; "
+                "done");
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+  // Compare the ids, locations, and properties of the particles of the
+  // resumed run with the ones of the uninterrupted run. The resumed run
+  // uses two processes, so the solutions differ by round-off and the
+  // solver tolerance. Every column is therefore compared relative to its
+  // largest absolute value.
+  ret = system ("cd output-checkpoint_06_particles_separate_file ; "
+                "paste -d ' ' particles-00009.gnuplot1 particles-00009.gnuplot2 > particles-00009.both ; "
+                "awk 'NR==FNR {n=NF/2; "
+                "              for (c=1; c<=n; ++c) {v=($c<0 ? -$c : $c); if (v>scale[c]) scale[c]=v}; "
+                "              next} "
+                "     {++count; n=NF/2; "
+                "      if ($3 != $(n+3)) different_ids=1; "
+                "      for (c=1; c<=n; ++c) "
+                "        {d=$c-$(n+c); if (d<0) d=-d; "
+                "         if (scale[c]>0 && d/scale[c]>max_difference) max_difference=d/scale[c]}} "
+                "     END {print \"Number of particles: \" count+0; "
+                "          print \"Same particle ids in both runs: \" (different_ids ? \"no\" : \"yes\"); "
+                "          print \"Relative difference of locations and properties below 1e-5: \" "
+                "                (max_difference<1e-5 ? \"yes\" : \"no\")}' "
+                "    particles-00009.both particles-00009.both > particle_comparison");
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+  // terminate current process:
+  exit (0);
+  return 42;
+}
+
+
+// run this function by initializing a global variable by it
+int i = f();
@@ -0,0 +1,268 @@
+/*
+  Copyright (C) 2026 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file doc/COPYING.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+// Functions for tests that run ASPECT several times with their own input
+// file, each time with a few different parameters, and compare the
+// results of these runs. Like the checkpoint tests, such a test consists
+// of a plugin that starts the runs when the shared library of the test is
+// loaded, and then terminates the outer ASPECT run:
+//
+//   int f()
+//   {
+//     if (aspect::CompareRuns::is_comparison_run())
+//       return 0;
+//
+//     aspect::CompareRuns::run_model ("my_test", "output1.tmp", {...});
+//     aspect::CompareRuns::run_model ("my_test", "output2.tmp", {...});
+//
+//     std::ofstream comparison ("output-my_test/comparison");
+//     ...
+//     exit (0);
+//   }
+//
+//   int i = f();
+//
+// The runs can load the shared library of the test to use plugins that
+// are defined in it. is_comparison_run() makes sure that they do not
+// start runs themselves in this case.
+
+#include <aspect/global.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace aspect
+{
+  namespace CompareRuns
+  {
+    /**
+     * The environment variable that is set for the runs started by
+     * run_model().
+     */
+    const char *const comparison_run_variable = "ASPECT_COMPARISON_RUN";
+
+
+
+    /**
+     * Return whether the current process is one of the runs started by
+     * run_model(), rather than the outer run of the test.
+     */
+    inline
+    bool
+    is_comparison_run ()
+    {
+      return std::getenv (comparison_run_variable) != nullptr;
+    }
+
+
+
+    /**
+     * Run ASPECT with the input file of the test @p test_name, followed by
+     * the lines in @p parameters. The output is written into the directory
+     * @p output_directory inside the output directory of the test. If
+     * @p load_test_library is true, the run loads the shared library of the
+     * test, e.g., because the model uses a plugin defined in it.
+     */
+    inline
+    void
+    run_model (const std::string &test_name,
+               const std::string &output_directory,
+               const std::vector<std::string> &parameters = std::vector<std::string>(),
+               const bool load_test_library = false)
+    {
+      std::string command = "cd output-" + test_name + " ; "
+                            "(cat " ASPECT_SOURCE_DIR "/tests/" + test_name + ".prm ; "
+                            " echo 'set Output directory = " + output_directory + "' ; ";
+      if (load_test_library)
+        command += " echo 'set Additional shared libraries = ../lib" + test_name + ".so' ; ";
+      for (const auto &parameter : parameters)
+        command += " echo '" + parameter + "' ; ";
+      command += " rm -rf " + output_directory + " ; mkdir " + output_directory + " ) "
+                 "| " + comparison_run_variable + "=1 ../../aspect -- > /dev/null";
+
+      std::cout << "Executing the following command:\n"
+                << command
+                << std::endl;
+      const int ret = system (command.c_str());
+      if (ret!=0)
+        std::cout << "system() returned error " << ret << std::endl;
+    }
+
+
+
+    /**
+     * Return the values of the column of the statistics file @p filename
+     * whose name starts with @p column_name, one value per line of the
+     * file. If the file or the column does not exist, an empty vector is
+     * returned.
+     */
+    inline
+    std::vector<double>
+    read_statistics_column (const std::string &filename,
+                            const std::string &column_name)
+    {
+      std::vector<double> values;
+      std::ifstream statistics (filename.c_str());
+
+      unsigned int column = 0;
+      std::string line;
+      while (std::getline (statistics, line))
+        {
+          if (line.empty())
+            continue;
+
+          // The header lines have the form "# 3: RMS velocity (m/s)"
+          if (line[0] == '#')
+            {
+              const std::size_t colon = line.find(':');
+              if (colon != std::string::npos
+                  && colon+2 <= line.size()
+                  && line.compare (colon+2, column_name.size(), column_name) == 0)
+                column = std::atoi (line.c_str()+1);
+              continue;
+            }
+
+          if (column == 0)
+            return values;
+
+          std::istringstream entries (line);
+          std::string entry;
+          for (unsigned int c=0; c<column; ++c)
+            entries >> entry;
+          values.push_back (std::atof (entry.c_str()));
+        }
+
+      return values;
+    }
+
+
+
+    /**
+     * Return all numbers of the lines of the text file @p filename that are
+     * neither empty nor start with a '#', as in the gnuplot output of
+     * ASPECT. Every line of the file is one entry of the returned vector.
+     */
+    inline
+    std::vector<std::vector<double> >
+    read_data_file (const std::string &filename)
+    {
+      std::vector<std::vector<double> > rows;
+      std::ifstream file (filename.c_str());
+
+      std::string line;
+      while (std::getline (file, line))
+        {
+          if (line.find_first_not_of(" \t") == std::string::npos || line[0] == '#')
+            continue;
+
+          std::istringstream entries (line);
+          std::vector<double> row;
+          double value;
+          while (entries >> value)
+            row.push_back (value);
+          rows.push_back (row);
+        }
+
+      return rows;
+    }
+
+
+
+    /**
+     * Return the largest difference between the entries of @p a and @p b,
+     * relative to the largest absolute value in @p a. If the vectors are
+     * empty or have different sizes, infinity is returned.
+     */
+    inline
+    double
+    max_relative_difference (const std::vector<double> &a,
+                             const std::vector<double> &b)
+    {
+      if (a.empty() || a.size() != b.size())
+        return std::numeric_limits<double>::infinity();
+
+      double max_value = 0;
+      double max_difference = 0;
+      for (unsigned int i=0; i<a.size(); ++i)
+        {
+          max_value = std::max (max_value, std::abs(a[i]));
+          max_difference = std::max (max_difference, std::abs(a[i]-b[i]));
+        }
+
+      return (max_value > 0 ? max_difference / max_value : max_difference);
+    }
+
+
+
+    /**
+     * Return the largest relative difference between the columns of two
+     * tables, e.g., two files read by read_data_file(). Every column is
+     * compared relative to its largest absolute value, so that quantities
+     * of very different magnitude can be compared. If the tables are empty
+     * or have different shapes, infinity is returned.
+     */
+    inline
+    double
+    max_relative_difference (const std::vector<std::vector<double> > &a,
+                             const std::vector<std::vector<double> > &b)
+    {
+      if (a.empty() || a.size() != b.size())
+        return std::numeric_limits<double>::infinity();
+
+      double max_difference = 0;
+      for (unsigned int c=0; c<a[0].size(); ++c)
+        {
+          std::vector<double> column_a, column_b;
+          for (unsigned int r=0; r<a.size(); ++r)
+            {
+              if (a[r].size() != a[0].size() || b[r].size() != a[0].size())
+                return std::numeric_limits<double>::infinity();
+
+              column_a.push_back (a[r][c]);
+              column_b.push_back (b[r][c]);
+            }
+          max_difference = std::max (max_difference, max_relative_difference (column_a, column_b));
+        }
+
+      return max_difference;
+    }
+
+
+
+    /**
+     * Return "yes" if @p condition is true and "no" otherwise, for the
+     * output of a comparison.
+     */
+    inline
+    const char *
+    yes_or_no (const bool condition)
+    {
+      return (condition ? "yes" : "no");
+    }
+  }
+}
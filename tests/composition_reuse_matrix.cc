@@ -0,0 +1,88 @@
+#include "compare_runs.h"
+
+#include <iomanip>
+
+/*
+ * Launch the following function when this plugin is created. Launch ASPECT
+ * twice, without and with reusing the matrix for identical compositional
+ * fields, compare the solutions of both runs, and then terminate the outer
+ * ASPECT run.
+ */
+int f()
+{
+  using namespace aspect::CompareRuns;
+
+  if (is_comparison_run())
+    return 0;
+
+  const std::string test_name = "composition_reuse_matrix";
+
+  std::cout << "* solving the compositional fields one by one:" << std::endl;
+  run_model (test_name, "output1.tmp",
+  {
+    "subsection Solver parameters",
+    "  subsection Advection solver parameters",
+    "    set Reuse matrix for identical compositional fields = false",
+    "  end",
+    "end"
+  });
+
+  std::cout << "* solving the compositional fields with a shared matrix:" << std::endl;
+  run_model (test_name, "output2.tmp");
+
+  std::cout << "* now comparing:" << std::endl;
+
+  const std::string output = "output-" + test_name + "/";
+
+  // Compare the composition statistics of all time steps
+  bool statistics_agree = true;
+  for (const std::string column : {"Minimal value for composition", "Maximal value for composition", "Global mass for composition"})
+    for (unsigned int c=1; c<=3; ++c)
+      {
+        const std::string column_name = column + " C_" + std::to_string(c);
+        if (max_relative_difference (read_statistics_column (output + "output1.tmp/statistics", column_name),
+                                     read_statistics_column (output + "output2.tmp/statistics", column_name))
+            > 1e-6)
+          statistics_agree = false;
+      }
+
+  // Compare the solutions of all time steps. The gnuplot output only has
+  // six significant digits, so the tolerance has to be larger than the
+  // one of the solver.
+  bool solutions_agree = true;
+  unsigned int n_output_files = 0;
+  for (;; ++n_output_files)
+    {
+      std::ostringstream solution;
+      solution << "solution/solution-" << std::setw(5) << std::setfill('0') << n_output_files << ".0000.gnuplot";
+
+      if (!std::ifstream ((output + "output1.tmp/" + solution.str()).c_str()))
+        {
+          // both runs need to have the same number of time steps
+          if (std::ifstream ((output + "output2.tmp/" + solution.str()).c_str()))
+            solutions_agree = false;
+          break;
+        }
+
+      if (max_relative_difference (read_data_file (output + "output1.tmp/" + solution.str()),
+                                   read_data_file (output + "output2.tmp/" + solution.str()))
+          > 1e-5)
+        solutions_agree = false;
+    }
+
+  std::ofstream comparison ((output + "composition_comparison").c_str());
+  comparison << "Composition statistics agree in all time steps: "
+             << yes_or_no (statistics_agree)
+             << std::endl
+             << "Compositional fields agree at all output points in all time steps: "
+             << yes_or_no (solutions_agree && n_output_files > 0)
+             << std::endl;
+
+  // terminate current process:
+  exit (0);
+  return 42;
+}
+
+
+// run this function by initializing a global variable by it
+int i = f();
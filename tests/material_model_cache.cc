@@ -0,0 +1,45 @@
+#include "matrix_free_hydrostatic.cc"
+
+#include <aspect/material_model/evaluation_cache.h>
+
+namespace aspect
+{
+  /**
+   * A postprocessor that writes how often the material model cache reused
+   * stored outputs, and how often it evaluated the material model, into
+   * the file 'material_model_cache_check' in the output directory.
+   */
+  template <int dim>
+  class MaterialModelCacheCheck : public Postprocess::Interface<dim>, public ::aspect::SimulatorAccess<dim>
+  {
+    public:
+      std::pair<std::string,std::string>
+      execute (TableHandler &) override
+      {
+        const unsigned int n_hits = Utilities::MPI::sum (this->get_material_model_cache().n_hits(),
+                                                         this->get_mpi_communicator());
+        const unsigned int n_misses = Utilities::MPI::sum (this->get_material_model_cache().n_misses(),
+                                                           this->get_mpi_communicator());
+
+        if (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()) == 0)
+          {
+            std::ofstream check_file ((this->get_output_directory() + "material_model_cache_check").c_str());
+            check_file << "Number of active cells: " << this->get_triangulation().n_global_active_cells() << std::endl
+                       << "Material model cache hits: " << n_hits << std::endl
+                       << "Material model cache misses: " << n_misses << std::endl;
+          }
+
+        return std::make_pair ("Material model cache hits and misses:",
+                               Utilities::int_to_string(n_hits) + ", " + Utilities::int_to_string(n_misses));
+      }
+  };
+}
+
+
+namespace aspect
+{
+  ASPECT_REGISTER_POSTPROCESSOR(MaterialModelCacheCheck,
+                                "material model cache check",
+                                "A postprocessor that writes the number of hits and misses "
+                                "of the material model cache.")
+}
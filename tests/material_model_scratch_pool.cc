@@ -0,0 +1,164 @@
+#include <aspect/postprocess/interface.h>
+#include <aspect/simulator_access.h>
+#include <aspect/material_model/scratch_pool.h>
+#include <aspect/material_model/visco_plastic.h>
+
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/signaling_nan.h>
+#include <deal.II/fe/fe_values.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace aspect
+{
+  using namespace dealii;
+
+  namespace
+  {
+    /**
+     * Additional outputs that count how often they are constructed, and
+     * that can either be reset in place or not.
+     */
+    template <int dim>
+    class CountedOutputs : public MaterialModel::AdditionalMaterialOutputs<dim>
+    {
+      public:
+        CountedOutputs (const unsigned int n_points,
+                        const bool resettable,
+                        unsigned int &n_constructed)
+          :
+          values (n_points, numbers::signaling_nan<double>()),
+          resettable (resettable)
+        {
+          ++n_constructed;
+        }
+
+        bool reset () override
+        {
+          if (!resettable)
+            return false;
+
+          std::fill (values.begin(), values.end(), numbers::signaling_nan<double>());
+          return true;
+        }
+
+        std::vector<double> values;
+
+      private:
+        const bool resettable;
+    };
+
+
+
+    // Compare the bits, because floating point operations on
+    // signaling NaNs may raise exceptions
+    bool is_signaling_nan (const double &value)
+    {
+      const double signaling_nan = numbers::signaling_nan<double>();
+      return std::memcmp(&value, &signaling_nan, sizeof(double)) == 0;
+    }
+  }
+
+
+
+  /**
+   * A postprocessor that evaluates the material model on all cells with
+   * the objects of two MaterialModel::ScratchPool objects, one with
+   * additional outputs that can be reset in place, and one with
+   * additional outputs that can not. After every evaluation all outputs
+   * are overwritten, so that values that are not reset before the next
+   * cell are detected. The postprocessor writes into the file
+   * 'scratch_pool_check' in the output directory how often the additional
+   * outputs were constructed, and how many values were not reset.
+   */
+  template <int dim>
+  class ScratchPoolCheck : public Postprocess::Interface<dim>, public ::aspect::SimulatorAccess<dim>
+  {
+    public:
+      std::pair<std::string,std::string>
+      execute (TableHandler &) override
+      {
+        const QGauss<dim> quadrature_formula (this->introspection().polynomial_degree.velocities+1);
+        FEValues<dim> fe_values (this->get_mapping(),
+                                 this->get_fe(),
+                                 quadrature_formula,
+                                 update_values | update_gradients | update_quadrature_points);
+
+        unsigned int n_resettable_constructed = 0;
+        unsigned int n_non_resettable_constructed = 0;
+        unsigned int n_values_not_reset = 0;
+        unsigned int n_cells = 0;
+
+        MaterialModel::ScratchPool<dim> resettable_pool ([&](typename MaterialModel::ScratchPool<dim>::Scratch &scratch)
+        {
+          this->get_material_model().create_additional_named_outputs(scratch.outputs);
+          scratch.outputs.additional_outputs.push_back(
+            std_cxx14::make_unique<CountedOutputs<dim>> (scratch.outputs.n_evaluation_points(),
+                                                        true,
+                                                        n_resettable_constructed));
+        });
+
+        MaterialModel::ScratchPool<dim> non_resettable_pool ([&](typename MaterialModel::ScratchPool<dim>::Scratch &scratch)
+        {
+          scratch.outputs.additional_outputs.push_back(
+            std_cxx14::make_unique<CountedOutputs<dim>> (scratch.outputs.n_evaluation_points(),
+                                                        false,
+                                                        n_non_resettable_constructed));
+        });
+
+        for (const auto &cell : this->get_dof_handler().active_cell_iterators())
+          if (cell->is_locally_owned())
+            {
+              ++n_cells;
+              fe_values.reinit (cell);
+
+              for (MaterialModel::ScratchPool<dim> *pool : {&resettable_pool, &non_resettable_pool})
+                {
+                  typename MaterialModel::ScratchPool<dim>::Scratch &scratch
+                    = pool->get (quadrature_formula.size(), this->n_compositional_fields());
+
+                  MaterialModel::PlasticAdditionalOutputs<dim> *plastic_outputs
+                    = scratch.outputs.template get_additional_output<MaterialModel::PlasticAdditionalOutputs<dim> >();
+                  CountedOutputs<dim> *counted_outputs
+                    = scratch.outputs.template get_additional_output<CountedOutputs<dim> >();
+
+                  for (unsigned int q=0; q<quadrature_formula.size(); ++q)
+                    {
+                      n_values_not_reset += (is_signaling_nan(scratch.outputs.viscosities[q]) ? 0 : 1);
+                      n_values_not_reset += (is_signaling_nan(scratch.outputs.densities[q]) ? 0 : 1);
+                      n_values_not_reset += (is_signaling_nan(counted_outputs->values[q]) ? 0 : 1);
+                      if (plastic_outputs != nullptr)
+                        n_values_not_reset += (is_signaling_nan(plastic_outputs->cohesions[q]) ? 0 : 1);
+                    }
+
+                  scratch.inputs.reinit (fe_values, cell, this->introspection(), this->get_solution());
+                  this->get_material_model().evaluate (scratch.inputs, scratch.outputs);
+
+                  // Make sure that every value would be detected if it was not reset
+                  std::fill (counted_outputs->values.begin(), counted_outputs->values.end(), 1.0);
+                  if (plastic_outputs != nullptr)
+                    std::fill (plastic_outputs->cohesions.begin(), plastic_outputs->cohesions.end(), 1.0);
+                }
+            }
+
+        std::ofstream check_file ((this->get_output_directory() + "scratch_pool_check").c_str());
+        check_file << "Number of cells: " << n_cells << std::endl
+                   << "Resettable additional outputs constructed: " << n_resettable_constructed << std::endl
+                   << "Non-resettable additional outputs constructed: " << n_non_resettable_constructed << std::endl
+                   << "Values not reset: " << n_values_not_reset << std::endl;
+
+        return std::make_pair ("Resettable additional outputs constructed:",
+                               Utilities::int_to_string (n_resettable_constructed));
+      }
+  };
+}
+
+
+namespace aspect
+{
+  ASPECT_REGISTER_POSTPROCESSOR(ScratchPoolCheck,
+                                "scratch pool check",
+                                "A postprocessor that checks that the material model inputs "
+                                "and outputs of a ScratchPool are reused and reset.")
+}
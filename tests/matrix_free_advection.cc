@@ -0,0 +1,95 @@
+#include <aspect/postprocess/interface.h>
+#include <aspect/simulator_access.h>
+
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/fe/fe_values.h>
+
+#include <fstream>
+
+namespace aspect
+{
+  using namespace dealii;
+
+  /**
+   * A postprocessor that checks that the temperature is T=1-z and the
+   * first compositional field is C=x-t, which are the exact solutions of
+   * the model in matrix_free_advection.prm. The result of all time steps
+   * so far is written into the file 'advection_check' in the output
+   * directory.
+   */
+  template <int dim>
+  class AdvectionCheck : public Postprocess::Interface<dim>, public ::aspect::SimulatorAccess<dim>
+  {
+    public:
+      AdvectionCheck ()
+        :
+        all_time_steps_passed (true)
+      {}
+
+      std::pair<std::string,std::string>
+      execute (TableHandler &) override
+      {
+        const QGauss<dim> quadrature_formula (this->introspection().polynomial_degree.temperature+1);
+        FEValues<dim> fe_values (this->get_mapping(),
+                                 this->get_fe(),
+                                 quadrature_formula,
+                                 update_values | update_quadrature_points);
+
+        std::vector<double> temperature_values (quadrature_formula.size());
+        std::vector<double> composition_values (quadrature_formula.size());
+
+        double max_temperature_error = 0.0;
+        double max_composition_error = 0.0;
+
+        for (const auto &cell : this->get_dof_handler().active_cell_iterators())
+          if (cell->is_locally_owned())
+            {
+              fe_values.reinit (cell);
+              fe_values[this->introspection().extractors.temperature].get_function_values (this->get_solution(),
+                  temperature_values);
+              fe_values[this->introspection().extractors.compositional_fields[0]].get_function_values (this->get_solution(),
+                  composition_values);
+
+              for (unsigned int q=0; q<quadrature_formula.size(); ++q)
+                {
+                  const Point<dim> &position = fe_values.quadrature_point(q);
+                  max_temperature_error = std::max (max_temperature_error,
+                                                    std::abs(temperature_values[q] - (1.0 - position[dim-1])));
+                  max_composition_error = std::max (max_composition_error,
+                                                    std::abs(composition_values[q] - (position[0] - this->get_time())));
+                }
+            }
+
+        max_temperature_error = Utilities::MPI::max (max_temperature_error, this->get_mpi_communicator());
+        max_composition_error = Utilities::MPI::max (max_composition_error, this->get_mpi_communicator());
+
+        const bool passed = (max_temperature_error < 1e-8 && max_composition_error < 1e-8);
+        all_time_steps_passed = all_time_steps_passed && passed;
+
+        if (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()) == 0)
+          {
+            std::ofstream check_file ((this->get_output_directory() + "advection_check").c_str());
+            check_file << "Temperature and composition errors "
+                       << (all_time_steps_passed ? "below" : "ABOVE")
+                       << " 1e-8 in all time steps."
+                       << std::endl;
+          }
+
+        std::ostringstream errors;
+        errors << std::scientific << max_temperature_error << ", " << max_composition_error;
+        return std::make_pair ("Max temperature and composition errors:", errors.str());
+      }
+
+    private:
+      bool all_time_steps_passed;
+  };
+}
+
+
+namespace aspect
+{
+  ASPECT_REGISTER_POSTPROCESSOR(AdvectionCheck,
+                                "advection check",
+                                "A postprocessor that compares temperature and composition "
+                                "with the exact solution of the matrix_free_advection test.")
+}
@@ -0,0 +1,60 @@
+// The geometry model of the runs started below
+#include "free_surface_relaxation.cc"
+
+#include "compare_runs.h"
+
+/*
+ * Launch the following function when this plugin is created. Launch ASPECT
+ * twice, with the matrix-free and with the matrix-based Stokes solver,
+ * compare the topography and the velocity of both runs in all time steps,
+ * and then terminate the outer ASPECT run.
+ */
+int f()
+{
+  using namespace aspect::CompareRuns;
+
+  if (is_comparison_run())
+    return 0;
+
+  const std::string test_name = "matrix_free_free_surface";
+
+  std::cout << "* running with the matrix-free solver:" << std::endl;
+  run_model (test_name, "output1.tmp", {}, true);
+
+  std::cout << "* running with the matrix-based solver:" << std::endl;
+  run_model (test_name, "output2.tmp",
+  {
+    "subsection Solver parameters",
+    "  subsection Stokes solver parameters",
+    "    set Stokes solver type = block AMG",
+    "  end",
+    "end"
+  },
+  true);
+
+  std::cout << "* now comparing:" << std::endl;
+
+  const std::string output = "output-" + test_name + "/";
+  const std::string statistics1 = output + "output1.tmp/statistics";
+  const std::string statistics2 = output + "output2.tmp/statistics";
+
+  std::ofstream comparison ((output + "relaxation_comparison").c_str());
+  comparison << "Maximum topography agrees in all time steps: "
+             << yes_or_no (max_relative_difference (read_statistics_column (statistics1, "Maximum topography"),
+                                                    read_statistics_column (statistics2, "Maximum topography"))
+                           < 1e-5)
+             << std::endl
+             << "RMS velocities agree in all time steps: "
+             << yes_or_no (max_relative_difference (read_statistics_column (statistics1, "RMS velocity"),
+                                                    read_statistics_column (statistics2, "RMS velocity"))
+                           < 1e-5)
+             << std::endl;
+
+  // terminate current process:
+  exit (0);
+  return 42;
+}
+
+
+// run this function by initializing a global variable by it
+int i = f();
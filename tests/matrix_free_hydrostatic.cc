@@ -0,0 +1,153 @@
+#include <aspect/postprocess/interface.h>
+#include <aspect/simulator_access.h>
+
+#include <deal.II/base/parsed_function.h>
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/fe/fe_values.h>
+
+#include <fstream>
+
+namespace aspect
+{
+  using namespace dealii;
+
+  /**
+   * A postprocessor that compares velocity and pressure with the exact
+   * solution given in the input file. The maximal errors at the quadrature
+   * points are compared against the given tolerances, and the result is
+   * written into the file 'analytic_solution_check' in the output
+   * directory, so that the test output does not depend on the round-off
+   * errors of the linear solvers.
+   */
+  template <int dim>
+  class AnalyticSolutionCheck : public Postprocess::Interface<dim>, public ::aspect::SimulatorAccess<dim>
+  {
+    public:
+      AnalyticSolutionCheck ()
+        :
+        exact_solution (dim+1)
+      {}
+
+      std::pair<std::string,std::string>
+      execute (TableHandler &) override
+      {
+        exact_solution.set_time (this->get_time());
+
+        const QGauss<dim> quadrature_formula (this->introspection().polynomial_degree.velocities+2);
+        FEValues<dim> fe_values (this->get_mapping(),
+                                 this->get_fe(),
+                                 quadrature_formula,
+                                 update_values | update_quadrature_points);
+
+        std::vector<Tensor<1,dim> > velocity_values (quadrature_formula.size());
+        std::vector<double> pressure_values (quadrature_formula.size());
+        Vector<double> exact_values (dim+1);
+
+        double max_velocity_error = 0.0;
+        double max_pressure_error = 0.0;
+
+        for (const auto &cell : this->get_dof_handler().active_cell_iterators())
+          if (cell->is_locally_owned())
+            {
+              fe_values.reinit (cell);
+              fe_values[this->introspection().extractors.velocities].get_function_values (this->get_solution(),
+                  velocity_values);
+              fe_values[this->introspection().extractors.pressure].get_function_values (this->get_solution(),
+                  pressure_values);
+
+              for (unsigned int q=0; q<quadrature_formula.size(); ++q)
+                {
+                  exact_solution.vector_value (fe_values.quadrature_point(q), exact_values);
+
+                  Tensor<1,dim> velocity_error = velocity_values[q];
+                  for (unsigned int d=0; d<dim; ++d)
+                    velocity_error[d] -= exact_values[d];
+
+                  max_velocity_error = std::max (max_velocity_error, velocity_error.norm());
+                  max_pressure_error = std::max (max_pressure_error,
+                                                 std::abs(pressure_values[q] - exact_values[dim]));
+                }
+            }
+
+        max_velocity_error = Utilities::MPI::max (max_velocity_error, this->get_mpi_communicator());
+        max_pressure_error = Utilities::MPI::max (max_pressure_error, this->get_mpi_communicator());
+
+        const bool velocity_passed = (max_velocity_error < velocity_tolerance);
+        const bool pressure_passed = (max_pressure_error < pressure_tolerance);
+
+        if (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()) == 0)
+          {
+            std::ofstream check_file ((this->get_output_directory() + "analytic_solution_check").c_str());
+            check_file << "Velocity error below tolerance: " << (velocity_passed ? "yes" : "no") << std::endl
+                       << "Pressure error below tolerance: " << (pressure_passed ? "yes" : "no") << std::endl;
+          }
+
+        std::ostringstream errors;
+        errors << std::scientific << max_velocity_error << ", " << max_pressure_error;
+        return std::make_pair ("Max velocity and pressure errors:", errors.str());
+      }
+
+      static
+      void
+      declare_parameters (ParameterHandler &prm)
+      {
+        prm.enter_subsection("Postprocess");
+        {
+          prm.enter_subsection("Analytic solution check");
+          {
+            prm.declare_entry ("Velocity tolerance", "1e-6",
+                               Patterns::Double (0.),
+                               "The maximal allowed difference of the velocity and the exact "
+                               "velocity at the quadrature points.");
+            prm.declare_entry ("Pressure tolerance", "1e-6",
+                               Patterns::Double (0.),
+                               "The maximal allowed difference of the pressure and the exact "
+                               "pressure at the quadrature points.");
+
+            prm.enter_subsection("Exact solution");
+            {
+              Functions::ParsedFunction<dim>::declare_parameters (prm, dim+1);
+            }
+            prm.leave_subsection();
+          }
+          prm.leave_subsection();
+        }
+        prm.leave_subsection();
+      }
+
+      void
+      parse_parameters (ParameterHandler &prm) override
+      {
+        prm.enter_subsection("Postprocess");
+        {
+          prm.enter_subsection("Analytic solution check");
+          {
+            velocity_tolerance = prm.get_double ("Velocity tolerance");
+            pressure_tolerance = prm.get_double ("Pressure tolerance");
+
+            prm.enter_subsection("Exact solution");
+            {
+              exact_solution.parse_parameters (prm);
+            }
+            prm.leave_subsection();
+          }
+          prm.leave_subsection();
+        }
+        prm.leave_subsection();
+      }
+
+    private:
+      Functions::ParsedFunction<dim> exact_solution;
+      double velocity_tolerance;
+      double pressure_tolerance;
+  };
+}
+
+
+namespace aspect
+{
+  ASPECT_REGISTER_POSTPROCESSOR(AnalyticSolutionCheck,
+                                "analytic solution check",
+                                "A postprocessor that checks that velocity and pressure "
+                                "agree with an exact solution given in the input file.")
+}
@@ -0,0 +1,55 @@
+#include "compare_runs.h"
+
+/*
+ * Launch the following function when this plugin is created. Launch ASPECT
+ * twice, with the matrix-free and with the matrix-based Stokes solver,
+ * compare the solutions of both runs, and then terminate the outer ASPECT
+ * run.
+ */
+int f()
+{
+  using namespace aspect::CompareRuns;
+
+  if (is_comparison_run())
+    return 0;
+
+  const std::string test_name = "matrix_free_implicit_reference_density_comparison";
+
+  std::cout << "* running with the matrix-free solver:" << std::endl;
+  run_model (test_name, "output1.tmp");
+
+  std::cout << "* running with the matrix-based solver:" << std::endl;
+  run_model (test_name, "output2.tmp",
+  {
+    "subsection Solver parameters",
+    "  subsection Stokes solver parameters",
+    "    set Stokes solver type = block AMG",
+    "  end",
+    "end"
+  });
+
+  std::cout << "* now comparing:" << std::endl;
+
+  const std::string output = "output-" + test_name + "/";
+  const std::string solution = "solution/solution-00000.0000.gnuplot";
+
+  std::ofstream comparison ((output + "solution_comparison").c_str());
+  comparison << "Velocities and pressures agree at all output points: "
+             << yes_or_no (max_relative_difference (read_data_file (output + "output1.tmp/" + solution),
+                                                    read_data_file (output + "output2.tmp/" + solution))
+                           < 1e-5)
+             << std::endl
+             << "Average pressures agree: "
+             << yes_or_no (max_relative_difference (read_statistics_column (output + "output1.tmp/statistics", "Average pressure"),
+                                                    read_statistics_column (output + "output2.tmp/statistics", "Average pressure"))
+                           < 1e-5)
+             << std::endl;
+
+  // terminate current process:
+  exit (0);
+  return 42;
+}
+
+
+// run this function by initializing a global variable by it
+int i = f();
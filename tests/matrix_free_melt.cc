@@ -0,0 +1,63 @@
+#include "melt_transport_convergence_simple.cc"
+
+#include <fstream>
+
+namespace aspect
+{
+  /**
+   * A postprocessor that computes the errors of the manufactured solution
+   * of melt_transport_convergence_simple like the 'melt error calculation'
+   * postprocessor, and compares them with the errors of the block AMG
+   * solver in the reference output of that test. The discretizations are
+   * not identical, because the matrix-free solver requires a continuous
+   * compaction pressure and material averaging, so the test only checks
+   * that all errors are smaller than ten times the block AMG errors, which
+   * is not the case if the matrix-free melt operator is wrong. The result
+   * is written into the file 'melt_solver_comparison' in the output
+   * directory.
+   */
+  template <int dim>
+  class MatrixFreeMeltComparison : public ConvergenceMeltPostprocessor<dim>
+  {
+    public:
+      std::pair<std::string,std::string>
+      execute (TableHandler &statistics) override
+      {
+        const std::pair<std::string,std::string> errors
+          = ConvergenceMeltPostprocessor<dim>::execute(statistics);
+
+        const std::vector<std::string> names = {"u_L2", "p_L2", "p_f_L2", "p_c_bar_L2",
+                                                "p_c_L2", "porosity_L2", "u_f_L2"
+                                               };
+        // The errors of the block AMG solver, see
+        // tests/melt_transport_convergence_simple/screen-output
+        const std::vector<double> block_amg_errors = {1.026761e-04, 1.699048e-02, 1.709911e-02, 3.657377e-06,
+                                                      8.694257e-05, 2.402420e-03, 4.347472e-03
+                                                     };
+
+        const std::vector<double> matrix_free_errors
+          = Utilities::string_to_double(Utilities::split_string_list(errors.second));
+        AssertThrow (matrix_free_errors.size() == names.size(), ExcInternalError());
+
+        if (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()) == 0)
+          {
+            std::ofstream check_file ((this->get_output_directory() + "melt_solver_comparison").c_str());
+            for (unsigned int i=0; i<names.size(); ++i)
+              check_file << names[i] << " less than ten times the block AMG error: "
+                         << (matrix_free_errors[i] < 10 * block_amg_errors[i] ? "yes" : "no")
+                         << std::endl;
+          }
+
+        return errors;
+      }
+  };
+}
+
+
+namespace aspect
+{
+  ASPECT_REGISTER_POSTPROCESSOR(MatrixFreeMeltComparison,
+                                "matrix free melt comparison",
+                                "A postprocessor that compares the errors of the manufactured "
+                                "melt transport solution with the ones of the block AMG solver.")
+}
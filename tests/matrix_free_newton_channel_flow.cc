@@ -0,0 +1,70 @@
+// The material model of the runs started below
+#include "nonlinear_channel_flow_velocities_Newton_Stokes.cc"
+
+#include "compare_runs.h"
+
+/*
+ * Launch the following function when this plugin is created. Launch ASPECT
+ * twice, with the matrix-free and with the matrix-based Newton solver,
+ * compare the solutions and the number of nonlinear iterations of both
+ * runs, and then terminate the outer ASPECT run.
+ */
+int f()
+{
+  using namespace aspect::CompareRuns;
+
+  if (is_comparison_run())
+    return 0;
+
+  const std::string test_name = "matrix_free_newton_channel_flow";
+
+  std::cout << "* running with the matrix-free Newton solver:" << std::endl;
+  run_model (test_name, "output1.tmp", {}, true);
+
+  std::cout << "* running with the matrix-based Newton solver:" << std::endl;
+  run_model (test_name, "output2.tmp",
+  {
+    "subsection Solver parameters",
+    "  subsection Stokes solver parameters",
+    "    set Stokes solver type = block AMG",
+    "  end",
+    "end"
+  },
+  true);
+
+  std::cout << "* now comparing:" << std::endl;
+
+  const std::string output = "output-" + test_name + "/";
+  const std::string statistics1 = output + "output1.tmp/statistics";
+  const std::string statistics2 = output + "output2.tmp/statistics";
+
+  // The Newton solver stops at a residual of 1e-8, and the linear
+  // solvers of both runs reduce the residual in different ways, so the
+  // number of nonlinear iterations may differ slightly
+  const std::vector<double> iterations1 = read_statistics_column (statistics1, "Number of nonlinear iterations");
+  const std::vector<double> iterations2 = read_statistics_column (statistics2, "Number of nonlinear iterations");
+
+  std::ofstream comparison ((output + "newton_solution_comparison").c_str());
+  comparison << "RMS velocities agree: "
+             << yes_or_no (max_relative_difference (read_statistics_column (statistics1, "RMS velocity"),
+                                                    read_statistics_column (statistics2, "RMS velocity"))
+                           < 1e-5)
+             << std::endl
+             << "Average pressures agree: "
+             << yes_or_no (max_relative_difference (read_statistics_column (statistics1, "Average pressure"),
+                                                    read_statistics_column (statistics2, "Average pressure"))
+                           < 1e-5)
+             << std::endl
+             << "Number of nonlinear iterations within two of the matrix-based solver: "
+             << yes_or_no (iterations1.size() == 1 && iterations2.size() == 1
+                           && iterations1[0] <= iterations2[0] + 2)
+             << std::endl;
+
+  // terminate current process:
+  exit (0);
+  return 42;
+}
+
+
+// run this function by initializing a global variable by it
+int i = f();
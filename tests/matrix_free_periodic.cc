@@ -0,0 +1 @@
+#include "matrix_free_hydrostatic.cc"
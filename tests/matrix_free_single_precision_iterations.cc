@@ -0,0 +1,58 @@
+#include "compare_runs.h"
+
+/*
+ * Launch the following function when this plugin is created. Launch ASPECT
+ * twice, with the multigrid preconditioner in double and in single
+ * precision, compare the statistics of both runs, and then terminate the
+ * outer ASPECT run.
+ */
+int f()
+{
+  using namespace aspect::CompareRuns;
+
+  if (is_comparison_run())
+    return 0;
+
+  const std::string test_name = "matrix_free_single_precision_iterations";
+
+  std::cout << "* running with a double precision multigrid:" << std::endl;
+  run_model (test_name, "output1.tmp");
+
+  std::cout << "* running with a single precision multigrid:" << std::endl;
+  run_model (test_name, "output2.tmp",
+  {
+    "subsection Solver parameters",
+    "  subsection Matrix Free",
+    "    set Use single precision multigrid = true",
+    "  end",
+    "end"
+  });
+
+  std::cout << "* now comparing:" << std::endl;
+
+  const std::string output = "output-" + test_name + "/";
+  const std::vector<double> double_iterations
+    = read_statistics_column (output + "output1.tmp/statistics", "Iterations for Stokes solver");
+  const std::vector<double> single_iterations
+    = read_statistics_column (output + "output2.tmp/statistics", "Iterations for Stokes solver");
+
+  std::ofstream comparison ((output + "iteration_comparison").c_str());
+  comparison << "Single precision needs at most ten percent more Stokes iterations: "
+             << yes_or_no (!double_iterations.empty()
+                           && single_iterations.size() == double_iterations.size()
+                           && single_iterations[0] <= 1.1 * double_iterations[0] + 1)
+             << std::endl
+             << "RMS velocities agree: "
+             << yes_or_no (max_relative_difference (read_statistics_column (output + "output1.tmp/statistics", "RMS velocity"),
+                                                    read_statistics_column (output + "output2.tmp/statistics", "RMS velocity"))
+                           < 1e-6)
+             << std::endl;
+
+  // terminate current process:
+  exit (0);
+  return 42;
+}
+
+
+// run this function by initializing a global variable by it
+int i = f();
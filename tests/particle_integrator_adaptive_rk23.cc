@@ -0,0 +1,63 @@
+#include "compare_runs.h"
+
+#include <algorithm>
+
+/*
+ * Launch the following function when this plugin is created. Launch ASPECT
+ * twice, with the adaptive RK23 integrator and large time steps, and with
+ * the RK4 integrator and small time steps, compare the particle positions
+ * at the end time of both runs, and then terminate the outer ASPECT run.
+ */
+int f()
+{
+  using namespace aspect::CompareRuns;
+
+  if (is_comparison_run())
+    return 0;
+
+  const std::string test_name = "particle_integrator_adaptive_rk23";
+
+  std::cout << "* running with the adaptive RK23 integrator:" << std::endl;
+  run_model (test_name, "output1.tmp");
+
+  std::cout << "* running with the RK4 integrator and 100 times smaller time steps:" << std::endl;
+  run_model (test_name, "output2.tmp",
+  {
+    "set Maximum time step = 0.0025",
+    "subsection Postprocess",
+    "  subsection Particles",
+    "    set Integration scheme = rk4",
+    "  end",
+    "end"
+  });
+
+  std::cout << "* now comparing:" << std::endl;
+
+  const std::string output = "output-" + test_name + "/";
+  const std::string particles = "particles/particles-00001.0000.gnuplot";
+
+  // The particles are written in the order of the cells they are in, so
+  // sort them by their id, which is the third column of the output
+  std::vector<std::vector<double> > particles1 = read_data_file (output + "output1.tmp/" + particles);
+  std::vector<std::vector<double> > particles2 = read_data_file (output + "output2.tmp/" + particles);
+  for (auto *p : {&particles1, &particles2})
+    std::sort (p->begin(), p->end(),
+               [] (const std::vector<double> &a, const std::vector<double> &b)
+    {
+      return a.size() > 2 && b.size() > 2 && a[2] < b[2];
+    });
+
+  // The gnuplot output only has six significant digits
+  std::ofstream comparison ((output + "particle_comparison").c_str());
+  comparison << "Particle positions agree with the RK4 run: "
+             << yes_or_no (max_relative_difference (particles1, particles2) < 1e-5)
+             << std::endl;
+
+  // terminate current process:
+  exit (0);
+  return 42;
+}
+
+
+// run this function by initializing a global variable by it
+int i = f();
@@ -0,0 +1,173 @@
+#include <aspect/material_model/simple.h>
+#include <aspect/postprocess/interface.h>
+#include <aspect/simulator_access.h>
+#include <aspect/particle/world.h>
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace aspect
+{
+  using namespace dealii;
+
+  /**
+   * Return whether the cell with center @p cell_center is one of the cells
+   * on which the material model below is expensive, i.e., whether it lies
+   * in the left quarter of the unit square.
+   */
+  template <int dim>
+  bool
+  is_expensive_cell (const Point<dim> &cell_center)
+  {
+    return cell_center[0] < 0.25;
+  }
+
+
+
+  namespace MaterialModel
+  {
+    /**
+     * The simple material model, which waits for 20 ms whenever it is
+     * evaluated on a cell in the left quarter of the domain, so that the
+     * measured cost of these cells is much larger than the one of all
+     * other cells.
+     */
+    template <int dim>
+    class ExpensiveSimple : public MaterialModel::Simple<dim>
+    {
+      public:
+        void
+        evaluate(const MaterialModel::MaterialModelInputs<dim> &in,
+                 MaterialModel::MaterialModelOutputs<dim> &out) const override
+        {
+          MaterialModel::Simple<dim>::evaluate(in, out);
+
+          if (in.current_cell.state() == IteratorState::valid
+              && is_expensive_cell(in.current_cell->center()))
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    };
+  }
+
+
+
+  /**
+   * A postprocessor that checks that the partition of the mesh computed
+   * from the measured cell cost is valid: the locally owned cells of all
+   * processes cover the whole mesh, every process owns at least one cell,
+   * every particle of a process is located in one of its locally owned
+   * cells, and the number of particles does not change.
+   *
+   * It also checks that the measured cost changes the partition. In the
+   * initial partition, which does not know about the cost, the expensive
+   * cells in the left quarter of the domain belong to only some of the
+   * processes. After every repartitioning with the measured cost, the
+   * expensive cells dominate the weights and every process needs to own
+   * some of them.
+   *
+   * The partition itself depends on the measured times, so only the
+   * results of these checks are written into the file 'partition_check'
+   * in the output directory.
+   */
+  template <int dim>
+  class PartitionCheck : public Postprocess::Interface<dim>, public ::aspect::SimulatorAccess<dim>
+  {
+    public:
+      PartitionCheck ()
+        :
+        n_executions (0),
+        all_steps_valid (true),
+        initial_partition_has_process_without_expensive_cells (false),
+        expensive_cells_on_all_processes_after_repartitioning (true)
+      {}
+
+      std::pair<std::string,std::string>
+      execute (TableHandler &) override
+      {
+        const Particle::World<dim> &world = this->get_particle_world();
+        const Particle::ParticleHandler<dim> &particle_handler = world.get_particle_handler();
+
+        unsigned int n_locally_owned_cells = 0;
+        unsigned int n_locally_owned_expensive_cells = 0;
+        Particle::types::particle_index n_particles_in_locally_owned_cells = 0;
+        for (const auto &cell : this->get_triangulation().active_cell_iterators())
+          if (cell->is_locally_owned())
+            {
+              ++n_locally_owned_cells;
+              if (is_expensive_cell(cell->center()))
+                ++n_locally_owned_expensive_cells;
+              n_particles_in_locally_owned_cells += particle_handler.n_particles_in_cell(cell);
+            }
+
+        const MPI_Comm comm = this->get_mpi_communicator();
+        const bool cells_cover_mesh
+          = (Utilities::MPI::sum (n_locally_owned_cells, comm) == this->get_triangulation().n_global_active_cells());
+        const bool every_process_owns_cells
+          = (Utilities::MPI::min (n_locally_owned_cells, comm) > 0);
+        const bool particles_in_owned_cells
+          = (Utilities::MPI::min (n_particles_in_locally_owned_cells == particle_handler.n_locally_owned_particles() ? 1 : 0,
+                                  comm) == 1);
+        const bool no_particles_lost
+          = (world.n_global_particles() == 1000);
+
+        const bool valid = cells_cover_mesh && every_process_owns_cells
+                           && particles_in_owned_cells && no_particles_lost;
+        all_steps_valid = all_steps_valid && valid;
+
+        const bool every_process_owns_expensive_cells
+          = (Utilities::MPI::min (n_locally_owned_expensive_cells, comm) > 0);
+
+        // The postprocessors run once on the initial mesh before the first
+        // refinement step, which is the first one that uses the measured
+        // cost
+        if (n_executions == 0)
+          initial_partition_has_process_without_expensive_cells = !every_process_owns_expensive_cells;
+        else
+          expensive_cells_on_all_processes_after_repartitioning
+            = expensive_cells_on_all_processes_after_repartitioning && every_process_owns_expensive_cells;
+        ++n_executions;
+
+        if (Utilities::MPI::this_mpi_process(comm) == 0)
+          {
+            std::ofstream check_file ((this->get_output_directory() + "partition_check").c_str());
+            check_file << "Partition valid after every refinement step: "
+                       << (all_steps_valid ? "yes" : "no")
+                       << std::endl
+                       << "Initial partition has a process without expensive cells: "
+                       << (initial_partition_has_process_without_expensive_cells ? "yes" : "no")
+                       << std::endl
+                       << "Every process owns expensive cells after every repartitioning: "
+                       << (expensive_cells_on_all_processes_after_repartitioning ? "yes" : "no")
+                       << std::endl;
+          }
+
+        return std::make_pair ("Partition valid:",
+                               valid ? "yes" : "no");
+      }
+
+    private:
+      unsigned int n_executions;
+      bool all_steps_valid;
+      bool initial_partition_has_process_without_expensive_cells;
+      bool expensive_cells_on_all_processes_after_repartitioning;
+  };
+}
+
+
+namespace aspect
+{
+  namespace MaterialModel
+  {
+    ASPECT_REGISTER_MATERIAL_MODEL(ExpensiveSimple,
+                                   "expensive simple",
+                                   "The simple material model, which is slow to evaluate "
+                                   "in the left quarter of the domain.")
+  }
+
+  ASPECT_REGISTER_POSTPROCESSOR(PartitionCheck,
+                                "partition check",
+                                "A postprocessor that checks that the mesh and the particles "
+                                "are correctly distributed between the processes, and that "
+                                "the measured cost changes the partition.")
+}
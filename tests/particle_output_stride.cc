@@ -0,0 +1,78 @@
+#include <aspect/postprocess/interface.h>
+#include <aspect/simulator_access.h>
+#include <aspect/particle/world.h>
+
+#include <fstream>
+
+namespace aspect
+{
+  using namespace dealii;
+
+  /**
+   * A postprocessor that checks the first output of the 'particles'
+   * postprocessor in particle_output_stride.prm: The gnuplot file of this
+   * process has to contain exactly the particles whose id is a multiple of
+   * the output stride, and the vtu file has to exist. The result is written
+   * into the file 'particle_output_check' in the output directory.
+   */
+  template <int dim>
+  class ParticleOutputCheck : public Postprocess::Interface<dim>, public ::aspect::SimulatorAccess<dim>
+  {
+    public:
+      std::pair<std::string,std::string>
+      execute (TableHandler &) override
+      {
+        const unsigned int output_stride = 3;
+        const std::string file_prefix = this->get_output_directory()
+                                        + "particles/particles-00000."
+                                        + Utilities::int_to_string (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()), 4);
+
+        unsigned int n_expected_particles = 0;
+        for (const auto &particle : this->get_particle_world().get_particle_handler())
+          if (particle.get_id() % output_stride == 0)
+            ++n_expected_particles;
+
+        // Every particle is written into one line of the gnuplot file,
+        // all other lines are comments or empty:
+        unsigned int n_written_particles = 0;
+        std::ifstream gnuplot_file ((file_prefix + ".gnuplot").c_str());
+        std::string line;
+        while (std::getline (gnuplot_file, line))
+          if (!line.empty() && line[0] != '#')
+            ++n_written_particles;
+
+        const std::ifstream vtu_file ((file_prefix + ".vtu").c_str());
+
+        const bool passed = Utilities::MPI::min ((n_written_particles == n_expected_particles
+                                                  && vtu_file.good()) ? 1 : 0,
+                                                 this->get_mpi_communicator()) == 1;
+
+        if (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()) == 0)
+          {
+            std::ofstream check_file ((this->get_output_directory() + "particle_output_check").c_str());
+            check_file << "Written particles "
+                       << (passed ? "match" : "DO NOT MATCH")
+                       << " the particles selected by the output stride."
+                       << std::endl;
+          }
+
+        return std::make_pair ("Particle output matches output stride:",
+                               passed ? "yes" : "no");
+      }
+
+      std::list<std::string>
+      required_other_postprocessors () const override
+      {
+        return std::list<std::string> (1, "particles");
+      }
+  };
+}
+
+
+namespace aspect
+{
+  ASPECT_REGISTER_POSTPROCESSOR(ParticleOutputCheck,
+                                "particle output check",
+                                "A postprocessor that checks the particle output of the "
+                                "particle_output_stride test.")
+}